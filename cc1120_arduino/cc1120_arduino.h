@@ -9,6 +9,7 @@ extern const uint8_t CC1120_CS;
 extern const uint8_t CC1120_MOSI;
 extern const uint8_t CC1120_MISO;
 extern const uint8_t CC1120_SCLK;
+extern const uint8_t CC1120_GPIO[4];
 
 /**
  * @brief Set up the SPI pins and the CS pin, run E2E tests.
@@ -26,6 +27,8 @@ void loop();
 extern "C" {
 #endif
 
+#include "cc1120_gpio.h"
+
 /**
  * @brief Logs a string to the serial port.
  * 
@@ -37,22 +40,80 @@ void arduino_serial_log(cc1120_log_level_t level, char str[]);
 /**
  * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
  * 
+ * @param bus - The bus handle of the device.
  * @param data - Data to transfer 
  * @return uint8_t - Data received from CC1120
  */
-uint8_t arduino_cc1120_spi_transfer(uint8_t data);
+uint8_t arduino_cc1120_spi_transfer(void *bus, uint8_t data);
+
+/**
+ * @brief Transfers a block of bytes over CC1120 SPI interface
+ * 
+ * @param bus - The bus handle of the device.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+void arduino_cc1120_spi_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len);
 
 /**
  * @brief Pulls the CS pin low.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
  */
-void arduino_cc1120_cs_assert();
+void arduino_cc1120_cs_assert(void *bus, uint8_t csPin);
 
 /**
  * @brief Pulls the CS pin high.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
+ */
+void arduino_cc1120_cs_deassert(void *bus, uint8_t csPin);
+
+/**
+ * @brief Sets the SPI clock.
+ * 
+ * @param bus - The bus handle of the device.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz.
+ */
+uint32_t arduino_cc1120_spi_set_clock(void *bus, uint32_t hz);
+
+/**
+ * @brief Reads the level of one of the CC1120 GPIO pins.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @return uint8_t - 1 if the pin is high, 0 if it is low.
+ */
+uint8_t arduino_cc1120_gpio_read(uint8_t gpio);
+
+/**
+ * @brief Routes the change interrupt of one of the CC1120 GPIO pins to a dispatcher.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @param dispatcher - The dispatcher to call cc1120_gpio_dispatch on, or NULL to detach the interrupt.
+ */
+void arduino_cc1120_gpio_attach(uint8_t gpio, cc1120_gpio_dispatcher_t *dispatcher);
+
+/**
+ * @brief Gets the number of microseconds since the board started.
+ * 
+ * @return uint32_t - The current time in microseconds.
+ */
+uint32_t arduino_get_time_us();
+
+/**
+ * @brief Calls a function from a one-shot timer interrupt at a given time.
+ * 
+ * @param atUs - The micros() time to call it at.
+ * @param callback - The function to call from the interrupt.
+ * @param ctx - Passed to the callback.
+ * @return true - If the timer was started.
+ * @return false - If the platform has no timer, or the time is out of its range.
  */
-void arduino_cc1120_cs_deassert();
+bool arduino_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx);
 
 #ifdef __cplusplus
 }
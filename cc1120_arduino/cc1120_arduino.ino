@@ -1,8 +1,15 @@
 #include "cc1120_arduino.h"
 
 extern "C" {
+#include "cc1120_dev.h"
+#include "cc1120_gpio.h"
+#include "cc1120_hal.h"
+#include "cc1120_mcu.h"
+#include "cc1120_selftest.h"
 #include "cc1120_spi.h"
 #include "cc1120_spi_tests.h"
+#include "cc1120_spi_tune.h"
+#include "cc1120_stats.h"
 #include "cc1120_txrx.h"
 }
 
@@ -15,6 +22,83 @@ const uint8_t CC1120_CS = 53;
 const uint8_t CC1120_MOSI = 51;
 const uint8_t CC1120_MISO = 50;
 const uint8_t CC1120_SCLK = 52;
+/* CC1120 GPIO0..3, wired to interrupt-capable pins */
+const uint8_t CC1120_GPIO[4] = {2, 3, 18, 19};
+
+cc1120_dev_t radio;
+cc1120_gpio_dispatcher_t radioGpio;
+cc1120_stats_t radioStats;
+
+/* Period of the link statistics printed from the loop */
+const uint32_t STATS_PERIOD_MS = 10000;
+
+/* CC1120 GPIO that signals the end of a packet, see on_packet_done */
+const uint8_t CC1120_GPIO_PKT = 2;
+/* CC1120 GPIO that signals a received packet with a good CRC, see on_packet_received */
+const uint8_t CC1120_GPIO_RX = 0;
+
+static cc1120_gpio_dispatcher_t *arduinoGpioDispatcher[4];
+static volatile uint8_t packetsDone;
+static volatile uint8_t packetsReceived;
+static volatile uint32_t packetSyncUs;
+static bool radioReady;
+
+/**
+ * @brief Counts finished packets. PKT_SYNC_RXTX asserts on the sync word and deasserts at the end of a packet.
+ * 
+ * @param ctx - Unused.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level.
+ * @param timeUs - The time of the edge.
+ */
+static void on_packet_done(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs) {
+    if (level)
+        packetSyncUs = timeUs;
+    else
+        packetsDone++;
+}
+
+/**
+ * @brief Counts received packets. PKT_CRC_OK asserts once a packet that passed CRC is in the RX FIFO.
+ * 
+ * @param ctx - Unused.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level.
+ * @param timeUs - The time of the edge.
+ */
+static void on_packet_received(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs) {
+    packetsReceived++;
+}
+
+/**
+ * @brief Reads a little-endian 16-bit field of a statistics record.
+ * 
+ * @param p - The field.
+ * @return uint16_t - The value.
+ */
+static uint16_t stats_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Takes a snapshot of the link statistics and prints the main counts.
+ * 
+ */
+static void log_stats() {
+    uint8_t record[CC1120_STATS_RECORD_LEN];
+    cc1120_stats_snapshot(&radioStats, mcu_get_time_us(), record);
+
+    Serial.print("Link stats: sent ");
+    Serial.print(stats_u16(&record[2]));
+    Serial.print(", received ");
+    Serial.print(stats_u16(&record[4]));
+    Serial.print(", CRC failures ");
+    Serial.print(stats_u16(&record[14]));
+    Serial.print(", FIFO recoveries ");
+    Serial.print(stats_u16(&record[26]));
+    Serial.print(", RSSI avg ");
+    Serial.println((int8_t)record[41]);
+}
 
 /**
  * @brief Set up the SPI pins and the CS pin, run E2E tests.
@@ -29,23 +113,28 @@ void setup() {
     pinMode(CC1120_RST, OUTPUT);
     digitalWrite(CC1120_RST, HIGH);
 
+    for (uint8_t gpio = 0; gpio < 4; gpio++)
+        pinMode(CC1120_GPIO[gpio], INPUT);
+
     SPI.begin();
+    cc1120_dev_init(&radio, &MCU_CC1120_TRANSPORT, NULL, CC1120_CS);
+    cc1120_gpio_init(&radioGpio);
     delay(1000);
 
     Serial.println("Starting E2E tests...");
     cc1120_status_code status;
     uint8_t i;
     for(i = 0; i < 3; i++) {
-        status = cc1120_test_spi_strobe();
+        status = cc1120_test_spi_strobe(&radio);
 
         if (status == CC1120_ERROR_CODE_SUCCESS)
-            status = cc1120_test_spi_read();
+            status = cc1120_test_spi_read(&radio);
 
         if (status == CC1120_ERROR_CODE_SUCCESS)
-            status = cc1120_test_spi_write();
+            status = cc1120_test_spi_write(&radio);
 
         if (status == CC1120_ERROR_CODE_SUCCESS)
-            status = cc1120_test_fifo_read_write();
+            status = cc1120_test_fifo_read_write(&radio);
 
         if (status == CC1120_ERROR_CODE_SUCCESS) {
             Serial.println("All CC1120 tests passed. Resetting the chip...");
@@ -64,23 +153,51 @@ void setup() {
         }
     }
 
-    if (cc1120_strobe_spi(CC1120_STROBE_SRES) != CC1120_ERROR_CODE_SUCCESS) {
+    if (cc1120_spi_tune(&radio, CC1120_SPI_MAX_HZ, CC1120_SPI_TUNE_DEFAULT_MARGIN_STEPS) != CC1120_ERROR_CODE_SUCCESS)
+        Serial.println("SPI clock tuning failed, keeping the default clock.");
+
+    uint32_t nsPerByte;
+    cc1120_test_spi_byte_time(&radio, &nsPerByte);
+
+    cc1120_selftest_report_t selftest;
+    status = cc1120_selftest_run(&radio, &selftest);
+    cc1120_selftest_log(&selftest);
+    if (status != CC1120_ERROR_CODE_SUCCESS) {
+        Serial.print("ERROR. CC1120 self-test failed. Error Code: ");
+        Serial.println(status);
+        return;
+    }
+
+    if (cc1120_strobe_spi(&radio, CC1120_STROBE_SRES) != CC1120_ERROR_CODE_SUCCESS) {
         Serial.println("ERROR. CC1120 reset failed.");
         return;
     }
 
-    if (cc1120_tx_init() != CC1120_ERROR_CODE_SUCCESS) {
+    if (cc1120_tx_init(&radio) != CC1120_ERROR_CODE_SUCCESS) {
         Serial.println("ERROR. TX initialization failed.");
         return;
     }
+    cc1120_stats_init(&radioStats, &radio, mcu_get_time_us());
+
+    if (cc1120_gpio_map(&radio, &radioGpio, CC1120_GPIO_PKT, CC1120_GPIO_CFG_PKT_SYNC_RXTX, false,
+                        CC1120_GPIO_EDGE_BOTH, on_packet_done, NULL) != CC1120_ERROR_CODE_SUCCESS) {
+        Serial.println("ERROR. GPIO mapping failed.");
+        return;
+    }
+
+    if (cc1120_gpio_map(&radio, &radioGpio, CC1120_GPIO_RX, CC1120_GPIO_CFG_PKT_CRC_OK, false,
+                        CC1120_GPIO_EDGE_RISING, on_packet_received, NULL) != CC1120_ERROR_CODE_SUCCESS) {
+        Serial.println("ERROR. GPIO mapping failed.");
+        return;
+    }
 
 
     uint8_t stateNum;
     uint8_t numPackets;
-    cc1120_get_state(&stateNum);
+    cc1120_get_state(&radio, &stateNum);
     Serial.print("State number: ");
     Serial.println(stateNum);
-    cc1120_get_packets_in_tx_fifo(&numPackets);
+    cc1120_get_packets_in_tx_fifo(&radio, &numPackets);
     Serial.print("Num packets in TX FIFO: ");
     Serial.println(numPackets);
 
@@ -93,29 +210,81 @@ void setup() {
     
     for (int i=0; i<100; i++) {
         uint8_t testTxData[] = "Hello World";
-        status = cc1120_send(testTxData, sizeof(testTxData)/sizeof(uint8_t));
+        uint8_t done = packetsDone;
+        status = cc1120_send(&radio, testTxData, sizeof(testTxData)/sizeof(uint8_t));
         if (status) {
             Serial.print("Failed");
             Serial.println(status);
         }
+
+        // Wait for the end of packet interrupt instead of polling the radio
+        uint32_t start = mcu_get_time_us();
+        while (packetsDone == done && mcu_get_time_us() - start < 1000000UL)
+            ;
+        if (packetsDone == done)
+            Serial.println("Timed out waiting for the packet to be sent");
     
-        cc1120_get_state(&stateNum);
+        cc1120_get_state(&radio, &stateNum);
         Serial.print("State number: ");
         Serial.println(stateNum);
-        cc1120_get_packets_in_tx_fifo(&numPackets);
+        cc1120_get_packets_in_tx_fifo(&radio, &numPackets);
         Serial.print("Num packets in TX FIFO: ");
         Serial.println(numPackets);
 
         delay(1000);
     }
+
+    log_stats();
+    radioReady = true;
 }
 
 /**
- * @brief Empty loop.
+ * @brief Listens for packets. The radio leaves RX after each one: PKT_CRC_OK rises for a good packet, and
+ * PKT_SYNC_RXTX falls at the end of any packet, so a CRC failure is read and dropped too.
  * 
  */
 void loop() {
+    static bool listening;
+    static uint8_t received;
+    static uint8_t ended;
+    static uint32_t statsMs;
+    uint8_t rxData[CC1120_MAX_PACKET_LEN];
+    uint8_t rxStatus[2];
+    uint8_t len;
+
+    if (!radioReady)
+        return;
+
+    if (millis() - statsMs >= STATS_PERIOD_MS) {
+        statsMs = millis();
+        log_stats();
+    }
+
+    if (!listening) {
+        received = packetsReceived;
+        ended = packetsDone;
+        if (cc1120_strobe_spi(&radio, CC1120_STROBE_SRX) != CC1120_ERROR_CODE_SUCCESS)
+            return;
+        listening = true;
+    }
+
+    if (packetsReceived == received && packetsDone == ended)
+        return;
+
+    cc1120_status_code status = cc1120_receive(&radio, rxData, sizeof(rxData), &len, rxStatus);
+    listening = false;
+    if (status != CC1120_ERROR_CODE_SUCCESS) {
+        Serial.print("Receive failed: ");
+        Serial.println(status);
+        return;
+    }
 
+    Serial.print("Received ");
+    Serial.print(len);
+    Serial.print(" bytes, sync at ");
+    Serial.print(packetSyncUs);
+    Serial.print(" us, RSSI ");
+    Serial.println((int8_t)rxStatus[0]);
 }
 
 /**
@@ -132,27 +301,167 @@ void arduino_serial_log(cc1120_log_level_t level, char str[]) {
 /**
  * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
  * 
+ * @param bus - The bus handle of the device.
  * @param data - Data to transfer 
  * @return uint8_t - Data received from CC1120
  */
-uint8_t arduino_cc1120_spi_transfer(uint8_t data) {
+uint8_t arduino_cc1120_spi_transfer(void *bus, uint8_t data) {
     return SPI.transfer(data);
 }
 
+/**
+ * @brief Transfers a block of bytes over CC1120 SPI interface
+ * 
+ * @param bus - The bus handle of the device.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+void arduino_cc1120_spi_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    cc1120_platform_spi_transfer_block(bus, tx, rx, len);
+}
+
 /**
  * @brief Pulls the CS pin low.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
  */
-void arduino_cc1120_cs_assert() {
-    digitalWrite(CC1120_CS, LOW);
+void arduino_cc1120_cs_assert(void *bus, uint8_t csPin) {
+    digitalWrite(csPin, LOW);
     return;
 }
 
 /**
  * @brief Pulls the CS pin high.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
  */
-void arduino_cc1120_cs_deassert() {
-    digitalWrite(CC1120_CS, HIGH);
+void arduino_cc1120_cs_deassert(void *bus, uint8_t csPin) {
+    digitalWrite(csPin, HIGH);
     return;
 }
+
+/**
+ * @brief Sets the SPI clock.
+ * 
+ * @param bus - The bus handle of the device.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz.
+ */
+uint32_t arduino_cc1120_spi_set_clock(void *bus, uint32_t hz) {
+    return cc1120_platform_spi_set_clock(bus, hz);
+}
+
+/**
+ * @brief Reads the level of one of the CC1120 GPIO pins.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @return uint8_t - 1 if the pin is high, 0 if it is low.
+ */
+uint8_t arduino_cc1120_gpio_read(uint8_t gpio) {
+    if (gpio > 3)
+        return 0;
+    return digitalRead(CC1120_GPIO[gpio]) == HIGH;
+}
+
+/**
+ * @brief Forwards the change interrupt of one CC1120 GPIO pin to its dispatcher.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ */
+static void arduino_cc1120_gpio_isr(uint8_t gpio) {
+    cc1120_gpio_dispatch(arduinoGpioDispatcher[gpio], gpio, digitalRead(CC1120_GPIO[gpio]) == HIGH);
+}
+
+static void arduino_cc1120_gpio_isr0() { arduino_cc1120_gpio_isr(0); }
+static void arduino_cc1120_gpio_isr1() { arduino_cc1120_gpio_isr(1); }
+static void arduino_cc1120_gpio_isr2() { arduino_cc1120_gpio_isr(2); }
+static void arduino_cc1120_gpio_isr3() { arduino_cc1120_gpio_isr(3); }
+
+static void (*const ARDUINO_CC1120_GPIO_ISR[4])() = {
+    arduino_cc1120_gpio_isr0,
+    arduino_cc1120_gpio_isr1,
+    arduino_cc1120_gpio_isr2,
+    arduino_cc1120_gpio_isr3,
+};
+
+/**
+ * @brief Routes the change interrupt of one of the CC1120 GPIO pins to a dispatcher.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @param dispatcher - The dispatcher to call cc1120_gpio_dispatch on, or NULL to detach the interrupt.
+ */
+void arduino_cc1120_gpio_attach(uint8_t gpio, cc1120_gpio_dispatcher_t *dispatcher) {
+    if (gpio > 3)
+        return;
+
+    uint8_t irq = digitalPinToInterrupt(CC1120_GPIO[gpio]);
+    detachInterrupt(irq);
+    arduinoGpioDispatcher[gpio] = dispatcher;
+    if (dispatcher != NULL)
+        attachInterrupt(irq, ARDUINO_CC1120_GPIO_ISR[gpio], CHANGE);
+}
+
+/**
+ * @brief Gets the number of microseconds since the board started.
+ * 
+ * @return uint32_t - The current time in microseconds.
+ */
+uint32_t arduino_get_time_us() {
+    return micros();
+}
+
+static void (*arduinoTimerCallback)(void *ctx);
+static void *arduinoTimerCtx;
+
+/**
+ * @brief Calls a function from a one-shot timer interrupt at a given time.
+ * Uses Timer1 with 0.5 us ticks up to 32 ms ahead, and 4 us ticks up to 262 ms ahead.
+ * 
+ * @param atUs - The micros() time to call it at.
+ * @param callback - The function to call from the interrupt.
+ * @param ctx - Passed to the callback.
+ * @return true - If the timer was started.
+ * @return false - If the platform has no timer, or the time is out of its range.
+ */
+bool arduino_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx) {
+    int32_t delayUs = (int32_t)(atUs - micros());
+    if (delayUs < 0)
+        return false;
+
+    // 16 MHz clock: prescaler 8 gives 0.5 us ticks, prescaler 64 gives 4 us ticks
+    uint32_t ticks = (uint32_t)delayUs * 2;
+    uint8_t prescaler = _BV(CS11);
+    if (ticks > 0xFFFFU) {
+        ticks = (uint32_t)delayUs / 4;
+        prescaler = _BV(CS11) | _BV(CS10);
+        if (ticks > 0xFFFFU)
+            return false;
+    }
+
+    noInterrupts();
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TCNT1 = 0;
+    OCR1A = ticks > 0 ? ticks : 1;
+    arduinoTimerCallback = callback;
+    arduinoTimerCtx = ctx;
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 = _BV(OCIE1A);
+    TCCR1B = prescaler;
+    interrupts();
+
+    return true;
+}
+
+/**
+ * @brief Stops Timer1 and calls the callback given to arduino_timer_at.
+ * 
+ */
+ISR(TIMER1_COMPA_vect) {
+    TIMSK1 = 0;
+    TCCR1B = 0;
+    arduinoTimerCallback(arduinoTimerCtx);
+}
@@ -0,0 +1,462 @@
+#include "cc1120_co.h"
+#include "cc1120_regs.h"
+#include "cc1120_spi.h"
+#include "cc1120_txrx.h"
+#include "cc1120_rate.h"
+#include <string.h>
+
+/* Event that never fires, for waits that only end at their deadline */
+static cc1120_co_event_t cc1120_co_never;
+
+/**
+ * @brief Initializes an executor with every slot free.
+ *
+ * @param exec - The executor.
+ */
+void cc1120_co_exec_init(cc1120_co_exec_t *exec) {
+    memset(exec, 0, sizeof(*exec));
+
+    uint16_t i;
+    for (i = CC1120_CO_MAX_TASKS; i > 0; i--) {
+        cc1120_co_t *co = &exec->tasks[i - 1];
+        co->frame = exec->frames[i - 1];
+        co->exec = exec;
+        co->next = exec->free;
+        exec->free = co;
+    }
+}
+
+/**
+ * @brief Starts a coroutine. It first runs on the next pass of the executor.
+ *
+ * @param exec - The executor.
+ * @param fn - The coroutine body.
+ * @param frameLen - The bytes of co->frame the coroutine needs.
+ * @return cc1120_co_t* - The coroutine, to fill in its frame, or NULL if no slot is free or frameLen is too big.
+ */
+cc1120_co_t *cc1120_co_spawn(cc1120_co_exec_t *exec, void (*fn)(cc1120_co_t *co), uint16_t frameLen) {
+    cc1120_co_t *co = exec->free;
+
+    if (frameLen > CC1120_CO_FRAME_SIZE)
+        return NULL;
+
+    if (co == NULL) {
+        exec->stats.exhausted++;
+        return NULL;
+    }
+
+    exec->free = co->next;
+    memset(co->frame, 0, CC1120_CO_FRAME_SIZE);
+    co->fn = fn;
+    co->wake = NULL;
+    co->line = 0;
+    co->done = false;
+    co->result = CC1120_ERROR_CODE_SUCCESS;
+    memset(&co->wait, 0, sizeof(co->wait));
+
+    // At the head, so a coroutine spawned during a pass waits for the next one
+    co->next = exec->live;
+    exec->live = co;
+    exec->count++;
+    exec->stats.spawned++;
+    if (exec->count > exec->stats.highWater)
+        exec->stats.highWater = exec->count;
+
+    return co;
+}
+
+/**
+ * @brief Checks whether the wait of a coroutine has finished, polling its operation if it may have.
+ *
+ * @param co - The coroutine, waiting.
+ * @param nowUs - The current time.
+ * @return true - If the wait finished, with co->result set.
+ */
+static bool cc1120_co_wait_done(cc1120_co_t *co, uint32_t nowUs) {
+    cc1120_co_wait_t *wait = &co->wait;
+    bool timedOut = wait->timeoutUs != 0 && nowUs - wait->startUs >= wait->timeoutUs;
+    bool fired = wait->event == NULL || !wait->polled || wait->event->seq != wait->eventSeq;
+
+    if (!fired && !timedOut)
+        return false;
+
+    if (wait->event != NULL)
+        wait->eventSeq = wait->event->seq;
+    wait->polled = true;
+    co->exec->stats.polls++;
+
+    // Something that happened just as the deadline passed still counts
+    if (fired && wait->poll(co, false))
+        return true;
+
+    return timedOut && wait->poll(co, true);
+}
+
+/**
+ * @brief Makes one pass over the live coroutines, resuming those that are not waiting or whose wait finished.
+ *
+ * @param exec - The executor.
+ * @param nowUs - The current time, e.g. mcu_get_time_us(), for deadlines.
+ * @return uint16_t - The number of coroutines still live.
+ */
+uint16_t cc1120_co_exec_run(cc1120_co_exec_t *exec, uint32_t nowUs) {
+    cc1120_co_t **link = &exec->live;
+
+    exec->nowUs = nowUs;
+    while (*link != NULL) {
+        cc1120_co_t *co = *link;
+
+        if (co->wait.poll != NULL && !cc1120_co_wait_done(co, nowUs)) {
+            link = &co->next;
+            continue;
+        }
+
+        co->wait.poll = NULL;
+        exec->stats.resumes++;
+        co->fn(co);
+
+        if (co->done) {
+            *link = co->next;
+            co->next = exec->free;
+            exec->free = co;
+            exec->count--;
+            exec->stats.finished++;
+            continue;
+        }
+
+        link = &co->next;
+    }
+
+    return exec->count;
+}
+
+/**
+ * @brief GPIO handler that fires the cc1120_co_event_t given as ctx to cc1120_gpio_map.
+ *
+ * @param ctx - The event.
+ * @param gpio - Unused.
+ * @param level - Unused.
+ * @param timeUs - Unused.
+ */
+void cc1120_co_gpio_handler(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs) {
+    (void)gpio;
+    (void)level;
+    (void)timeUs;
+
+    cc1120_co_event_fire((cc1120_co_event_t *)ctx);
+}
+
+/**
+ * @brief Fires an event, e.g. from an ISR.
+ *
+ * @param event - The event.
+ */
+void cc1120_co_event_fire(cc1120_co_event_t *event) {
+    event->seq++;
+}
+
+/**
+ * @brief Makes a coroutine wait on an operation.
+ *
+ * @param co - The coroutine.
+ * @param poll - The operation's poll function.
+ * @param event - The event to poll after, or NULL to poll on every pass.
+ * @param timeoutUs - The deadline from now, 0 for none.
+ */
+static void cc1120_co_wait_on(cc1120_co_t *co, cc1120_co_poll_t poll, cc1120_co_event_t *event, uint32_t timeoutUs) {
+    cc1120_co_wait_t *wait = &co->wait;
+
+    wait->poll = poll;
+    wait->event = event;
+    wait->eventSeq = (event != NULL) ? event->seq : 0;
+    wait->polled = false;
+    wait->startUs = co->exec->nowUs;
+    wait->timeoutUs = timeoutUs;
+}
+
+/**
+ * @brief Finishes an operation with a result.
+ *
+ * @param co - The coroutine.
+ * @param status - The result.
+ * @return true - Always, for returning from a poll function.
+ */
+static bool cc1120_co_finish(cc1120_co_t *co, cc1120_status_code status) {
+    co->result = status;
+    return true;
+}
+
+/**
+ * @brief Polls a send: done once MARC_STATUS1 shows TX_DONE, or the radio has left TX after being seen in it.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the deadline has passed.
+ * @return true - If the send finished.
+ */
+static bool cc1120_co_poll_send(cc1120_co_t *co, bool timedOut) {
+    cc1120_dev_t *dev = co->wait.dev;
+    cc1120_status_code status;
+    uint8_t state;
+
+    status = cc1120_get_state(dev, &state);
+    if (status != CC1120_ERROR_CODE_SUCCESS)
+        return cc1120_co_finish(co, status);
+
+    if (state == CC1120_MARCSTATE_TX_FIFO_ERR) {
+        status = cc1120_fifo_recover(dev);
+        return cc1120_co_finish(co, status != CC1120_ERROR_CODE_SUCCESS ? status : CC1120_ERROR_CODE_FIFO_ERROR);
+    }
+
+    if (state == CC1120_MARCSTATE_TX) {
+        co->wait.arg = 1;
+    } else if (state == CC1120_MARCSTATE_IDLE || state == CC1120_MARCSTATE_FSTXON || state == CC1120_MARCSTATE_RX) {
+        // Right after STX the radio can still read as IDLE, so only TX_DONE ends the send. With TXOFF_MODE
+        // RX, a received packet can replace TX_DONE before this poll, hence also the TX seen earlier.
+        uint8_t marcStatus;
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARC_STATUS1, &marcStatus, 1);
+        if (status != CC1120_ERROR_CODE_SUCCESS)
+            return cc1120_co_finish(co, status);
+        if (marcStatus == CC1120_MARC_STATUS1_TX_DONE || co->wait.arg != 0)
+            return cc1120_co_finish(co, CC1120_ERROR_CODE_SUCCESS);
+    }
+
+    if (!timedOut)
+        return false;
+
+    // Stop the packet and drop what is left of it, so the next send starts clean
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    if (status == CC1120_ERROR_CODE_SUCCESS)
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SFTX);
+    return cc1120_co_finish(co, status != CC1120_ERROR_CODE_SUCCESS ? status : CC1120_ERROR_CODE_STATE_TIMEOUT);
+}
+
+/**
+ * @brief Operation that sends a packet with cc1120_send and waits for MARC_STATUS1 to show TX_DONE.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param data - The packet, which must stay valid until the wait ends.
+ * @param len - The size of the packet.
+ * @param timeoutUs - The longest the packet may take, 0 for no limit.
+ * @return cc1120_status_code - The error from cc1120_send, else success and the result on resuming:
+ * success, CC1120_ERROR_CODE_FIFO_ERROR after a recovered TX FIFO error, or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_send(cc1120_co_t *co, cc1120_dev_t *dev, uint8_t *data, uint32_t len, uint32_t timeoutUs) {
+    uint8_t marcStatus;
+
+    // Reading MARC_STATUS1 clears it, so a TX_DONE left from an earlier packet is not taken for this one
+    cc1120_status_code status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARC_STATUS1, &marcStatus, 1);
+    RETURN_IF_ERROR(status)
+    status = cc1120_send(dev, data, len);
+    RETURN_IF_ERROR(status)
+
+    co->wait.dev = dev;
+    co->wait.arg = 0;
+    cc1120_co_wait_on(co, cc1120_co_poll_send, co->wake, timeoutUs);
+    return status;
+}
+
+/**
+ * @brief Polls a receive: done once the radio has left RX with a packet in the RX FIFO.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the deadline has passed.
+ * @return true - If the receive finished.
+ */
+static bool cc1120_co_poll_receive(cc1120_co_t *co, bool timedOut) {
+    cc1120_dev_t *dev = co->wait.dev;
+    cc1120_status_code status;
+    uint8_t state;
+
+    status = cc1120_get_state(dev, &state);
+    if (status != CC1120_ERROR_CODE_SUCCESS)
+        return cc1120_co_finish(co, status);
+
+    if (state == CC1120_MARCSTATE_RX_FIFO_ERR) {
+        status = cc1120_fifo_recover(dev);
+        return cc1120_co_finish(co, status != CC1120_ERROR_CODE_SUCCESS ? status : CC1120_ERROR_CODE_FIFO_ERROR);
+    }
+
+    if (state == CC1120_MARCSTATE_IDLE || state == CC1120_MARCSTATE_FSTXON) {
+        uint8_t numBytes;
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_NUM_RXBYTES, &numBytes, 1);
+        if (status != CC1120_ERROR_CODE_SUCCESS)
+            return cc1120_co_finish(co, status);
+
+        // cc1120_receive also counts the packet in the link statistics
+        if (numBytes > 0)
+            return cc1120_co_finish(co, cc1120_receive(dev, co->wait.buf, co->wait.max, co->wait.lenOut, co->rxStatus));
+
+        // The packet was flushed for failing CRC, so listen for the next one
+        if (!timedOut) {
+            status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+            if (status != CC1120_ERROR_CODE_SUCCESS)
+                return cc1120_co_finish(co, status);
+            return false;
+        }
+    }
+
+    if (!timedOut)
+        return false;
+
+    *co->wait.lenOut = 0;
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    if (status == CC1120_ERROR_CODE_SUCCESS)
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SFRX);
+    return cc1120_co_finish(co, status != CC1120_ERROR_CODE_SUCCESS ? status : CC1120_ERROR_CODE_STATE_TIMEOUT);
+}
+
+/**
+ * @brief Operation that enters RX and waits for a packet. Packets removed by CRC_AUTOFLUSH are skipped.
+ * The radio must leave RX at the end of a packet, so RFEND_CFG1.RXOFF_MODE must not be RX.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param buf - Filled with the payload, without the length byte.
+ * @param max - The size of buf.
+ * @param len - Set to the payload length.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - The error from SRX, else success and the result on resuming:
+ * success, CC1120_ERROR_CODE_CRC_FAILED with the payload if the appended status shows a CRC failure,
+ * CC1120_ERROR_CODE_INVALID_PARAM if the packet did not fit in buf, CC1120_ERROR_CODE_FIFO_ERROR after a
+ * recovered RX FIFO error, or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_receive(cc1120_co_t *co, cc1120_dev_t *dev, uint8_t buf[], uint8_t max, uint8_t *len,
+                                     uint32_t timeoutUs) {
+    cc1120_status_code status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+    RETURN_IF_ERROR(status)
+
+    co->wait.dev = dev;
+    co->wait.buf = buf;
+    co->wait.max = max;
+    co->wait.lenOut = len;
+    cc1120_co_wait_on(co, cc1120_co_poll_receive, co->wake, timeoutUs);
+    return status;
+}
+
+/**
+ * @brief Polls a FIFO threshold.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the deadline has passed.
+ * @return true - If the threshold was reached or the wait timed out.
+ */
+static bool cc1120_co_poll_fifo(cc1120_co_t *co, bool timedOut) {
+    cc1120_co_wait_t *wait = &co->wait;
+    bool rx = wait->max != 0;
+    uint8_t numBytes;
+
+    cc1120_status_code status = cc1120_read_ext_addr_spi(wait->dev, rx ? CC1120_REGS_EXT_NUM_RXBYTES :
+                                                         CC1120_REGS_EXT_NUM_TXBYTES, &numBytes, 1);
+    if (status != CC1120_ERROR_CODE_SUCCESS)
+        return cc1120_co_finish(co, status);
+
+    if (rx ? numBytes >= wait->arg : numBytes <= wait->arg)
+        return cc1120_co_finish(co, CC1120_ERROR_CODE_SUCCESS);
+
+    return timedOut && cc1120_co_finish(co, CC1120_ERROR_CODE_STATE_TIMEOUT);
+}
+
+/**
+ * @brief Operation that waits for the RX FIFO to hold at least, or the TX FIFO at most, a number of bytes.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param rx - true for the RX FIFO, false for the TX FIFO.
+ * @param threshold - The number of bytes.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - Success, and on resuming success or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_fifo(cc1120_co_t *co, cc1120_dev_t *dev, bool rx, uint8_t threshold, uint32_t timeoutUs) {
+    co->wait.dev = dev;
+    co->wait.max = rx ? 1 : 0;
+    co->wait.arg = threshold;
+    cc1120_co_wait_on(co, cc1120_co_poll_fifo, co->wake, timeoutUs);
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Polls for a MARCSTATE.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the deadline has passed.
+ * @return true - If the state was reached or the wait timed out.
+ */
+static bool cc1120_co_poll_state(cc1120_co_t *co, bool timedOut) {
+    uint8_t state;
+
+    cc1120_status_code status = cc1120_get_state(co->wait.dev, &state);
+    if (status != CC1120_ERROR_CODE_SUCCESS)
+        return cc1120_co_finish(co, status);
+
+    if (state == co->wait.arg)
+        return cc1120_co_finish(co, CC1120_ERROR_CODE_SUCCESS);
+
+    return timedOut && cc1120_co_finish(co, CC1120_ERROR_CODE_STATE_TIMEOUT);
+}
+
+/**
+ * @brief Operation that waits for the radio to reach a MARCSTATE.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param marcState - The MARCSTATE value, CC1120_MARCSTATE_*.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - Success, and on resuming success or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_state(cc1120_co_t *co, cc1120_dev_t *dev, uint8_t marcState, uint32_t timeoutUs) {
+    co->wait.dev = dev;
+    co->wait.arg = marcState;
+    cc1120_co_wait_on(co, cc1120_co_poll_state, co->wake, timeoutUs);
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Polls an event wait, which is only polled once the event fired or the deadline passed.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the deadline has passed.
+ * @return true - Always.
+ */
+static bool cc1120_co_poll_event(cc1120_co_t *co, bool timedOut) {
+    return cc1120_co_finish(co, timedOut ? CC1120_ERROR_CODE_STATE_TIMEOUT : CC1120_ERROR_CODE_SUCCESS);
+}
+
+/**
+ * @brief Operation that waits for an event to fire.
+ *
+ * @param co - The coroutine.
+ * @param event - The event.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - Success, and on resuming success or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_event(cc1120_co_t *co, cc1120_co_event_t *event, uint32_t timeoutUs) {
+    cc1120_co_wait_on(co, cc1120_co_poll_event, event, timeoutUs);
+    // Nothing to check until the event fires
+    co->wait.polled = true;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Polls a sleep, which only finishes at its deadline.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the time has passed.
+ * @return true - If the time has passed.
+ */
+static bool cc1120_co_poll_sleep(cc1120_co_t *co, bool timedOut) {
+    return timedOut && cc1120_co_finish(co, CC1120_ERROR_CODE_SUCCESS);
+}
+
+/**
+ * @brief Operation that waits for a time to pass.
+ *
+ * @param co - The coroutine.
+ * @param us - The time, at least 1.
+ * @return cc1120_status_code - Success.
+ */
+cc1120_status_code cc1120_co_sleep(cc1120_co_t *co, uint32_t us) {
+    cc1120_co_wait_on(co, cc1120_co_poll_sleep, &cc1120_co_never, us != 0 ? us : 1);
+    co->wait.polled = true;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
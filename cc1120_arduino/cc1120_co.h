@@ -0,0 +1,256 @@
+#ifndef CC1120_CO_H
+#define CC1120_CO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/*
+ * Stackless coroutines over the driver, for protocol code that would otherwise be a hand-written state
+ * machine or block in delays. A coroutine is a function that is resumed from where it last waited:
+ *
+ *   static void ping(cc1120_co_t *co) {
+ *       ping_t *p = co->frame;
+ *       CC1120_CO_BEGIN(co);
+ *       for (p->i = 0; p->i < 10; p->i++) {
+ *           CC1120_CO_AWAIT(co, cc1120_co_send(co, p->dev, p->buf, 20, 100000));
+ *           CC1120_CO_AWAIT(co, cc1120_co_receive(co, p->dev, p->buf, sizeof(p->buf), &p->len, 100000));
+ *           if (co->result != CC1120_ERROR_CODE_SUCCESS)
+ *               break;
+ *       }
+ *       CC1120_CO_END(co);
+ *   }
+ *
+ * Locals do not survive an await, so a coroutine keeps its state in co->frame, which the executor hands
+ * out from a static arena. The executor is single-threaded and never allocates: call cc1120_co_exec_run
+ * from the main loop. A waiting coroutine costs a compare per pass while its wake event has not fired,
+ * so thousands of them, e.g. one per emulated link on the host, are cheap.
+ *
+ * Radio operations wait by polling the radio on each pass. Set co->wake to an event fired from a GPIO
+ * edge with cc1120_co_gpio_handler, e.g. PKT_SYNC_RXTX, to poll only after an edge instead.
+ * SPI transfers themselves are synchronous.
+ */
+
+/* Coroutines one executor runs at once */
+#ifndef CC1120_CO_MAX_TASKS
+#define CC1120_CO_MAX_TASKS 8U
+#endif
+
+/* Bytes of co->frame, a multiple of 8 */
+#ifndef CC1120_CO_FRAME_SIZE
+#define CC1120_CO_FRAME_SIZE 64U
+#endif
+
+#if CC1120_CO_FRAME_SIZE % 8 != 0
+#error "CC1120_CO_FRAME_SIZE must be a multiple of 8"
+#endif
+
+/* Starts the body of a coroutine */
+#define CC1120_CO_BEGIN(co) switch ((co)->line) { case 0:
+
+/* Ends the body of a coroutine. The executor frees it once it returns. */
+#define CC1120_CO_END(co) } (co)->done = true; return
+
+/* Lets the other coroutines run, and resumes on the next pass */
+#define CC1120_CO_YIELD(co)                                                                 \
+    do {                                                                                    \
+        (co)->line = __LINE__;                                                              \
+        return;                                                                             \
+    case __LINE__:;                                                                         \
+    } while (0)
+
+/*
+ * Starts an operation and waits for it. co->result is the error if it failed to start,
+ * else the result it finished with.
+ */
+#define CC1120_CO_AWAIT(co, op)                                                             \
+    do {                                                                                    \
+        if (((co)->result = (op)) == CC1120_ERROR_CODE_SUCCESS && (co)->wait.poll != NULL) { \
+            (co)->line = __LINE__;                                                          \
+            return;                                                                         \
+        case __LINE__:;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+/* Counter a GPIO handler or ISR bumps to wake the coroutines waiting on it */
+typedef struct {
+    volatile uint32_t seq;
+} cc1120_co_event_t;
+
+typedef struct cc1120_co cc1120_co_t;
+
+/**
+ * @brief Checks whether the operation a coroutine waits on has finished, and finishes it.
+ *
+ * @param co - The coroutine.
+ * @param timedOut - Whether the deadline has passed. The operation must then clean up and finish.
+ * @return true - If the operation finished, with co->result set.
+ */
+typedef bool (*cc1120_co_poll_t)(cc1120_co_t *co, bool timedOut);
+
+typedef struct {
+    cc1120_co_poll_t poll;      /* NULL when not waiting */
+    cc1120_co_event_t *event;   /* Poll only after this fires, or NULL to poll on every pass */
+    uint32_t eventSeq;
+    bool polled;                /* Polled at least once, which happens whether or not the event fired */
+    uint32_t startUs;
+    uint32_t timeoutUs;         /* 0 for none */
+    cc1120_dev_t *dev;
+    uint8_t *buf;
+    uint8_t *lenOut;
+    uint8_t max;                /* Size of buf, or 1 for an RX FIFO threshold */
+    uint8_t arg;                /* Threshold, state or TX seen, by operation */
+} cc1120_co_wait_t;
+
+struct cc1120_co_exec;
+
+struct cc1120_co {
+    void (*fn)(cc1120_co_t *co);
+    void *frame;                /* CC1120_CO_FRAME_SIZE bytes for the coroutine's state, zeroed at spawn */
+    struct cc1120_co_exec *exec;
+    cc1120_co_t *next;          /* In the live or free list */
+    cc1120_co_event_t *wake;    /* Event radio operations wait on, or NULL to poll */
+    uint16_t line;              /* Resume point */
+    bool done;
+    cc1120_status_code result;  /* Result of the last await */
+    uint8_t rxStatus[2];        /* RSSI and CRC_OK/LQI of the last packet received, if appended */
+    cc1120_co_wait_t wait;
+};
+
+typedef struct {
+    uint32_t spawned;
+    uint32_t finished;
+    uint32_t exhausted;         /* Spawns refused because every slot was in use */
+    uint32_t resumes;
+    uint32_t polls;
+    uint16_t highWater;         /* Most coroutines live at once */
+} cc1120_co_stats_t;
+
+typedef struct cc1120_co_exec {
+    cc1120_co_t tasks[CC1120_CO_MAX_TASKS];
+    uint64_t frames[CC1120_CO_MAX_TASKS][CC1120_CO_FRAME_SIZE / 8];
+    cc1120_co_t *live;
+    cc1120_co_t *free;
+    uint16_t count;
+    uint32_t nowUs;
+    cc1120_co_stats_t stats;
+} cc1120_co_exec_t;
+
+/**
+ * @brief Initializes an executor with every slot free.
+ *
+ * @param exec - The executor.
+ */
+void cc1120_co_exec_init(cc1120_co_exec_t *exec);
+
+/**
+ * @brief Starts a coroutine. It first runs on the next pass of the executor.
+ *
+ * @param exec - The executor.
+ * @param fn - The coroutine body.
+ * @param frameLen - The bytes of co->frame the coroutine needs.
+ * @return cc1120_co_t* - The coroutine, to fill in its frame, or NULL if no slot is free or frameLen is too big.
+ */
+cc1120_co_t *cc1120_co_spawn(cc1120_co_exec_t *exec, void (*fn)(cc1120_co_t *co), uint16_t frameLen);
+
+/**
+ * @brief Makes one pass over the live coroutines, resuming those that are not waiting or whose wait finished.
+ *
+ * @param exec - The executor.
+ * @param nowUs - The current time, e.g. mcu_get_time_us(), for deadlines.
+ * @return uint16_t - The number of coroutines still live.
+ */
+uint16_t cc1120_co_exec_run(cc1120_co_exec_t *exec, uint32_t nowUs);
+
+/**
+ * @brief GPIO handler that fires the cc1120_co_event_t given as ctx to cc1120_gpio_map.
+ *
+ * @param ctx - The event.
+ * @param gpio - Unused.
+ * @param level - Unused.
+ * @param timeUs - Unused.
+ */
+void cc1120_co_gpio_handler(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs);
+
+/**
+ * @brief Fires an event, e.g. from an ISR.
+ *
+ * @param event - The event.
+ */
+void cc1120_co_event_fire(cc1120_co_event_t *event);
+
+/**
+ * @brief Operation that sends a packet with cc1120_send and waits for MARC_STATUS1 to show TX_DONE.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param data - The packet, which must stay valid until the wait ends.
+ * @param len - The size of the packet.
+ * @param timeoutUs - The longest the packet may take, 0 for no limit.
+ * @return cc1120_status_code - The error from cc1120_send, else success and the result on resuming:
+ * success, CC1120_ERROR_CODE_FIFO_ERROR after a recovered TX FIFO error, or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_send(cc1120_co_t *co, cc1120_dev_t *dev, uint8_t *data, uint32_t len, uint32_t timeoutUs);
+
+/**
+ * @brief Operation that enters RX and waits for a packet. Packets removed by CRC_AUTOFLUSH are skipped.
+ * The radio must leave RX at the end of a packet, so RFEND_CFG1.RXOFF_MODE must not be RX.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param buf - Filled with the payload, without the length byte.
+ * @param max - The size of buf.
+ * @param len - Set to the payload length.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - The error from SRX, else success and the result on resuming:
+ * success, CC1120_ERROR_CODE_CRC_FAILED with the payload if the appended status shows a CRC failure,
+ * CC1120_ERROR_CODE_INVALID_PARAM if the packet did not fit in buf, CC1120_ERROR_CODE_FIFO_ERROR after a
+ * recovered RX FIFO error, or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_receive(cc1120_co_t *co, cc1120_dev_t *dev, uint8_t buf[], uint8_t max, uint8_t *len,
+                                     uint32_t timeoutUs);
+
+/**
+ * @brief Operation that waits for the RX FIFO to hold at least, or the TX FIFO at most, a number of bytes.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param rx - true for the RX FIFO, false for the TX FIFO.
+ * @param threshold - The number of bytes.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - Success, and on resuming success or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_fifo(cc1120_co_t *co, cc1120_dev_t *dev, bool rx, uint8_t threshold, uint32_t timeoutUs);
+
+/**
+ * @brief Operation that waits for the radio to reach a MARCSTATE.
+ *
+ * @param co - The coroutine.
+ * @param dev - The CC1120 to talk to.
+ * @param marcState - The MARCSTATE value, CC1120_MARCSTATE_*.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - Success, and on resuming success or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_state(cc1120_co_t *co, cc1120_dev_t *dev, uint8_t marcState, uint32_t timeoutUs);
+
+/**
+ * @brief Operation that waits for an event to fire.
+ *
+ * @param co - The coroutine.
+ * @param event - The event.
+ * @param timeoutUs - The longest to wait, 0 for no limit.
+ * @return cc1120_status_code - Success, and on resuming success or CC1120_ERROR_CODE_STATE_TIMEOUT.
+ */
+cc1120_status_code cc1120_co_event(cc1120_co_t *co, cc1120_co_event_t *event, uint32_t timeoutUs);
+
+/**
+ * @brief Operation that waits for a time to pass.
+ *
+ * @param co - The coroutine.
+ * @param us - The time, at least 1.
+ * @return cc1120_status_code - Success.
+ */
+cc1120_status_code cc1120_co_sleep(cc1120_co_t *co, uint32_t us);
+
+#endif /* CC1120_CO_H */
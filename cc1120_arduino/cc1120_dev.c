@@ -0,0 +1,17 @@
+#include "cc1120_dev.h"
+#include <string.h>
+
+/**
+ * @brief Initializes a device handle on a transport. Does not talk to the radio.
+ *
+ * @param dev - The device to initialize.
+ * @param ops - The transport primitives for the bus the radio is on.
+ * @param bus - The platform bus handle passed to every transport call.
+ * @param csPin - The chip select line of this radio.
+ */
+void cc1120_dev_init(cc1120_dev_t *dev, const cc1120_transport_ops_t *ops, void *bus, uint8_t csPin) {
+    memset(dev, 0, sizeof(*dev));
+    dev->ops = ops;
+    dev->bus = bus;
+    dev->csPin = csPin;
+}
@@ -0,0 +1,83 @@
+#ifndef CC1120_DEV_H
+#define CC1120_DEV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* SPI and chip select primitives for one bus. bus is the platform handle stored in the device. */
+typedef struct {
+    uint8_t (*transfer)(void *bus, uint8_t data);
+    void (*csAssert)(void *bus, uint8_t csPin);
+    void (*csDeassert)(void *bus, uint8_t csPin);
+    uint32_t (*setClock)(void *bus, uint32_t hz);   /* Returns the rate applied, at most hz. NULL if fixed. */
+    /* Transfers len bytes, sending zeros if tx is NULL and discarding the data if rx is NULL. NULL to loop on transfer. */
+    void (*transferBlock)(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len);
+} cc1120_transport_ops_t;
+
+/* Kinds of SPI access, which the CC1120 may tolerate at different SCLK rates */
+typedef enum {
+    CC1120_SPI_ACCESS_SINGLE = 0,   /* Single register access and strobes */
+    CC1120_SPI_ACCESS_BURST,        /* Burst register access */
+    CC1120_SPI_ACCESS_EXT,          /* Extended address space access */
+    CC1120_SPI_ACCESS_FIFO,         /* FIFO access, standard and direct */
+    CC1120_SPI_ACCESS_COUNT
+} cc1120_spi_access_t;
+
+/* Driver-side copy of registers that are rewritten on the hot path */
+typedef struct {
+    bool valid;
+    uint8_t pktCfg0;
+    uint8_t pktLen;
+} cc1120_dev_shadow_t;
+
+typedef struct {
+    uint32_t transactions;      /* CS assert/deassert pairs */
+    uint32_t chipReadyRetries;  /* Status bytes with CHIP_RDYn high */
+    uint32_t invalidStatus;     /* Transactions abandoned because the chip never became ready */
+} cc1120_dev_stats_t;
+
+/* FIFO error events, by MARC_STATUS1 cause, and the recoveries that cleared them */
+typedef struct {
+    uint32_t txUnderflows;
+    uint32_t txOverflows;
+    uint32_t rxOverflows;
+    uint32_t rxUnderflows;
+    uint32_t unknown;           /* FIFO error state with no FIFO cause in MARC_STATUS1 */
+    uint32_t recoveries;
+    uint32_t lastRecoveryUs;
+    uint32_t maxRecoveryUs;
+} cc1120_dev_fifo_stats_t;
+
+typedef struct cc1120_stats cc1120_stats_t;
+
+/*
+ * One CC1120. Every driver function that talks to a radio takes a pointer to one of these,
+ * and the driver keeps no other mutable state, so separate devices can be used concurrently
+ * as long as each device is only used from one context at a time. The time source behind
+ * mcu_get_time_us and the log levels are process-wide, but are only read by the driver.
+ * Timeouts run on that shared clock, so a context held off for longer than a timeout may
+ * report it expired even though the radio got there in the meantime.
+ */
+typedef struct {
+    const cc1120_transport_ops_t *ops;
+    void *bus;
+    uint8_t csPin;
+    uint8_t lastStatus;         /* Last status byte received */
+    uint32_t spiClockHz[CC1120_SPI_ACCESS_COUNT];   /* SCLK per access type, 0 to leave the bus as is */
+    cc1120_dev_shadow_t shadow;
+    cc1120_dev_stats_t stats;
+    cc1120_dev_fifo_stats_t fifoStats;
+    cc1120_stats_t *linkStats;  /* Link statistics the driver updates, or NULL, see cc1120_stats_init */
+} cc1120_dev_t;
+
+/**
+ * @brief Initializes a device handle on a transport. Does not talk to the radio.
+ *
+ * @param dev - The device to initialize.
+ * @param ops - The transport primitives for the bus the radio is on.
+ * @param bus - The platform bus handle passed to every transport call.
+ * @param csPin - The chip select line of this radio.
+ */
+void cc1120_dev_init(cc1120_dev_t *dev, const cc1120_transport_ops_t *ops, void *bus, uint8_t csPin);
+
+#endif /* CC1120_DEV_H */
@@ -0,0 +1,218 @@
+#include "cc1120_doppler.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+
+/**
+ * @brief Clamps a value to [-limit, limit].
+ *
+ * @param value - The value to clamp.
+ * @param limit - The positive limit.
+ * @return int32_t - The clamped value.
+ */
+static int32_t cc1120_doppler_clamp(int32_t value, int32_t limit) {
+    if (value > limit)
+        return limit;
+    if (value < -limit)
+        return -limit;
+    return value;
+}
+
+/**
+ * @brief Writes a FREQOFF value to FREQOFF1/0 in one burst.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker to record the written value in.
+ * @param freqOff - The value to write.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
+ * @return An error code - If an SPI transfer failed.
+ */
+static cc1120_status_code cc1120_doppler_write_freqoff(cc1120_dev_t *dev, cc1120_doppler_t *tracker, int16_t freqOff) {
+    uint8_t data[2] = {(uint8_t)((uint16_t)freqOff >> 8), (uint8_t)freqOff};
+    cc1120_status_code status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQOFF1, data, 2);
+    RETURN_IF_ERROR(status)
+
+    tracker->applied = freqOff;
+    return status;
+}
+
+/**
+ * @brief Initializes the tracking loop with zero offset and no Doppler curve.
+ *
+ * @param tracker - The tracker to initialize.
+ * @param gainShift - The loop gain as a power of two. Larger is slower but less noisy.
+ * @param limitHz - The maximum offset the loop may apply, in Hz.
+ */
+void cc1120_doppler_init(cc1120_doppler_t *tracker, uint8_t gainShift, int32_t limitHz) {
+    tracker->freqOff = 0;
+    tracker->txFreqOff = 0;
+    tracker->applied = 0;
+    tracker->limit = cc1120_doppler_hz_to_freqoff(limitHz < 0 ? -limitHz : limitHz);
+    tracker->gainShift = gainShift;
+    tracker->lastEstimate = 0;
+    tracker->updates = 0;
+    tracker->rejected = 0;
+    tracker->curve = 0;
+    tracker->curveLen = 0;
+}
+
+/**
+ * @brief Converts a frequency offset in Hz to FREQOFF/FREQOFF_EST LSBs.
+ *
+ * @param hz - The frequency offset in Hz.
+ * @return int16_t - The offset in LSBs, saturated to the register range.
+ */
+int16_t cc1120_doppler_hz_to_freqoff(int32_t hz) {
+    int64_t scaled = (int64_t)hz * (int64_t)CC1120_FREQOFF_SCALE;
+    int64_t half = (int64_t)(CC1120_XOSC_FREQ_HZ / 2);
+    int64_t lsb = (scaled >= 0 ? scaled + half : scaled - half) / (int64_t)CC1120_XOSC_FREQ_HZ;
+
+    if (lsb > INT16_MAX)
+        return INT16_MAX;
+    if (lsb < -INT16_MAX)
+        return -INT16_MAX;
+    return (int16_t)lsb;
+}
+
+/**
+ * @brief Converts FREQOFF/FREQOFF_EST LSBs to a frequency offset in Hz.
+ *
+ * @param freqOff - The offset in LSBs.
+ * @return int32_t - The offset in Hz.
+ */
+int32_t cc1120_doppler_freqoff_to_hz(int16_t freqOff) {
+    return (int32_t)((int64_t)freqOff * (int64_t)CC1120_XOSC_FREQ_HZ / (int64_t)CC1120_FREQOFF_SCALE);
+}
+
+/**
+ * @brief Applies one frequency estimate to the loop without touching the radio.
+ * The estimate is relative to the currently applied offset, so the loop integrates
+ * est / 2^gainShift, which low-pass filters the true offset.
+ *
+ * @param tracker - The tracker.
+ * @param estimate - The FREQOFF_EST value from the last packet.
+ * @return int16_t - The new FREQOFF value.
+ */
+int16_t cc1120_doppler_step(cc1120_doppler_t *tracker, int16_t estimate) {
+    tracker->lastEstimate = estimate;
+
+    // An estimate beyond the tracking range is almost certainly a false sync, not Doppler
+    if (estimate > 2 * tracker->limit || estimate < -2 * tracker->limit) {
+        tracker->rejected++;
+        return tracker->freqOff;
+    }
+
+    // Round to nearest so the loop settles within 2^(gainShift - 1) LSBs of the true offset
+    int32_t correction = estimate >= 0 ? ((int32_t)estimate + ((1L << tracker->gainShift) >> 1)) >> tracker->gainShift
+                                       : -((-(int32_t)estimate + ((1L << tracker->gainShift) >> 1)) >> tracker->gainShift);
+
+    tracker->updates++;
+    return (int16_t)cc1120_doppler_clamp((int32_t)tracker->freqOff + correction, tracker->limit);
+}
+
+/**
+ * @brief Reads FREQOFF_EST1/0 after a received packet, updates the loop and writes FREQOFF1/0.
+ * Call while the radio is out of RX, e.g. in IDLE after the packet, and after cc1120_doppler_restore_rx
+ * if a transmission was pre-compensated since the last packet.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the offset was updated.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_doppler_update_rx(cc1120_dev_t *dev, cc1120_doppler_t *tracker) {
+    cc1120_status_code status;
+    uint8_t est[2];
+
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FREQOFF_EST1, est, 2);
+    RETURN_IF_ERROR(status)
+
+    tracker->freqOff = cc1120_doppler_step(tracker, (int16_t)(((uint16_t)est[0] << 8) | est[1]));
+    return cc1120_doppler_restore_rx(dev, tracker);
+}
+
+/**
+ * @brief Writes FREQOFF1/0 back to the offset of the RX tracking loop, e.g. after a pre-compensated
+ * transmission. Call before entering RX.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the offset was written, or was already in place.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_doppler_restore_rx(cc1120_dev_t *dev, cc1120_doppler_t *tracker) {
+    if (tracker->applied == tracker->freqOff)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    return cc1120_doppler_write_freqoff(dev, tracker, tracker->freqOff);
+}
+
+/**
+ * @brief Sets a predicted Doppler curve for TX pre-compensation.
+ *
+ * @param tracker - The tracker.
+ * @param curve - The curve points, sorted by time. Must stay valid while in use.
+ * @param curveLen - The number of points.
+ */
+void cc1120_doppler_set_curve(cc1120_doppler_t *tracker, const cc1120_doppler_point_t curve[], uint16_t curveLen) {
+    tracker->curve = curve;
+    tracker->curveLen = curveLen;
+}
+
+/**
+ * @brief Linearly interpolates the predicted Doppler curve.
+ *
+ * @param tracker - The tracker with a curve set.
+ * @param timeMs - The time since the start of the pass.
+ * @return int32_t - The predicted Doppler shift in Hz, held at the end points outside the curve.
+ */
+int32_t cc1120_doppler_curve_at(const cc1120_doppler_t *tracker, uint32_t timeMs) {
+    const cc1120_doppler_point_t *curve = tracker->curve;
+
+    if (tracker->curveLen == 0)
+        return 0;
+    if (timeMs <= curve[0].timeMs)
+        return curve[0].dopplerHz;
+    if (timeMs >= curve[tracker->curveLen - 1].timeMs)
+        return curve[tracker->curveLen - 1].dopplerHz;
+
+    // Binary search for the segment containing timeMs
+    uint16_t lo = 0;
+    uint16_t hi = tracker->curveLen - 1;
+    while (hi - lo > 1) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        if (curve[mid].timeMs <= timeMs)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    int64_t span = (int64_t)(curve[hi].timeMs - curve[lo].timeMs);
+    int64_t delta = (int64_t)curve[hi].dopplerHz - curve[lo].dopplerHz;
+    return curve[lo].dopplerHz + (int32_t)(delta * (int64_t)(timeMs - curve[lo].timeMs) / span);
+}
+
+/**
+ * @brief Writes FREQOFF1/0 to cancel the predicted Doppler shift before a transmission.
+ * The RX tracking loop keeps its own offset, so call cc1120_doppler_restore_rx before going back to RX.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker with a curve set.
+ * @param timeMs - The time since the start of the pass.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the offset was written.
+ * @return An error code - If no curve is set, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_doppler_precompensate_tx(cc1120_dev_t *dev, cc1120_doppler_t *tracker, uint32_t timeMs) {
+    if (tracker->curveLen == 0) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_doppler_precompensate_tx: No Doppler curve set!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // Transmit at f0 - doppler so the ground station receives f0
+    int16_t freqOff = cc1120_doppler_hz_to_freqoff(-cc1120_doppler_curve_at(tracker, timeMs));
+    tracker->txFreqOff = (int16_t)cc1120_doppler_clamp(freqOff, tracker->limit);
+    if (tracker->applied == tracker->txFreqOff)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    return cc1120_doppler_write_freqoff(dev, tracker, tracker->txFreqOff);
+}
@@ -0,0 +1,124 @@
+#ifndef CC1120_DOPPLER_H
+#define CC1120_DOPPLER_H
+
+#include <stdint.h>
+#include "cc1120_logging.h"
+#include "cc1120_txrx.h"
+
+/*
+ * FREQOFF and FREQOFF_EST share the same resolution: f_xosc / (LO divider * 2^18) Hz per LSB.
+ * See sections 9.12 and 6.7 of the user guide.
+ */
+#define CC1120_FREQOFF_SCALE (CC1120_LO_DIVIDER * 262144ULL)
+
+#define CC1120_DOPPLER_DEFAULT_GAIN_SHIFT 2U
+#define CC1120_DOPPLER_DEFAULT_LIMIT_HZ 15000L
+
+typedef struct {
+    uint32_t timeMs;    /* Time since the start of the pass */
+    int32_t dopplerHz;  /* Predicted shift seen by the ground station */
+} cc1120_doppler_point_t;
+
+typedef struct {
+    int16_t freqOff;                        /* Offset of the RX tracking loop */
+    int16_t txFreqOff;                      /* Last TX pre-compensation */
+    int16_t applied;                        /* Value currently written to FREQOFF1/0 */
+    int16_t limit;                          /* Maximum |FREQOFF| in LSBs */
+    uint8_t gainShift;                      /* Loop gain is 1 / 2^gainShift */
+    int16_t lastEstimate;                   /* Last FREQOFF_EST read after a packet */
+    uint32_t updates;                       /* Estimates applied */
+    uint32_t rejected;                      /* Estimates outside the limit, ignored */
+    const cc1120_doppler_point_t *curve;    /* Optional predicted Doppler curve, sorted by time */
+    uint16_t curveLen;
+} cc1120_doppler_t;
+
+/**
+ * @brief Initializes the tracking loop with zero offset and no Doppler curve.
+ *
+ * @param tracker - The tracker to initialize.
+ * @param gainShift - The loop gain as a power of two. Larger is slower but less noisy.
+ * @param limitHz - The maximum offset the loop may apply, in Hz.
+ */
+void cc1120_doppler_init(cc1120_doppler_t *tracker, uint8_t gainShift, int32_t limitHz);
+
+/**
+ * @brief Converts a frequency offset in Hz to FREQOFF/FREQOFF_EST LSBs.
+ *
+ * @param hz - The frequency offset in Hz.
+ * @return int16_t - The offset in LSBs, saturated to the register range.
+ */
+int16_t cc1120_doppler_hz_to_freqoff(int32_t hz);
+
+/**
+ * @brief Converts FREQOFF/FREQOFF_EST LSBs to a frequency offset in Hz.
+ *
+ * @param freqOff - The offset in LSBs.
+ * @return int32_t - The offset in Hz.
+ */
+int32_t cc1120_doppler_freqoff_to_hz(int16_t freqOff);
+
+/**
+ * @brief Applies one frequency estimate to the loop without touching the radio.
+ * The estimate is relative to the currently applied offset, so the loop integrates
+ * est / 2^gainShift, which low-pass filters the true offset.
+ *
+ * @param tracker - The tracker.
+ * @param estimate - The FREQOFF_EST value from the last packet.
+ * @return int16_t - The new FREQOFF value.
+ */
+int16_t cc1120_doppler_step(cc1120_doppler_t *tracker, int16_t estimate);
+
+/**
+ * @brief Reads FREQOFF_EST1/0 after a received packet, updates the loop and writes FREQOFF1/0.
+ * Call while the radio is out of RX, e.g. in IDLE after the packet, and after cc1120_doppler_restore_rx
+ * if a transmission was pre-compensated since the last packet.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the offset was updated.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_doppler_update_rx(cc1120_dev_t *dev, cc1120_doppler_t *tracker);
+
+/**
+ * @brief Sets a predicted Doppler curve for TX pre-compensation.
+ *
+ * @param tracker - The tracker.
+ * @param curve - The curve points, sorted by time. Must stay valid while in use.
+ * @param curveLen - The number of points.
+ */
+void cc1120_doppler_set_curve(cc1120_doppler_t *tracker, const cc1120_doppler_point_t curve[], uint16_t curveLen);
+
+/**
+ * @brief Linearly interpolates the predicted Doppler curve.
+ *
+ * @param tracker - The tracker with a curve set.
+ * @param timeMs - The time since the start of the pass.
+ * @return int32_t - The predicted Doppler shift in Hz, held at the end points outside the curve.
+ */
+int32_t cc1120_doppler_curve_at(const cc1120_doppler_t *tracker, uint32_t timeMs);
+
+/**
+ * @brief Writes FREQOFF1/0 back to the offset of the RX tracking loop, e.g. after a pre-compensated
+ * transmission. Call before entering RX.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the offset was written, or was already in place.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_doppler_restore_rx(cc1120_dev_t *dev, cc1120_doppler_t *tracker);
+
+/**
+ * @brief Writes FREQOFF1/0 to cancel the predicted Doppler shift before a transmission.
+ * The RX tracking loop keeps its own offset, so call cc1120_doppler_restore_rx before going back to RX.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tracker - The tracker with a curve set.
+ * @param timeMs - The time since the start of the pass.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the offset was written.
+ * @return An error code - If no curve is set, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_doppler_precompensate_tx(cc1120_dev_t *dev, cc1120_doppler_t *tracker, uint32_t timeMs);
+
+#endif /* CC1120_DOPPLER_H */
@@ -0,0 +1,430 @@
+#include "cc1120_downlink.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_txrx.h"
+#include "cc1120_fields.h"
+#include <stddef.h>
+#include <string.h>
+
+#define CC1120_DOWNLINK_TOKEN_SCALE 1000000ULL
+
+/**
+ * @brief Adds the tokens earned since the last refill, up to the bucket size.
+ *
+ * @param q - The class queue.
+ * @param nowUs - The current time.
+ */
+static void cc1120_downlink_refill(cc1120_downlink_queue_t *q, uint32_t nowUs) {
+    if (q->cfg.rateBytesPerSec == 0)
+        return;
+
+    uint64_t maxTokens = (uint64_t)q->cfg.burstBytes * CC1120_DOWNLINK_TOKEN_SCALE;
+    q->tokens += (uint64_t)(nowUs - q->refilledUs) * q->cfg.rateBytesPerSec;
+    if (q->tokens > maxTokens)
+        q->tokens = maxTokens;
+    q->refilledUs = nowUs;
+}
+
+/**
+ * @brief Takes the packet at the head of a class queue.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class.
+ * @return cc1120_downlink_pkt_t - The packet.
+ */
+static cc1120_downlink_pkt_t cc1120_downlink_pop(cc1120_downlink_t *dl, uint8_t cls) {
+    cc1120_downlink_queue_t *q = &dl->queues[cls];
+    cc1120_downlink_pkt_t pkt = q->ring[q->head];
+
+    q->head = (q->head + 1) & (CC1120_DOWNLINK_QUEUE_LEN - 1);
+    if (--q->count == 0)
+        dl->pending &= ~(1U << cls);
+
+    return pkt;
+}
+
+/**
+ * @brief Drops the packets at the head of a class queue that are past their maximum age.
+ * The queue is in age order, so only the head needs checking.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class.
+ * @param nowUs - The current time.
+ */
+static void cc1120_downlink_expire(cc1120_downlink_t *dl, uint8_t cls, uint32_t nowUs) {
+    cc1120_downlink_queue_t *q = &dl->queues[cls];
+
+    if (q->cfg.maxAgeUs == 0)
+        return;
+
+    while (q->count > 0 && nowUs - q->ring[q->head].queuedUs >= q->cfg.maxAgeUs) {
+        cc1120_downlink_pkt_t pkt = cc1120_downlink_pop(dl, cls);
+        q->stats.expired++;
+        if (dl->onDone != NULL)
+            dl->onDone(dl->ctx, (cc1120_downlink_class_t)cls, pkt.data, CC1120_ERROR_CODE_EXPIRED);
+    }
+}
+
+/**
+ * @brief Adds a latency to the histogram of a class.
+ *
+ * @param stats - The statistics of the class.
+ * @param latencyUs - The latency.
+ */
+static void cc1120_downlink_record_latency(cc1120_downlink_stats_t *stats, uint32_t latencyUs) {
+    uint8_t bucket = 0;
+    uint32_t boundUs = CC1120_DOWNLINK_HIST_MIN_US;
+
+    while (bucket < CC1120_DOWNLINK_HIST_BUCKETS - 1 && latencyUs >= boundUs) {
+        bucket++;
+        boundUs <<= 1;
+    }
+
+    stats->latencyHist[bucket]++;
+    if (latencyUs > stats->maxLatencyUs)
+        stats->maxLatencyUs = latencyUs;
+}
+
+/**
+ * @brief Initializes the scheduler with empty queues and full token buckets.
+ *
+ * @param dl - The scheduler to initialize.
+ * @param cfg - The settings of each class, or NULL for no deadlines, expiry or buckets.
+ * @param onDone - Called when a packet is sent, fails or expires, or NULL.
+ * @param ctx - Passed to onDone.
+ */
+void cc1120_downlink_init(cc1120_downlink_t *dl, const cc1120_downlink_class_cfg_t cfg[CC1120_DOWNLINK_CLASS_COUNT],
+                          cc1120_downlink_done_t onDone, void *ctx) {
+    memset(dl, 0, sizeof(*dl));
+
+    uint32_t nowUs = mcu_get_time_us();
+    uint8_t c;
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++) {
+        cc1120_downlink_queue_t *q = &dl->queues[c];
+        if (cfg != NULL)
+            q->cfg = cfg[c];
+        q->tokens = (uint64_t)q->cfg.burstBytes * CC1120_DOWNLINK_TOKEN_SCALE;
+        q->refilledUs = nowUs;
+    }
+
+    dl->urgentUs = CC1120_DOWNLINK_DEFAULT_URGENT_US;
+    dl->onDone = onDone;
+    dl->ctx = ctx;
+}
+
+/**
+ * @brief Queues a packet.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class of the packet.
+ * @param data - The packet, which must stay valid until onDone is called for it.
+ * @param len - The size of the packet.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was queued.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the class is out of range, or the packet is empty.
+ * @return CC1120_ERROR_CODE_QUEUE_FULL - If the class queue is full.
+ */
+cc1120_status_code cc1120_downlink_enqueue(cc1120_downlink_t *dl, cc1120_downlink_class_t cls, uint8_t *data, uint32_t len) {
+    if (cls >= CC1120_DOWNLINK_CLASS_COUNT || len < 1) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_downlink_enqueue: Invalid class or packet size!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    cc1120_downlink_queue_t *q = &dl->queues[cls];
+    if (q->count == CC1120_DOWNLINK_QUEUE_LEN) {
+        q->stats.rejected++;
+        return CC1120_ERROR_CODE_QUEUE_FULL;
+    }
+
+    cc1120_downlink_pkt_t *pkt = &q->ring[(q->head + q->count) & (CC1120_DOWNLINK_QUEUE_LEN - 1)];
+    pkt->data = data;
+    pkt->len = len;
+    pkt->queuedUs = mcu_get_time_us();
+
+    q->count++;
+    q->stats.queued++;
+    dl->pending |= 1U << cls;
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Drops expired packets, then takes the packet to send next off its queue:
+ * the one with the earliest deadline among those within urgentUs of it, else the highest priority
+ * class that is within its token bucket, else the highest priority class with anything queued.
+ * Charges the packet to its bucket and records its latency. Touches no hardware.
+ *
+ * @param dl - The scheduler.
+ * @param nowUs - The current mcu_get_time_us time.
+ * @param cls - Set to the class of the packet.
+ * @param pkt - Set to the packet.
+ * @return true - If a packet was taken.
+ * @return false - If nothing is queued.
+ */
+bool cc1120_downlink_next(cc1120_downlink_t *dl, uint32_t nowUs, cc1120_downlink_class_t *cls, cc1120_downlink_pkt_t *pkt) {
+    uint8_t c;
+
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++) {
+        if (dl->pending & (1U << c))
+            cc1120_downlink_expire(dl, c, nowUs);
+    }
+
+    if (dl->pending == 0)
+        return false;
+
+    uint8_t chosen = CC1120_DOWNLINK_CLASS_COUNT;
+    int32_t chosenSlackUs = 0;
+
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++) {
+        cc1120_downlink_queue_t *q = &dl->queues[c];
+        if (!(dl->pending & (1U << c)) || q->cfg.deadlineUs == 0)
+            continue;
+
+        int32_t slackUs = (int32_t)(q->ring[q->head].queuedUs + q->cfg.deadlineUs - nowUs);
+        if (slackUs <= (int32_t)dl->urgentUs && (chosen == CC1120_DOWNLINK_CLASS_COUNT || slackUs < chosenSlackUs)) {
+            chosen = c;
+            chosenSlackUs = slackUs;
+        }
+    }
+
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT && chosen == CC1120_DOWNLINK_CLASS_COUNT; c++) {
+        cc1120_downlink_queue_t *q = &dl->queues[c];
+        if (!(dl->pending & (1U << c)))
+            continue;
+
+        cc1120_downlink_refill(q, nowUs);
+        if (q->cfg.rateBytesPerSec == 0 || q->tokens >= (uint64_t)q->ring[q->head].len * CC1120_DOWNLINK_TOKEN_SCALE)
+            chosen = c;
+    }
+
+    // Every class with traffic is over its share, so the radio would otherwise sit idle
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT && chosen == CC1120_DOWNLINK_CLASS_COUNT; c++) {
+        if (dl->pending & (1U << c))
+            chosen = c;
+    }
+
+    cc1120_downlink_queue_t *q = &dl->queues[chosen];
+    *pkt = cc1120_downlink_pop(dl, chosen);
+    *cls = (cc1120_downlink_class_t)chosen;
+
+    if (q->cfg.rateBytesPerSec != 0) {
+        cc1120_downlink_refill(q, nowUs);
+        uint64_t cost = (uint64_t)pkt->len * CC1120_DOWNLINK_TOKEN_SCALE;
+        q->tokens = (q->tokens > cost) ? q->tokens - cost : 0;
+    }
+
+    cc1120_downlink_record_latency(&q->stats, nowUs - pkt->queuedUs);
+    return true;
+}
+
+/**
+ * @brief Counts a packet handed to the radio, or that failed, and passes it to onDone.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class of the packet.
+ * @param pkt - The packet.
+ * @param status - The result of handing it to the radio.
+ */
+static void cc1120_downlink_finish(cc1120_downlink_t *dl, cc1120_downlink_class_t cls, const cc1120_downlink_pkt_t *pkt,
+                                   cc1120_status_code status) {
+    if (status == CC1120_ERROR_CODE_SUCCESS) {
+        dl->queues[cls].stats.sent++;
+        dl->onAirLen = pkt->len;
+        dl->active = true;
+    } else {
+        dl->queues[cls].stats.failed++;
+    }
+
+    if (dl->onDone != NULL)
+        dl->onDone(dl->ctx, cls, pkt->data, status);
+}
+
+/**
+ * @brief Takes the held packet, else the next one off the queues, and holds it.
+ *
+ * @param dl - The scheduler.
+ * @return true - If a packet is held.
+ * @return false - If nothing is queued.
+ */
+static bool cc1120_downlink_hold(cc1120_downlink_t *dl) {
+    if (!dl->hasHeld)
+        dl->hasHeld = cc1120_downlink_next(dl, mcu_get_time_us(), &dl->heldCls, &dl->held);
+    return dl->hasHeld;
+}
+
+/**
+ * @brief Sets RFEND_CFG0.TXOFF_MODE unless it already has that value.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dl - The scheduler.
+ * @param mode - CC1120_OFF_MODE_TX or CC1120_OFF_MODE_FSTXON.
+ * @return cc1120_status_code - Whether or not the register write was successful
+ */
+static cc1120_status_code cc1120_downlink_txoff(cc1120_dev_t *dev, cc1120_downlink_t *dl, uint8_t mode) {
+    if (dl->txoffMode == mode)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    cc1120_status_code status = CC1120_FIELD_WRITE(dev, RFEND_CFG0_TXOFF_MODE, mode);
+    RETURN_IF_ERROR(status)
+
+    dl->txoffMode = mode;
+    return status;
+}
+
+/**
+ * @brief Loads the next packet behind the one on air if the TX FIFO has room for all of it, then lets
+ * the radio go on to it from TX. With nothing to load, the radio stops in FSTXON after the FIFO runs out.
+ *
+ * @param dev - The CC1120 to talk to, in TX.
+ * @param dl - The scheduler.
+ * @return cc1120_status_code - Whether or not the SPI transfers were successful
+ */
+static cc1120_status_code cc1120_downlink_preload(cc1120_dev_t *dev, cc1120_downlink_t *dl) {
+    cc1120_status_code status;
+
+    // Too big to load whole, so it waits for the FIFO to drain
+    if (!cc1120_downlink_hold(dl) || dl->held.len >= CC1120_TX_FIFO_SIZE)
+        return cc1120_downlink_txoff(dev, dl, CC1120_OFF_MODE_FSTXON);
+
+    uint8_t txBytes;
+    status = cc1120_get_packets_in_tx_fifo(dev, &txBytes);
+    RETURN_IF_ERROR(status)
+
+    if (txBytes + 1U + dl->held.len > CC1120_TX_FIFO_SIZE)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    // Loaded before TXOFF_MODE changes, so that a packet ending in between leaves the radio in FSTXON
+    // with a full FIFO rather than underflowing
+    dl->hasHeld = false;
+    status = cc1120_tx_load(dev, dl->held.data, (uint8_t)dl->held.len);
+    cc1120_downlink_finish(dl, dl->heldCls, &dl->held, status);
+    RETURN_IF_ERROR(status)
+
+    dl->preloaded++;
+    return cc1120_downlink_txoff(dev, dl, CC1120_OFF_MODE_TX);
+}
+
+/**
+ * @brief Makes the radio wait in FSTXON after each packet, which cc1120_downlink_service switches to TX
+ * while a packet is loaded behind the one on air. Call after cc1120_tx_init.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dl - The scheduler.
+ * @return cc1120_status_code - Whether or not the register write was successful
+ */
+cc1120_status_code cc1120_downlink_radio_init(cc1120_dev_t *dev, cc1120_downlink_t *dl) {
+    cc1120_status_code status = CC1120_FIELD_WRITE(dev, RFEND_CFG0_TXOFF_MODE, CC1120_OFF_MODE_FSTXON);
+    RETURN_IF_ERROR(status)
+
+    dl->txoffMode = CC1120_OFF_MODE_FSTXON;
+    return status;
+}
+
+/**
+ * @brief Keeps the radio sending. While a packet is on air, loads the next one behind it once NUM_TXBYTES
+ * shows room and sets TXOFF_MODE to TX, so that the radio goes straight on to it. With nothing behind,
+ * TXOFF_MODE goes back to FSTXON. Packets that do not fit in the TX FIFO are sent with cc1120_send once it
+ * has drained. Call from the main loop at least once per packet airtime, else the radio underflows
+ * after a loaded packet and the FIFO error is cleared on the next call.
+ *
+ * @param dev - The CC1120 to talk to, set up with cc1120_downlink_radio_init.
+ * @param dl - The scheduler.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a packet was sent or loaded, or there was nothing to do.
+ * @return An error code - If an SPI transfer failed. A packet that failed to send is passed to onDone.
+ */
+cc1120_status_code cc1120_downlink_service(cc1120_dev_t *dev, cc1120_downlink_t *dl) {
+    cc1120_status_code status;
+
+    if (dl->pending == 0 && !dl->hasHeld && !dl->active)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SNOP);
+    RETURN_IF_ERROR(status)
+
+    uint8_t state = dev->lastStatus & CC1120_STATE_MASK;
+
+    // A large packet is still being fed to the FIFO by cc1120_send, so nothing goes behind it
+    if (state == CC1120_STATE_TX) {
+        if (dl->onAirLen >= CC1120_TX_FIFO_SIZE)
+            return CC1120_ERROR_CODE_SUCCESS;
+        return cc1120_downlink_preload(dev, dl);
+    }
+
+    // Still calibrating or settling for a packet
+    if (state == CC1120_STATE_CALIBRATE || state == CC1120_STATE_SETTLING)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    // An underflow leaves bytes in the TX FIFO that would stall the queue. The flush also drops
+    // a loaded packet, already passed to onDone.
+    status = cc1120_fifo_recover(dev);
+    RETURN_IF_ERROR(status)
+
+    uint8_t txBytes;
+    status = cc1120_get_packets_in_tx_fifo(dev, &txBytes);
+    RETURN_IF_ERROR(status)
+
+    // The radio stopped before TXOFF_MODE reached TX, or a packet ended while loading the next
+    if (txBytes != 0) {
+        if (state == CC1120_STATE_FSTXON || state == CC1120_STATE_IDLE)
+            return cc1120_strobe_spi(dev, CC1120_STROBE_STX);
+        return CC1120_ERROR_CODE_SUCCESS;
+    }
+
+    dl->active = false;
+    if (!cc1120_downlink_hold(dl))
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    status = cc1120_downlink_txoff(dev, dl, CC1120_OFF_MODE_FSTXON);
+    RETURN_IF_ERROR(status)
+
+    dl->hasHeld = false;
+    status = cc1120_send(dev, dl->held.data, dl->held.len);
+    cc1120_downlink_finish(dl, dl->heldCls, &dl->held, status);
+    return status;
+}
+
+/**
+ * @brief Gets a latency percentile of a class from its histogram.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class.
+ * @param percent - The percentile, 1-100.
+ * @return uint32_t - The upper bound of the histogram bucket holding the percentile,
+ * or the largest latency seen for the last bucket, or 0 if nothing was sent.
+ */
+uint32_t cc1120_downlink_latency_percentile_us(const cc1120_downlink_t *dl, cc1120_downlink_class_t cls, uint8_t percent) {
+    const cc1120_downlink_stats_t *stats = &dl->queues[cls].stats;
+    uint32_t total = 0;
+    uint8_t b;
+
+    for (b = 0; b < CC1120_DOWNLINK_HIST_BUCKETS; b++)
+        total += stats->latencyHist[b];
+
+    if (total == 0)
+        return 0;
+
+    // Rank of the sample at the percentile, rounded up
+    uint32_t rank = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (b = 0; b < CC1120_DOWNLINK_HIST_BUCKETS - 1; b++) {
+        seen += stats->latencyHist[b];
+        if (seen >= rank) {
+            uint32_t boundUs = CC1120_DOWNLINK_HIST_MIN_US << b;
+            return (boundUs < stats->maxLatencyUs) ? boundUs : stats->maxLatencyUs;
+        }
+    }
+
+    return stats->maxLatencyUs;
+}
+
+/**
+ * @brief Clears the counters and latency histograms of all classes, and the preloaded count.
+ *
+ * @param dl - The scheduler.
+ */
+void cc1120_downlink_reset_stats(cc1120_downlink_t *dl) {
+    uint8_t c;
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++)
+        memset(&dl->queues[c].stats, 0, sizeof(dl->queues[c].stats));
+    dl->preloaded = 0;
+}
@@ -0,0 +1,176 @@
+#ifndef CC1120_DOWNLINK_H
+#define CC1120_DOWNLINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/*
+ * Downlink scheduler above the TX FIFO. Each traffic class has its own queue; the next packet is
+ * chosen by deadline first, then by class priority among the classes within their token bucket.
+ * The decision looks at the head of each queue only, so it takes the same time however much is queued.
+ * The queues hold pointers: a packet must stay valid until its done callback.
+ */
+
+/* Packets per class queue, a power of two */
+#define CC1120_DOWNLINK_QUEUE_LEN 8U
+
+/* A packet is sent ahead of priority once its deadline is this close */
+#define CC1120_DOWNLINK_DEFAULT_URGENT_US 20000UL
+
+/* Latency histogram: bucket i counts latencies below CC1120_DOWNLINK_HIST_MIN_US << i, the last bucket the rest */
+#define CC1120_DOWNLINK_HIST_BUCKETS 20U
+#define CC1120_DOWNLINK_HIST_MIN_US 128UL
+
+/* In priority order, highest first */
+typedef enum {
+    CC1120_DOWNLINK_BEACON = 0,
+    CC1120_DOWNLINK_ACK,
+    CC1120_DOWNLINK_HOUSEKEEPING,
+    CC1120_DOWNLINK_BULK,
+    CC1120_DOWNLINK_CLASS_COUNT
+} cc1120_downlink_class_t;
+
+typedef struct {
+    uint32_t deadlineUs;        /* Sent ahead of priority when this long after queueing draws near, 0 for none */
+    uint32_t maxAgeUs;          /* Dropped when still queued this long after queueing, 0 for never */
+    uint32_t rateBytesPerSec;   /* Token bucket fill rate, 0 for no bucket */
+    uint32_t burstBytes;        /* Token bucket size */
+} cc1120_downlink_class_cfg_t;
+
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+    uint32_t queuedUs;
+} cc1120_downlink_pkt_t;
+
+typedef struct {
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t expired;
+    uint32_t rejected;          /* Queue was full */
+    uint32_t failed;            /* cc1120_send returned an error */
+    uint32_t maxLatencyUs;
+    uint32_t latencyHist[CC1120_DOWNLINK_HIST_BUCKETS];     /* Queueing to being handed to the radio */
+} cc1120_downlink_stats_t;
+
+typedef struct {
+    cc1120_downlink_class_cfg_t cfg;
+    cc1120_downlink_pkt_t ring[CC1120_DOWNLINK_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+    uint64_t tokens;            /* In bytes * 1e6, so the refill needs no division */
+    uint32_t refilledUs;
+    cc1120_downlink_stats_t stats;
+} cc1120_downlink_queue_t;
+
+/**
+ * @brief Called when a packet leaves the scheduler.
+ *
+ * @param ctx - The ctx given to cc1120_downlink_init.
+ * @param cls - The class of the packet.
+ * @param data - The packet, which the scheduler no longer refers to.
+ * @param status - CC1120_ERROR_CODE_SUCCESS if sent, CC1120_ERROR_CODE_EXPIRED if dropped, or the error from cc1120_send.
+ */
+typedef void (*cc1120_downlink_done_t)(void *ctx, cc1120_downlink_class_t cls, uint8_t *data, cc1120_status_code status);
+
+typedef struct {
+    cc1120_downlink_queue_t queues[CC1120_DOWNLINK_CLASS_COUNT];
+    uint8_t pending;            /* Bit per class with packets queued */
+    uint32_t urgentUs;
+    cc1120_downlink_done_t onDone;
+    void *ctx;
+
+    /* Radio side */
+    cc1120_downlink_pkt_t held;     /* Taken off its queue, waiting for room in the TX FIFO */
+    cc1120_downlink_class_t heldCls;
+    bool hasHeld;
+    bool active;                /* The radio may still be sending what the scheduler gave it */
+    uint8_t txoffMode;          /* RFEND_CFG0.TXOFF_MODE as last written */
+    uint32_t onAirLen;          /* Size of the last packet handed to the radio */
+    uint32_t preloaded;         /* Packets loaded behind one still on air */
+} cc1120_downlink_t;
+
+/**
+ * @brief Initializes the scheduler with empty queues and full token buckets.
+ *
+ * @param dl - The scheduler to initialize.
+ * @param cfg - The settings of each class, or NULL for no deadlines, expiry or buckets.
+ * @param onDone - Called when a packet is sent, fails or expires, or NULL.
+ * @param ctx - Passed to onDone.
+ */
+void cc1120_downlink_init(cc1120_downlink_t *dl, const cc1120_downlink_class_cfg_t cfg[CC1120_DOWNLINK_CLASS_COUNT],
+                          cc1120_downlink_done_t onDone, void *ctx);
+
+/**
+ * @brief Makes the radio wait in FSTXON after each packet, which cc1120_downlink_service switches to TX
+ * while a packet is loaded behind the one on air. Call after cc1120_tx_init.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dl - The scheduler.
+ * @return cc1120_status_code - Whether or not the register write was successful
+ */
+cc1120_status_code cc1120_downlink_radio_init(cc1120_dev_t *dev, cc1120_downlink_t *dl);
+
+/**
+ * @brief Queues a packet.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class of the packet.
+ * @param data - The packet, which must stay valid until onDone is called for it.
+ * @param len - The size of the packet.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was queued.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the class is out of range, or the packet is empty.
+ * @return CC1120_ERROR_CODE_QUEUE_FULL - If the class queue is full.
+ */
+cc1120_status_code cc1120_downlink_enqueue(cc1120_downlink_t *dl, cc1120_downlink_class_t cls, uint8_t *data, uint32_t len);
+
+/**
+ * @brief Drops expired packets, then takes the packet to send next off its queue:
+ * the one with the earliest deadline among those within urgentUs of it, else the highest priority
+ * class that is within its token bucket, else the highest priority class with anything queued.
+ * Charges the packet to its bucket and records its latency. Touches no hardware.
+ *
+ * @param dl - The scheduler.
+ * @param nowUs - The current mcu_get_time_us time.
+ * @param cls - Set to the class of the packet.
+ * @param pkt - Set to the packet.
+ * @return true - If a packet was taken.
+ * @return false - If nothing is queued.
+ */
+bool cc1120_downlink_next(cc1120_downlink_t *dl, uint32_t nowUs, cc1120_downlink_class_t *cls, cc1120_downlink_pkt_t *pkt);
+
+/**
+ * @brief Keeps the radio sending. While a packet is on air, loads the next one behind it once NUM_TXBYTES
+ * shows room and sets TXOFF_MODE to TX, so that the radio goes straight on to it. With nothing behind,
+ * TXOFF_MODE goes back to FSTXON. Packets that do not fit in the TX FIFO are sent with cc1120_send once it
+ * has drained. Call from the main loop at least once per packet airtime, else the radio underflows
+ * after a loaded packet and the FIFO error is cleared on the next call.
+ *
+ * @param dev - The CC1120 to talk to, set up with cc1120_downlink_radio_init.
+ * @param dl - The scheduler.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a packet was sent or loaded, or there was nothing to do.
+ * @return An error code - If an SPI transfer failed. A packet that failed to send is passed to onDone.
+ */
+cc1120_status_code cc1120_downlink_service(cc1120_dev_t *dev, cc1120_downlink_t *dl);
+
+/**
+ * @brief Gets a latency percentile of a class from its histogram.
+ *
+ * @param dl - The scheduler.
+ * @param cls - The class.
+ * @param percent - The percentile, 1-100.
+ * @return uint32_t - The upper bound of the histogram bucket holding the percentile,
+ * or the largest latency seen for the last bucket, or 0 if nothing was sent.
+ */
+uint32_t cc1120_downlink_latency_percentile_us(const cc1120_downlink_t *dl, cc1120_downlink_class_t cls, uint8_t percent);
+
+/**
+ * @brief Clears the counters and latency histograms of all classes, and the preloaded count.
+ *
+ * @param dl - The scheduler.
+ */
+void cc1120_downlink_reset_stats(cc1120_downlink_t *dl);
+
+#endif /* CC1120_DOWNLINK_H */
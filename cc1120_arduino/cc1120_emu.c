@@ -0,0 +1,885 @@
+#include "cc1120_emu.h"
+
+#if !defined(CC1120_PLATFORM_ARDUINO) && !defined(CC1120_PLATFORM_RM46)
+
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_spi_tests.h"
+#include "cc1120_fields.h"
+#include "cc1120_modem.h"
+#include "cc1120_txrx.h"
+#include "cc1120_rate.h"
+#include "cc1120_regs.h"
+#include <string.h>
+
+/* Markers sent on the air along with the packet bytes */
+#define CC1120_EMU_AIR_SYNC 0x100U      /* Sync word received, at the end of the sync word */
+#define CC1120_EMU_AIR_END 0x200U       /* CRC received */
+#define CC1120_EMU_AIR_ABORT 0x300U     /* Transmitter stopped in the middle of the packet */
+
+#define CC1120_EMU_PKT_CFG1_CRC_CFG_MASK 0x0CU
+#define CC1120_EMU_PKT_CFG1_APPEND_STATUS 0x01U
+#define CC1120_EMU_FIFO_CFG_CRC_AUTOFLUSH 0x80U
+#define CC1120_EMU_MOD_FORMAT_MASK 0x38U
+
+/* PREAMBLE_CFG1.NUM_PREAMBLE and SYNC_CFG0.SYNC_MODE in bits */
+static const uint8_t CC1120_EMU_PREAMBLE_BITS[16] = {0, 4, 8, 12, 16, 24, 32, 40, 48, 56, 64, 96, 192, 240, 0, 0};
+static const uint8_t CC1120_EMU_SYNC_BITS[8] = {0, 11, 16, 18, 24, 32, 16, 16};
+
+/* Links on the shared clock, as a min-heap on nextNs */
+static cc1120_emu_link_t *cc1120_emu_heap[CC1120_EMU_MAX_LINKS];
+static uint16_t cc1120_emu_link_count = 0;
+
+/* The shared clock */
+static uint64_t cc1120_emu_clock_ns = 0;
+
+static void cc1120_emu_run(uint64_t untilNs);
+static void cc1120_emu_tx_start(cc1120_emu_radio_t *radio);
+
+/**
+ * @brief Draws a uniform number in [0, 1) from the link's xorshift64* generator.
+ *
+ * @param link - The link.
+ * @return double - The number.
+ */
+static double cc1120_emu_rand(cc1120_emu_link_t *link) {
+    uint64_t x = link->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    link->rng = x;
+    return (double)((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Gets the MARCSTATE value for the state of the status byte.
+ *
+ * @param state - The STATE field.
+ * @return uint8_t - The MARC_STATE value.
+ */
+static uint8_t cc1120_emu_marcstate(uint8_t state) {
+    switch (state) {
+    case CC1120_STATE_RX:
+        return CC1120_MARCSTATE_RX;
+    case CC1120_STATE_TX:
+        return CC1120_MARCSTATE_TX;
+    case CC1120_STATE_FSTXON:
+        return CC1120_MARCSTATE_FSTXON;
+    case CC1120_STATE_RX_FIFO_ERR:
+        return CC1120_MARCSTATE_RX_FIFO_ERR;
+    case CC1120_STATE_TX_FIFO_ERR:
+        return CC1120_MARCSTATE_TX_FIFO_ERR;
+    default:
+        return CC1120_MARCSTATE_IDLE;
+    }
+}
+
+/**
+ * @brief Computes the time one byte takes on the air with the radio's current registers.
+ *
+ * @param radio - The radio.
+ * @return uint32_t - The byte time in nanoseconds.
+ */
+static uint32_t cc1120_emu_byte_ns(const cc1120_emu_radio_t *radio) {
+    cc1120_modem_cfg_t cfg;
+
+    cfg.modem[3] = radio->regs[CC1120_REGS_SYMBOL_RATE2];
+    cfg.modem[4] = radio->regs[CC1120_REGS_SYMBOL_RATE1];
+    cfg.modem[5] = radio->regs[CC1120_REGS_SYMBOL_RATE0];
+    uint64_t bitRate = cc1120_modem_symbol_rate(&cfg, CC1120_XOSC_FREQ_HZ);
+
+    uint8_t modFormat = radio->regs[CC1120_REGS_MODCFG_DEV_E] & CC1120_EMU_MOD_FORMAT_MASK;
+    if (modFormat == CC1120_MODCFG_MOD_FORMAT_4FSK || modFormat == CC1120_MODCFG_MOD_FORMAT_4GFSK)
+        bitRate *= 2;
+    if (bitRate == 0)
+        bitRate = 1;
+
+    return (uint32_t)(8000000000ULL / bitRate);
+}
+
+/**
+ * @brief Computes the number of preamble and sync word bits with the radio's current registers.
+ *
+ * @param radio - The radio.
+ * @return uint32_t - The number of bits.
+ */
+static uint32_t cc1120_emu_header_bits(const cc1120_emu_radio_t *radio) {
+    uint8_t numPreamble = (radio->regs[CC1120_REGS_PREAMBLE_CFG1] >> 2) & 0x0FU;
+    uint8_t syncMode = (radio->regs[CC1120_REGS_SYNC_CFG0] >> 2) & 0x07U;
+
+    return CC1120_EMU_PREAMBLE_BITS[numPreamble] + CC1120_EMU_SYNC_BITS[syncMode];
+}
+
+/**
+ * @brief Computes the airtime of a packet with the radio's current registers.
+ *
+ * @param radio - The radio.
+ * @param len - The packet length in bytes, length byte included and CRC excluded.
+ * @return uint32_t - The airtime in microseconds.
+ */
+uint32_t cc1120_emu_airtime_us(const cc1120_emu_radio_t *radio, uint32_t len) {
+    uint64_t byteNs = cc1120_emu_byte_ns(radio);
+    uint32_t crcBytes = (radio->regs[CC1120_REGS_PKT_CFG1] & CC1120_EMU_PKT_CFG1_CRC_CFG_MASK) ? 2 : 0;
+
+    return (uint32_t)((byteNs * cc1120_emu_header_bits(radio) / 8 + byteNs * (len + crcBytes)) / 1000);
+}
+
+/**
+ * @brief Puts a byte or marker on the air towards the other radio.
+ *
+ * @param radio - The transmitting radio.
+ * @param atNs - When it reaches the receiver, before the propagation delay.
+ * @param data - The byte or marker.
+ */
+static void cc1120_emu_air_push(cc1120_emu_radio_t *radio, uint64_t atNs, uint16_t data) {
+    cc1120_emu_link_t *link = radio->link;
+    uint8_t dir = radio->side;
+
+    if (link->airCount[dir] >= CC1120_EMU_AIR_SIZE) {
+        link->stats[dir].airOverruns++;
+        return;
+    }
+
+    cc1120_emu_air_t *entry = &link->air[dir][(link->airHead[dir] + link->airCount[dir]) % CC1120_EMU_AIR_SIZE];
+    entry->atNs = atNs + (uint64_t)link->channel[dir].delayUs * 1000;
+    entry->data = data;
+    link->airCount[dir]++;
+}
+
+/**
+ * @brief Enters the state an OFF_MODE field selects at the end of a packet.
+ *
+ * @param radio - The radio.
+ * @param offMode - The TXOFF_MODE or RXOFF_MODE value.
+ */
+static void cc1120_emu_off_mode(cc1120_emu_radio_t *radio, uint8_t offMode) {
+    switch (offMode) {
+    case CC1120_OFF_MODE_FSTXON:
+        radio->state = CC1120_STATE_FSTXON;
+        break;
+    case CC1120_OFF_MODE_TX:
+        cc1120_emu_tx_start(radio);
+        break;
+    case CC1120_OFF_MODE_RX:
+        radio->state = CC1120_STATE_RX;
+        break;
+    default:
+        radio->state = CC1120_STATE_IDLE;
+        break;
+    }
+}
+
+/**
+ * @brief Starts sending a packet: the preamble and sync word, then the TX FIFO.
+ *
+ * @param radio - The radio.
+ */
+static void cc1120_emu_tx_start(cc1120_emu_radio_t *radio) {
+    radio->state = CC1120_STATE_TX;
+    radio->rxActive = false;
+    radio->txByteNs = cc1120_emu_byte_ns(radio);
+    radio->txHeaderNs = (uint32_t)((uint64_t)radio->txByteNs * cc1120_emu_header_bits(radio) / 8);
+    radio->txCrcBytes = (radio->regs[CC1120_REGS_PKT_CFG1] & CC1120_EMU_PKT_CFG1_CRC_CFG_MASK) ? 2 : 0;
+    radio->txSent = 0;
+    radio->txEnding = false;
+    radio->txNextNs = cc1120_emu_clock_ns + radio->txHeaderNs;
+    cc1120_emu_air_push(radio, radio->txNextNs, CC1120_EMU_AIR_SYNC);
+}
+
+/**
+ * @brief Stops a packet being sent, e.g. on SIDLE, so that the receiver drops what it has of it.
+ *
+ * @param radio - The radio.
+ */
+static void cc1120_emu_tx_abort(cc1120_emu_radio_t *radio) {
+    if (radio->state == CC1120_STATE_TX)
+        cc1120_emu_air_push(radio, cc1120_emu_clock_ns, CC1120_EMU_AIR_ABORT);
+}
+
+/**
+ * @brief Checks whether the byte just sent ends the packet, following PKT_CFG0.LENGTH_CONFIG as it is now,
+ * so that switching from infinite to fixed length in the middle of a large packet ends it at PKT_LEN modulo 256.
+ *
+ * @param radio - The radio.
+ * @return true - If the packet is complete.
+ */
+static bool cc1120_emu_tx_done(const cc1120_emu_radio_t *radio) {
+    uint8_t lengthConfig = (radio->regs[CC1120_REGS_PKT_CFG0] >> 5) & 0x03U;
+
+    if (lengthConfig == CC1120_LENGTH_CONFIG_VARIABLE)
+        return radio->txSent == (uint32_t)radio->txFirstByte + 1;
+    if (lengthConfig == CC1120_LENGTH_CONFIG_FIXED)
+        return radio->txSent % 256 == radio->regs[CC1120_REGS_PKT_LEN];
+
+    return false;
+}
+
+/**
+ * @brief Takes the next byte from the TX FIFO, or ends the packet once its CRC is sent.
+ *
+ * @param radio - The radio, in TX.
+ */
+static void cc1120_emu_tx_step(cc1120_emu_radio_t *radio) {
+    cc1120_emu_link_t *link = radio->link;
+    cc1120_emu_stats_t *stats = &link->stats[radio->side];
+    uint64_t nowNs = radio->txNextNs;
+
+    if (radio->txEnding) {
+        cc1120_emu_air_push(radio, nowNs, CC1120_EMU_AIR_END);
+        stats->packetsSent++;
+        stats->airtimeNs += radio->txHeaderNs + (uint64_t)radio->txByteNs * (radio->txSent + radio->txCrcBytes);
+        radio->marcStatus1 = CC1120_MARC_STATUS1_TX_DONE;
+        cc1120_emu_off_mode(radio, (radio->regs[CC1120_REGS_RFEND_CFG0] & CC1120_RFEND_CFG0_TXOFF_MODE_MASK) >>
+                                       CC1120_RFEND_OFF_MODE_SHIFT);
+        return;
+    }
+
+    if (radio->txCount == 0) {
+        cc1120_emu_air_push(radio, nowNs, CC1120_EMU_AIR_ABORT);
+        stats->txUnderflows++;
+        radio->state = CC1120_STATE_TX_FIFO_ERR;
+        radio->marcStatus1 = CC1120_MARC_STATUS1_TX_FIFO_UNDERFLOW;
+        return;
+    }
+
+    uint8_t data = radio->fifo[radio->txFirst];
+    radio->txFirst = (radio->txFirst + 1) % CC1120_EMU_FIFO_SIZE;
+    radio->txCount--;
+    radio->txSent++;
+    if (radio->txSent == 1)
+        radio->txFirstByte = data;
+
+    // The byte reaches the receiver once all its bits have
+    cc1120_emu_air_push(radio, nowNs + radio->txByteNs, data);
+    radio->txNextNs = nowNs + radio->txByteNs;
+
+    if (cc1120_emu_tx_done(radio)) {
+        radio->txEnding = true;
+        radio->txNextNs += (uint64_t)radio->txByteNs * radio->txCrcBytes;
+    }
+}
+
+/**
+ * @brief Puts a byte in the RX FIFO, or enters RX_FIFO_ERR if it is full.
+ *
+ * @param radio - The receiving radio.
+ * @param data - The byte.
+ * @return true - If the byte was stored.
+ */
+static bool cc1120_emu_rx_push(cc1120_emu_radio_t *radio, uint8_t data) {
+    if (radio->rxCount >= CC1120_EMU_FIFO_SIZE) {
+        radio->link->stats[radio->side ^ 1].rxOverflows++;
+        radio->state = CC1120_STATE_RX_FIFO_ERR;
+        radio->marcStatus1 = CC1120_MARC_STATUS1_RX_FIFO_OVERFLOW;
+        radio->rxActive = false;
+        return false;
+    }
+
+    radio->fifo[CC1120_EMU_FIFO_SIZE + (radio->rxFirst + radio->rxCount) % CC1120_EMU_FIFO_SIZE] = data;
+    radio->rxCount++;
+    return true;
+}
+
+/**
+ * @brief Removes what is still in the RX FIFO of the packet being received.
+ *
+ * @param radio - The receiving radio.
+ */
+static void cc1120_emu_rx_flush_packet(cc1120_emu_radio_t *radio) {
+    uint8_t remove = radio->rxBytes < radio->rxCount ? (uint8_t)radio->rxBytes : radio->rxCount;
+
+    radio->rxCount -= remove;
+    radio->link->stats[radio->side ^ 1].packetsFlushed++;
+}
+
+/**
+ * @brief Flips the bits of a byte that the channel corrupts.
+ *
+ * @param link - The link.
+ * @param dir - The direction.
+ * @param data - The byte as sent.
+ * @return uint8_t - The byte as received.
+ */
+static uint8_t cc1120_emu_channel_errors(cc1120_emu_link_t *link, uint8_t dir, uint8_t data) {
+    const cc1120_emu_channel_t *channel = &link->channel[dir];
+
+    if (channel->ber <= 0.0 && channel->burstEnter <= 0.0 && !link->burst[dir])
+        return data;
+
+    uint8_t bit;
+    for (bit = 0; bit < 8; bit++) {
+        double p = link->burst[dir] ? channel->burstBer : channel->ber;
+        if (p > 0.0 && cc1120_emu_rand(link) < p) {
+            data ^= (uint8_t)(1U << bit);
+            link->stats[dir].bitErrors++;
+        }
+
+        if (link->burst[dir]) {
+            if (cc1120_emu_rand(link) < channel->burstExit)
+                link->burst[dir] = false;
+        } else if (channel->burstEnter > 0.0 && cc1120_emu_rand(link) < channel->burstEnter) {
+            link->burst[dir] = true;
+        }
+    }
+
+    return data;
+}
+
+/**
+ * @brief Hands the receiver the next byte or marker that has arrived.
+ *
+ * @param link - The link.
+ * @param dir - The direction, the index of the transmitting radio.
+ */
+static void cc1120_emu_rx_step(cc1120_emu_link_t *link, uint8_t dir) {
+    cc1120_emu_radio_t *radio = &link->radios[dir ^ 1];
+    cc1120_emu_stats_t *stats = &link->stats[dir];
+    uint16_t data = link->air[dir][link->airHead[dir]].data;
+
+    link->airHead[dir] = (link->airHead[dir] + 1) % CC1120_EMU_AIR_SIZE;
+    link->airCount[dir]--;
+
+    if (data == CC1120_EMU_AIR_SYNC) {
+        if (radio->state != CC1120_STATE_RX) {
+            radio->rxActive = false;
+            stats->packetsMissed++;
+            return;
+        }
+
+        radio->rxActive = true;
+        radio->rxLost = cc1120_emu_rand(link) < link->channel[dir].lossProb;
+        radio->rxCrcOk = true;
+        radio->rxBytes = 0;
+        if (radio->rxLost)
+            stats->packetsLost++;
+        return;
+    }
+
+    if (!radio->rxActive || radio->rxLost)
+        return;
+
+    // Left RX in the middle of the packet
+    if (radio->state != CC1120_STATE_RX) {
+        radio->rxActive = false;
+        stats->packetsMissed++;
+        return;
+    }
+
+    if (data == CC1120_EMU_AIR_ABORT) {
+        radio->rxActive = false;
+        cc1120_emu_rx_flush_packet(radio);
+        return;
+    }
+
+    if (data < CC1120_EMU_AIR_SYNC) {
+        uint8_t received = cc1120_emu_channel_errors(link, dir, (uint8_t)data);
+        if (received != data)
+            radio->rxCrcOk = false;
+        if (cc1120_emu_rx_push(radio, received))
+            radio->rxBytes++;
+        return;
+    }
+
+    // CRC received
+    radio->rxActive = false;
+    if (!radio->rxCrcOk)
+        stats->packetsCorrupted++;
+
+    if (!radio->rxCrcOk && (radio->regs[CC1120_REGS_FIFO_CFG] & CC1120_EMU_FIFO_CFG_CRC_AUTOFLUSH)) {
+        cc1120_emu_rx_flush_packet(radio);
+    } else {
+        if (radio->regs[CC1120_REGS_PKT_CFG1] & CC1120_EMU_PKT_CFG1_APPEND_STATUS) {
+            uint8_t crcLqi = (link->channel[dir].lqi & CC1120_STATUS_LQI_MASK) |
+                             (radio->rxCrcOk ? CC1120_STATUS_CRC_OK : 0);
+            if (!cc1120_emu_rx_push(radio, (uint8_t)(int8_t)(link->channel[dir].rssiDbm + CC1120_RSSI_OFFSET_DB)) ||
+                !cc1120_emu_rx_push(radio, crcLqi))
+                return;
+        }
+
+        stats->packetsDelivered++;
+        if (radio->rxCrcOk)
+            stats->bytesDelivered += radio->rxBytes;
+    }
+
+    radio->marcStatus1 = CC1120_MARC_STATUS1_RX_DONE;
+    cc1120_emu_off_mode(radio, (radio->regs[CC1120_REGS_RFEND_CFG1] & CC1120_RFEND_CFG1_RXOFF_MODE_MASK) >>
+                                   CC1120_RFEND_OFF_MODE_SHIFT);
+}
+
+/**
+ * @brief Gets the virtual time of the next byte leaving a TX FIFO or reaching a receiver on one link.
+ *
+ * @param link - The link.
+ * @return uint64_t - The time in nanoseconds, or UINT64_MAX if nothing is being sent or on the air.
+ */
+static uint64_t cc1120_emu_link_next_event(const cc1120_emu_link_t *link) {
+    uint64_t next = UINT64_MAX;
+    uint8_t i;
+
+    for (i = 0; i < 2; i++) {
+        if (link->radios[i].state == CC1120_STATE_TX && link->radios[i].txNextNs < next)
+            next = link->radios[i].txNextNs;
+        if (link->airCount[i] > 0 && link->air[i][link->airHead[i]].atNs < next)
+            next = link->air[i][link->airHead[i]].atNs;
+    }
+
+    return next;
+}
+
+/**
+ * @brief Runs the transmitter and receiver steps of one link that are due at a time.
+ *
+ * @param link - The link.
+ * @param atNs - The time of the link's next event.
+ */
+static void cc1120_emu_link_step(cc1120_emu_link_t *link, uint64_t atNs) {
+    uint8_t i;
+
+    for (i = 0; i < 2; i++) {
+        if (link->radios[i].state == CC1120_STATE_TX && link->radios[i].txNextNs == atNs)
+            cc1120_emu_tx_step(&link->radios[i]);
+        else if (link->airCount[i] > 0 && link->air[i][link->airHead[i]].atNs == atNs)
+            cc1120_emu_rx_step(link, i);
+    }
+}
+
+/**
+ * @brief Puts the link at a heap slot.
+ *
+ * @param index - The slot.
+ * @param link - The link.
+ */
+static void cc1120_emu_heap_put(uint16_t index, cc1120_emu_link_t *link) {
+    cc1120_emu_heap[index] = link;
+    link->heapIndex = index;
+}
+
+/**
+ * @brief Moves a link up or down the heap after its nextNs changed.
+ *
+ * @param link - The link, on the clock.
+ */
+static void cc1120_emu_heap_fix(cc1120_emu_link_t *link) {
+    uint16_t index = link->heapIndex;
+
+    while (index > 0 && cc1120_emu_heap[(index - 1) / 2]->nextNs > link->nextNs) {
+        cc1120_emu_heap_put(index, cc1120_emu_heap[(index - 1) / 2]);
+        index = (index - 1) / 2;
+    }
+
+    for (;;) {
+        uint16_t child = (uint16_t)(2 * index + 1);
+        if (child >= cc1120_emu_link_count)
+            break;
+        if (child + 1 < cc1120_emu_link_count && cc1120_emu_heap[child + 1]->nextNs < cc1120_emu_heap[child]->nextNs)
+            child++;
+        if (cc1120_emu_heap[child]->nextNs >= link->nextNs)
+            break;
+        cc1120_emu_heap_put(index, cc1120_emu_heap[child]);
+        index = child;
+    }
+
+    cc1120_emu_heap_put(index, link);
+}
+
+/**
+ * @brief Updates a link's next event time after it may have changed.
+ *
+ * @param link - The link, on the clock.
+ */
+static void cc1120_emu_link_update(cc1120_emu_link_t *link) {
+    uint64_t next = cc1120_emu_link_next_event(link);
+
+    if (next != link->nextNs) {
+        link->nextNs = next;
+        cc1120_emu_heap_fix(link);
+    }
+}
+
+/**
+ * @brief Runs the transmitters and receivers of every link up to a time, in time order, and moves the
+ * shared clock there. Links do not interact, but their events still run in time order so that each one
+ * sees the clock at its own time.
+ *
+ * @param untilNs - The time to run to.
+ */
+static void cc1120_emu_run(uint64_t untilNs) {
+    while (cc1120_emu_link_count > 0 && cc1120_emu_heap[0]->nextNs <= untilNs) {
+        cc1120_emu_link_t *link = cc1120_emu_heap[0];
+
+        if (link->nextNs > cc1120_emu_clock_ns)
+            cc1120_emu_clock_ns = link->nextNs;
+        cc1120_emu_link_step(link, link->nextNs);
+        cc1120_emu_link_update(link);
+    }
+
+    if (untilNs > cc1120_emu_clock_ns)
+        cc1120_emu_clock_ns = untilNs;
+}
+
+/**
+ * @brief Clock hook for mcu_get_time_us.
+ *
+ * @return uint32_t - The shared clock in microseconds.
+ */
+static uint32_t cc1120_emu_time_us(void) {
+    cc1120_emu_run(cc1120_emu_clock_ns + CC1120_EMU_CLOCK_READ_NS);
+    return (uint32_t)(cc1120_emu_clock_ns / 1000);
+}
+
+/**
+ * @brief Puts a radio in its state after SRES.
+ *
+ * @param radio - The radio.
+ */
+static void cc1120_emu_reset(cc1120_emu_radio_t *radio) {
+    memcpy(radio->regs, CC1120_REGS_DEFAULTS, sizeof(radio->regs));
+    memset(radio->ext, 0, sizeof(radio->ext));
+    radio->txFirst = 0;
+    radio->txCount = 0;
+    radio->rxFirst = 0;
+    radio->rxCount = 0;
+    radio->state = CC1120_STATE_IDLE;
+    radio->marcStatus1 = CC1120_MARC_STATUS1_NO_FAILURE;
+    radio->rxActive = false;
+}
+
+/**
+ * @brief Executes a command strobe. Strobes that do not apply in the current state are ignored, as on the chip.
+ *
+ * @param radio - The radio.
+ * @param strobe - The strobe address.
+ */
+static void cc1120_emu_strobe(cc1120_emu_radio_t *radio, uint8_t strobe) {
+    bool idle = radio->state == CC1120_STATE_IDLE;
+
+    switch (strobe) {
+    case CC1120_STROBE_SRES:
+        cc1120_emu_tx_abort(radio);
+        cc1120_emu_reset(radio);
+        break;
+    case CC1120_STROBE_SFSTXON:
+        if (idle || radio->state == CC1120_STATE_RX) {
+            radio->rxActive = false;
+            radio->state = CC1120_STATE_FSTXON;
+        }
+        break;
+    case CC1120_STROBE_SRX:
+        if (idle || radio->state == CC1120_STATE_FSTXON)
+            radio->state = CC1120_STATE_RX;
+        break;
+    case CC1120_STROBE_STX:
+        if (idle || radio->state == CC1120_STATE_FSTXON || radio->state == CC1120_STATE_RX)
+            cc1120_emu_tx_start(radio);
+        break;
+    case CC1120_STROBE_SIDLE:
+    case CC1120_STROBE_SXOFF:
+    case CC1120_STROBE_SPWD:
+    case CC1120_STROBE_SWOR:
+        cc1120_emu_tx_abort(radio);
+        radio->rxActive = false;
+        radio->state = CC1120_STATE_IDLE;
+        break;
+    case CC1120_STROBE_SFRX:
+        if (idle || radio->state == CC1120_STATE_RX_FIFO_ERR) {
+            radio->rxCount = 0;
+            radio->state = CC1120_STATE_IDLE;
+        }
+        break;
+    case CC1120_STROBE_SFTX:
+        if (idle || radio->state == CC1120_STATE_TX_FIFO_ERR) {
+            radio->txCount = 0;
+            radio->state = CC1120_STATE_IDLE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Reads an extended register, serving the status registers from the emulated state.
+ *
+ * @param radio - The radio.
+ * @param addr - The extended address.
+ * @return uint8_t - The register value.
+ */
+static uint8_t cc1120_emu_read_ext(cc1120_emu_radio_t *radio, uint8_t addr) {
+    cc1120_emu_link_t *link = radio->link;
+    const cc1120_emu_radio_t *peer = &link->radios[radio->side ^ 1];
+    bool carrier = radio->state == CC1120_STATE_RX && peer->state == CC1120_STATE_TX;
+    uint8_t val;
+
+    switch (addr) {
+    case CC1120_REGS_EXT_MARCSTATE:
+        return cc1120_emu_marcstate(radio->state);
+    case CC1120_REGS_EXT_MARC_STATUS1:
+        val = radio->marcStatus1;
+        radio->marcStatus1 = CC1120_MARC_STATUS1_NO_FAILURE;
+        return val;
+    case CC1120_REGS_EXT_RSSI1:
+        return (uint8_t)(int8_t)((carrier ? link->channel[peer->side].rssiDbm : CC1120_EMU_NOISE_DBM) +
+                                 CC1120_RSSI_OFFSET_DB);
+    case CC1120_REGS_EXT_RSSI0:
+        return CC1120_RSSI0_RSSI_VALID | CC1120_RSSI0_CARRIER_SENSE_VALID | (carrier ? CC1120_RSSI0_CARRIER_SENSE : 0);
+    case CC1120_REGS_EXT_LQI_VAL:
+        return link->channel[peer->side].lqi & CC1120_STATUS_LQI_MASK;
+    case CC1120_REGS_EXT_NUM_TXBYTES:
+        return radio->txCount;
+    case CC1120_REGS_EXT_NUM_RXBYTES:
+    case CC1120_REGS_EXT_FIFO_NUM_RXBYTES:
+        return radio->rxCount;
+    case CC1120_REGS_EXT_FIFO_NUM_TXBYTES:
+        return CC1120_EMU_FIFO_SIZE - radio->txCount;
+    case CC1120_REGS_EXT_TXFIRST:
+        return radio->txFirst;
+    case CC1120_REGS_EXT_TXLAST:
+        return (radio->txFirst + radio->txCount) % CC1120_EMU_FIFO_SIZE;
+    case CC1120_REGS_EXT_RXFIRST:
+        return radio->rxFirst;
+    case CC1120_REGS_EXT_RXLAST:
+        return (radio->rxFirst + radio->rxCount) % CC1120_EMU_FIFO_SIZE;
+    default:
+        return radio->ext[addr];
+    }
+}
+
+/**
+ * @brief Reads a byte through the standard FIFO access, entering RX_FIFO_ERR if the RX FIFO is empty.
+ *
+ * @param radio - The radio.
+ * @return uint8_t - The byte.
+ */
+static uint8_t cc1120_emu_fifo_read(cc1120_emu_radio_t *radio) {
+    if (radio->rxCount == 0) {
+        radio->state = CC1120_STATE_RX_FIFO_ERR;
+        radio->marcStatus1 = CC1120_MARC_STATUS1_RX_FIFO_UNDERFLOW;
+        return 0;
+    }
+
+    uint8_t data = radio->fifo[CC1120_EMU_FIFO_SIZE + radio->rxFirst];
+    radio->rxFirst = (radio->rxFirst + 1) % CC1120_EMU_FIFO_SIZE;
+    radio->rxCount--;
+    return data;
+}
+
+/**
+ * @brief Writes a byte through the standard FIFO access, entering TX_FIFO_ERR if the TX FIFO is full.
+ *
+ * @param radio - The radio.
+ * @param data - The byte.
+ */
+static void cc1120_emu_fifo_write(cc1120_emu_radio_t *radio, uint8_t data) {
+    if (radio->txCount >= CC1120_EMU_FIFO_SIZE) {
+        cc1120_emu_tx_abort(radio);
+        radio->state = CC1120_STATE_TX_FIFO_ERR;
+        radio->marcStatus1 = CC1120_MARC_STATUS1_TX_FIFO_OVERFLOW;
+        return;
+    }
+
+    radio->fifo[(radio->txFirst + radio->txCount) % CC1120_EMU_FIFO_SIZE] = data;
+    radio->txCount++;
+}
+
+/**
+ * @brief Handles one SPI byte of a transaction with an emulated radio.
+ *
+ * @param radio - The radio.
+ * @param data - The MOSI byte.
+ * @return uint8_t - The MISO byte.
+ */
+static uint8_t cc1120_emu_spi_byte(cc1120_emu_radio_t *radio, uint8_t data) {
+    uint8_t pos = radio->spiPos;
+    uint8_t status = radio->state | 0x0FU;
+
+    if (radio->spiPos < UINT8_MAX)
+        radio->spiPos++;
+
+    if (pos == 0) {
+        radio->spiHeader = data;
+        uint8_t addr = data & 0x3FU;
+        if (addr >= CC1120_STROBE_SRES && addr <= CC1120_STROBE_SNOP)
+            cc1120_emu_strobe(radio, addr);
+        return status;
+    }
+
+    uint8_t header = radio->spiHeader;
+    uint8_t addr = header & 0x3FU;
+    bool read = (header & (R_BIT)) != 0;
+    uint8_t offset = (header & (BURST_BIT)) ? (uint8_t)(pos - 1) : 0;
+
+    if (addr < CC1120_REGS_EXT_ADDR) {
+        addr += offset;
+        if (addr >= CC1120_REGS_STD_SPACE_SIZE)
+            return read ? 0 : status;
+        if (read)
+            return radio->regs[addr];
+        radio->regs[addr] = data;
+        return status;
+    }
+
+    if (addr == CC1120_REGS_EXT_ADDR || addr == CC1120_REGS_FIFO_ACCESS_DIR) {
+        // The address byte reads back as zero
+        if (pos == 1) {
+            radio->spiAddr = data;
+            return 0x00;
+        }
+
+        offset = (header & (BURST_BIT)) ? (uint8_t)(pos - 2) : 0;
+        uint8_t target = (uint8_t)(radio->spiAddr + offset);
+        uint8_t *mem = (addr == CC1120_REGS_EXT_ADDR) ? &radio->ext[target] : &radio->fifo[target];
+
+        if (read)
+            return (addr == CC1120_REGS_EXT_ADDR) ? cc1120_emu_read_ext(radio, target) : *mem;
+        *mem = data;
+        return status;
+    }
+
+    if (addr == CC1120_REGS_FIFO_ACCESS_STD) {
+        if (read)
+            return cc1120_emu_fifo_read(radio);
+        cc1120_emu_fifo_write(radio, data);
+        return status;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Transfers one SPI byte with an emulated radio, after letting the byte's time pass.
+ *
+ * @param bus - The cc1120_emu_radio_t.
+ * @param data - The MOSI byte.
+ * @return uint8_t - The MISO byte.
+ */
+static uint8_t cc1120_emu_transfer(void *bus, uint8_t data) {
+    cc1120_emu_radio_t *radio = (cc1120_emu_radio_t *)bus;
+
+    cc1120_emu_run(cc1120_emu_clock_ns + radio->link->spiByteNs);
+    uint8_t reply = cc1120_emu_spi_byte(radio, data);
+
+    // A strobe or FIFO write can start or end a packet on this link
+    cc1120_emu_link_update(radio->link);
+
+    return reply;
+}
+
+/**
+ * @brief Starts an SPI transaction with an emulated radio.
+ *
+ * @param bus - The cc1120_emu_radio_t.
+ * @param csPin - Unused, each radio is its own bus.
+ */
+static void cc1120_emu_cs_assert(void *bus, uint8_t csPin) {
+    cc1120_emu_radio_t *radio = (cc1120_emu_radio_t *)bus;
+    (void)csPin;
+
+    radio->spiPos = 0;
+}
+
+/**
+ * @brief Ends an SPI transaction with an emulated radio.
+ *
+ * @param bus - The cc1120_emu_radio_t.
+ * @param csPin - Unused, each radio is its own bus.
+ */
+static void cc1120_emu_cs_deassert(void *bus, uint8_t csPin) {
+    (void)bus;
+    (void)csPin;
+}
+
+const cc1120_transport_ops_t CC1120_EMU_TRANSPORT = {
+    cc1120_emu_transfer,
+    cc1120_emu_cs_assert,
+    cc1120_emu_cs_deassert,
+    NULL,
+    NULL,
+};
+
+/**
+ * @brief Initializes a link with both radios just reset, and puts it on the shared clock behind
+ * mcu_get_time_us. Initializing a link already on the clock resets it in place.
+ *
+ * @param link - The link.
+ * @param channel - The channel, used for both directions. Change link->channel[i] for an asymmetric link.
+ * @param spiByteNs - The virtual time one SPI byte takes.
+ * @param seed - The seed of the error and loss draws, so that a run can be repeated.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the link is on the clock
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If CC1120_EMU_MAX_LINKS other links are already on it
+ */
+cc1120_status_code cc1120_emu_link_init(cc1120_emu_link_t *link, const cc1120_emu_channel_t *channel,
+                                        uint32_t spiByteNs, uint64_t seed) {
+    cc1120_emu_link_remove(link);
+    if (cc1120_emu_link_count >= CC1120_EMU_MAX_LINKS)
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+
+    memset(link, 0, sizeof(*link));
+    link->spiByteNs = spiByteNs;
+    link->nextNs = UINT64_MAX;
+    // xorshift never leaves zero
+    link->rng = seed != 0 ? seed : 0x9E3779B97F4A7C15ULL;
+
+    uint8_t i;
+    for (i = 0; i < 2; i++) {
+        link->channel[i] = *channel;
+        link->radios[i].link = link;
+        link->radios[i].side = i;
+        cc1120_emu_reset(&link->radios[i]);
+    }
+
+    // With no event it belongs at the end
+    cc1120_emu_heap_put(cc1120_emu_link_count++, link);
+    mcu_host_time_us = cc1120_emu_time_us;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Takes a link off the shared clock, e.g. before its memory is reused. Its radios must not be
+ * accessed afterwards.
+ *
+ * @param link - The link. Nothing is done if it is not on the clock.
+ */
+void cc1120_emu_link_remove(cc1120_emu_link_t *link) {
+    uint16_t index = link->heapIndex;
+
+    // The index of a link never initialized is garbage, so check that it points back
+    if (index >= cc1120_emu_link_count || cc1120_emu_heap[index] != link)
+        return;
+
+    cc1120_emu_link_t *last = cc1120_emu_heap[--cc1120_emu_link_count];
+    if (last != link) {
+        cc1120_emu_heap_put(index, last);
+        cc1120_emu_heap_fix(last);
+    }
+    link->heapIndex = UINT16_MAX;
+}
+
+/**
+ * @brief Lets virtual time pass with no SPI traffic on any link, e.g. instead of a delay.
+ *
+ * @param us - The time to pass.
+ */
+void cc1120_emu_advance(uint32_t us) {
+    cc1120_emu_run(cc1120_emu_clock_ns + (uint64_t)us * 1000);
+}
+
+/**
+ * @brief Gets the virtual time of the next byte leaving a TX FIFO or reaching a receiver on any link,
+ * so that idle time can be skipped with cc1120_emu_advance.
+ *
+ * @return uint64_t - The time in nanoseconds, or UINT64_MAX if nothing is being sent or on the air.
+ */
+uint64_t cc1120_emu_next_event(void) {
+    return (cc1120_emu_link_count > 0) ? cc1120_emu_heap[0]->nextNs : UINT64_MAX;
+}
+
+/**
+ * @brief Gets the shared virtual time.
+ *
+ * @return uint64_t - The time in nanoseconds.
+ */
+uint64_t cc1120_emu_time_ns(void) {
+    return cc1120_emu_clock_ns;
+}
+
+#endif
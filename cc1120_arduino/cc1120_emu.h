@@ -0,0 +1,198 @@
+#ifndef CC1120_EMU_H
+#define CC1120_EMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+#include "cc1120_hal.h"
+#include "cc1120_regs.h"
+
+/*
+ * Two-radio link emulator for host builds. Each side is an emulated CC1120 behind CC1120_EMU_TRANSPORT,
+ * so two cc1120_dev_t run the unmodified driver against each other:
+ *
+ *   cc1120_emu_link_init(&link, &channel, 1000, 1);
+ *   cc1120_dev_init(&ground, &CC1120_EMU_TRANSPORT, &link.radios[0], 0);
+ *   cc1120_dev_init(&sat, &CC1120_EMU_TRANSPORT, &link.radios[1], 0);
+ *
+ * Bytes taken from one TX FIFO arrive in the other RX FIFO as they come off the air, timed from the
+ * SYMBOL_RATE, MODCFG_DEV_E, PREAMBLE_CFG1, SYNC_CFG0 and PKT_CFG1 registers plus the propagation delay.
+ * Packet length, CRC_AUTOFLUSH, APPEND_STATUS, TXOFF_MODE and RXOFF_MODE follow the registers, and FIFO
+ * overflows and underflows end in the FIFO error states. The channel drops whole packets and flips bits
+ * with a two-state burst model, and the receiver's CRC check fails when any bit was flipped.
+ *
+ * Time is virtual and shared by every initialized link: an SPI byte on any of them advances the clock by
+ * that link's byte time, and the clock backs mcu_get_time_us, so driver timeouts and polling loops run
+ * much faster than real time. Idle time is skipped with cc1120_emu_advance. Links do not hear each other.
+ *
+ * Not modelled: calibration and settling time, RX timeouts, collisions, GPIO pins (IOCFG has no effect and
+ * nothing drives a pin, so drivers must poll the status registers rather than wait on an interrupt),
+ * frequency and modem settings other than the symbol rate, and the extended register defaults, which read
+ * as zero.
+ */
+
+#if !defined(CC1120_PLATFORM_ARDUINO) && !defined(CC1120_PLATFORM_RM46)
+
+#define CC1120_EMU_FIFO_SIZE 128U
+
+/* Bytes that can be in flight in one direction, enough for the propagation delay at the symbol rate used */
+#ifndef CC1120_EMU_AIR_SIZE
+#define CC1120_EMU_AIR_SIZE 512U
+#endif
+
+/* Links that can share the clock at once */
+#ifndef CC1120_EMU_MAX_LINKS
+#define CC1120_EMU_MAX_LINKS 1024U
+#endif
+
+/* RSSI reported while nothing is being received */
+#ifndef CC1120_EMU_NOISE_DBM
+#define CC1120_EMU_NOISE_DBM (-120)
+#endif
+
+/* Virtual time each mcu_get_time_us call takes, so loops that only read the clock still see it move */
+#ifndef CC1120_EMU_CLOCK_READ_NS
+#define CC1120_EMU_CLOCK_READ_NS 1000U
+#endif
+
+/* One direction of the link */
+typedef struct {
+    double ber;                 /* Bit error probability outside bursts */
+    double burstBer;            /* Bit error probability during a burst */
+    double burstEnter;          /* Probability per bit that a burst starts */
+    double burstExit;           /* Probability per bit that a burst ends */
+    double lossProb;            /* Probability that a whole packet is lost */
+    uint32_t delayUs;           /* Propagation delay */
+    int16_t rssiDbm;            /* RSSI at the receiver */
+    uint8_t lqi;                /* LQI appended to received packets */
+} cc1120_emu_channel_t;
+
+/* Counts for one direction, by the transmitting side */
+typedef struct {
+    uint32_t packetsSent;       /* Packets that left the transmitter whole */
+    uint32_t packetsLost;       /* Dropped by the channel */
+    uint32_t packetsMissed;     /* Arrived while the receiver was not in RX */
+    uint32_t packetsCorrupted;  /* Received with at least one bit flipped */
+    uint32_t packetsFlushed;    /* Removed from the RX FIFO by CRC_AUTOFLUSH, or cut off by a TX underflow */
+    uint32_t packetsDelivered;  /* Left in the receiver's RX FIFO */
+    uint32_t bytesDelivered;    /* Bytes of delivered packets without bit errors, length byte included */
+    uint32_t bitErrors;
+    uint32_t txUnderflows;
+    uint32_t rxOverflows;
+    uint32_t airOverruns;       /* Bytes dropped because CC1120_EMU_AIR_SIZE were already in flight */
+    uint64_t airtimeNs;         /* Time spent transmitting whole packets */
+} cc1120_emu_stats_t;
+
+/* A byte or marker on its way to the receiver */
+typedef struct {
+    uint64_t atNs;
+    uint16_t data;
+} cc1120_emu_air_t;
+
+struct cc1120_emu_link;
+
+typedef struct {
+    struct cc1120_emu_link *link;
+    uint8_t side;               /* Index in link->radios */
+    uint8_t regs[CC1120_REGS_STD_SPACE_SIZE];
+    uint8_t ext[256];
+    uint8_t fifo[256];          /* TX FIFO at 0x00-0x7F and RX FIFO at 0x80-0xFF, as seen by direct access */
+    uint8_t txFirst;
+    uint8_t txCount;
+    uint8_t rxFirst;
+    uint8_t rxCount;
+    uint8_t state;              /* STATE field of the status byte */
+    uint8_t marcStatus1;
+
+    uint8_t spiPos;             /* Byte of the current transaction */
+    uint8_t spiHeader;
+    uint8_t spiAddr;            /* Extended or direct FIFO address */
+
+    uint64_t txNextNs;          /* When the next byte leaves the TX FIFO, or the packet ends */
+    uint32_t txByteNs;
+    uint32_t txHeaderNs;        /* Preamble and sync word */
+    uint32_t txSent;
+    uint8_t txFirstByte;        /* The length byte in variable length mode */
+    uint8_t txCrcBytes;
+    bool txEnding;
+
+    bool rxActive;              /* Synced to a packet */
+    bool rxLost;
+    bool rxCrcOk;
+    uint16_t rxBytes;           /* Bytes of the packet put in the RX FIFO */
+} cc1120_emu_radio_t;
+
+typedef struct cc1120_emu_link {
+    cc1120_emu_radio_t radios[2];
+    cc1120_emu_channel_t channel[2];    /* channel[i] carries what radios[i] sends */
+    cc1120_emu_stats_t stats[2];
+    cc1120_emu_air_t air[2][CC1120_EMU_AIR_SIZE];
+    uint16_t airHead[2];
+    uint16_t airCount[2];
+    bool burst[2];
+    uint32_t spiByteNs;
+    uint64_t rng;
+    uint64_t nextNs;            /* Time of the link's next event, UINT64_MAX for none */
+    uint16_t heapIndex;         /* Place among the links on the shared clock */
+} cc1120_emu_link_t;
+
+/* Transport to an emulated radio, with a cc1120_emu_radio_t as the bus */
+extern const cc1120_transport_ops_t CC1120_EMU_TRANSPORT;
+
+/**
+ * @brief Initializes a link with both radios just reset, and puts it on the shared clock behind
+ * mcu_get_time_us. Initializing a link already on the clock resets it in place.
+ *
+ * @param link - The link.
+ * @param channel - The channel, used for both directions. Change link->channel[i] for an asymmetric link.
+ * @param spiByteNs - The virtual time one SPI byte takes.
+ * @param seed - The seed of the error and loss draws, so that a run can be repeated.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the link is on the clock
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If CC1120_EMU_MAX_LINKS other links are already on it
+ */
+cc1120_status_code cc1120_emu_link_init(cc1120_emu_link_t *link, const cc1120_emu_channel_t *channel,
+                                        uint32_t spiByteNs, uint64_t seed);
+
+/**
+ * @brief Takes a link off the shared clock, e.g. before its memory is reused. Its radios must not be
+ * accessed afterwards.
+ *
+ * @param link - The link. Nothing is done if it is not on the clock.
+ */
+void cc1120_emu_link_remove(cc1120_emu_link_t *link);
+
+/**
+ * @brief Lets virtual time pass with no SPI traffic on any link, e.g. instead of a delay.
+ *
+ * @param us - The time to pass.
+ */
+void cc1120_emu_advance(uint32_t us);
+
+/**
+ * @brief Gets the virtual time of the next byte leaving a TX FIFO or reaching a receiver on any link,
+ * so that idle time can be skipped with cc1120_emu_advance.
+ *
+ * @return uint64_t - The time in nanoseconds, or UINT64_MAX if nothing is being sent or on the air.
+ */
+uint64_t cc1120_emu_next_event(void);
+
+/**
+ * @brief Gets the shared virtual time.
+ *
+ * @return uint64_t - The time in nanoseconds.
+ */
+uint64_t cc1120_emu_time_ns(void);
+
+/**
+ * @brief Computes the airtime of a packet with the radio's current registers.
+ *
+ * @param radio - The radio.
+ * @param len - The packet length in bytes, length byte included and CRC excluded.
+ * @return uint32_t - The airtime in microseconds.
+ */
+uint32_t cc1120_emu_airtime_us(const cc1120_emu_radio_t *radio, uint32_t len);
+
+#endif
+
+#endif /* CC1120_EMU_H */
@@ -0,0 +1,77 @@
+#include "cc1120_fields.h"
+#include "cc1120_spi.h"
+
+/**
+ * @brief Reads a register. Use CC1120_REG_READ, which checks the address at compile time.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param val - Set to the register value.
+ * @return cc1120_status_code - Whether or not the register read was successful
+ */
+cc1120_status_code cc1120_reg_read(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t *val) {
+    if (space == CC1120_SPACE_EXT)
+        return cc1120_read_ext_addr_spi(dev, addr, val, 1);
+
+    return cc1120_read_spi(dev, addr, val, 1);
+}
+
+/**
+ * @brief Writes a register. Use CC1120_REG_WRITE, which checks the address at compile time.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param val - The value to write.
+ * @return cc1120_status_code - Whether or not the register write was successful
+ */
+cc1120_status_code cc1120_reg_write(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t val) {
+    if (space == CC1120_SPACE_EXT)
+        return cc1120_write_ext_addr_spi(dev, addr, &val, 1);
+
+    return cc1120_write_spi(dev, addr, &val, 1);
+}
+
+/**
+ * @brief Reads a field of a register. Use CC1120_FIELD_READ.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param mask - The mask of the field.
+ * @param shift - The position of the field.
+ * @param val - Set to the field value.
+ * @return cc1120_status_code - Whether or not the register read was successful
+ */
+cc1120_status_code cc1120_reg_read_field(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t mask, uint8_t shift,
+                                         uint8_t *val) {
+    cc1120_status_code status = cc1120_reg_read(dev, space, addr, val);
+    RETURN_IF_ERROR(status)
+
+    *val = (*val & mask) >> shift;
+    return status;
+}
+
+/**
+ * @brief Replaces the masked bits of a register, skipping the write if they already hold the value.
+ * Use CC1120_FIELD_WRITE, CC1120_FIELD_WRITE2 or CC1120_FIELD_WRITE3.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param mask - The bits to replace.
+ * @param bits - The new bits, in place.
+ * @return cc1120_status_code - Whether or not the register access was successful
+ */
+cc1120_status_code cc1120_reg_update(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t mask, uint8_t bits) {
+    uint8_t val;
+    cc1120_status_code status = cc1120_reg_read(dev, space, addr, &val);
+    RETURN_IF_ERROR(status)
+
+    uint8_t updated = (val & ~mask) | (bits & mask);
+    if (updated == val)
+        return status;
+
+    return cc1120_reg_write(dev, space, addr, updated);
+}
@@ -0,0 +1,210 @@
+#ifndef CC1120_FIELDS_H
+#define CC1120_FIELDS_H
+
+#include <stdint.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+#include "cc1120_regs.h"
+
+/*
+ * Typed access to registers and bitfields. Each register and field is a compile-time descriptor,
+ * so an invalid address or a write to a read-only field fails to compile, and the masks and shifts
+ * fold into constants. Setting several fields of one register is a single read and at most one write.
+ *
+ *   CC1120_FIELD_WRITE2(dev, RFEND_CFG1_RXOFF_MODE, CC1120_OFF_MODE_IDLE, RFEND_CFG1_RX_TIME, rxTime);
+ *   CC1120_REG_READ(dev, EXT, MARCSTATE, &val);
+ */
+
+#define CC1120_SPACE_STD 0U
+#define CC1120_SPACE_EXT 1U
+
+#define CC1120_ACCESS_R 1U
+#define CC1120_ACCESS_RW 3U
+
+/* Fails to compile when cond is false. cond must be a constant expression. */
+#define CC1120_STATIC_CHECK(cond) ((void)sizeof(char[(cond) ? 1 : -1]))
+
+/* The same ranges the SPI functions check at run time */
+#define CC1120_REG_ADDR_VALID(space, addr)                                                  \
+    ((space) == CC1120_SPACE_STD ? (addr) < CC1120_REGS_EXT_ADDR :                          \
+     !(((addr) > CC1120_REGS_EXT_PA_CFG3 && (addr) < CC1120_REGS_EXT_WOR_TIME1) ||          \
+       ((addr) > CC1120_REGS_EXT_XOSC_TEST0 && (addr) < CC1120_REGS_EXT_RXFIRST) ||         \
+       (addr) > CC1120_REGS_EXT_FIFO_NUM_RXBYTES))
+
+/* Register addresses by name: CC1120_REGS_<name> for STD, CC1120_REGS_EXT_<name> for EXT */
+#define CC1120_REG_ADDR_STD(name) CC1120_REGS_##name
+#define CC1120_REG_ADDR_EXT(name) CC1120_REGS_EXT_##name
+
+/**
+ * Whole-register access by name, checked at compile time.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - STD or EXT.
+ * @param name - The register name, e.g. PKT_CFG0.
+ */
+#define CC1120_REG_READ(dev, space, name, val)                                              \
+    (CC1120_STATIC_CHECK(CC1120_REG_ADDR_VALID(CC1120_SPACE_##space, CC1120_REG_ADDR_##space(name))), \
+     cc1120_reg_read((dev), CC1120_SPACE_##space, CC1120_REG_ADDR_##space(name), (val)))
+#define CC1120_REG_WRITE(dev, space, name, val)                                             \
+    (CC1120_STATIC_CHECK(CC1120_REG_ADDR_VALID(CC1120_SPACE_##space, CC1120_REG_ADDR_##space(name))), \
+     cc1120_reg_write((dev), CC1120_SPACE_##space, CC1120_REG_ADDR_##space(name), (val)))
+
+/*
+ * Field descriptors: space, address, access, mask, shift.
+ * Named CC1120_FIELD_<register>_<field> after the user guide, and used without the CC1120_FIELD_ prefix.
+ */
+#define CC1120_FIELD_PREAMBLE_CFG0_PQT_EN               CC1120_SPACE_STD, CC1120_REGS_PREAMBLE_CFG0, CC1120_ACCESS_RW, CC1120_PREAMBLE_CFG0_PQT_EN, 5U
+#define CC1120_FIELD_PREAMBLE_CFG0_PQT_VALID_TIMEOUT    CC1120_SPACE_STD, CC1120_REGS_PREAMBLE_CFG0, CC1120_ACCESS_RW, 0x10U, 4U
+#define CC1120_FIELD_PREAMBLE_CFG0_PQT                  CC1120_SPACE_STD, CC1120_REGS_PREAMBLE_CFG0, CC1120_ACCESS_RW, CC1120_PREAMBLE_CFG0_PQT_MASK, 0U
+
+#define CC1120_FIELD_SETTLING_CFG_FS_AUTOCAL            CC1120_SPACE_STD, CC1120_REGS_SETTLING_CFG, CC1120_ACCESS_RW, CC1120_SETTLING_CFG_FS_AUTOCAL_MASK, 3U
+#define CC1120_FIELD_SETTLING_CFG_LOCK_TIME             CC1120_SPACE_STD, CC1120_REGS_SETTLING_CFG, CC1120_ACCESS_RW, 0x06U, 1U
+#define CC1120_FIELD_SETTLING_CFG_FSREG_TIME            CC1120_SPACE_STD, CC1120_REGS_SETTLING_CFG, CC1120_ACCESS_RW, 0x01U, 0U
+
+#define CC1120_FIELD_WOR_CFG1_WOR_RES                   CC1120_SPACE_STD, CC1120_REGS_WOR_CFG1, CC1120_ACCESS_RW, 0xC0U, CC1120_WOR_CFG1_WOR_RES_SHIFT
+#define CC1120_FIELD_WOR_CFG1_WOR_MODE                  CC1120_SPACE_STD, CC1120_REGS_WOR_CFG1, CC1120_ACCESS_RW, 0x38U, CC1120_WOR_CFG1_WOR_MODE_SHIFT
+#define CC1120_FIELD_WOR_CFG1_EVENT1                    CC1120_SPACE_STD, CC1120_REGS_WOR_CFG1, CC1120_ACCESS_RW, CC1120_WOR_CFG1_EVENT1_MASK, 0U
+
+#define CC1120_FIELD_WOR_CFG0_DIV_256HZ_EN              CC1120_SPACE_STD, CC1120_REGS_WOR_CFG0, CC1120_ACCESS_RW, CC1120_WOR_CFG0_DIV_256HZ_EN, 5U
+#define CC1120_FIELD_WOR_CFG0_EVENT2_CFG                CC1120_SPACE_STD, CC1120_REGS_WOR_CFG0, CC1120_ACCESS_RW, 0x18U, 3U
+#define CC1120_FIELD_WOR_CFG0_RC_MODE                   CC1120_SPACE_STD, CC1120_REGS_WOR_CFG0, CC1120_ACCESS_RW, 0x06U, 1U
+#define CC1120_FIELD_WOR_CFG0_RC_PD                     CC1120_SPACE_STD, CC1120_REGS_WOR_CFG0, CC1120_ACCESS_RW, CC1120_WOR_CFG0_RC_PD, 0U
+
+#define CC1120_FIELD_PKT_CFG2_CCA_MODE                  CC1120_SPACE_STD, CC1120_REGS_PKT_CFG2, CC1120_ACCESS_RW, CC1120_PKT_CFG2_CCA_MODE_MASK, CC1120_PKT_CFG2_CCA_MODE_SHIFT
+#define CC1120_FIELD_PKT_CFG2_PKT_FORMAT                CC1120_SPACE_STD, CC1120_REGS_PKT_CFG2, CC1120_ACCESS_RW, 0x03U, 0U
+
+#define CC1120_FIELD_PKT_CFG0_LENGTH_CONFIG             CC1120_SPACE_STD, CC1120_REGS_PKT_CFG0, CC1120_ACCESS_RW, 0x60U, 5U
+#define CC1120_FIELD_PKT_CFG0_PKT_BIT_LEN               CC1120_SPACE_STD, CC1120_REGS_PKT_CFG0, CC1120_ACCESS_RW, 0x1CU, 2U
+#define CC1120_FIELD_PKT_CFG0_UART_MODE_EN              CC1120_SPACE_STD, CC1120_REGS_PKT_CFG0, CC1120_ACCESS_RW, 0x02U, 1U
+#define CC1120_FIELD_PKT_CFG0_UART_SWAP_EN              CC1120_SPACE_STD, CC1120_REGS_PKT_CFG0, CC1120_ACCESS_RW, 0x01U, 0U
+
+#define CC1120_FIELD_RFEND_CFG1_RXOFF_MODE              CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG1, CC1120_ACCESS_RW, CC1120_RFEND_CFG1_RXOFF_MODE_MASK, CC1120_RFEND_OFF_MODE_SHIFT
+#define CC1120_FIELD_RFEND_CFG1_RX_TIME                 CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG1, CC1120_ACCESS_RW, CC1120_RFEND_CFG1_RX_TIME_MASK, CC1120_RFEND_CFG1_RX_TIME_SHIFT
+#define CC1120_FIELD_RFEND_CFG1_RX_TIME_QUAL            CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG1, CC1120_ACCESS_RW, CC1120_RFEND_CFG1_RX_TIME_QUAL, 0U
+
+#define CC1120_FIELD_RFEND_CFG0_CAL_END_WAKE_UP_EN      CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG0, CC1120_ACCESS_RW, 0x40U, 6U
+#define CC1120_FIELD_RFEND_CFG0_TXOFF_MODE              CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG0, CC1120_ACCESS_RW, CC1120_RFEND_CFG0_TXOFF_MODE_MASK, CC1120_RFEND_OFF_MODE_SHIFT
+#define CC1120_FIELD_RFEND_CFG0_TERM_ON_BAD_PACKET_EN   CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG0, CC1120_ACCESS_RW, 0x08U, 3U
+#define CC1120_FIELD_RFEND_CFG0_ANT_DIV_RX_TERM_CFG     CC1120_SPACE_STD, CC1120_REGS_RFEND_CFG0, CC1120_ACCESS_RW, 0x07U, 0U
+
+#define CC1120_FIELD_MARCSTATE_MARC_2PIN_STATE          CC1120_SPACE_EXT, CC1120_REGS_EXT_MARCSTATE, CC1120_ACCESS_R, 0x60U, 5U
+#define CC1120_FIELD_MARCSTATE_MARC_STATE               CC1120_SPACE_EXT, CC1120_REGS_EXT_MARCSTATE, CC1120_ACCESS_R, CC1120_MARCSTATE_MASK, 0U
+
+#define CC1120_FIELD_RNDGEN_RNDGEN_EN                   CC1120_SPACE_EXT, CC1120_REGS_EXT_RNDGEN, CC1120_ACCESS_RW, CC1120_RNDGEN_EN, 7U
+#define CC1120_FIELD_RNDGEN_RNDGEN_VALUE                CC1120_SPACE_EXT, CC1120_REGS_EXT_RNDGEN, CC1120_ACCESS_R, CC1120_RNDGEN_VALUE_MASK, 0U
+
+/* PKT_CFG0.LENGTH_CONFIG values */
+#define CC1120_LENGTH_CONFIG_FIXED          0x00U
+#define CC1120_LENGTH_CONFIG_VARIABLE       0x01U
+#define CC1120_LENGTH_CONFIG_INFINITE       0x02U
+
+/* Descriptor parts. The extra level expands the descriptor into its arguments. */
+#define CC1120_FIELD_SPACE_(space, addr, access, mask, shift) (space)
+#define CC1120_FIELD_ADDR_(space, addr, access, mask, shift) (addr)
+#define CC1120_FIELD_ACCESS_(space, addr, access, mask, shift) (access)
+#define CC1120_FIELD_MASK_(space, addr, access, mask, shift) ((uint8_t)(mask))
+#define CC1120_FIELD_SHIFT_(space, addr, access, mask, shift) (shift)
+#define CC1120_FIELD_APPLY_(part, desc) part(desc)
+
+#define CC1120_FIELD_SPACE(f) CC1120_FIELD_APPLY_(CC1120_FIELD_SPACE_, CC1120_FIELD_##f)
+#define CC1120_FIELD_ADDR(f) CC1120_FIELD_APPLY_(CC1120_FIELD_ADDR_, CC1120_FIELD_##f)
+#define CC1120_FIELD_ACCESS(f) CC1120_FIELD_APPLY_(CC1120_FIELD_ACCESS_, CC1120_FIELD_##f)
+#define CC1120_FIELD_MASK(f) CC1120_FIELD_APPLY_(CC1120_FIELD_MASK_, CC1120_FIELD_##f)
+#define CC1120_FIELD_SHIFT(f) CC1120_FIELD_APPLY_(CC1120_FIELD_SHIFT_, CC1120_FIELD_##f)
+
+/* A field value placed in its register, and a field value taken out of its register */
+#define CC1120_FIELD_VAL(f, v) ((uint8_t)(((uint8_t)(v) << CC1120_FIELD_SHIFT(f)) & CC1120_FIELD_MASK(f)))
+#define CC1120_FIELD_GET(f, reg) ((uint8_t)(((reg) & CC1120_FIELD_MASK(f)) >> CC1120_FIELD_SHIFT(f)))
+
+#define CC1120_FIELD_CHECK_WRITABLE_(f)                                                     \
+    CC1120_STATIC_CHECK(CC1120_FIELD_ACCESS(f) == CC1120_ACCESS_RW &&                       \
+                        CC1120_REG_ADDR_VALID(CC1120_FIELD_SPACE(f), CC1120_FIELD_ADDR(f)))
+#define CC1120_FIELD_CHECK_SAME_REG_(f1, f2)                                                \
+    CC1120_STATIC_CHECK(CC1120_FIELD_SPACE(f1) == CC1120_FIELD_SPACE(f2) &&                 \
+                        CC1120_FIELD_ADDR(f1) == CC1120_FIELD_ADDR(f2))
+
+/**
+ * Reads one field of a register.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param f - The field name, e.g. MARCSTATE_MARC_STATE.
+ * @param val - A uint8_t * set to the field value.
+ */
+#define CC1120_FIELD_READ(dev, f, val)                                                      \
+    (CC1120_STATIC_CHECK(CC1120_REG_ADDR_VALID(CC1120_FIELD_SPACE(f), CC1120_FIELD_ADDR(f))), \
+     cc1120_reg_read_field((dev), CC1120_FIELD_SPACE(f), CC1120_FIELD_ADDR(f), CC1120_FIELD_MASK(f), \
+                           CC1120_FIELD_SHIFT(f), (val)))
+
+/**
+ * Sets one, two or three fields of the same register with one read and at most one write.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param fN - The field names, e.g. RFEND_CFG1_RXOFF_MODE.
+ * @param vN - The field values, unshifted.
+ */
+#define CC1120_FIELD_WRITE(dev, f1, v1)                                                     \
+    (CC1120_FIELD_CHECK_WRITABLE_(f1),                                                      \
+     cc1120_reg_update((dev), CC1120_FIELD_SPACE(f1), CC1120_FIELD_ADDR(f1), CC1120_FIELD_MASK(f1), \
+                       CC1120_FIELD_VAL(f1, v1)))
+#define CC1120_FIELD_WRITE2(dev, f1, v1, f2, v2)                                            \
+    (CC1120_FIELD_CHECK_WRITABLE_(f1), CC1120_FIELD_CHECK_WRITABLE_(f2), CC1120_FIELD_CHECK_SAME_REG_(f1, f2), \
+     cc1120_reg_update((dev), CC1120_FIELD_SPACE(f1), CC1120_FIELD_ADDR(f1),                \
+                       CC1120_FIELD_MASK(f1) | CC1120_FIELD_MASK(f2),                       \
+                       CC1120_FIELD_VAL(f1, v1) | CC1120_FIELD_VAL(f2, v2)))
+#define CC1120_FIELD_WRITE3(dev, f1, v1, f2, v2, f3, v3)                                    \
+    (CC1120_FIELD_CHECK_WRITABLE_(f1), CC1120_FIELD_CHECK_WRITABLE_(f2), CC1120_FIELD_CHECK_WRITABLE_(f3), \
+     CC1120_FIELD_CHECK_SAME_REG_(f1, f2), CC1120_FIELD_CHECK_SAME_REG_(f1, f3),            \
+     cc1120_reg_update((dev), CC1120_FIELD_SPACE(f1), CC1120_FIELD_ADDR(f1),                \
+                       CC1120_FIELD_MASK(f1) | CC1120_FIELD_MASK(f2) | CC1120_FIELD_MASK(f3), \
+                       CC1120_FIELD_VAL(f1, v1) | CC1120_FIELD_VAL(f2, v2) | CC1120_FIELD_VAL(f3, v3)))
+
+/**
+ * @brief Reads a register. Use CC1120_REG_READ, which checks the address at compile time.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param val - Set to the register value.
+ * @return cc1120_status_code - Whether or not the register read was successful
+ */
+cc1120_status_code cc1120_reg_read(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t *val);
+
+/**
+ * @brief Writes a register. Use CC1120_REG_WRITE, which checks the address at compile time.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param val - The value to write.
+ * @return cc1120_status_code - Whether or not the register write was successful
+ */
+cc1120_status_code cc1120_reg_write(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t val);
+
+/**
+ * @brief Reads a field of a register. Use CC1120_FIELD_READ.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param mask - The mask of the field.
+ * @param shift - The position of the field.
+ * @param val - Set to the field value.
+ * @return cc1120_status_code - Whether or not the register read was successful
+ */
+cc1120_status_code cc1120_reg_read_field(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t mask, uint8_t shift,
+                                         uint8_t *val);
+
+/**
+ * @brief Replaces the masked bits of a register, skipping the write if they already hold the value.
+ * Use CC1120_FIELD_WRITE, CC1120_FIELD_WRITE2 or CC1120_FIELD_WRITE3.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param space - CC1120_SPACE_STD or CC1120_SPACE_EXT.
+ * @param addr - The register address.
+ * @param mask - The bits to replace.
+ * @param bits - The new bits, in place.
+ * @return cc1120_status_code - Whether or not the register access was successful
+ */
+cc1120_status_code cc1120_reg_update(cc1120_dev_t *dev, uint8_t space, uint8_t addr, uint8_t mask, uint8_t bits);
+
+#endif /* CC1120_FIELDS_H */
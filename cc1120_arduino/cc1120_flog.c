@@ -0,0 +1,394 @@
+#include "cc1120_flog.h"
+#include "cc1120_mcu.h"
+#include <string.h>
+#if !defined(CC1120_PLATFORM_ARDUINO) && !defined(CC1120_PLATFORM_RM46)
+#include <stdio.h>
+#endif
+
+/**
+ * @brief Computes the CRC-16/CCITT of a block.
+ *
+ * @param crc - The CRC so far, 0xFFFF to start.
+ * @param data - The block.
+ * @param len - The number of bytes.
+ * @return uint16_t - The updated CRC.
+ */
+static uint16_t cc1120_flog_crc(uint16_t crc, const uint8_t *data, uint16_t len) {
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        uint8_t bit;
+        crc ^= (uint16_t)data[i] << 8;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+
+    return crc;
+}
+
+/**
+ * @brief Checks the header and CRC of a page read from flash.
+ *
+ * @param data - The page.
+ * @param seq - Set to the sequence number of a valid page.
+ * @return true - If the page is valid.
+ * @return false - If it is erased or torn.
+ */
+static bool cc1120_flog_page_valid(const uint8_t data[CC1120_FLOG_PAGE_SIZE], uint32_t *seq) {
+    uint16_t magic = (uint16_t)(data[0] | (data[1] << 8));
+    uint16_t len = (uint16_t)(data[6] | (data[7] << 8));
+    uint16_t crc = (uint16_t)(data[8] | (data[9] << 8));
+
+    if (magic != CC1120_FLOG_MAGIC || len > CC1120_FLOG_PAYLOAD_LEN)
+        return false;
+
+    uint16_t computed = cc1120_flog_crc(0xFFFFU, &data[2], 6);
+    computed = cc1120_flog_crc(computed, &data[CC1120_FLOG_HEADER_LEN], len);
+    if (computed != crc)
+        return false;
+
+    *seq = (uint32_t)data[2] | ((uint32_t)data[3] << 8) | ((uint32_t)data[4] << 16) | ((uint32_t)data[5] << 24);
+    return true;
+}
+
+/**
+ * @brief Checks whether a page is still erased.
+ *
+ * @param data - The page.
+ * @return true - If every byte is 0xFF.
+ * @return false - If anything was programmed.
+ */
+static bool cc1120_flog_page_erased(const uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    uint16_t i;
+    for (i = 0; i < CC1120_FLOG_PAGE_SIZE; i++) {
+        if (data[i] != 0xFFU)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Moves the write position to the next page, wrapping round the sectors.
+ *
+ * @param log - The log.
+ */
+static void cc1120_flog_advance(cc1120_flog_t *log) {
+    if (++log->page < CC1120_FLOG_PAGES_PER_SECTOR)
+        return;
+
+    log->page = 0;
+    if (++log->sector == CC1120_FLOG_SECTORS)
+        log->sector = 0;
+}
+
+/**
+ * @brief Finds the newest page in flash and continues the log after it.
+ *
+ * @param log - The log.
+ * @param ops - The flash primitives.
+ * @param ctx - Passed to every flash call.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the log was mounted, empty or not.
+ * @return CC1120_ERROR_CODE_FLASH_FAILED - If a page could not be read.
+ */
+cc1120_status_code cc1120_flog_mount(cc1120_flog_t *log, const cc1120_flog_flash_ops_t *ops, void *ctx) {
+    uint8_t scratch[CC1120_FLOG_PAGE_SIZE];
+    uint32_t newest = 0;
+    bool found = false;
+    uint16_t s;
+    uint16_t p;
+
+    // The buffers are kept, so messages appended before mounting are not lost
+    memset(&log->stats, 0, sizeof(log->stats));
+    log->ops = ops;
+    log->ctx = ctx;
+    log->sector = 0;
+    log->page = 0;
+    log->seq = 0;
+
+    // Sectors are filled from their first page, so the first pages are enough to find the newest sector
+    for (s = 0; s < CC1120_FLOG_SECTORS; s++) {
+        uint32_t seq;
+        if (!ops->read(ctx, s, 0, scratch)) {
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_flog_mount: Flash read failed!\n");
+            return CC1120_ERROR_CODE_FLASH_FAILED;
+        }
+
+        if (cc1120_flog_page_valid(scratch, &seq) && (!found || seq > newest)) {
+            newest = seq;
+            log->sector = s;
+            found = true;
+        }
+    }
+
+    if (!found)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    // Resume at the first erased page after the newest sector's first page, skipping torn ones
+    for (p = 1; p < CC1120_FLOG_PAGES_PER_SECTOR; p++) {
+        uint32_t seq;
+        if (!ops->read(ctx, log->sector, p, scratch)) {
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_flog_mount: Flash read failed!\n");
+            return CC1120_ERROR_CODE_FLASH_FAILED;
+        }
+
+        if (cc1120_flog_page_valid(scratch, &seq)) {
+            if (seq > newest)
+                newest = seq;
+        } else if (cc1120_flog_page_erased(scratch)) {
+            break;
+        } else {
+            log->stats.tornPages++;
+        }
+    }
+
+    log->page = p - 1;
+    cc1120_flog_advance(log);
+    log->seq = newest + 1;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Appends a message to the RAM buffer. Does not touch flash, so it is safe on SPI paths and in ISRs.
+ * Interrupts are masked while the message is copied.
+ *
+ * @param log - The log.
+ * @param level - The log level.
+ * @param str - The message.
+ */
+void cc1120_flog_append(cc1120_flog_t *log, cc1120_log_level_t level, const char str[]) {
+    uint8_t prefix[2] = { (uint8_t)('0' + level), ' ' };
+    const uint8_t *parts[2] = { prefix, (const uint8_t *)str };
+    uint16_t lens[2] = { sizeof(prefix), (uint16_t)strlen(str) };
+    uint8_t i;
+
+    uint32_t irq = cc1120_hal_irq_save();
+    for (i = 0; i < 2; i++) {
+        const uint8_t *src = parts[i];
+        uint16_t left = lens[i];
+
+        while (left > 0) {
+            cc1120_flog_buf_t *buf = &log->bufs[log->active];
+            if (buf->ready) {
+                log->stats.dropped += left;
+                break;
+            }
+
+            uint16_t n = CC1120_FLOG_PAYLOAD_LEN - buf->len;
+            if (n > left)
+                n = left;
+
+            memcpy(&buf->data[CC1120_FLOG_HEADER_LEN + buf->len], src, n);
+            buf->len += n;
+            src += n;
+            left -= n;
+            log->stats.appended += n;
+
+            if (buf->len == CC1120_FLOG_PAYLOAD_LEN) {
+                buf->ready = true;
+                log->active ^= 1U;
+            }
+        }
+    }
+    cc1120_hal_irq_restore(irq);
+}
+
+/**
+ * @brief Writes one buffer to the next page, erasing the sector when the page is its first.
+ *
+ * @param log - The log.
+ * @param buf - The buffer, which is ready.
+ * @return cc1120_status_code - Whether or not the erase and program were successful
+ */
+static cc1120_status_code cc1120_flog_write_buf(cc1120_flog_t *log, cc1120_flog_buf_t *buf) {
+    if (log->page == 0) {
+        if (!log->ops->erase(log->ctx, log->sector)) {
+            log->stats.flashErrors++;
+            // Leave a sector that will not erase, rather than retrying it forever
+            log->page = CC1120_FLOG_PAGES_PER_SECTOR - 1;
+            cc1120_flog_advance(log);
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_flog_write_buf: Flash erase failed!\n");
+            return CC1120_ERROR_CODE_FLASH_FAILED;
+        }
+        log->stats.erases++;
+    }
+
+    uint8_t *data = buf->data;
+    uint16_t len = buf->len;
+    data[0] = (uint8_t)CC1120_FLOG_MAGIC;
+    data[1] = (uint8_t)(CC1120_FLOG_MAGIC >> 8);
+    data[2] = (uint8_t)log->seq;
+    data[3] = (uint8_t)(log->seq >> 8);
+    data[4] = (uint8_t)(log->seq >> 16);
+    data[5] = (uint8_t)(log->seq >> 24);
+    data[6] = (uint8_t)len;
+    data[7] = (uint8_t)(len >> 8);
+
+    uint16_t crc = cc1120_flog_crc(0xFFFFU, &data[2], 6);
+    crc = cc1120_flog_crc(crc, &data[CC1120_FLOG_HEADER_LEN], len);
+    data[8] = (uint8_t)crc;
+    data[9] = (uint8_t)(crc >> 8);
+
+    // Leave the unused tail erased
+    memset(&data[CC1120_FLOG_HEADER_LEN + len], 0xFF, CC1120_FLOG_PAYLOAD_LEN - len);
+
+    bool programmed = log->ops->program(log->ctx, log->sector, log->page, data);
+    // A failed program may have cleared some bits, so the page cannot be reused either way
+    cc1120_flog_advance(log);
+
+    if (!programmed) {
+        log->stats.flashErrors++;
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_flog_write_buf: Flash program failed!\n");
+        return CC1120_ERROR_CODE_FLASH_FAILED;
+    }
+
+    log->seq++;
+    log->stats.pagesWritten++;
+    buf->len = 0;
+    buf->ready = false;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Writes the buffers that are full to flash. Call from a low-priority context.
+ *
+ * @param log - The log.
+ * @return CC1120_ERROR_CODE_SUCCESS - If nothing was waiting, or it was written.
+ * @return CC1120_ERROR_CODE_FLASH_FAILED - If an erase or program failed. The buffer is retried on the next page.
+ */
+cc1120_status_code cc1120_flog_flush(cc1120_flog_t *log) {
+    cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
+    uint8_t i;
+
+    // Buffers become ready alternately, so they are written alternately too
+    for (i = 0; i < 2; i++) {
+        cc1120_flog_buf_t *buf = &log->bufs[log->flushNext];
+        if (!buf->ready)
+            break;
+
+        status = cc1120_flog_write_buf(log, buf);
+        RETURN_IF_ERROR(status)
+
+        log->flushNext ^= 1U;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Writes the partly filled buffer too, e.g. before a planned power down.
+ *
+ * @param log - The log.
+ * @return cc1120_status_code - As cc1120_flog_flush.
+ */
+cc1120_status_code cc1120_flog_sync(cc1120_flog_t *log) {
+    uint32_t irq = cc1120_hal_irq_save();
+    cc1120_flog_buf_t *buf = &log->bufs[log->active];
+    if (!buf->ready && buf->len > 0) {
+        buf->ready = true;
+        log->active ^= 1U;
+    }
+    cc1120_hal_irq_restore(irq);
+
+    return cc1120_flog_flush(log);
+}
+
+#if !defined(CC1120_PLATFORM_ARDUINO) && !defined(CC1120_PLATFORM_RM46)
+/**
+ * @brief Seeks the backing file to a page.
+ *
+ * @param file - The backing file.
+ * @param sector - The sector.
+ * @param page - The page in the sector.
+ * @return true - If the seek succeeded.
+ * @return false - If it failed.
+ */
+static bool cc1120_flog_file_seek(FILE *file, uint16_t sector, uint16_t page) {
+    long offset = ((long)sector * CC1120_FLOG_PAGES_PER_SECTOR + page) * (long)CC1120_FLOG_PAGE_SIZE;
+    return fseek(file, offset, SEEK_SET) == 0;
+}
+
+/**
+ * @brief Reads a page of the backing file. Past the end of the file reads as erased.
+ *
+ * @param ctx - The backing FILE*.
+ * @param sector - The sector.
+ * @param page - The page in the sector.
+ * @param data - Filled with the page.
+ * @return true - If the read succeeded.
+ * @return false - If the file could not be read.
+ */
+static bool cc1120_flog_file_read(void *ctx, uint16_t sector, uint16_t page, uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    FILE *file = (FILE *)ctx;
+    if (!cc1120_flog_file_seek(file, sector, page))
+        return false;
+
+    size_t n = fread(data, 1, CC1120_FLOG_PAGE_SIZE, file);
+    if (n < CC1120_FLOG_PAGE_SIZE && ferror(file))
+        return false;
+
+    memset(&data[n], 0xFF, CC1120_FLOG_PAGE_SIZE - n);
+    return true;
+}
+
+/**
+ * @brief Erases a sector of the backing file to 0xFF.
+ *
+ * @param ctx - The backing FILE*.
+ * @param sector - The sector.
+ * @return true - If the write succeeded.
+ * @return false - If it failed.
+ */
+static bool cc1120_flog_file_erase(void *ctx, uint16_t sector) {
+    FILE *file = (FILE *)ctx;
+    uint8_t erased[CC1120_FLOG_PAGE_SIZE];
+    uint16_t p;
+
+    memset(erased, 0xFF, sizeof(erased));
+    if (!cc1120_flog_file_seek(file, sector, 0))
+        return false;
+
+    for (p = 0; p < CC1120_FLOG_PAGES_PER_SECTOR; p++) {
+        if (fwrite(erased, 1, sizeof(erased), file) != sizeof(erased))
+            return false;
+    }
+
+    return fflush(file) == 0;
+}
+
+/**
+ * @brief Programs a page of the backing file. Like NOR flash, only clears bits.
+ *
+ * @param ctx - The backing FILE*.
+ * @param sector - The sector.
+ * @param page - The page in the sector.
+ * @param data - The page to program.
+ * @return true - If the write succeeded.
+ * @return false - If it failed.
+ */
+static bool cc1120_flog_file_program(void *ctx, uint16_t sector, uint16_t page,
+                                     const uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    FILE *file = (FILE *)ctx;
+    uint8_t current[CC1120_FLOG_PAGE_SIZE];
+    uint16_t i;
+
+    if (!cc1120_flog_file_read(ctx, sector, page, current))
+        return false;
+
+    for (i = 0; i < CC1120_FLOG_PAGE_SIZE; i++)
+        current[i] &= data[i];
+
+    if (!cc1120_flog_file_seek(file, sector, page))
+        return false;
+
+    if (fwrite(current, 1, sizeof(current), file) != sizeof(current))
+        return false;
+
+    return fflush(file) == 0;
+}
+
+const cc1120_flog_flash_ops_t CC1120_FLOG_FILE_OPS = {
+    cc1120_flog_file_erase,
+    cc1120_flog_file_program,
+    cc1120_flog_file_read,
+};
+#endif
@@ -0,0 +1,112 @@
+#ifndef CC1120_FLOG_H
+#define CC1120_FLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_hal.h"
+
+/*
+ * Log backend that appends into a RAM double buffer and writes whole flash pages from a low-priority context.
+ * Pages go round a ring of sectors, so every sector is erased equally often, and mounting resumes after
+ * the newest page instead of at the first sector. Each page carries a sequence number and a CRC, so after
+ * a power loss a torn page is skipped and at most the page being written is lost.
+ *
+ * The log must start zeroed, e.g. in static storage, so that messages can be appended before it is mounted.
+ *
+ * Page layout, little-endian: u16 magic, u32 sequence, u16 payload length, u16 CRC-16/CCITT of the
+ * sequence, length and payload, then the payload. Records are "<level digit> <message>" and may span pages.
+ */
+
+#ifndef CC1120_FLOG_PAGE_SIZE
+#define CC1120_FLOG_PAGE_SIZE 256U
+#endif
+#ifndef CC1120_FLOG_PAGES_PER_SECTOR
+#define CC1120_FLOG_PAGES_PER_SECTOR 16U
+#endif
+#ifndef CC1120_FLOG_SECTORS
+#define CC1120_FLOG_SECTORS 8U
+#endif
+
+#define CC1120_FLOG_MAGIC 0x4C47U
+#define CC1120_FLOG_HEADER_LEN 10U
+#define CC1120_FLOG_PAYLOAD_LEN (CC1120_FLOG_PAGE_SIZE - CC1120_FLOG_HEADER_LEN)
+
+/* Flash primitives. Each returns false on failure. Programming only clears bits, erasing sets them. */
+typedef struct {
+    bool (*erase)(void *ctx, uint16_t sector);
+    bool (*program)(void *ctx, uint16_t sector, uint16_t page, const uint8_t data[CC1120_FLOG_PAGE_SIZE]);
+    bool (*read)(void *ctx, uint16_t sector, uint16_t page, uint8_t data[CC1120_FLOG_PAGE_SIZE]);
+} cc1120_flog_flash_ops_t;
+
+typedef struct {
+    uint32_t appended;          /* Bytes accepted into the buffers */
+    uint32_t dropped;           /* Bytes lost because both buffers were waiting for flash */
+    uint32_t pagesWritten;
+    uint32_t erases;
+    uint32_t flashErrors;
+    uint32_t tornPages;         /* Pages found unreadable at mount */
+} cc1120_flog_stats_t;
+
+typedef struct {
+    uint8_t data[CC1120_FLOG_PAGE_SIZE];
+    uint16_t len;               /* Payload bytes */
+    volatile bool ready;        /* Full, or synced, and waiting for flash */
+} cc1120_flog_buf_t;
+
+typedef struct {
+    const cc1120_flog_flash_ops_t *ops;
+    void *ctx;
+    cc1120_flog_buf_t bufs[2];
+    uint8_t active;             /* Buffer being appended to */
+    uint8_t flushNext;          /* Buffer to write next */
+    uint16_t sector;            /* Next page to write */
+    uint16_t page;
+    uint32_t seq;
+    cc1120_flog_stats_t stats;
+} cc1120_flog_t;
+
+/**
+ * @brief Finds the newest page in flash and continues the log after it.
+ *
+ * @param log - The log.
+ * @param ops - The flash primitives.
+ * @param ctx - Passed to every flash call.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the log was mounted, empty or not.
+ * @return CC1120_ERROR_CODE_FLASH_FAILED - If a page could not be read.
+ */
+cc1120_status_code cc1120_flog_mount(cc1120_flog_t *log, const cc1120_flog_flash_ops_t *ops, void *ctx);
+
+/**
+ * @brief Appends a message to the RAM buffer. Does not touch flash, so it is safe on SPI paths and in ISRs.
+ * Interrupts are masked while the message is copied.
+ *
+ * @param log - The log.
+ * @param level - The log level.
+ * @param str - The message.
+ */
+void cc1120_flog_append(cc1120_flog_t *log, cc1120_log_level_t level, const char str[]);
+
+/**
+ * @brief Writes the buffers that are full to flash. Call from a low-priority context.
+ *
+ * @param log - The log.
+ * @return CC1120_ERROR_CODE_SUCCESS - If nothing was waiting, or it was written.
+ * @return CC1120_ERROR_CODE_FLASH_FAILED - If an erase or program failed. The buffer is retried on the next page.
+ */
+cc1120_status_code cc1120_flog_flush(cc1120_flog_t *log);
+
+/**
+ * @brief Writes the partly filled buffer too, e.g. before a planned power down.
+ *
+ * @param log - The log.
+ * @return cc1120_status_code - As cc1120_flog_flush.
+ */
+cc1120_status_code cc1120_flog_sync(cc1120_flog_t *log);
+
+#if !defined(CC1120_PLATFORM_ARDUINO) && !defined(CC1120_PLATFORM_RM46)
+/* Host flash backed by a regular file of CC1120_FLOG_SECTORS sectors. ctx is the FILE*, opened "r+b" or "w+b". */
+extern const cc1120_flog_flash_ops_t CC1120_FLOG_FILE_OPS;
+#endif
+
+#endif /* CC1120_FLOG_H */
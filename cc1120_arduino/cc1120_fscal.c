@@ -0,0 +1,211 @@
+#include "cc1120_fscal.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+
+/**
+ * @brief Sets the FREQ2..0 word of a channel from a frequency in Hz and invalidates its calibration.
+ *
+ * @param channel - The channel to update.
+ * @param freqHz - The RF frequency in Hz.
+ */
+void cc1120_fscal_set_freq(cc1120_fscal_channel_t *channel, uint32_t freqHz) {
+    uint32_t word = CC1120_FREQ_WORD(freqHz);
+
+    channel->freq[0] = (uint8_t)(word >> 16);
+    channel->freq[1] = (uint8_t)(word >> 8);
+    channel->freq[2] = (uint8_t)word;
+    channel->calValid = false;
+}
+
+/**
+ * @brief Initializes a calibration cache over a channel table.
+ * The channel frequencies must already be set, either with CC1120_FSCAL_CHANNEL or cc1120_fscal_set_freq.
+ *
+ * @param cache - The cache to initialize.
+ * @param channels - The channel table.
+ * @param numChannels - The number of channels in the table.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the cache was initialized.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If there are no channels.
+ */
+cc1120_status_code cc1120_fscal_init(cc1120_fscal_cache_t *cache, cc1120_fscal_channel_t channels[], uint8_t numChannels) {
+    if (numChannels < 1) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_fscal_init: Not a valid number of channels!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    cache->channels = channels;
+    cache->numChannels = numChannels;
+    cache->settlingCfg = CC1120_DEFAULTS_SETTLING_CFG;
+    cache->hopLatencyCachedUs = 0;
+    cache->hopLatencyUncachedUs = 0;
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Saves SETTLING_CFG and turns synthesizer autocalibration off.
+ * Must be called before hopping with cached values.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The cache to save SETTLING_CFG in.
+ * @return CC1120_ERROR_CODE_SUCCESS - If autocalibration was disabled.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_disable_autocal(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache) {
+    cc1120_status_code status;
+
+    status = cc1120_read_spi(dev, CC1120_REGS_SETTLING_CFG, &cache->settlingCfg, 1);
+    RETURN_IF_ERROR(status)
+
+    uint8_t noAutocal = (cache->settlingCfg & ~CC1120_SETTLING_CFG_FS_AUTOCAL_MASK) | CC1120_SETTLING_CFG_FS_AUTOCAL_NEVER;
+    return cc1120_write_spi(dev, CC1120_REGS_SETTLING_CFG, &noAutocal, 1);
+}
+
+/**
+ * @brief Restores the SETTLING_CFG saved by cc1120_fscal_disable_autocal.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The cache holding the saved SETTLING_CFG.
+ * @return CC1120_ERROR_CODE_SUCCESS - If SETTLING_CFG was restored.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_restore_autocal(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache) {
+    return cc1120_write_spi(dev, CC1120_REGS_SETTLING_CFG, &cache->settlingCfg, 1);
+}
+
+/**
+ * @brief Runs SCAL once on every channel and caches FS_CHP and FS_VCO4..2.
+ * Leaves the radio in IDLE with autocalibration disabled.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The initialized cache.
+ * @return CC1120_ERROR_CODE_SUCCESS - If every channel was calibrated.
+ * @return An error code - If a calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_calibrate_all(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache) {
+    cc1120_status_code status;
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_fscal_disable_autocal(dev, cache);
+    RETURN_IF_ERROR(status)
+
+    uint8_t i;
+    for (i = 0; i < cache->numChannels; i++) {
+        cache->channels[i].calValid = false;
+        status = cc1120_fscal_hop(dev, cache, i);
+        RETURN_IF_ERROR(status)
+    }
+
+    return status;
+}
+
+/**
+ * @brief Tunes the synthesizer to a channel while the radio is in IDLE.
+ * Writes the cached calibration if present, otherwise calibrates the channel and caches the result.
+ * The next SRX/STX/SFSTXON strobe locks without recalibrating as long as autocalibration is disabled.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The initialized cache.
+ * @param index - The channel to tune to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the channel was tuned.
+ * @return An error code - If the index is invalid, calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_hop(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache, uint8_t index) {
+    cc1120_status_code status;
+
+    if (index >= cache->numChannels) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_fscal_hop: Not a valid channel!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    cc1120_fscal_channel_t *channel = &cache->channels[index];
+
+    status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2, channel->freq, 3);
+    RETURN_IF_ERROR(status)
+
+    if (channel->calValid) {
+        status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FS_CHP, &channel->fsChp, 1);
+        RETURN_IF_ERROR(status)
+
+        return cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FS_VCO4, channel->fsVco, 3);
+    }
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SCAL);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_IDLE, CC1120_FSCAL_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FS_CHP, &channel->fsChp, 1);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FS_VCO4, channel->fsVco, 3);
+    RETURN_IF_ERROR(status)
+
+    channel->calValid = true;
+    return status;
+}
+
+/**
+ * @brief Measures the time from IDLE to RX on a channel, with and without the cache.
+ * Results are stored in hopLatencyCachedUs and hopLatencyUncachedUs.
+ * Leaves the radio in IDLE with autocalibration disabled.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The initialized cache.
+ * @param index - The channel to measure on.
+ * @return CC1120_ERROR_CODE_SUCCESS - If both hops were measured.
+ * @return An error code - If the index is invalid, a state change timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_measure_hop_latency(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache, uint8_t index) {
+    cc1120_status_code status;
+    uint32_t start;
+
+    if (index >= cache->numChannels || !cache->channels[index].calValid) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_fscal_measure_hop_latency: Channel not calibrated!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    // Uncached: retune and let IDLE -> RX run the full calibration
+    uint8_t autocal = (cache->settlingCfg & ~CC1120_SETTLING_CFG_FS_AUTOCAL_MASK) | CC1120_SETTLING_CFG_FS_AUTOCAL_IDLE_TO_RXTX;
+    status = cc1120_write_spi(dev, CC1120_REGS_SETTLING_CFG, &autocal, 1);
+    RETURN_IF_ERROR(status)
+
+    start = mcu_get_time_us();
+    status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2, cache->channels[index].freq, 3);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_RX, CC1120_FSCAL_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+    cache->hopLatencyUncachedUs = mcu_get_time_us() - start;
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    // Cached: write the stored calibration with autocalibration off
+    uint8_t noAutocal = autocal & ~CC1120_SETTLING_CFG_FS_AUTOCAL_MASK;
+    status = cc1120_write_spi(dev, CC1120_REGS_SETTLING_CFG, &noAutocal, 1);
+    RETURN_IF_ERROR(status)
+
+    start = mcu_get_time_us();
+    status = cc1120_fscal_hop(dev, cache, index);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_RX, CC1120_FSCAL_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+    cache->hopLatencyCachedUs = mcu_get_time_us() - start;
+
+    return cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+}
@@ -0,0 +1,109 @@
+#ifndef CC1120_FSCAL_H
+#define CC1120_FSCAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_txrx.h"
+
+#define CC1120_FSCAL_TIMEOUT_US 2000U
+
+/* Compile-time channel initializer, e.g. cc1120_fscal_channel_t ch[] = {CC1120_FSCAL_CHANNEL(435000000)}; */
+#define CC1120_FSCAL_CHANNEL(hz) {{(uint8_t)(CC1120_FREQ_WORD(hz) >> 16), \
+                                   (uint8_t)(CC1120_FREQ_WORD(hz) >> 8),  \
+                                   (uint8_t)CC1120_FREQ_WORD(hz)}, 0, {0, 0, 0}, false}
+
+typedef struct {
+    uint8_t freq[3];    /* FREQ2, FREQ1, FREQ0 */
+    uint8_t fsChp;      /* FS_CHP after calibration */
+    uint8_t fsVco[3];   /* FS_VCO4, FS_VCO3, FS_VCO2 after calibration */
+    bool calValid;
+} cc1120_fscal_channel_t;
+
+typedef struct {
+    cc1120_fscal_channel_t *channels;
+    uint8_t numChannels;
+    uint8_t settlingCfg;            /* SETTLING_CFG saved by cc1120_fscal_disable_autocal */
+    uint32_t hopLatencyCachedUs;    /* Last measured IDLE -> RX time using the cache */
+    uint32_t hopLatencyUncachedUs;  /* Last measured IDLE -> RX time using autocalibration */
+} cc1120_fscal_cache_t;
+
+/**
+ * @brief Sets the FREQ2..0 word of a channel from a frequency in Hz and invalidates its calibration.
+ *
+ * @param channel - The channel to update.
+ * @param freqHz - The RF frequency in Hz.
+ */
+void cc1120_fscal_set_freq(cc1120_fscal_channel_t *channel, uint32_t freqHz);
+
+/**
+ * @brief Initializes a calibration cache over a channel table.
+ * The channel frequencies must already be set, either with CC1120_FSCAL_CHANNEL or cc1120_fscal_set_freq.
+ *
+ * @param cache - The cache to initialize.
+ * @param channels - The channel table.
+ * @param numChannels - The number of channels in the table.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the cache was initialized.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If there are no channels.
+ */
+cc1120_status_code cc1120_fscal_init(cc1120_fscal_cache_t *cache, cc1120_fscal_channel_t channels[], uint8_t numChannels);
+
+/**
+ * @brief Saves SETTLING_CFG and turns synthesizer autocalibration off.
+ * Must be called before hopping with cached values.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The cache to save SETTLING_CFG in.
+ * @return CC1120_ERROR_CODE_SUCCESS - If autocalibration was disabled.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_disable_autocal(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache);
+
+/**
+ * @brief Restores the SETTLING_CFG saved by cc1120_fscal_disable_autocal.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The cache holding the saved SETTLING_CFG.
+ * @return CC1120_ERROR_CODE_SUCCESS - If SETTLING_CFG was restored.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_restore_autocal(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache);
+
+/**
+ * @brief Runs SCAL once on every channel and caches FS_CHP and FS_VCO4..2.
+ * Leaves the radio in IDLE with autocalibration disabled.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The initialized cache.
+ * @return CC1120_ERROR_CODE_SUCCESS - If every channel was calibrated.
+ * @return An error code - If a calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_calibrate_all(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache);
+
+/**
+ * @brief Tunes the synthesizer to a channel while the radio is in IDLE.
+ * Writes the cached calibration if present, otherwise calibrates the channel and caches the result.
+ * The next SRX/STX/SFSTXON strobe locks without recalibrating as long as autocalibration is disabled.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The initialized cache.
+ * @param index - The channel to tune to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the channel was tuned.
+ * @return An error code - If the index is invalid, calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_hop(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache, uint8_t index);
+
+/**
+ * @brief Measures the time from IDLE to RX on a channel, with and without the cache.
+ * Results are stored in hopLatencyCachedUs and hopLatencyUncachedUs.
+ * Leaves the radio in IDLE with autocalibration disabled.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cache - The initialized cache.
+ * @param index - The channel to measure on.
+ * @return CC1120_ERROR_CODE_SUCCESS - If both hops were measured.
+ * @return An error code - If the index is invalid, a state change timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_fscal_measure_hop_latency(cc1120_dev_t *dev, cc1120_fscal_cache_t *cache, uint8_t index);
+
+#endif /* CC1120_FSCAL_H */
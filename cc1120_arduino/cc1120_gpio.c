@@ -0,0 +1,120 @@
+#include "cc1120_gpio.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Initializes a dispatcher with no handlers.
+ *
+ * @param dispatcher - The dispatcher to initialize.
+ */
+void cc1120_gpio_init(cc1120_gpio_dispatcher_t *dispatcher) {
+    memset(dispatcher, 0, sizeof(*dispatcher));
+
+    uint8_t i;
+    for (i = 0; i < CC1120_GPIO_COUNT; i++)
+        dispatcher->slots[i].signal = CC1120_GPIO_CFG_HIGHZ;
+}
+
+/**
+ * @brief Routes a CC1120 signal to a GPIO through IOCFGx and calls a handler on its edges.
+ * The MCU line wired to the GPIO is detached while the slot is updated and attached again afterwards.
+ * If the IOCFGx write fails, the previous mapping is left in place.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dispatcher - The dispatcher of this CC1120.
+ * @param gpio - The CC1120 GPIO (0-3).
+ * @param signal - The signal, one of CC1120_GPIO_CFG_*.
+ * @param invert - Whether to invert the signal on the pin.
+ * @param edgeMask - The edges to call the handler on, CC1120_GPIO_EDGE_*.
+ * @param handler - The handler, or NULL to only count edges.
+ * @param ctx - Passed to the handler.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the signal was mapped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the GPIO or signal is invalid.
+ * @return An error code - If the SPI write failed.
+ */
+cc1120_status_code cc1120_gpio_map(cc1120_dev_t *dev, cc1120_gpio_dispatcher_t *dispatcher, uint8_t gpio, uint8_t signal,
+                                   bool invert, uint8_t edgeMask, cc1120_gpio_handler_t handler, void *ctx) {
+    cc1120_status_code status;
+
+    if (gpio >= CC1120_GPIO_COUNT || signal > CC1120_IOCFG_GPIO_CFG_MASK) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_gpio_map: Invalid parameters!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // Keep the ISR away from the slot while it is half written
+    mcu_cc1120_gpio_attach(gpio, NULL);
+
+    cc1120_gpio_slot_t *slot = &dispatcher->slots[gpio];
+    uint8_t iocfg = signal | (invert ? CC1120_IOCFG_GPIO_INV : 0);
+    status = cc1120_write_spi(dev, CC1120_REGS_IOCFG0 - gpio, &iocfg, 1);
+    if (status != CC1120_ERROR_CODE_SUCCESS) {
+        // The slot is untouched, so the previous mapping, if any, keeps working
+        if (slot->signal != CC1120_GPIO_CFG_HIGHZ)
+            mcu_cc1120_gpio_attach(gpio, dispatcher);
+        return status;
+    }
+
+    slot->handler = handler;
+    slot->ctx = ctx;
+    slot->signal = signal;
+    slot->edgeMask = edgeMask;
+    slot->level = mcu_cc1120_gpio_read(gpio);
+
+    mcu_cc1120_gpio_attach(gpio, dispatcher);
+    return status;
+}
+
+/**
+ * @brief Puts a GPIO in high impedance and detaches its MCU line.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dispatcher - The dispatcher of this CC1120.
+ * @param gpio - The CC1120 GPIO (0-3).
+ * @return CC1120_ERROR_CODE_SUCCESS - If the GPIO was unmapped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the GPIO is invalid.
+ * @return An error code - If the SPI write failed.
+ */
+cc1120_status_code cc1120_gpio_unmap(cc1120_dev_t *dev, cc1120_gpio_dispatcher_t *dispatcher, uint8_t gpio) {
+    if (gpio >= CC1120_GPIO_COUNT) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_gpio_unmap: Not a valid GPIO!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    mcu_cc1120_gpio_attach(gpio, NULL);
+
+    cc1120_gpio_slot_t *slot = &dispatcher->slots[gpio];
+    slot->handler = NULL;
+    slot->signal = CC1120_GPIO_CFG_HIGHZ;
+    slot->edgeMask = 0;
+
+    uint8_t iocfg = CC1120_GPIO_CFG_HIGHZ;
+    return cc1120_write_spi(dev, CC1120_REGS_IOCFG0 - gpio, &iocfg, 1);
+}
+
+/**
+ * @brief Interrupt entry point. Platform ISRs call this with the level of the pin after an edge,
+ * and host and test builds call it to inject edges.
+ * Levels equal to the last one seen are ignored, so it may be called on any change interrupt.
+ *
+ * @param dispatcher - The dispatcher of the CC1120 the pin belongs to.
+ * @param gpio - The CC1120 GPIO (0-3). Only the low two bits are used.
+ * @param level - The level of the pin.
+ */
+void cc1120_gpio_dispatch(cc1120_gpio_dispatcher_t *dispatcher, uint8_t gpio, uint8_t level) {
+    gpio &= CC1120_GPIO_COUNT - 1;
+    cc1120_gpio_slot_t *slot = &dispatcher->slots[gpio];
+
+    level = (level != 0);
+    if (level == slot->level)
+        return;
+
+    slot->level = level;
+    slot->edges++;
+
+    uint8_t edge = level ? CC1120_GPIO_EDGE_RISING : CC1120_GPIO_EDGE_FALLING;
+    if (slot->handler != NULL && (slot->edgeMask & edge))
+        slot->handler(slot->ctx, gpio, level, mcu_get_time_us());
+}
@@ -0,0 +1,91 @@
+#ifndef CC1120_GPIO_H
+#define CC1120_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+#define CC1120_GPIO_COUNT 4U
+
+/* Edges a handler is called on */
+#define CC1120_GPIO_EDGE_RISING 0x01U
+#define CC1120_GPIO_EDGE_FALLING 0x02U
+#define CC1120_GPIO_EDGE_BOTH (CC1120_GPIO_EDGE_RISING | CC1120_GPIO_EDGE_FALLING)
+
+/**
+ * @brief Called from interrupt context when a mapped signal changes.
+ * Must not talk to the radio; set a flag or queue work for the main loop instead.
+ *
+ * @param ctx - The context given to cc1120_gpio_map.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level, after any inversion by IOCFGx.GPIOx_INV.
+ * @param timeUs - The mcu_get_time_us timestamp of the edge.
+ */
+typedef void (*cc1120_gpio_handler_t)(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs);
+
+typedef struct {
+    cc1120_gpio_handler_t handler;
+    void *ctx;
+    uint8_t signal;             /* IOCFGx.GPIOx_CFG */
+    uint8_t edgeMask;           /* CC1120_GPIO_EDGE_* the handler is called on */
+    volatile uint8_t level;     /* Last level seen */
+    volatile uint32_t edges;    /* Edges seen, whether or not the handler was called */
+} cc1120_gpio_slot_t;
+
+/* Routes the four GPIO lines of one CC1120 to handlers */
+typedef struct {
+    cc1120_gpio_slot_t slots[CC1120_GPIO_COUNT];
+} cc1120_gpio_dispatcher_t;
+
+/**
+ * @brief Initializes a dispatcher with no handlers.
+ *
+ * @param dispatcher - The dispatcher to initialize.
+ */
+void cc1120_gpio_init(cc1120_gpio_dispatcher_t *dispatcher);
+
+/**
+ * @brief Routes a CC1120 signal to a GPIO through IOCFGx and calls a handler on its edges.
+ * The MCU line wired to the GPIO is detached while the slot is updated and attached again afterwards.
+ * If the IOCFGx write fails, the previous mapping is left in place.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dispatcher - The dispatcher of this CC1120.
+ * @param gpio - The CC1120 GPIO (0-3).
+ * @param signal - The signal, one of CC1120_GPIO_CFG_*.
+ * @param invert - Whether to invert the signal on the pin.
+ * @param edgeMask - The edges to call the handler on, CC1120_GPIO_EDGE_*.
+ * @param handler - The handler, or NULL to only count edges.
+ * @param ctx - Passed to the handler.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the signal was mapped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the GPIO or signal is invalid.
+ * @return An error code - If the SPI write failed.
+ */
+cc1120_status_code cc1120_gpio_map(cc1120_dev_t *dev, cc1120_gpio_dispatcher_t *dispatcher, uint8_t gpio, uint8_t signal,
+                                   bool invert, uint8_t edgeMask, cc1120_gpio_handler_t handler, void *ctx);
+
+/**
+ * @brief Puts a GPIO in high impedance and detaches its MCU line.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dispatcher - The dispatcher of this CC1120.
+ * @param gpio - The CC1120 GPIO (0-3).
+ * @return CC1120_ERROR_CODE_SUCCESS - If the GPIO was unmapped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the GPIO is invalid.
+ * @return An error code - If the SPI write failed.
+ */
+cc1120_status_code cc1120_gpio_unmap(cc1120_dev_t *dev, cc1120_gpio_dispatcher_t *dispatcher, uint8_t gpio);
+
+/**
+ * @brief Interrupt entry point. Platform ISRs call this with the level of the pin after an edge,
+ * and host and test builds call it to inject edges.
+ * Levels equal to the last one seen are ignored, so it may be called on any change interrupt.
+ *
+ * @param dispatcher - The dispatcher of the CC1120 the pin belongs to.
+ * @param gpio - The CC1120 GPIO (0-3). Only the low two bits are used.
+ * @param level - The level of the pin.
+ */
+void cc1120_gpio_dispatch(cc1120_gpio_dispatcher_t *dispatcher, uint8_t gpio, uint8_t level);
+
+#endif /* CC1120_GPIO_H */
@@ -0,0 +1,149 @@
+#ifndef CC1120_HAL_H
+#define CC1120_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cc1120_dev.h"
+
+/*
+ * The platform is selected at build time:
+ *   CC1120_PLATFORM_ARDUINO - Defined automatically by the Arduino AVR core.
+ *   CC1120_PLATFORM_RM46 - Define in the RM46 project.
+ *   Neither - Host and test builds. SPI goes through the cc1120_dev_t transport ops.
+ *
+ * On a platform, the per-byte SPI primitives are static inline and the transport ops are bypassed.
+ * Define CC1120_HAL_FUNCTION_TABLE to dispatch through the ops on a platform too, e.g. to mock or trace the bus.
+ */
+#if !defined(CC1120_PLATFORM_RM46) && defined(ARDUINO_ARCH_AVR)
+#define CC1120_PLATFORM_ARDUINO
+#endif
+
+#if defined(CC1120_PLATFORM_ARDUINO)
+#include "cc1120_hal_avr.h"
+#elif defined(CC1120_PLATFORM_RM46)
+#include "cc1120_hal_rm46.h"
+#endif
+
+#if !defined(CC1120_HAL_FUNCTION_TABLE) && (defined(CC1120_PLATFORM_ARDUINO) || defined(CC1120_PLATFORM_RM46))
+#define CC1120_HAL_STATIC
+#endif
+
+/**
+ * @brief Simultaneously sends and receives a byte on the device's bus.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param data - Data to transfer
+ * @return uint8_t - Data received from CC1120
+ */
+static inline uint8_t cc1120_hal_spi_transfer(cc1120_dev_t *dev, uint8_t data) {
+#ifdef CC1120_HAL_STATIC
+    return cc1120_platform_spi_transfer(dev->bus, data);
+#else
+    return dev->ops->transfer(dev->bus, data);
+#endif
+}
+
+/**
+ * @brief Transfers a block of bytes on the device's bus. Used for FIFO payloads,
+ * where the platform may hand the whole block to the SPI hardware.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+static inline void cc1120_hal_spi_transfer_block(cc1120_dev_t *dev, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+#ifdef CC1120_HAL_STATIC
+    cc1120_platform_spi_transfer_block(dev->bus, tx, rx, len);
+#else
+    if (dev->ops->transferBlock != NULL) {
+        dev->ops->transferBlock(dev->bus, tx, rx, len);
+        return;
+    }
+
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        uint8_t data = dev->ops->transfer(dev->bus, (tx != NULL) ? tx[i] : 0x00);
+        if (rx != NULL)
+            rx[i] = data;
+    }
+#endif
+}
+
+/**
+ * @brief Sets the SPI clock of the device's bus.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz, or 0 if the bus clock is fixed.
+ */
+static inline uint32_t cc1120_hal_set_clock(cc1120_dev_t *dev, uint32_t hz) {
+#ifdef CC1120_HAL_STATIC
+    return cc1120_platform_spi_set_clock(dev->bus, hz);
+#else
+    if (dev->ops->setClock == NULL)
+        return 0;
+    return dev->ops->setClock(dev->bus, hz);
+#endif
+}
+
+/**
+ * @brief Switches the bus to the SPI clock tuned for an access type and pulls the device's CS line low.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param access - The kind of access the transaction makes.
+ */
+static inline void cc1120_hal_cs_assert(cc1120_dev_t *dev, cc1120_spi_access_t access) {
+    // Set on every transaction, since other devices on the bus may use other rates
+    if (dev->spiClockHz[access] != 0)
+        cc1120_hal_set_clock(dev, dev->spiClockHz[access]);
+
+    dev->stats.transactions++;
+#ifdef CC1120_HAL_STATIC
+    cc1120_platform_cs_assert(dev->bus, dev->csPin);
+#else
+    dev->ops->csAssert(dev->bus, dev->csPin);
+#endif
+}
+
+/**
+ * @brief Pulls the device's CS line high.
+ *
+ * @param dev - The CC1120 to talk to.
+ */
+static inline void cc1120_hal_cs_deassert(cc1120_dev_t *dev) {
+#ifdef CC1120_HAL_STATIC
+    cc1120_platform_cs_deassert(dev->bus, dev->csPin);
+#else
+    dev->ops->csDeassert(dev->bus, dev->csPin);
+#endif
+}
+
+/**
+ * @brief Masks interrupts for a short critical section shared with ISRs.
+ * Host builds have no ISRs, so this does nothing there.
+ *
+ * @return uint32_t - The previous interrupt state, for cc1120_hal_irq_restore.
+ */
+static inline uint32_t cc1120_hal_irq_save(void) {
+#if defined(CC1120_PLATFORM_ARDUINO) || defined(CC1120_PLATFORM_RM46)
+    return cc1120_platform_irq_save();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Ends a critical section started by cc1120_hal_irq_save.
+ *
+ * @param state - The interrupt state returned by cc1120_hal_irq_save.
+ */
+static inline void cc1120_hal_irq_restore(uint32_t state) {
+#if defined(CC1120_PLATFORM_ARDUINO) || defined(CC1120_PLATFORM_RM46)
+    cc1120_platform_irq_restore(state);
+#else
+    (void)state;
+#endif
+}
+
+#endif /* CC1120_HAL_H */
@@ -0,0 +1,132 @@
+#ifndef CC1120_HAL_AVR_H
+#define CC1120_HAL_AVR_H
+
+#include <Arduino.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Inline SPI primitives for the AVR Arduino boards.
+ * The SPI peripheral must already be configured, e.g. by SPI.begin().
+ */
+
+/**
+ * @brief Simultaneously sends and receives a byte over the hardware SPI.
+ *
+ * @param bus - Unused, there is one SPI peripheral.
+ * @param data - Data to transfer
+ * @return uint8_t - Data received from CC1120
+ */
+static inline uint8_t cc1120_platform_spi_transfer(void *bus, uint8_t data) {
+    (void)bus;
+    SPDR = data;
+    // Lets the loop skip a cycle at the fastest clock, as the SPI library does
+    asm volatile("nop");
+    while (!(SPSR & _BV(SPIF)))
+        ;
+    return SPDR;
+}
+
+/**
+ * @brief Transfers a block of bytes over the hardware SPI, one byte at a time.
+ *
+ * @param bus - Unused, there is one SPI peripheral.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+static inline void cc1120_platform_spi_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        uint8_t data = cc1120_platform_spi_transfer(bus, (tx != NULL) ? tx[i] : 0x00);
+        if (rx != NULL)
+            rx[i] = data;
+    }
+}
+
+/**
+ * @brief Pulls the CS pin low.
+ *
+ * @param bus - Unused, there is one SPI peripheral.
+ * @param csPin - The chip select line of the device.
+ */
+static inline void cc1120_platform_cs_assert(void *bus, uint8_t csPin) {
+    (void)bus;
+    volatile uint8_t *out = portOutputRegister(digitalPinToPort(csPin));
+    uint8_t mask = digitalPinToBitMask(csPin);
+    uint8_t sreg = SREG;
+
+    // The port may be shared with pins driven from interrupts
+    cli();
+    *out &= ~mask;
+    SREG = sreg;
+}
+
+/**
+ * @brief Pulls the CS pin high.
+ *
+ * @param bus - Unused, there is one SPI peripheral.
+ * @param csPin - The chip select line of the device.
+ */
+static inline void cc1120_platform_cs_deassert(void *bus, uint8_t csPin) {
+    (void)bus;
+    volatile uint8_t *out = portOutputRegister(digitalPinToPort(csPin));
+    uint8_t mask = digitalPinToBitMask(csPin);
+    uint8_t sreg = SREG;
+
+    cli();
+    *out |= mask;
+    SREG = sreg;
+}
+
+/**
+ * @brief Sets the hardware SPI clock to the fastest F_CPU / 2^n not above a rate.
+ *
+ * @param bus - Unused, there is one SPI peripheral.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied. F_CPU / 128 if hz is lower than that.
+ */
+static inline uint32_t cc1120_platform_spi_set_clock(void *bus, uint32_t hz) {
+    (void)bus;
+    uint8_t shift = 1;
+    while (shift < 7 && (F_CPU >> shift) > hz)
+        shift++;
+
+    // Dividers 2, 4, 8, 16, 32, 64 are SPR1:0 = (shift - 1) / 2 with SPI2X on odd shifts, 128 is SPR1:0 = 3
+    uint8_t spr = (shift == 7) ? 3 : (shift - 1) / 2;
+    bool x2 = (shift < 7) && (shift & 1);
+
+    SPCR = (SPCR & ~(_BV(SPR1) | _BV(SPR0))) | spr;
+    if (x2)
+        SPSR |= _BV(SPI2X);
+    else
+        SPSR &= ~_BV(SPI2X);
+
+    return F_CPU >> shift;
+}
+
+/**
+ * @brief Masks interrupts for a short critical section. The AVR has no compare-and-swap,
+ * so updates shared with ISRs are made atomic this way.
+ *
+ * @return uint8_t - The previous SREG, for cc1120_platform_irq_restore.
+ */
+static inline uint8_t cc1120_platform_irq_save(void) {
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+}
+
+/**
+ * @brief Ends a critical section started by cc1120_platform_irq_save.
+ *
+ * @param sreg - The SREG returned by cc1120_platform_irq_save.
+ */
+static inline void cc1120_platform_irq_restore(uint8_t sreg) {
+    SREG = sreg;
+}
+
+#endif /* CC1120_HAL_AVR_H */
@@ -0,0 +1,94 @@
+#ifndef CC1120_HAL_RM46_H
+#define CC1120_HAL_RM46_H
+
+#include "cc1120_rm46.h"
+#include <stdint.h>
+
+/*
+ * SPI primitives for the RM46. These call the backend directly, so there is no table lookup per byte.
+ * Blocks go through MibSPI transfer groups and DMA, see cc1120_rm46_sched.h.
+ */
+
+/**
+ * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
+ *
+ * @param bus - The bus handle of the device.
+ * @param data - Data to transfer
+ * @return uint8_t - Data received from CC1120
+ */
+static inline uint8_t cc1120_platform_spi_transfer(void *bus, uint8_t data) {
+    return rm46_cc1120_spi_transfer(bus, data);
+}
+
+/**
+ * @brief Transfers a block of bytes over CC1120 SPI interface
+ *
+ * @param bus - The bus handle of the device.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+static inline void cc1120_platform_spi_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    rm46_cc1120_spi_transfer_block(bus, tx, rx, len);
+}
+
+/**
+ * @brief Pulls the CS pin low.
+ *
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
+ */
+static inline void cc1120_platform_cs_assert(void *bus, uint8_t csPin) {
+    rm46_cc1120_cs_assert(bus, csPin);
+}
+
+/**
+ * @brief Pulls the CS pin high.
+ *
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
+ */
+static inline void cc1120_platform_cs_deassert(void *bus, uint8_t csPin) {
+    rm46_cc1120_cs_deassert(bus, csPin);
+}
+
+/**
+ * @brief Sets the SPI clock.
+ *
+ * @param bus - The bus handle of the device.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz.
+ */
+static inline uint32_t cc1120_platform_spi_set_clock(void *bus, uint32_t hz) {
+    return rm46_cc1120_spi_set_clock(bus, hz);
+}
+
+/**
+ * @brief Masks IRQs for a short critical section.
+ *
+ * @return uint32_t - The previous CPSR, for cc1120_platform_irq_restore.
+ */
+static inline uint32_t cc1120_platform_irq_save(void) {
+#if defined(__TI_COMPILER_VERSION__)
+    return _disable_IRQ();
+#else
+    uint32_t cpsr;
+    __asm volatile("mrs %0, cpsr\n\tcpsid i" : "=r"(cpsr) : : "memory");
+    return cpsr;
+#endif
+}
+
+/**
+ * @brief Ends a critical section started by cc1120_platform_irq_save.
+ *
+ * @param cpsr - The CPSR returned by cc1120_platform_irq_save.
+ */
+static inline void cc1120_platform_irq_restore(uint32_t cpsr) {
+#if defined(__TI_COMPILER_VERSION__)
+    _restore_interrupts(cpsr);
+#else
+    __asm volatile("msr cpsr_c, %0" : : "r"(cpsr) : "memory");
+#endif
+}
+
+#endif /* CC1120_HAL_RM46_H */
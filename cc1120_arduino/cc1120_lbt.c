@@ -0,0 +1,236 @@
+#include "cc1120_lbt.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_fields.h"
+#include "cc1120_txrx.h"
+
+/**
+ * @brief Waits until carrier sense is valid, so the chip can assess the channel on STX.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If carrier sense is valid.
+ * @return CC1120_ERROR_CODE_RSSI_VALID_TIMEOUT - If carrier sense did not become valid in time.
+ * @return An error code - If an SPI transfer failed.
+ */
+static cc1120_status_code cc1120_lbt_wait_sense(cc1120_dev_t *dev) {
+    cc1120_status_code status;
+    uint32_t start = mcu_get_time_us();
+    uint8_t rssi0;
+
+    do {
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_RSSI0, &rssi0, 1);
+        RETURN_IF_ERROR(status)
+
+        if (rssi0 & CC1120_RSSI0_CARRIER_SENSE_VALID)
+            return status;
+    } while (mcu_get_time_us() - start < CC1120_LBT_SENSE_TIMEOUT_US);
+
+    mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_lbt_wait_sense: Carrier sense never became valid!\n");
+    return CC1120_ERROR_CODE_RSSI_VALID_TIMEOUT;
+}
+
+/**
+ * @brief Strobes STX once and waits for the chip's clear channel decision.
+ * The status byte shows TX if the channel was clear. If the chip stays in RX,
+ * MARC_STATUS1 tells whether it deferred because the channel was busy.
+ *
+ * @param dev - The CC1120 to talk to, in RX with valid carrier sense.
+ * @param lbt - The LBT context.
+ * @param sent - Set to whether the packet went out.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the chip made a decision.
+ * @return CC1120_ERROR_CODE_STATE_TIMEOUT - If no decision was seen in time.
+ * @return An error code - If an SPI transfer failed.
+ */
+static cc1120_status_code cc1120_lbt_try(cc1120_dev_t *dev, cc1120_lbt_t *lbt, bool *sent) {
+    cc1120_status_code status;
+
+    lbt->stats.attempts++;
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_STX);
+    RETURN_IF_ERROR(status)
+
+    uint32_t start = mcu_get_time_us();
+    do {
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SNOP);
+        RETURN_IF_ERROR(status)
+
+        uint8_t state = dev->lastStatus & CC1120_STATE_MASK;
+        if (state == CC1120_STATE_TX) {
+            *sent = true;
+            return status;
+        }
+
+        if (state == CC1120_STATE_RX) {
+            // Reading MARC_STATUS1 clears it, so a failure seen here belongs to this strobe
+            uint8_t marcStatus;
+            status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARC_STATUS1, &marcStatus, 1);
+            RETURN_IF_ERROR(status)
+
+            if (marcStatus == CC1120_MARC_STATUS1_TXONCCA_FAILED) {
+                *sent = false;
+                return status;
+            }
+        }
+    } while (mcu_get_time_us() - start < CC1120_LBT_DECISION_TIMEOUT_US);
+
+    mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_lbt_try: No clear channel decision, status 0x%02X\n", dev->lastStatus);
+    return CC1120_ERROR_CODE_STATE_TIMEOUT;
+}
+
+/**
+ * @brief Picks a random backoff of 1 to 2^exp slots, where exp grows with the number of busy attempts.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param lbt - The LBT context.
+ * @param busyCount - The number of busy attempts so far for this packet.
+ * @param backoffUs - Set to the backoff in microseconds.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a backoff was picked.
+ * @return An error code - If reading RNDGEN failed.
+ */
+static cc1120_status_code cc1120_lbt_backoff(cc1120_dev_t *dev, cc1120_lbt_t *lbt, uint8_t busyCount, uint32_t *backoffUs) {
+    uint8_t rnd;
+    cc1120_status_code status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_RNDGEN, &rnd, 1);
+    RETURN_IF_ERROR(status)
+
+    uint8_t exp = (busyCount < lbt->maxBackoffExp) ? busyCount : lbt->maxBackoffExp;
+    uint8_t slots = (rnd & ((1U << exp) - 1U)) + 1U;
+
+    *backoffUs = slots * lbt->slotUs;
+    return status;
+}
+
+/**
+ * @brief Drops the queued packet and leaves the radio in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the flush was successful
+ */
+static cc1120_status_code cc1120_lbt_flush(cc1120_dev_t *dev) {
+    cc1120_status_code status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_IDLE, CC1120_LBT_DECISION_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    return cc1120_strobe_spi(dev, CC1120_STROBE_SFTX);
+}
+
+/**
+ * @brief Programs the carrier sense threshold and CCA mode, and enables the random number generator.
+ * Call after cc1120_tx_init, which overwrites AGC_CS_THR.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param lbt - The LBT context to initialize.
+ * @param thresholdDbm - The carrier sense threshold in dBm.
+ * @param ccaMode - The CCA mode, one of CC1120_CCA_MODE_*.
+ * @param slotUs - The backoff slot length in microseconds.
+ * @param maxBackoffExp - The largest backoff window exponent, at most CC1120_LBT_MAX_BACKOFF_EXP.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was configured.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If a parameter is out of range.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_lbt_init(cc1120_dev_t *dev, cc1120_lbt_t *lbt, int8_t thresholdDbm, uint8_t ccaMode,
+                                   uint32_t slotUs, uint8_t maxBackoffExp) {
+    cc1120_status_code status;
+
+    // AGC_CS_THR is relative to the RSSI offset and must fit in a signed byte
+    int16_t csThr = thresholdDbm + CC1120_RSSI_OFFSET_DB;
+    if (csThr > INT8_MAX || ccaMode > CC1120_CCA_MODE_ETSI_LBT || slotUs == 0 ||
+        maxBackoffExp < 1 || maxBackoffExp > CC1120_LBT_MAX_BACKOFF_EXP) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_lbt_init: Invalid parameters!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    uint8_t agcCsThr = (uint8_t)(int8_t)csThr;
+    status = cc1120_write_spi(dev, CC1120_REGS_AGC_CS_THR, &agcCsThr, 1);
+    RETURN_IF_ERROR(status)
+
+    status = CC1120_FIELD_WRITE(dev, PKT_CFG2_CCA_MODE, ccaMode);
+    RETURN_IF_ERROR(status)
+
+    uint8_t rndgen = CC1120_RNDGEN_EN;
+    status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_RNDGEN, &rndgen, 1);
+    RETURN_IF_ERROR(status)
+
+    lbt->thresholdDbm = thresholdDbm;
+    lbt->ccaMode = ccaMode;
+    lbt->slotUs = slotUs;
+    lbt->maxBackoffExp = maxBackoffExp;
+    lbt->stats.attempts = 0;
+    lbt->stats.sent = 0;
+    lbt->stats.busy = 0;
+    lbt->stats.deadlineMisses = 0;
+    lbt->stats.backoffUs = 0;
+
+    return status;
+}
+
+/**
+ * @brief Sends a packet once the channel is clear, backing off for a random number of slots while it is busy.
+ * The chip itself decides on each STX whether the channel is clear, and stays in RX if it is not.
+ * If the deadline passes first, the packet is flushed from the TX FIFO and the radio is left in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param lbt - The initialized LBT context.
+ * @param data - The packet to transmit.
+ * @param len - The size of the packet, at most CC1120_TX_FIFO_SIZE - 1.
+ * @param timeoutUs - The time from now after which the packet is dropped.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet went out.
+ * @return CC1120_ERROR_CODE_CHANNEL_BUSY - If the channel stayed busy until the deadline.
+ * @return An error code - If carrier sense never became valid, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_lbt_send(cc1120_dev_t *dev, cc1120_lbt_t *lbt, uint8_t *data, uint8_t len, uint32_t timeoutUs) {
+    cc1120_status_code status;
+    uint32_t start = mcu_get_time_us();
+
+    status = cc1120_tx_load(dev, data, len);
+    RETURN_IF_ERROR(status)
+
+    // The chip can only assess the channel from RX
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_lbt_wait_sense(dev);
+    if (status != CC1120_ERROR_CODE_SUCCESS) {
+        cc1120_lbt_flush(dev);
+        return status;
+    }
+
+    // Clear any result left over from an earlier packet
+    uint8_t marcStatus;
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARC_STATUS1, &marcStatus, 1);
+    RETURN_IF_ERROR(status)
+
+    uint8_t busyCount = 0;
+    for (;;) {
+        bool sent;
+        status = cc1120_lbt_try(dev, lbt, &sent);
+        RETURN_IF_ERROR(status)
+
+        if (sent) {
+            lbt->stats.sent++;
+            return status;
+        }
+
+        lbt->stats.busy++;
+        if (busyCount < UINT8_MAX)
+            busyCount++;
+
+        uint32_t backoffUs;
+        status = cc1120_lbt_backoff(dev, lbt, busyCount, &backoffUs);
+        RETURN_IF_ERROR(status)
+
+        if (mcu_get_time_us() - start + backoffUs >= timeoutUs) {
+            lbt->stats.deadlineMisses++;
+            status = cc1120_lbt_flush(dev);
+            RETURN_IF_ERROR(status)
+            return CC1120_ERROR_CODE_CHANNEL_BUSY;
+        }
+
+        // The radio stays in RX, so carrier sense is still valid for the next attempt
+        uint32_t backoffStart = mcu_get_time_us();
+        while (mcu_get_time_us() - backoffStart < backoffUs)
+            ;
+        lbt->stats.backoffUs += backoffUs;
+    }
+}
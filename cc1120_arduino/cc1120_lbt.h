@@ -0,0 +1,71 @@
+#ifndef CC1120_LBT_H
+#define CC1120_LBT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/* Longest backoff window is 2^CC1120_LBT_MAX_BACKOFF_EXP slots, limited by the 7-bit RNDGEN value */
+#define CC1120_LBT_MAX_BACKOFF_EXP 7U
+
+#define CC1120_LBT_DEFAULT_THRESHOLD_DBM (-90)
+#define CC1120_LBT_DEFAULT_SLOT_US 2000UL
+#define CC1120_LBT_DEFAULT_BACKOFF_EXP 5U
+
+/* Maximum time to wait for CARRIER_SENSE_VALID after entering RX */
+#define CC1120_LBT_SENSE_TIMEOUT_US 2000UL
+
+/* Maximum time for the chip to decide between TX and staying in RX after STX */
+#define CC1120_LBT_DECISION_TIMEOUT_US 1000UL
+
+typedef struct {
+    uint32_t attempts;          /* STX strobes issued with CCA enabled */
+    uint32_t sent;              /* Packets that went out */
+    uint32_t busy;              /* Attempts the chip deferred because the channel was busy */
+    uint32_t deadlineMisses;    /* Packets dropped because the deadline passed */
+    uint32_t backoffUs;         /* Total time spent backing off */
+} cc1120_lbt_stats_t;
+
+typedef struct {
+    int8_t thresholdDbm;        /* Carrier sense threshold */
+    uint8_t ccaMode;            /* PKT_CFG2.CCA_MODE, one of CC1120_CCA_MODE_* */
+    uint32_t slotUs;            /* Backoff slot length */
+    uint8_t maxBackoffExp;      /* The backoff window doubles per busy attempt up to 2^maxBackoffExp slots */
+    cc1120_lbt_stats_t stats;
+} cc1120_lbt_t;
+
+/**
+ * @brief Programs the carrier sense threshold and CCA mode, and enables the random number generator.
+ * Call after cc1120_tx_init, which overwrites AGC_CS_THR.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param lbt - The LBT context to initialize.
+ * @param thresholdDbm - The carrier sense threshold in dBm.
+ * @param ccaMode - The CCA mode, one of CC1120_CCA_MODE_*.
+ * @param slotUs - The backoff slot length in microseconds.
+ * @param maxBackoffExp - The largest backoff window exponent, at most CC1120_LBT_MAX_BACKOFF_EXP.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was configured.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If a parameter is out of range.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_lbt_init(cc1120_dev_t *dev, cc1120_lbt_t *lbt, int8_t thresholdDbm, uint8_t ccaMode,
+                                   uint32_t slotUs, uint8_t maxBackoffExp);
+
+/**
+ * @brief Sends a packet once the channel is clear, backing off for a random number of slots while it is busy.
+ * The chip itself decides on each STX whether the channel is clear, and stays in RX if it is not.
+ * If the deadline passes first, the packet is flushed from the TX FIFO and the radio is left in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param lbt - The initialized LBT context.
+ * @param data - The packet to transmit.
+ * @param len - The size of the packet, at most CC1120_TX_FIFO_SIZE - 1.
+ * @param timeoutUs - The time from now after which the packet is dropped.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet went out.
+ * @return CC1120_ERROR_CODE_CHANNEL_BUSY - If the channel stayed busy until the deadline.
+ * @return An error code - If carrier sense never became valid, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_lbt_send(cc1120_dev_t *dev, cc1120_lbt_t *lbt, uint8_t *data, uint8_t len, uint32_t timeoutUs);
+
+#endif /* CC1120_LBT_H */
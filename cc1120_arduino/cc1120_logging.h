@@ -32,7 +32,20 @@ typedef enum  {
   CC1120_ERROR_CODE_TEST_FIFO_READ_WRITE_SINGLE_WRITE_DIRECT_READ_FAILED,
   CC1120_ERROR_CODE_TEST_FIFO_READ_WRITE_BURST_WRITE_DIRECT_READ_FAILED,
   CC1120_ERROR_CODE_TEST_FIFO_READ_WRITE_SINGLE_DIRECT_WRITE_FAILED,
-  CC1120_ERROR_CODE_TEST_FIFO_READ_WRITE_BURST_DIRECT_WRITE_FAILED
+  CC1120_ERROR_CODE_TEST_FIFO_READ_WRITE_BURST_DIRECT_WRITE_FAILED,
+  CC1120_ERROR_CODE_STATE_TIMEOUT,
+  CC1120_ERROR_CODE_RSSI_VALID_TIMEOUT,
+  CC1120_ERROR_CODE_INVALID_RATE_HEADER,
+  CC1120_ERROR_CODE_SPI_TUNE_FAILED,
+  CC1120_ERROR_CODE_CHANNEL_BUSY,
+  CC1120_ERROR_CODE_QUEUE_FULL,
+  CC1120_ERROR_CODE_EXPIRED,
+  CC1120_ERROR_CODE_SELFTEST_FAILED,
+  CC1120_ERROR_CODE_FLASH_FAILED,
+  CC1120_ERROR_CODE_TRACE_MISMATCH,
+  CC1120_ERROR_CODE_FIFO_ERROR,
+  CC1120_ERROR_CODE_CRC_FAILED,
+  CC1120_ERROR_CODE_RATE_OUT_OF_SYNC
   
 } cc1120_status_code;
 
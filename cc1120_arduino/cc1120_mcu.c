@@ -1,9 +1,32 @@
 #include "cc1120_mcu.h"
+#include "cc1120_hal.h"
+#if defined(CC1120_PLATFORM_ARDUINO)
 #include "cc1120_arduino.h"
+#elif defined(CC1120_PLATFORM_RM46)
+#include "cc1120_rm46.h"
+#endif
 #include <stdio.h>
 #define MAX_LOG_SIZE 500U
 
-cc1120_mcu_t CC1120_MCU = CC1120_MCU_ARDUINO;
+#if defined(CC1120_PLATFORM_ARDUINO)
+const cc1120_transport_ops_t MCU_CC1120_TRANSPORT = {
+    arduino_cc1120_spi_transfer,
+    arduino_cc1120_cs_assert,
+    arduino_cc1120_cs_deassert,
+    arduino_cc1120_spi_set_clock,
+    arduino_cc1120_spi_transfer_block,
+};
+#elif defined(CC1120_PLATFORM_RM46)
+const cc1120_transport_ops_t MCU_CC1120_TRANSPORT = {
+    rm46_cc1120_spi_transfer,
+    rm46_cc1120_cs_assert,
+    rm46_cc1120_cs_deassert,
+    rm46_cc1120_spi_set_clock,
+    rm46_cc1120_spi_transfer_block,
+};
+#else
+uint32_t (*mcu_host_time_us)(void) = NULL;
+#endif
 
 /**
  * @brief Calls serial and file log functions. Appends log info to string.
@@ -34,10 +57,9 @@ void mcu_log(cc1120_log_level_t level, char str[], ...) {
  * @param str - The string to log.
  */
 void mcu_serial_log(cc1120_log_level_t level, char str[]) {
-    #ifdef CC1120_ARDUINO_H
+    #if defined(CC1120_PLATFORM_ARDUINO)
     arduino_serial_log(level, str);
-    #endif
-    #ifdef CC1120_RM46_H
+    #elif defined(CC1120_PLATFORM_RM46)
     rm46_serial_log(level, str);
     #endif
 }
@@ -49,51 +71,77 @@ void mcu_serial_log(cc1120_log_level_t level, char str[]) {
  * @param str - The string to log.
  */
 void mcu_file_log(cc1120_log_level_t level, char str[]) {
-    #ifdef CC1120_RM46_H
+    #if defined(CC1120_PLATFORM_RM46)
     rm46_file_log(level, str);
     #endif
 }
 
 /**
- * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
+ * @brief Reads the level of one of the CC1120 GPIO pins.
  * 
- * @param data - Data to transfer 
- * @return uint8_t - Data received from CC1120
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @return uint8_t - 1 if the pin is high, 0 if it is low.
  */
-uint8_t mcu_cc1120_spi_transfer(uint8_t data) {
-    uint8_t received;
-    #ifdef CC1120_ARDUINO_H
-    received = arduino_cc1120_spi_transfer(data);
-    #endif
-    #ifdef CC1120_RM46_H
-    received = rm46_cc1120_spi_transfer(data);
+uint8_t mcu_cc1120_gpio_read(uint8_t gpio) {
+    uint8_t level = 0;
+    #if defined(CC1120_PLATFORM_ARDUINO)
+    level = arduino_cc1120_gpio_read(gpio);
+    #elif defined(CC1120_PLATFORM_RM46)
+    level = rm46_cc1120_gpio_read(gpio);
     #endif
 
-    return received;
+    return level;
 }
 
 /**
- * @brief Calls the correct CS assert function based on the MCU selected.
+ * @brief Routes the change interrupt of one of the CC1120 GPIO pins to a dispatcher.
  * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @param dispatcher - The dispatcher to call cc1120_gpio_dispatch on, or NULL to detach the interrupt.
  */
-void mcu_cc1120_cs_assert() {
-    #ifdef CC1120_ARDUINO_H
-    arduino_cc1120_cs_assert();
-    #endif
-    #ifdef CC1120_RM46_H
-    rm46_cc1120_cs_assert();
+void mcu_cc1120_gpio_attach(uint8_t gpio, cc1120_gpio_dispatcher_t *dispatcher) {
+    #if defined(CC1120_PLATFORM_ARDUINO)
+    arduino_cc1120_gpio_attach(gpio, dispatcher);
+    #elif defined(CC1120_PLATFORM_RM46)
+    rm46_cc1120_gpio_attach(gpio, dispatcher);
     #endif
 }
 
 /**
- * @brief Calls the correct CS deassert function based on the MCU selected.
+ * @brief Gets a free-running microsecond timestamp from the MCU.
  * 
+ * @return uint32_t - The current time in microseconds. Wraps around on overflow.
  */
-void mcu_cc1120_cs_deassert() {
-    #ifdef CC1120_ARDUINO_H
-    arduino_cc1120_cs_deassert();
+uint32_t mcu_get_time_us() {
+    uint32_t time = 0;
+    #if defined(CC1120_PLATFORM_ARDUINO)
+    time = arduino_get_time_us();
+    #elif defined(CC1120_PLATFORM_RM46)
+    time = rm46_get_time_us();
+    #else
+    if (mcu_host_time_us != NULL)
+        time = mcu_host_time_us();
     #endif
-    #ifdef CC1120_RM46_H
-    rm46_cc1120_cs_deassert();
+
+    return time;
+}
+
+/**
+ * @brief Calls a function from a one-shot timer interrupt at a given time.
+ * 
+ * @param atUs - The mcu_get_time_us time to call it at.
+ * @param callback - The function to call from the interrupt.
+ * @param ctx - Passed to the callback.
+ * @return true - If the timer was started.
+ * @return false - If the platform has no timer, or the time is out of its range.
+ */
+bool mcu_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx) {
+    bool started = false;
+    #if defined(CC1120_PLATFORM_ARDUINO)
+    started = arduino_timer_at(atUs, callback, ctx);
+    #elif defined(CC1120_PLATFORM_RM46)
+    started = rm46_timer_at(atUs, callback, ctx);
     #endif
+
+    return started;
 }
@@ -2,16 +2,24 @@
 #define CC1120_MCU_H
 
 #include "cc1120_logging.h"
+#include "cc1120_dev.h"
+#include "cc1120_gpio.h"
+#include "cc1120_hal.h"
 #include <stdarg.h>
 #include <stdint.h>
+#include <stdbool.h>
 
-typedef enum {
-    CC1120_MCU_UNKNOWN = 0,
-    CC1120_MCU_ARDUINO,
-    CC1120_MCU_RM46,
-} cc1120_mcu_t;
+/*
+ * Transport for radios on the MCU's CC1120 SPI bus, for use with cc1120_dev_init.
+ * Only used when the driver dispatches through the table, see cc1120_hal.h.
+ */
+extern const cc1120_transport_ops_t MCU_CC1120_TRANSPORT;
+
+#if !defined(CC1120_PLATFORM_ARDUINO) && !defined(CC1120_PLATFORM_RM46)
+/* Host builds have no MCU timer. mcu_get_time_us returns this clock, e.g. a virtual one, or 0 while it is NULL. */
+extern uint32_t (*mcu_host_time_us)(void);
+#endif
 
-extern cc1120_mcu_t CC1120_MCU;
 /**
  * @brief Calls serial and file log functions. Appends log info to string.
  * 
@@ -38,23 +46,37 @@ void mcu_serial_log(cc1120_log_level_t level, char str[]);
 void mcu_file_log(cc1120_log_level_t level, char str[]);
 
 /**
- * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
+ * @brief Reads the level of one of the CC1120 GPIO pins.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @return uint8_t - 1 if the pin is high, 0 if it is low.
+ */
+uint8_t mcu_cc1120_gpio_read(uint8_t gpio);
+
+/**
+ * @brief Routes the change interrupt of one of the CC1120 GPIO pins to a dispatcher.
  * 
- * @param data - Data to transfer 
- * @return uint8_t - Data received from CC1120
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @param dispatcher - The dispatcher to call cc1120_gpio_dispatch on, or NULL to detach the interrupt.
  */
-uint8_t mcu_cc1120_spi_transfer(uint8_t data);
+void mcu_cc1120_gpio_attach(uint8_t gpio, cc1120_gpio_dispatcher_t *dispatcher);
 
 /**
- * @brief Calls the correct CS assert function based on the MCU selected.
+ * @brief Gets a free-running microsecond timestamp from the MCU.
  * 
+ * @return uint32_t - The current time in microseconds. Wraps around on overflow.
  */
-void mcu_cc1120_cs_assert();
+uint32_t mcu_get_time_us();
 
 /**
- * @brief Calls the correct CS deassert function based on the MCU selected.
+ * @brief Calls a function from a one-shot timer interrupt at a given time.
  * 
+ * @param atUs - The mcu_get_time_us time to call it at.
+ * @param callback - The function to call from the interrupt.
+ * @param ctx - Passed to the callback.
+ * @return true - If the timer was started.
+ * @return false - If the platform has no timer, or the time is out of its range.
  */
-void mcu_cc1120_cs_deassert();
+bool mcu_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx);
 
 #endif /* CC1120_MCU_H */
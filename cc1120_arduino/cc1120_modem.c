@@ -0,0 +1,102 @@
+#include "cc1120_modem.h"
+#include "cc1120_regs.h"
+#include "cc1120_spi.h"
+
+/**
+ * @brief Writes a modem configuration to the CC1120 in three burst transactions.
+ * The radio should be in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cfg - The configuration, usually built with CC1120_MODEM_CFG.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the configuration was written.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_modem_apply(cc1120_dev_t *dev, const cc1120_modem_cfg_t *cfg) {
+    cc1120_status_code status;
+
+    status = cc1120_write_spi(dev, CC1120_REGS_DEVIATION_M, (uint8_t *)cfg->deviation, sizeof(cfg->deviation));
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_write_spi(dev, CC1120_REGS_CHAN_BW, (uint8_t *)cfg->modem, sizeof(cfg->modem));
+    RETURN_IF_ERROR(status)
+
+    return cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2, (uint8_t *)cfg->freq, sizeof(cfg->freq));
+}
+
+/**
+ * @brief Finds the span of bytes that differ between two register images.
+ *
+ * @param from - The current image.
+ * @param to - The new image.
+ * @param len - The length of both images.
+ * @param first - Set to the index of the first differing byte.
+ * @return uint8_t - The number of bytes from first to the last differing byte, 0 if identical.
+ */
+static uint8_t cc1120_modem_diff_span(const uint8_t from[], const uint8_t to[], uint8_t len, uint8_t *first) {
+    uint8_t lo = 0;
+    while (lo < len && from[lo] == to[lo])
+        lo++;
+    if (lo == len)
+        return 0;
+
+    uint8_t hi = len - 1;
+    while (from[hi] == to[hi])
+        hi--;
+
+    *first = lo;
+    return hi - lo + 1;
+}
+
+/**
+ * @brief Switches from one modem configuration to another, writing only the registers that differ.
+ * Each register group is written as a single burst covering its first to last changed byte.
+ * The radio should be in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param from - The configuration currently in the radio.
+ * @param to - The configuration to switch to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the configuration was written.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_modem_apply_delta(cc1120_dev_t *dev, const cc1120_modem_cfg_t *from, const cc1120_modem_cfg_t *to) {
+    cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
+    uint8_t first;
+    uint8_t len;
+
+    len = cc1120_modem_diff_span(from->deviation, to->deviation, sizeof(to->deviation), &first);
+    if (len > 0) {
+        status = cc1120_write_spi(dev, CC1120_REGS_DEVIATION_M + first, (uint8_t *)&to->deviation[first], len);
+        RETURN_IF_ERROR(status)
+    }
+
+    len = cc1120_modem_diff_span(from->modem, to->modem, sizeof(to->modem), &first);
+    if (len > 0) {
+        status = cc1120_write_spi(dev, CC1120_REGS_CHAN_BW + first, (uint8_t *)&to->modem[first], len);
+        RETURN_IF_ERROR(status)
+    }
+
+    len = cc1120_modem_diff_span(from->freq, to->freq, sizeof(to->freq), &first);
+    if (len > 0) {
+        status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2 + first, (uint8_t *)&to->freq[first], len);
+        RETURN_IF_ERROR(status)
+    }
+
+    return status;
+}
+
+/**
+ * @brief Computes the symbol rate a configuration produces.
+ *
+ * @param cfg - The configuration.
+ * @param xoscHz - The crystal frequency in Hz.
+ * @return uint32_t - The symbol rate in symbols per second, rounded down.
+ */
+uint32_t cc1120_modem_symbol_rate(const cc1120_modem_cfg_t *cfg, uint32_t xoscHz) {
+    uint8_t srateE = cfg->modem[3] >> 4;
+    uint64_t srateM = ((uint64_t)(cfg->modem[3] & 0x0FU) << 16) | ((uint64_t)cfg->modem[4] << 8) | cfg->modem[5];
+
+    if (srateE == 0)
+        return (uint32_t)((srateM * xoscHz) >> 38);
+
+    return (uint32_t)((((1ULL << 20) + srateM) * xoscHz) >> (39 - srateE));
+}
@@ -0,0 +1,141 @@
+#ifndef CC1120_MODEM_H
+#define CC1120_MODEM_H
+
+#include <stdint.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/*
+ * Compile-time modem configurator.
+ * Every macro below is an integer constant expression, so a cc1120_modem_cfg_t built with
+ * CC1120_MODEM_CFG can live in flash and no floating point is needed on the MCU.
+ * Formulas are from sections 5.2.1, 5.5, 6.1 and 9.12 of the user guide.
+ */
+
+/* MODCFG_DEV_E.MOD_FORMAT */
+#define CC1120_MODCFG_MOD_FORMAT_2FSK   0x00U
+#define CC1120_MODCFG_MOD_FORMAT_2GFSK  0x08U
+#define CC1120_MODCFG_MOD_FORMAT_4FSK   0x20U
+#define CC1120_MODCFG_MOD_FORMAT_4GFSK  0x28U
+
+/* MDMCFG1/MDMCFG0 carried in the burst image, as used by txSettingsStd */
+#define CC1120_MODEM_MDMCFG1            0x46U
+#define CC1120_MODEM_MDMCFG0            0x05U
+
+/* Rounded integer division of two non-negative values */
+#define CC1120_MODEM_DIV_ROUND(num, den) (((uint64_t)(num) + (uint64_t)(den) / 2) / (uint64_t)(den))
+
+/* floor(log2(x)) for 2 <= x < 2^16, and 0 for x < 2 */
+#define CC1120_MODEM_LOG2(x) \
+    ((x) >= (1ULL << 15) ? 15 : (x) >= (1ULL << 14) ? 14 : (x) >= (1ULL << 13) ? 13 : \
+     (x) >= (1ULL << 12) ? 12 : (x) >= (1ULL << 11) ? 11 : (x) >= (1ULL << 10) ? 10 : \
+     (x) >= (1ULL << 9)  ? 9  : (x) >= (1ULL << 8)  ? 8  : (x) >= (1ULL << 7)  ? 7  : \
+     (x) >= (1ULL << 6)  ? 6  : (x) >= (1ULL << 5)  ? 5  : (x) >= (1ULL << 4)  ? 4  : \
+     (x) >= (1ULL << 3)  ? 3  : (x) >= (1ULL << 2)  ? 2  : (x) >= (1ULL << 1)  ? 1  : 0)
+
+#define CC1120_MODEM_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/*
+ * Symbol rate: R = (2^20 + SRATE_M) * 2^SRATE_E * f_xosc / 2^39 for SRATE_E > 0,
+ *              R = SRATE_M * f_xosc / 2^38 for SRATE_E = 0.
+ */
+#define CC1120_MODEM_SRATE_E(rate, xosc) \
+    CC1120_MODEM_LOG2((uint64_t)(rate) * (1ULL << 19) / (uint64_t)(xosc))
+
+#define CC1120_MODEM_SRATE_M(rate, xosc) \
+    CC1120_MODEM_MIN((1ULL << 20) - 1, \
+        CC1120_MODEM_SRATE_E(rate, xosc) == 0 ? \
+            CC1120_MODEM_DIV_ROUND((uint64_t)(rate) << 38, (xosc)) : \
+            CC1120_MODEM_DIV_ROUND((uint64_t)(rate) << 39, (uint64_t)(xosc) << CC1120_MODEM_SRATE_E(rate, xosc)) - (1ULL << 20))
+
+#define CC1120_MODEM_SYMBOL_RATE2(rate, xosc) \
+    ((uint8_t)((CC1120_MODEM_SRATE_E(rate, xosc) << 4) | ((CC1120_MODEM_SRATE_M(rate, xosc) >> 16) & 0x0FU)))
+#define CC1120_MODEM_SYMBOL_RATE1(rate, xosc) ((uint8_t)(CC1120_MODEM_SRATE_M(rate, xosc) >> 8))
+#define CC1120_MODEM_SYMBOL_RATE0(rate, xosc) ((uint8_t)CC1120_MODEM_SRATE_M(rate, xosc))
+
+/*
+ * Deviation: f_dev = (256 + DEV_M) * 2^DEV_E * f_xosc / 2^24 for DEV_E > 0,
+ *            f_dev = DEV_M * f_xosc / 2^23 for DEV_E = 0.
+ * CC1120_MODEM_DEV_X is f_dev in units of f_xosc / 2^24.
+ */
+#define CC1120_MODEM_DEV_X(dev, xosc) ((uint64_t)(dev) * (1ULL << 24) / (uint64_t)(xosc))
+
+#define CC1120_MODEM_DEV_E(dev, xosc) \
+    (CC1120_MODEM_DEV_X(dev, xosc) < 512 ? 0 : CC1120_MODEM_MIN(7, CC1120_MODEM_LOG2(CC1120_MODEM_DEV_X(dev, xosc) / 256)))
+
+#define CC1120_MODEM_DEV_M(dev, xosc) \
+    CC1120_MODEM_MIN(255, \
+        CC1120_MODEM_DEV_E(dev, xosc) == 0 ? \
+            CC1120_MODEM_DIV_ROUND((uint64_t)(dev) << 23, (xosc)) : \
+            CC1120_MODEM_DIV_ROUND((uint64_t)(dev) << 24, (uint64_t)(xosc) << CC1120_MODEM_DEV_E(dev, xosc)) - 256)
+
+#define CC1120_MODEM_DEVIATION_M(dev, xosc) ((uint8_t)CC1120_MODEM_DEV_M(dev, xosc))
+#define CC1120_MODEM_MODCFG_DEV_E(dev, xosc, modFormat) ((uint8_t)((modFormat) | CC1120_MODEM_DEV_E(dev, xosc)))
+
+/*
+ * RX filter bandwidth: BW = f_xosc / (8 * 20 * BB_CIC_DECFACT) with ADC_CIC_DECFACT = 20.
+ * Rounds to the nearest achievable bandwidth, BB_CIC_DECFACT limited to 1-63.
+ */
+#define CC1120_MODEM_BB_CIC_DECFACT(bw, xosc) \
+    CC1120_MODEM_MIN(63, CC1120_MODEM_DIV_ROUND((xosc), 160ULL * (uint64_t)(bw)) < 1 ? 1 : \
+                         CC1120_MODEM_DIV_ROUND((xosc), 160ULL * (uint64_t)(bw)))
+#define CC1120_MODEM_CHAN_BW(bw, xosc) ((uint8_t)CC1120_MODEM_BB_CIC_DECFACT(bw, xosc))
+
+/* Carrier: FREQ = f_RF * LO divider * 2^16 / f_xosc */
+#define CC1120_MODEM_FREQ(hz, loDiv, xosc) \
+    CC1120_MODEM_DIV_ROUND((uint64_t)(hz) * (uint64_t)(loDiv) << 16, (xosc))
+
+typedef struct {
+    uint8_t deviation[2];   /* Burst at CC1120_REGS_DEVIATION_M: DEVIATION_M, MODCFG_DEV_E */
+    uint8_t modem[6];       /* Burst at CC1120_REGS_CHAN_BW: CHAN_BW, MDMCFG1, MDMCFG0, SYMBOL_RATE2..0 */
+    uint8_t freq[3];        /* Extended burst at CC1120_REGS_EXT_FREQ2: FREQ2, FREQ1, FREQ0 */
+} cc1120_modem_cfg_t;
+
+/* Builds a complete cc1120_modem_cfg_t initializer at compile time */
+#define CC1120_MODEM_CFG(symbolRate, deviationHz, rxBwHz, carrierHz, loDiv, xoscHz, modFormat) { \
+    {CC1120_MODEM_DEVIATION_M(deviationHz, xoscHz),                                             \
+     CC1120_MODEM_MODCFG_DEV_E(deviationHz, xoscHz, modFormat)},                                 \
+    {CC1120_MODEM_CHAN_BW(rxBwHz, xoscHz),                                                       \
+     CC1120_MODEM_MDMCFG1,                                                                       \
+     CC1120_MODEM_MDMCFG0,                                                                       \
+     CC1120_MODEM_SYMBOL_RATE2(symbolRate, xoscHz),                                              \
+     CC1120_MODEM_SYMBOL_RATE1(symbolRate, xoscHz),                                              \
+     CC1120_MODEM_SYMBOL_RATE0(symbolRate, xoscHz)},                                             \
+    {(uint8_t)(CC1120_MODEM_FREQ(carrierHz, loDiv, xoscHz) >> 16),                               \
+     (uint8_t)(CC1120_MODEM_FREQ(carrierHz, loDiv, xoscHz) >> 8),                                \
+     (uint8_t)CC1120_MODEM_FREQ(carrierHz, loDiv, xoscHz)}}
+
+/**
+ * @brief Writes a modem configuration to the CC1120 in three burst transactions.
+ * The radio should be in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param cfg - The configuration, usually built with CC1120_MODEM_CFG.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the configuration was written.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_modem_apply(cc1120_dev_t *dev, const cc1120_modem_cfg_t *cfg);
+
+/**
+ * @brief Switches from one modem configuration to another, writing only the registers that differ.
+ * Each register group is written as a single burst covering its first to last changed byte.
+ * The radio should be in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param from - The configuration currently in the radio.
+ * @param to - The configuration to switch to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the configuration was written.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_modem_apply_delta(cc1120_dev_t *dev, const cc1120_modem_cfg_t *from, const cc1120_modem_cfg_t *to);
+
+/**
+ * @brief Computes the symbol rate a configuration produces.
+ *
+ * @param cfg - The configuration.
+ * @param xoscHz - The crystal frequency in Hz.
+ * @return uint32_t - The symbol rate in symbols per second, rounded down.
+ */
+uint32_t cc1120_modem_symbol_rate(const cc1120_modem_cfg_t *cfg, uint32_t xoscHz);
+
+#endif /* CC1120_MODEM_H */
@@ -0,0 +1,266 @@
+#include "cc1120_pool.h"
+#include "cc1120_hal.h"
+#include <stddef.h>
+
+#define CC1120_POOL_FULL_MASK(n) ((n) >= 32U ? 0xFFFFFFFFUL : ((1UL << ((n) & 31U)) - 1UL))
+
+/* One size class. A set bit in freeMask is a free buffer. */
+typedef struct {
+    uint8_t *base;
+    uint16_t len;
+    uint8_t count;
+    volatile uint32_t *refs;
+    volatile uint32_t freeMask;
+    volatile uint32_t inUse;
+    volatile uint32_t highWater;
+    volatile uint32_t allocs;
+    volatile uint32_t exhausted;
+} cc1120_pool_slab_t;
+
+static uint8_t cc1120_pool_small[CC1120_POOL_SMALL_COUNT][CC1120_POOL_SMALL_LEN];
+static uint8_t cc1120_pool_medium[CC1120_POOL_MEDIUM_COUNT][CC1120_POOL_MEDIUM_LEN];
+static uint8_t cc1120_pool_large[CC1120_POOL_LARGE_COUNT][CC1120_POOL_LARGE_LEN];
+
+static volatile uint32_t cc1120_pool_small_refs[CC1120_POOL_SMALL_COUNT];
+static volatile uint32_t cc1120_pool_medium_refs[CC1120_POOL_MEDIUM_COUNT];
+static volatile uint32_t cc1120_pool_large_refs[CC1120_POOL_LARGE_COUNT];
+
+/* Refused ref and free calls */
+static volatile uint32_t cc1120_pool_fault_count;
+
+static cc1120_pool_slab_t cc1120_pool_slabs[CC1120_POOL_CLASS_COUNT] = {
+    { &cc1120_pool_small[0][0], CC1120_POOL_SMALL_LEN, CC1120_POOL_SMALL_COUNT, cc1120_pool_small_refs,
+      CC1120_POOL_FULL_MASK(CC1120_POOL_SMALL_COUNT), 0, 0, 0, 0 },
+    { &cc1120_pool_medium[0][0], CC1120_POOL_MEDIUM_LEN, CC1120_POOL_MEDIUM_COUNT, cc1120_pool_medium_refs,
+      CC1120_POOL_FULL_MASK(CC1120_POOL_MEDIUM_COUNT), 0, 0, 0, 0 },
+    { &cc1120_pool_large[0][0], CC1120_POOL_LARGE_LEN, CC1120_POOL_LARGE_COUNT, cc1120_pool_large_refs,
+      CC1120_POOL_FULL_MASK(CC1120_POOL_LARGE_COUNT), 0, 0, 0, 0 },
+};
+
+/**
+ * @brief Atomically replaces a word if it still holds the expected value. Lock-free where the CPU
+ * has compare-and-swap; on the AVR, interrupts are masked for the few cycles of the compare and store.
+ *
+ * @param p - The word.
+ * @param expected - The value it must hold.
+ * @param desired - The value to store.
+ * @return true - If the word was replaced.
+ * @return false - If the word changed in the meantime.
+ */
+static bool cc1120_pool_cas(volatile uint32_t *p, uint32_t expected, uint32_t desired) {
+#if defined(CC1120_PLATFORM_ARDUINO)
+    uint8_t sreg = cc1120_platform_irq_save();
+    bool swapped = (*p == expected);
+    if (swapped)
+        *p = desired;
+    cc1120_platform_irq_restore(sreg);
+    return swapped;
+#else
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * @brief Atomically adds to a word.
+ *
+ * @param p - The word.
+ * @param delta - The amount to add, wrapping.
+ * @return uint32_t - The new value.
+ */
+static uint32_t cc1120_pool_add(volatile uint32_t *p, uint32_t delta) {
+    uint32_t old;
+    do {
+        old = *p;
+    } while (!cc1120_pool_cas(p, old, old + delta));
+
+    return old + delta;
+}
+
+/**
+ * @brief Finds the size class and index of a buffer.
+ *
+ * @param buf - The buffer.
+ * @param index - Set to the index of the buffer in its class.
+ * @return cc1120_pool_slab_t* - The class, or NULL if buf is not the start of a pool buffer.
+ */
+static cc1120_pool_slab_t *cc1120_pool_find(const uint8_t *buf, uint8_t *index) {
+    uint8_t c;
+    for (c = 0; c < CC1120_POOL_CLASS_COUNT; c++) {
+        cc1120_pool_slab_t *slab = &cc1120_pool_slabs[c];
+        if (buf < slab->base || buf >= slab->base + (uint32_t)slab->len * slab->count)
+            continue;
+
+        uint32_t offset = (uint32_t)(buf - slab->base);
+        if (offset % slab->len != 0)
+            return NULL;
+
+        *index = (uint8_t)(offset / slab->len);
+        return slab;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Takes a buffer from the smallest class that fits and has one free, with a reference count of 1.
+ *
+ * @param len - The number of bytes needed.
+ * @return uint8_t* - The buffer, or NULL if every class that fits is exhausted.
+ */
+uint8_t *cc1120_pool_alloc(uint16_t len) {
+    uint8_t c;
+    for (c = 0; c < CC1120_POOL_CLASS_COUNT; c++) {
+        cc1120_pool_slab_t *slab = &cc1120_pool_slabs[c];
+        if (len > slab->len)
+            continue;
+
+        uint32_t mask;
+        uint8_t bit;
+        do {
+            mask = slab->freeMask;
+            if (mask == 0)
+                break;
+            bit = (uint8_t)__builtin_ctzl(mask);
+        } while (!cc1120_pool_cas(&slab->freeMask, mask, mask & ~(1UL << bit)));
+
+        if (mask == 0) {
+            cc1120_pool_add(&slab->exhausted, 1);
+            continue;
+        }
+
+        slab->refs[bit] = 1;
+        cc1120_pool_add(&slab->allocs, 1);
+
+        uint32_t inUse = cc1120_pool_add(&slab->inUse, 1);
+        uint32_t highWater;
+        do {
+            highWater = slab->highWater;
+        } while (inUse > highWater && !cc1120_pool_cas(&slab->highWater, highWater, inUse));
+
+        return slab->base + (uint32_t)bit * slab->len;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Adds a reference to a buffer, e.g. when a retransmission queue keeps it after the first send.
+ *
+ * @param buf - A buffer from cc1120_pool_alloc.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reference was added.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If buf is not a pool buffer, or is free. Counted as a fault.
+ */
+cc1120_status_code cc1120_pool_ref(uint8_t *buf) {
+    uint8_t index;
+    cc1120_pool_slab_t *slab = cc1120_pool_find(buf, &index);
+
+    if (slab == NULL) {
+        cc1120_pool_add(&cc1120_pool_fault_count, 1);
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // A free buffer may already be someone else's
+    uint32_t refs;
+    do {
+        refs = slab->refs[index];
+        if (refs == 0) {
+            cc1120_pool_add(&cc1120_pool_fault_count, 1);
+            return CC1120_ERROR_CODE_INVALID_PARAM;
+        }
+    } while (!cc1120_pool_cas(&slab->refs[index], refs, refs + 1));
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Drops a reference to a buffer, and returns it to the pool when it was the last.
+ *
+ * @param buf - A buffer from cc1120_pool_alloc.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reference was dropped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If buf is not a pool buffer, or is already free. Counted as a fault.
+ */
+cc1120_status_code cc1120_pool_free(uint8_t *buf) {
+    uint8_t index;
+    cc1120_pool_slab_t *slab = cc1120_pool_find(buf, &index);
+
+    if (slab == NULL) {
+        cc1120_pool_add(&cc1120_pool_fault_count, 1);
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    uint32_t refs;
+    do {
+        refs = slab->refs[index];
+        if (refs == 0) {
+            cc1120_pool_add(&cc1120_pool_fault_count, 1);
+            return CC1120_ERROR_CODE_INVALID_PARAM;
+        }
+    } while (!cc1120_pool_cas(&slab->refs[index], refs, refs - 1));
+
+    if (refs > 1)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    cc1120_pool_add(&slab->inUse, (uint32_t)-1);
+
+    uint32_t mask;
+    do {
+        mask = slab->freeMask;
+    } while (!cc1120_pool_cas(&slab->freeMask, mask, mask | (1UL << index)));
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Gets the size of a buffer, which may be larger than was asked for.
+ *
+ * @param buf - A buffer from cc1120_pool_alloc.
+ * @return uint16_t - The size, or 0 if buf is not from the pool.
+ */
+uint16_t cc1120_pool_capacity(const uint8_t *buf) {
+    uint8_t index;
+    cc1120_pool_slab_t *slab = cc1120_pool_find(buf, &index);
+
+    return (slab != NULL) ? slab->len : 0;
+}
+
+/**
+ * @brief Gets the usage of a size class.
+ *
+ * @param cls - The class.
+ * @param stats - Filled with the usage.
+ */
+void cc1120_pool_get_stats(cc1120_pool_class_t cls, cc1120_pool_stats_t *stats) {
+    cc1120_pool_slab_t *slab = &cc1120_pool_slabs[cls];
+
+    stats->len = slab->len;
+    stats->count = slab->count;
+    stats->inUse = slab->inUse;
+    stats->highWater = slab->highWater;
+    stats->allocs = slab->allocs;
+    stats->exhausted = slab->exhausted;
+}
+
+/**
+ * @brief Gets the number of ref and free calls refused because the buffer was not from the pool, or free.
+ * Those calls do not log, as they may come from an ISR.
+ *
+ * @return uint32_t - The number of faults since startup or the last reset.
+ */
+uint32_t cc1120_pool_faults(void) {
+    return cc1120_pool_fault_count;
+}
+
+/**
+ * @brief Clears the counters, including the faults. The high water marks restart from the buffers in use.
+ *
+ */
+void cc1120_pool_reset_stats(void) {
+    uint8_t c;
+    for (c = 0; c < CC1120_POOL_CLASS_COUNT; c++) {
+        cc1120_pool_slab_t *slab = &cc1120_pool_slabs[c];
+        slab->highWater = slab->inUse;
+        slab->allocs = 0;
+        slab->exhausted = 0;
+    }
+    cc1120_pool_fault_count = 0;
+}
@@ -0,0 +1,112 @@
+#ifndef CC1120_POOL_H
+#define CC1120_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+
+/*
+ * Static slab pool of packet buffers in three size classes, sized at compile time.
+ * Alloc, ref and free are safe from ISRs and need no init: the pool is ready at startup. They never log;
+ * misuse of ref and free is returned as an error and counted in cc1120_pool_faults.
+ * Override the sizes with -D, at most 32 buffers per class.
+ */
+
+#ifndef CC1120_POOL_SMALL_LEN
+#define CC1120_POOL_SMALL_LEN 32U
+#endif
+#ifndef CC1120_POOL_SMALL_COUNT
+#define CC1120_POOL_SMALL_COUNT 8U
+#endif
+
+#ifndef CC1120_POOL_MEDIUM_LEN
+#define CC1120_POOL_MEDIUM_LEN 128U
+#endif
+#ifndef CC1120_POOL_MEDIUM_COUNT
+#define CC1120_POOL_MEDIUM_COUNT 4U
+#endif
+
+#ifndef CC1120_POOL_LARGE_LEN
+#define CC1120_POOL_LARGE_LEN 256U
+#endif
+#ifndef CC1120_POOL_LARGE_COUNT
+#define CC1120_POOL_LARGE_COUNT 2U
+#endif
+
+#if CC1120_POOL_SMALL_COUNT > 32 || CC1120_POOL_MEDIUM_COUNT > 32 || CC1120_POOL_LARGE_COUNT > 32
+#error "At most 32 buffers per pool class"
+#endif
+
+typedef enum {
+    CC1120_POOL_SMALL = 0,
+    CC1120_POOL_MEDIUM,
+    CC1120_POOL_LARGE,
+    CC1120_POOL_CLASS_COUNT
+} cc1120_pool_class_t;
+
+typedef struct {
+    uint16_t len;           /* Size of each buffer */
+    uint8_t count;          /* Number of buffers */
+    uint32_t inUse;
+    uint32_t highWater;     /* Most buffers in use at once */
+    uint32_t allocs;
+    uint32_t exhausted;     /* Requests this class would have served but had no free buffer for */
+} cc1120_pool_stats_t;
+
+/**
+ * @brief Takes a buffer from the smallest class that fits and has one free, with a reference count of 1.
+ *
+ * @param len - The number of bytes needed.
+ * @return uint8_t* - The buffer, or NULL if every class that fits is exhausted.
+ */
+uint8_t *cc1120_pool_alloc(uint16_t len);
+
+/**
+ * @brief Adds a reference to a buffer, e.g. when a retransmission queue keeps it after the first send.
+ *
+ * @param buf - A buffer from cc1120_pool_alloc.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reference was added.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If buf is not a pool buffer, or is free. Counted as a fault.
+ */
+cc1120_status_code cc1120_pool_ref(uint8_t *buf);
+
+/**
+ * @brief Drops a reference to a buffer, and returns it to the pool when it was the last.
+ *
+ * @param buf - A buffer from cc1120_pool_alloc.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reference was dropped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If buf is not a pool buffer, or is already free. Counted as a fault.
+ */
+cc1120_status_code cc1120_pool_free(uint8_t *buf);
+
+/**
+ * @brief Gets the size of a buffer, which may be larger than was asked for.
+ *
+ * @param buf - A buffer from cc1120_pool_alloc.
+ * @return uint16_t - The size, or 0 if buf is not from the pool.
+ */
+uint16_t cc1120_pool_capacity(const uint8_t *buf);
+
+/**
+ * @brief Gets the usage of a size class.
+ *
+ * @param cls - The class.
+ * @param stats - Filled with the usage.
+ */
+void cc1120_pool_get_stats(cc1120_pool_class_t cls, cc1120_pool_stats_t *stats);
+
+/**
+ * @brief Gets the number of ref and free calls refused because the buffer was not from the pool, or free.
+ * Those calls do not log, as they may come from an ISR.
+ *
+ * @return uint32_t - The number of faults since startup or the last reset.
+ */
+uint32_t cc1120_pool_faults(void);
+
+/**
+ * @brief Clears the counters, including the faults. The high water marks restart from the buffers in use.
+ *
+ */
+void cc1120_pool_reset_stats(void);
+
+#endif /* CC1120_POOL_H */
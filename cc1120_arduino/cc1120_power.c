@@ -0,0 +1,210 @@
+#include "cc1120_power.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_txrx.h"
+#include <stddef.h>
+#include <string.h>
+
+static const uint32_t CC1120_POWER_DEFAULT_CURRENT_NA[CC1120_POWER_STATE_COUNT] = {
+    CC1120_POWER_DEFAULT_FSTXON_NA,
+    CC1120_POWER_DEFAULT_IDLE_NA,
+    CC1120_POWER_DEFAULT_XOFF_NA,
+    CC1120_POWER_DEFAULT_SLEEP_NA,
+};
+
+/**
+ * @brief Switches the accounting to a new state.
+ *
+ * @param pm - The power manager.
+ * @param state - The state entered.
+ */
+static void cc1120_power_enter(cc1120_power_t *pm, cc1120_power_state_t state) {
+    cc1120_power_update(pm);
+    pm->state = state;
+    pm->entries[state]++;
+}
+
+/**
+ * @brief Initializes the power manager with the radio in FSTXON, as cc1120_tx_init leaves it.
+ *
+ * @param pm - The power manager to initialize.
+ * @param currentNa - The current draw per state in nA, or NULL for the CC1120_POWER_DEFAULT_* values.
+ * @param supplyMv - The radio supply voltage, used for the energy figures.
+ */
+void cc1120_power_init(cc1120_power_t *pm, const uint32_t currentNa[CC1120_POWER_STATE_COUNT], uint32_t supplyMv) {
+    memset(pm, 0, sizeof(*pm));
+
+    if (currentNa == NULL)
+        currentNa = CC1120_POWER_DEFAULT_CURRENT_NA;
+    memcpy(pm->currentNa, currentNa, sizeof(pm->currentNa));
+
+    pm->wakeUs[CC1120_POWER_IDLE] = CC1120_POWER_DEFAULT_IDLE_WAKE_US;
+    pm->wakeUs[CC1120_POWER_XOFF] = CC1120_POWER_DEFAULT_XOFF_WAKE_US;
+    pm->wakeUs[CC1120_POWER_SLEEP] = CC1120_POWER_DEFAULT_SLEEP_WAKE_US;
+    pm->supplyMv = supplyMv;
+    pm->state = CC1120_POWER_FSTXON;
+    pm->enteredUs = mcu_get_time_us();
+}
+
+/**
+ * @brief Parks the radio until a transmission due at wakeAtUs. Picks the state that draws the least
+ * charge over the idle interval, counting the wake-up at FSTXON current, and stays in FSTXON
+ * if no state can wake in time. cc1120_power_poll then wakes the radio ahead of wakeAtUs.
+ * SLEEP loses the FIFO contents, so queue the packet after the radio is awake.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param pm - The power manager.
+ * @param wakeAtUs - The mcu_get_time_us time at which the radio must be in FSTXON.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was parked, or left in FSTXON.
+ * @return An error code - If the radio did not reach IDLE, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_power_sleep_until(cc1120_dev_t *dev, cc1120_power_t *pm, uint32_t wakeAtUs) {
+    cc1120_status_code status;
+    int32_t idleUs = (int32_t)(wakeAtUs - mcu_get_time_us());
+
+    pm->wakeAtUs = wakeAtUs;
+    pm->wakeScheduled = true;
+
+    if (pm->state != CC1120_POWER_FSTXON || idleUs <= 0)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    cc1120_power_state_t best = CC1120_POWER_FSTXON;
+    uint64_t bestCharge = (uint64_t)idleUs * pm->currentNa[CC1120_POWER_FSTXON];
+
+    uint8_t s;
+    for (s = CC1120_POWER_IDLE; s < CC1120_POWER_STATE_COUNT; s++) {
+        uint32_t wakeUs = pm->wakeUs[s] + CC1120_POWER_PREWAKE_GUARD_US;
+        if (wakeUs >= (uint32_t)idleUs)
+            continue;
+
+        uint64_t charge = (uint64_t)((uint32_t)idleUs - wakeUs) * pm->currentNa[s] +
+                          (uint64_t)wakeUs * pm->currentNa[CC1120_POWER_FSTXON];
+        if (charge < bestCharge) {
+            best = (cc1120_power_state_t)s;
+            bestCharge = charge;
+        }
+    }
+
+    if (best == CC1120_POWER_FSTXON)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_IDLE, CC1120_POWER_WAKE_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    // XOFF and SLEEP are entered when CS goes high after the strobe
+    if (best == CC1120_POWER_XOFF) {
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SXOFF);
+        RETURN_IF_ERROR(status)
+    } else if (best == CC1120_POWER_SLEEP) {
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SPWD);
+        RETURN_IF_ERROR(status)
+    }
+
+    cc1120_power_enter(pm, best);
+    return status;
+}
+
+/**
+ * @brief Wakes the radio once it is time to, so it is in FSTXON by the scheduled time. Call from the main loop.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param pm - The power manager.
+ * @return CC1120_ERROR_CODE_SUCCESS - If no wake was due, or the radio was woken.
+ * @return An error code - If the wake failed.
+ */
+cc1120_status_code cc1120_power_poll(cc1120_dev_t *dev, cc1120_power_t *pm) {
+    if (!pm->wakeScheduled || pm->state == CC1120_POWER_FSTXON)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    uint32_t leadUs = pm->wakeUs[pm->state] + CC1120_POWER_PREWAKE_GUARD_US;
+    if ((int32_t)(pm->wakeAtUs - mcu_get_time_us()) > (int32_t)leadUs)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    return cc1120_power_wake(dev, pm);
+}
+
+/**
+ * @brief Brings the radio back to FSTXON now, and updates the measured wake time of the state it left.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param pm - The power manager.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio is in FSTXON.
+ * @return An error code - If the chip did not wake, did not reach FSTXON, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_power_wake(cc1120_dev_t *dev, cc1120_power_t *pm) {
+    cc1120_status_code status;
+    cc1120_power_state_t from = pm->state;
+
+    pm->wakeScheduled = false;
+    if (from == CC1120_POWER_FSTXON)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    uint32_t start = mcu_get_time_us();
+
+    if (from != CC1120_POWER_IDLE) {
+        status = cc1120_wait_chip_ready(dev, CC1120_POWER_WAKE_TIMEOUT_US);
+        RETURN_IF_ERROR(status)
+    }
+
+    // Leaving IDLE recalibrates the synthesizer, since FS_AUTOCAL is IDLE to RX/TX
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SFSTXON);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_FSTXON, CC1120_POWER_WAKE_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    uint32_t now = mcu_get_time_us();
+    uint32_t wakeUs = now - start;
+    if (wakeUs > pm->wakeUs[from])
+        pm->wakeUs[from] = wakeUs;
+
+    // The wake-up draws roughly FSTXON current but is charged to the state it ends
+    cc1120_power_update(pm);
+    if (pm->currentNa[CC1120_POWER_FSTXON] > pm->currentNa[from])
+        pm->chargeNaUs[from] += (uint64_t)wakeUs * (pm->currentNa[CC1120_POWER_FSTXON] - pm->currentNa[from]);
+
+    cc1120_power_enter(pm, CC1120_POWER_FSTXON);
+    return status;
+}
+
+/**
+ * @brief Adds the time since the last update to the current state, so the figures are current.
+ *
+ * @param pm - The power manager.
+ */
+void cc1120_power_update(cc1120_power_t *pm) {
+    uint32_t now = mcu_get_time_us();
+    uint32_t elapsedUs = now - pm->enteredUs;
+
+    pm->timeUs[pm->state] += elapsedUs;
+    pm->chargeNaUs[pm->state] += (uint64_t)elapsedUs * pm->currentNa[pm->state];
+    pm->enteredUs = now;
+}
+
+/**
+ * @brief Gets the energy drawn in a state, including wake-ups from it.
+ *
+ * @param pm - The power manager.
+ * @param state - The state.
+ * @return uint32_t - The energy in uJ.
+ */
+uint32_t cc1120_power_energy_uj(const cc1120_power_t *pm, cc1120_power_state_t state) {
+    // nA * us * mV = 1e-18 J
+    return (uint32_t)(pm->chargeNaUs[state] / 1000000ULL * pm->supplyMv / 1000000ULL);
+}
+
+/**
+ * @brief Clears the time, charge and entry counts, for example at the start of a pass.
+ *
+ * @param pm - The power manager.
+ */
+void cc1120_power_reset_stats(cc1120_power_t *pm) {
+    cc1120_power_update(pm);
+    memset(pm->timeUs, 0, sizeof(pm->timeUs));
+    memset(pm->chargeNaUs, 0, sizeof(pm->chargeNaUs));
+    memset(pm->entries, 0, sizeof(pm->entries));
+}
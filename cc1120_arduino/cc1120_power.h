@@ -0,0 +1,116 @@
+#ifndef CC1120_POWER_H
+#define CC1120_POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/* Current draw per state in nA, from the datasheet */
+#define CC1120_POWER_DEFAULT_FSTXON_NA 20000000UL
+#define CC1120_POWER_DEFAULT_IDLE_NA 1500000UL
+#define CC1120_POWER_DEFAULT_XOFF_NA 180000UL
+#define CC1120_POWER_DEFAULT_SLEEP_NA 300UL
+
+/* Wake times back to FSTXON used until a wake has been measured */
+#define CC1120_POWER_DEFAULT_IDLE_WAKE_US 800UL     /* Calibration and synthesizer settling */
+#define CC1120_POWER_DEFAULT_XOFF_WAKE_US 1200UL    /* Crystal start, then as from IDLE */
+#define CC1120_POWER_DEFAULT_SLEEP_WAKE_US 1500UL   /* Crystal and regulator start, then as from IDLE */
+
+#define CC1120_POWER_DEFAULT_SUPPLY_MV 3300UL
+
+/* Extra time to wake ahead of a scheduled transmission */
+#define CC1120_POWER_PREWAKE_GUARD_US 200UL
+
+/* Maximum time for any one wake step */
+#define CC1120_POWER_WAKE_TIMEOUT_US 5000UL
+
+/* Ordered from most to least awake */
+typedef enum {
+    CC1120_POWER_FSTXON = 0,
+    CC1120_POWER_IDLE,
+    CC1120_POWER_XOFF,
+    CC1120_POWER_SLEEP,
+    CC1120_POWER_STATE_COUNT
+} cc1120_power_state_t;
+
+typedef struct {
+    cc1120_power_state_t state;
+    uint32_t currentNa[CC1120_POWER_STATE_COUNT];
+    uint32_t wakeUs[CC1120_POWER_STATE_COUNT];      /* Longest measured time back to FSTXON */
+    uint32_t supplyMv;
+    uint32_t enteredUs;         /* When the current state was entered */
+    uint32_t wakeAtUs;          /* When the radio must be back in FSTXON */
+    bool wakeScheduled;
+    uint64_t timeUs[CC1120_POWER_STATE_COUNT];      /* Time spent in each state */
+    uint64_t chargeNaUs[CC1120_POWER_STATE_COUNT];  /* Charge drawn in each state, including wake-ups from it */
+    uint32_t entries[CC1120_POWER_STATE_COUNT];
+} cc1120_power_t;
+
+/**
+ * @brief Initializes the power manager with the radio in FSTXON, as cc1120_tx_init leaves it.
+ *
+ * @param pm - The power manager to initialize.
+ * @param currentNa - The current draw per state in nA, or NULL for the CC1120_POWER_DEFAULT_* values.
+ * @param supplyMv - The radio supply voltage, used for the energy figures.
+ */
+void cc1120_power_init(cc1120_power_t *pm, const uint32_t currentNa[CC1120_POWER_STATE_COUNT], uint32_t supplyMv);
+
+/**
+ * @brief Parks the radio until a transmission due at wakeAtUs. Picks the state that draws the least
+ * charge over the idle interval, counting the wake-up at FSTXON current, and stays in FSTXON
+ * if no state can wake in time. cc1120_power_poll then wakes the radio ahead of wakeAtUs.
+ * SLEEP loses the FIFO contents, so queue the packet after the radio is awake.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param pm - The power manager.
+ * @param wakeAtUs - The mcu_get_time_us time at which the radio must be in FSTXON.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was parked, or left in FSTXON.
+ * @return An error code - If the radio did not reach IDLE, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_power_sleep_until(cc1120_dev_t *dev, cc1120_power_t *pm, uint32_t wakeAtUs);
+
+/**
+ * @brief Wakes the radio once it is time to, so it is in FSTXON by the scheduled time. Call from the main loop.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param pm - The power manager.
+ * @return CC1120_ERROR_CODE_SUCCESS - If no wake was due, or the radio was woken.
+ * @return An error code - If the wake failed.
+ */
+cc1120_status_code cc1120_power_poll(cc1120_dev_t *dev, cc1120_power_t *pm);
+
+/**
+ * @brief Brings the radio back to FSTXON now, and updates the measured wake time of the state it left.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param pm - The power manager.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio is in FSTXON.
+ * @return An error code - If the chip did not wake, did not reach FSTXON, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_power_wake(cc1120_dev_t *dev, cc1120_power_t *pm);
+
+/**
+ * @brief Adds the time since the last update to the current state, so the figures are current.
+ *
+ * @param pm - The power manager.
+ */
+void cc1120_power_update(cc1120_power_t *pm);
+
+/**
+ * @brief Gets the energy drawn in a state, including wake-ups from it.
+ *
+ * @param pm - The power manager.
+ * @param state - The state.
+ * @return uint32_t - The energy in uJ.
+ */
+uint32_t cc1120_power_energy_uj(const cc1120_power_t *pm, cc1120_power_state_t state);
+
+/**
+ * @brief Clears the time, charge and entry counts, for example at the start of a pass.
+ *
+ * @param pm - The power manager.
+ */
+void cc1120_power_reset_stats(cc1120_power_t *pm);
+
+#endif /* CC1120_POWER_H */
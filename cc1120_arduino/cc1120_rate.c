@@ -0,0 +1,191 @@
+#include "cc1120_rate.h"
+#include "cc1120_mcu.h"
+#include "cc1120_regs.h"
+
+/**
+ * @brief Announces a switch to another profile, unless one is already pending.
+ *
+ * @param ctrl - The controller.
+ * @param target - The profile to switch to.
+ */
+static void cc1120_rate_announce(cc1120_rate_ctrl_t *ctrl, uint8_t target) {
+    if (ctrl->countdown > 0)
+        return;
+
+    ctrl->target = target;
+    ctrl->countdown = CC1120_RATE_SWITCH_FRAMES;
+
+    if (target > ctrl->current)
+        ctrl->switchesUp++;
+    else
+        ctrl->switchesDown++;
+}
+
+/**
+ * @brief Decides on a rate change from the metrics of a full window.
+ *
+ * @param ctrl - The controller.
+ */
+static void cc1120_rate_decide(cc1120_rate_ctrl_t *ctrl) {
+    const cc1120_rate_profile_t *cur = &ctrl->profiles[ctrl->current];
+    int16_t rssiDbm = ctrl->rssiAvg16 / 16;
+
+    bool tooManyFails = ((uint16_t)ctrl->crcFails << CC1120_RATE_CRC_FAIL_SHIFT) > ctrl->packets;
+    bool belowCurrent = rssiDbm < cur->minRssiDbm || ctrl->lqiAvg > cur->maxLqi;
+
+    if ((tooManyFails || belowCurrent) && ctrl->current > 0) {
+        cc1120_rate_announce(ctrl, ctrl->current - 1);
+    } else if (ctrl->crcFails == 0 && ctrl->current + 1 < ctrl->numProfiles) {
+        const cc1120_rate_profile_t *next = &ctrl->profiles[ctrl->current + 1];
+        if (rssiDbm >= next->minRssiDbm + ctrl->hysteresisDb && ctrl->lqiAvg <= next->maxLqi)
+            cc1120_rate_announce(ctrl, ctrl->current + 1);
+    }
+
+    ctrl->packets = 0;
+    ctrl->crcFails = 0;
+}
+
+/**
+ * @brief Initializes the rate controller on a profile. Does not touch the radio.
+ *
+ * @param ctrl - The controller to initialize.
+ * @param profiles - The profile table, most robust first.
+ * @param numProfiles - The number of profiles, at most CC1120_RATE_MAX_PROFILES.
+ * @param initial - The profile currently applied to the radio.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the controller was initialized.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the profile table or initial profile is invalid.
+ */
+cc1120_status_code cc1120_rate_init(cc1120_rate_ctrl_t *ctrl, const cc1120_rate_profile_t profiles[],
+                                    uint8_t numProfiles, uint8_t initial) {
+    if (numProfiles < 1 || numProfiles > CC1120_RATE_MAX_PROFILES || initial >= numProfiles) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_rate_init: Invalid profile table!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    ctrl->profiles = profiles;
+    ctrl->numProfiles = numProfiles;
+    ctrl->current = initial;
+    ctrl->target = initial;
+    ctrl->countdown = 0;
+    ctrl->rssiAvg16 = profiles[initial].minRssiDbm * 16;
+    ctrl->lqiAvg = profiles[initial].maxLqi;
+    ctrl->packets = 0;
+    ctrl->crcFails = 0;
+    ctrl->hysteresisDb = CC1120_RATE_DEFAULT_HYSTERESIS_DB;
+    ctrl->switchesUp = 0;
+    ctrl->switchesDown = 0;
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Records the link metrics of one received packet.
+ * At the end of each window, decides whether to step the rate up or down and,
+ * if so, announces the switch through the header field.
+ *
+ * @param ctrl - The controller.
+ * @param rssiDbm - The packet RSSI in dBm.
+ * @param lqi - The packet LQI.
+ * @param crcOk - Whether the packet passed CRC.
+ */
+void cc1120_rate_on_packet(cc1120_rate_ctrl_t *ctrl, int16_t rssiDbm, uint8_t lqi, bool crcOk) {
+    if (crcOk) {
+        // Moving average with weight 1/8, so a window mostly reflects its own packets
+        ctrl->rssiAvg16 += (rssiDbm * 16 - ctrl->rssiAvg16) / 8;
+        ctrl->lqiAvg = (uint8_t)(ctrl->lqiAvg + ((int16_t)lqi - ctrl->lqiAvg) / 8);
+    } else {
+        ctrl->crcFails++;
+    }
+
+    ctrl->packets++;
+    if (ctrl->packets >= CC1120_RATE_WINDOW)
+        cc1120_rate_decide(ctrl);
+}
+
+/**
+ * @brief Records the link metrics of one received packet from its two appended status bytes.
+ *
+ * @param ctrl - The controller.
+ * @param status - The RSSI and CRC_OK/LQI bytes appended by the CC1120.
+ */
+void cc1120_rate_on_status_bytes(cc1120_rate_ctrl_t *ctrl, const uint8_t status[2]) {
+    int16_t rssiDbm = (int16_t)((int8_t)status[0]) - CC1120_RSSI_OFFSET_DB;
+
+    cc1120_rate_on_packet(ctrl, rssiDbm, status[1] & CC1120_STATUS_LQI_MASK, (status[1] & CC1120_STATUS_CRC_OK) != 0);
+}
+
+/**
+ * @brief Gets the rate field to put in the header of the next outgoing frame.
+ *
+ * @param ctrl - The controller.
+ * @return uint8_t - The header field, see CC1120_RATE_HEADER.
+ */
+uint8_t cc1120_rate_header_field(const cc1120_rate_ctrl_t *ctrl) {
+    return CC1120_RATE_HEADER(ctrl->target, ctrl->countdown);
+}
+
+/**
+ * @brief Adopts a switch announced by the peer in a received header.
+ *
+ * @param ctrl - The controller.
+ * @param field - The rate field from the received header.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the field was accepted.
+ * @return CC1120_ERROR_CODE_INVALID_RATE_HEADER - If the field names an unknown profile.
+ * @return CC1120_ERROR_CODE_RATE_OUT_OF_SYNC - If the peer is already on another profile, e.g. after a header
+ * announcing the switch was lost. The switch is then applied at the next frame boundary.
+ */
+cc1120_status_code cc1120_rate_on_header(cc1120_rate_ctrl_t *ctrl, uint8_t field) {
+    uint8_t target = CC1120_RATE_HEADER_TARGET(field);
+    uint8_t countdown = CC1120_RATE_HEADER_COUNTDOWN(field);
+
+    if (target >= ctrl->numProfiles) {
+        mcu_log(CC1120_LOG_LEVEL_WARN, "cc1120_rate_on_header: Unknown profile %u in header\n", target);
+        return CC1120_ERROR_CODE_INVALID_RATE_HEADER;
+    }
+
+    if (target == ctrl->current)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    // A countdown of 0 means the peer has already switched, so follow it as soon as possible
+    if (countdown == 0) {
+        mcu_log(CC1120_LOG_LEVEL_WARN, "cc1120_rate_on_header: Peer already on profile %u\n", target);
+        ctrl->target = target;
+        ctrl->countdown = 1;
+        return CC1120_ERROR_CODE_RATE_OUT_OF_SYNC;
+    }
+
+    // Both ends now count down from the same value at the same frame boundaries
+    ctrl->target = target;
+    ctrl->countdown = countdown;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Advances the switch countdown at a frame boundary and applies the pending profile when it expires.
+ * Only the registers that differ between the profiles are written. The radio should be in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ctrl - The controller.
+ * @return CC1120_ERROR_CODE_SUCCESS - If no switch was due, or the switch was applied.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_rate_frame_boundary(cc1120_dev_t *dev, cc1120_rate_ctrl_t *ctrl) {
+    cc1120_status_code status;
+
+    if (ctrl->countdown == 0)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    ctrl->countdown--;
+    if (ctrl->countdown > 0)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    status = cc1120_modem_apply_delta(dev, ctrl->profiles[ctrl->current].cfg, ctrl->profiles[ctrl->target].cfg);
+    RETURN_IF_ERROR(status)
+
+    ctrl->current = ctrl->target;
+
+    // Metrics gathered at the old rate say little about the new one
+    ctrl->packets = 0;
+    ctrl->crcFails = 0;
+    return status;
+}
@@ -0,0 +1,116 @@
+#ifndef CC1120_RATE_H
+#define CC1120_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_modem.h"
+
+/* Packets evaluated per rate decision */
+#define CC1120_RATE_WINDOW 16U
+
+/* Frames between announcing a switch in the header and applying it */
+#define CC1120_RATE_SWITCH_FRAMES 2U
+
+/* Step down when more than 1 in 2^CC1120_RATE_CRC_FAIL_SHIFT packets in a window fail CRC */
+#define CC1120_RATE_CRC_FAIL_SHIFT 3U
+
+#define CC1120_RATE_DEFAULT_HYSTERESIS_DB 3
+
+#define CC1120_RATE_MAX_PROFILES 16U
+
+/* Rate header field: target profile in bits 7:4, frames until the switch in bits 3:0 */
+#define CC1120_RATE_HEADER(target, countdown) ((uint8_t)(((target) << 4) | ((countdown) & 0x0FU)))
+#define CC1120_RATE_HEADER_TARGET(field) ((uint8_t)((field) >> 4))
+#define CC1120_RATE_HEADER_COUNTDOWN(field) ((uint8_t)((field) & 0x0FU))
+
+/* Appended status byte 2 (PKT_CFG1.APPEND_STATUS): CRC_OK in bit 7, LQI in bits 6:0 */
+#define CC1120_STATUS_CRC_OK 0x80U
+#define CC1120_STATUS_LQI_MASK 0x7FU
+
+typedef struct {
+    const cc1120_modem_cfg_t *cfg;
+    int16_t minRssiDbm;     /* Weakest signal the profile decodes reliably */
+    uint8_t maxLqi;         /* Worst LQI the profile tolerates; lower LQI is better */
+} cc1120_rate_profile_t;
+
+typedef struct {
+    const cc1120_rate_profile_t *profiles;  /* Sorted from most robust to fastest */
+    uint8_t numProfiles;
+    uint8_t current;            /* Profile applied to the radio */
+    uint8_t target;             /* Profile announced in the header */
+    uint8_t countdown;          /* Frames left before target is applied, 0 if no switch is pending */
+    int16_t rssiAvg16;          /* Moving average of RSSI in 1/16 dBm */
+    uint8_t lqiAvg;
+    uint8_t packets;            /* Packets in the current window */
+    uint8_t crcFails;           /* CRC failures in the current window */
+    int8_t hysteresisDb;
+    uint32_t switchesUp;
+    uint32_t switchesDown;
+} cc1120_rate_ctrl_t;
+
+/**
+ * @brief Initializes the rate controller on a profile. Does not touch the radio.
+ *
+ * @param ctrl - The controller to initialize.
+ * @param profiles - The profile table, most robust first.
+ * @param numProfiles - The number of profiles, at most CC1120_RATE_MAX_PROFILES.
+ * @param initial - The profile currently applied to the radio.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the controller was initialized.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the profile table or initial profile is invalid.
+ */
+cc1120_status_code cc1120_rate_init(cc1120_rate_ctrl_t *ctrl, const cc1120_rate_profile_t profiles[],
+                                    uint8_t numProfiles, uint8_t initial);
+
+/**
+ * @brief Records the link metrics of one received packet.
+ * At the end of each window, decides whether to step the rate up or down and,
+ * if so, announces the switch through the header field.
+ *
+ * @param ctrl - The controller.
+ * @param rssiDbm - The packet RSSI in dBm.
+ * @param lqi - The packet LQI.
+ * @param crcOk - Whether the packet passed CRC.
+ */
+void cc1120_rate_on_packet(cc1120_rate_ctrl_t *ctrl, int16_t rssiDbm, uint8_t lqi, bool crcOk);
+
+/**
+ * @brief Records the link metrics of one received packet from its two appended status bytes.
+ *
+ * @param ctrl - The controller.
+ * @param status - The RSSI and CRC_OK/LQI bytes appended by the CC1120.
+ */
+void cc1120_rate_on_status_bytes(cc1120_rate_ctrl_t *ctrl, const uint8_t status[2]);
+
+/**
+ * @brief Gets the rate field to put in the header of the next outgoing frame.
+ *
+ * @param ctrl - The controller.
+ * @return uint8_t - The header field, see CC1120_RATE_HEADER.
+ */
+uint8_t cc1120_rate_header_field(const cc1120_rate_ctrl_t *ctrl);
+
+/**
+ * @brief Adopts a switch announced by the peer in a received header.
+ *
+ * @param ctrl - The controller.
+ * @param field - The rate field from the received header.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the field was accepted.
+ * @return CC1120_ERROR_CODE_INVALID_RATE_HEADER - If the field names an unknown profile.
+ * @return CC1120_ERROR_CODE_RATE_OUT_OF_SYNC - If the peer is already on another profile, e.g. after a header
+ * announcing the switch was lost. The switch is then applied at the next frame boundary.
+ */
+cc1120_status_code cc1120_rate_on_header(cc1120_rate_ctrl_t *ctrl, uint8_t field);
+
+/**
+ * @brief Advances the switch countdown at a frame boundary and applies the pending profile when it expires.
+ * Only the registers that differ between the profiles are written. The radio should be in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ctrl - The controller.
+ * @return CC1120_ERROR_CODE_SUCCESS - If no switch was due, or the switch was applied.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_rate_frame_boundary(cc1120_dev_t *dev, cc1120_rate_ctrl_t *ctrl);
+
+#endif /* CC1120_RATE_H */
@@ -218,6 +218,140 @@
 
 #define CC1120_REGS_EXT_SPACE_END           0xD9U
 
+/* IOCFGx fields. IOCFG3 is at the lowest address, IOCFG0 at the highest. */
+#define CC1120_IOCFG_GPIO_ATRAN             0x80U
+#define CC1120_IOCFG_GPIO_INV               0x40U
+#define CC1120_IOCFG_GPIO_CFG_MASK          0x3FU
+
+/* IOCFGx.GPIOx_CFG signals. See section 3.4 of the user guide. */
+#define CC1120_GPIO_CFG_RXFIFO_THR          0x00U
+#define CC1120_GPIO_CFG_RXFIFO_THR_PKT      0x01U
+#define CC1120_GPIO_CFG_TXFIFO_THR          0x02U
+#define CC1120_GPIO_CFG_TXFIFO_THR_PKT      0x03U
+#define CC1120_GPIO_CFG_RXFIFO_OVERFLOW     0x04U
+#define CC1120_GPIO_CFG_TXFIFO_UNDERFLOW    0x05U
+#define CC1120_GPIO_CFG_PKT_SYNC_RXTX       0x06U
+#define CC1120_GPIO_CFG_CRC_OK              0x07U
+#define CC1120_GPIO_CFG_PQT_REACHED         0x0BU
+#define CC1120_GPIO_CFG_PQT_VALID           0x0CU
+#define CC1120_GPIO_CFG_RSSI_VALID          0x0DU
+#define CC1120_GPIO_CFG_CCA_STATUS          0x0FU   /* GPIO3 and GPIO1 only */
+#define CC1120_GPIO_CFG_TXONCCA_DONE        0x0FU   /* GPIO2 only */
+#define CC1120_GPIO_CFG_TXONCCA_FAILED      0x0FU   /* GPIO0 only */
+#define CC1120_GPIO_CFG_CARRIER_SENSE_VALID 0x10U
+#define CC1120_GPIO_CFG_CARRIER_SENSE       0x11U
+#define CC1120_GPIO_CFG_PKT_CRC_OK          0x13U
+#define CC1120_GPIO_CFG_MCU_WAKEUP          0x14U
+#define CC1120_GPIO_CFG_HIGHZ               0x30U
+
+/* MARCSTATE.MARC_STATE values */
+#define CC1120_MARCSTATE_MASK               0x1FU
+#define CC1120_MARCSTATE_SLEEP              0x00U
+#define CC1120_MARCSTATE_IDLE               0x01U
+#define CC1120_MARCSTATE_XOFF               0x02U
+#define CC1120_MARCSTATE_MANCAL             0x05U
+#define CC1120_MARCSTATE_FS_LOCK            0x0AU
+#define CC1120_MARCSTATE_RX                 0x0DU
+#define CC1120_MARCSTATE_RX_END             0x0EU
+#define CC1120_MARCSTATE_TXRX_SWITCH        0x10U
+#define CC1120_MARCSTATE_RX_FIFO_ERR        0x11U
+#define CC1120_MARCSTATE_FSTXON             0x12U
+#define CC1120_MARCSTATE_TX                 0x13U
+#define CC1120_MARCSTATE_TX_END             0x14U
+#define CC1120_MARCSTATE_RXTX_SWITCH        0x15U
+#define CC1120_MARCSTATE_TX_FIFO_ERR        0x16U
+
+/* Chip status byte STATE field, returned with every SPI header byte */
+#define CC1120_STATE_MASK                   0x70U
+#define CC1120_STATE_IDLE                   0x00U
+#define CC1120_STATE_RX                     0x10U
+#define CC1120_STATE_TX                     0x20U
+#define CC1120_STATE_FSTXON                 0x30U
+#define CC1120_STATE_CALIBRATE              0x40U
+#define CC1120_STATE_SETTLING               0x50U
+#define CC1120_STATE_RX_FIFO_ERR            0x60U
+#define CC1120_STATE_TX_FIFO_ERR            0x70U
+
+/* PKT_CFG2.CCA_MODE values */
+#define CC1120_PKT_CFG2_CCA_MODE_MASK       0x1CU
+#define CC1120_PKT_CFG2_CCA_MODE_SHIFT      2U
+#define CC1120_CCA_MODE_ALWAYS              0x00U
+#define CC1120_CCA_MODE_RSSI_BELOW_THR      0x01U
+#define CC1120_CCA_MODE_NOT_RECEIVING       0x02U
+#define CC1120_CCA_MODE_RSSI_BELOW_THR_NOT_RECEIVING 0x03U
+#define CC1120_CCA_MODE_ETSI_LBT            0x04U
+
+/* MARC_STATUS1.MARC_STATUS_OUT values */
+#define CC1120_MARC_STATUS1_NO_FAILURE      0x00U
+#define CC1120_MARC_STATUS1_TX_FIFO_OVERFLOW    0x07U
+#define CC1120_MARC_STATUS1_TX_FIFO_UNDERFLOW   0x08U
+#define CC1120_MARC_STATUS1_RX_FIFO_OVERFLOW    0x09U
+#define CC1120_MARC_STATUS1_RX_FIFO_UNDERFLOW   0x0AU
+#define CC1120_MARC_STATUS1_TXONCCA_FAILED  0x0BU
+#define CC1120_MARC_STATUS1_TX_DONE         0x40U
+#define CC1120_MARC_STATUS1_RX_DONE         0x80U
+
+/* MARC_STATUS0 fields */
+#define CC1120_MARC_STATUS0_TXONCCA_FAILED  0x04U
+
+/* RNDGEN fields */
+#define CC1120_RNDGEN_EN                    0x80U
+#define CC1120_RNDGEN_VALUE_MASK            0x7FU
+
+/* RSSI0 fields */
+#define CC1120_RSSI0_RSSI_VALID             0x01U
+#define CC1120_RSSI0_CARRIER_SENSE_VALID    0x02U
+#define CC1120_RSSI0_CARRIER_SENSE          0x04U
+#define CC1120_RSSI0_RSSI_LSB_MASK          0x78U
+#define CC1120_RSSI0_RSSI_LSB_SHIFT         3U
+
+/* RSSI offset for the CC1120 with AGC_GAIN_ADJUST = 0. See section 6.9 of the user guide. */
+#define CC1120_RSSI_OFFSET_DB               102
+
+/* Reported by RSSI1 when no valid RSSI value is available */
+#define CC1120_RSSI_INVALID                 0x80U
+
+/* SETTLING_CFG fields */
+#define CC1120_SETTLING_CFG_FS_AUTOCAL_MASK     0x18U
+#define CC1120_SETTLING_CFG_FS_AUTOCAL_NEVER    0x00U
+#define CC1120_SETTLING_CFG_FS_AUTOCAL_IDLE_TO_RXTX 0x08U
+
+/* RFEND_CFG1.RXOFF_MODE and RFEND_CFG0.TXOFF_MODE: the state entered when a packet ends */
+#define CC1120_RFEND_CFG1_RXOFF_MODE_MASK   0x30U
+#define CC1120_RFEND_CFG0_TXOFF_MODE_MASK   0x30U
+#define CC1120_RFEND_OFF_MODE_SHIFT         4U
+#define CC1120_OFF_MODE_IDLE                0x00U
+#define CC1120_OFF_MODE_FSTXON              0x01U
+#define CC1120_OFF_MODE_TX                  0x02U
+#define CC1120_OFF_MODE_RX                  0x03U
+
+/* RFEND_CFG1 RX termination timer fields */
+#define CC1120_RFEND_CFG1_RX_TIME_MASK      0x0EU
+#define CC1120_RFEND_CFG1_RX_TIME_SHIFT     1U
+#define CC1120_RFEND_CFG1_RX_TIME_FOREVER   0x07U
+#define CC1120_RFEND_CFG1_RX_TIME_QUAL      0x01U
+
+/* RFEND_CFG0.ANT_DIV_RX_TERM_CFG values that end RX early when nothing is heard */
+#define CC1120_RX_TERM_NONE                 0x00U
+#define CC1120_RX_TERM_CS                   0x01U   /* Carrier sense not asserted once valid */
+#define CC1120_RX_TERM_PQT                  0x04U   /* PQT not reached once evaluated */
+
+/* WOR_CFG1 fields */
+#define CC1120_WOR_CFG1_WOR_RES_SHIFT       6U
+#define CC1120_WOR_CFG1_WOR_MODE_SHIFT      3U
+#define CC1120_WOR_CFG1_EVENT1_MASK         0x07U
+#define CC1120_WOR_MODE_FEEDBACK            0x00U
+#define CC1120_WOR_MODE_NORMAL              0x01U
+
+/* WOR_CFG0 fields */
+#define CC1120_WOR_CFG0_DIV_256HZ_EN        0x20U
+#define CC1120_WOR_CFG0_RC_MODE_CAL         0x04U
+#define CC1120_WOR_CFG0_RC_PD               0x01U
+
+/* PREAMBLE_CFG0 fields */
+#define CC1120_PREAMBLE_CFG0_PQT_EN         0x20U
+#define CC1120_PREAMBLE_CFG0_PQT_MASK       0x0FU
+
 /* Standard register space defaults */
 #define CC1120_DEFAULTS_IOCFG3              0x06U
 #define CC1120_DEFAULTS_IOCFG2              0x07U
@@ -1,5 +1,54 @@
 #include "cc1120_rm46.h"
 
+#if defined(CC1120_PLATFORM_RM46)
+
+#include "cc1120_rm46_mibspi.h"
+#include "cc1120_rm46_sched.h"
+#include "cc1120_rm46_f021.h"
+#include "cc1120_flog.h"
+#include <stddef.h>
+#include <string.h>
+
+#if CC1120_FLOG_PAGE_SIZE * CC1120_FLOG_PAGES_PER_SECTOR != RM46_F021_BANK7_SECTOR_SIZE
+#error "A log sector must be one bank 7 sector"
+#endif
+#if RM46_FLOG_FIRST_SECTOR + CC1120_FLOG_SECTORS > RM46_F021_BANK7_SECTORS
+#error "The log does not fit in bank 7"
+#endif
+#if CC1120_FLOG_PAGE_SIZE % RM46_F021_BANK7_WIDTH != 0
+#error "A log page must be a whole number of bank 7 program widths"
+#endif
+
+/* Address of a page of the log in bank 7 */
+#define RM46_FLOG_ADDR(sector, page)                                                                   \
+    (RM46_F021_BANK7_BASE + (RM46_FLOG_FIRST_SECTOR + (uint32_t)(sector)) * RM46_F021_BANK7_SECTOR_SIZE + \
+     (uint32_t)(page) * CC1120_FLOG_PAGE_SIZE)
+
+static cc1120_flog_t rm46_file_log_state;
+static rm46_cc1120_pin_t rm46GpioPins[CC1120_GPIO_COUNT];
+static cc1120_gpio_dispatcher_t *rm46GpioDispatcher[CC1120_GPIO_COUNT];
+static uint8_t rm46TimerCompare;
+static bool rm46TimerReady = false;
+static void (*volatile rm46TimerCallback)(void *ctx);
+static void *volatile rm46TimerCtx;
+
+/**
+ * @brief Transfers bytes one at a time, polling each.
+ * 
+ * @param bus - The bus to use.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+static void rm46_cc1120_poll_block(rm46_cc1120_bus_t *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        uint8_t data = rm46_mibspi_transfer_byte(bus, (tx != NULL) ? tx[i] : 0x00);
+        if (rx != NULL)
+            rx[i] = data;
+    }
+}
+
 /**
  * @brief Logs a string to the serial port.
  * 
@@ -18,35 +67,389 @@ void rm46_serial_log(cc1120_log_level_t level, char str[]) {
  * @param str - The string to log.
  */
 void rm46_file_log(cc1120_log_level_t level, char str[]) {
-    /* Fill in later */    
-    return;
+    cc1120_flog_append(&rm46_file_log_state, level, str);
+}
+
+/**
+ * @brief Erases a sector of the log flash.
+ * 
+ * @param ctx - Unused.
+ * @param sector - The sector in the log area.
+ * @return true - If the sector was erased.
+ * @return false - If the erase failed.
+ */
+static bool rm46_flash_erase(void *ctx, uint16_t sector) {
+    return rm46_f021_erase(RM46_FLOG_ADDR(sector, 0U));
+}
+
+/**
+ * @brief Programs a page of the log flash.
+ * 
+ * @param ctx - Unused.
+ * @param sector - The sector in the log area.
+ * @param page - The page in the sector.
+ * @param data - The page to program.
+ * @return true - If the page was programmed.
+ * @return false - If the program failed.
+ */
+static bool rm46_flash_program(void *ctx, uint16_t sector, uint16_t page, const uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    return rm46_f021_program(RM46_FLOG_ADDR(sector, page), data, CC1120_FLOG_PAGE_SIZE);
+}
+
+/**
+ * @brief Reads a page of the log flash.
+ * 
+ * @param ctx - Unused.
+ * @param sector - The sector in the log area.
+ * @param page - The page in the sector.
+ * @param data - Filled with the page.
+ * @return true - If the page was read.
+ * @return false - If the read failed.
+ */
+static bool rm46_flash_read(void *ctx, uint16_t sector, uint16_t page, uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    // Bank 7 is memory mapped
+    memcpy(data, (const void *)(uintptr_t)RM46_FLOG_ADDR(sector, page), CC1120_FLOG_PAGE_SIZE);
+    return true;
+}
+
+static const cc1120_flog_flash_ops_t RM46_FLASH_LOG_OPS = {
+    rm46_flash_erase,
+    rm46_flash_program,
+    rm46_flash_read,
+};
+
+/**
+ * @brief Finds where the log in flash ends, so that logging continues after it. Call once at startup.
+ * 
+ * @return cc1120_status_code - Whether or not the log flash could be read
+ */
+cc1120_status_code rm46_file_log_mount(void) {
+    if (!rm46_f021_init())
+        return CC1120_ERROR_CODE_FLASH_FAILED;
+
+    return cc1120_flog_mount(&rm46_file_log_state, &RM46_FLASH_LOG_OPS, NULL);
+}
+
+/**
+ * @brief Writes the buffered log pages to flash. Call from a low-priority task, never from an SPI path.
+ * 
+ * @return cc1120_status_code - Whether or not the flash writes were successful
+ */
+cc1120_status_code rm46_file_log_flush(void) {
+    return cc1120_flog_flush(&rm46_file_log_state);
 }
 
 /**
  * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
  * 
+ * @param bus - The bus handle of the device.
  * @param data - Data to transfer 
  * @return uint8_t - Data received from CC1120
  */
-uint8_t rm46_cc1120_spi_transfer(uint8_t data) {
-    /* Fill in later */
-    return 0;
+uint8_t rm46_cc1120_spi_transfer(void *bus, uint8_t data) {
+    return rm46_mibspi_transfer_byte((rm46_cc1120_bus_t *)bus, data);
+}
+
+/**
+ * @brief Runs the block in progress up to its next DMA chunk, polling short chunks on the way,
+ * or finishes the block after its last chunk.
+ * 
+ * @param bus - The bus.
+ */
+static void rm46_cc1120_block_next(rm46_cc1120_bus_t *bus) {
+    while (bus->chunk < bus->plan.numChunks) {
+        const cc1120_rm46_chunk_t *chunk = &bus->plan.chunks[bus->chunk];
+        const uint8_t *chunkTx = (bus->tx != NULL) ? &bus->tx[chunk->offset] : NULL;
+
+        if (chunk->mode == CC1120_RM46_CHUNK_GROUP_DMA) {
+            bus->phase = RM46_BLOCK_LOAD;
+            rm46_mibspi_load_group(bus, chunkTx, chunk->len);
+            return;
+        }
+
+        rm46_cc1120_poll_block(bus, chunkTx, (bus->rx != NULL) ? &bus->rx[chunk->offset] : NULL, chunk->len);
+        bus->chunk++;
+    }
+
+    bus->phase = RM46_BLOCK_IDLE;
+    if (bus->done != NULL)
+        bus->done(bus->doneCtx);
+}
+
+/**
+ * @brief Transfers a block of bytes over CC1120 SPI interface
+ * Long blocks are moved by DMA and shifted by a transfer group, short ones are polled.
+ * The driver needs the block done before it raises CS, so this waits for the interrupts to finish it.
+ * 
+ * @param bus - The bus handle of the device.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+void rm46_cc1120_spi_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    rm46_cc1120_bus_t *port = (rm46_cc1120_bus_t *)bus;
+
+    // A block started asynchronously owns the port until it is done
+    while (port->phase != RM46_BLOCK_IDLE)
+        ;
+
+    rm46_cc1120_spi_transfer_block_async(bus, tx, rx, len, NULL, NULL);
+    while (port->phase != RM46_BLOCK_IDLE)
+        ;
+}
+
+/**
+ * @brief Starts transferring a block of bytes over CC1120 SPI interface and returns.
+ * The interrupts finish the block, and the CPU is free meanwhile. For a FIFO burst, assert CS and send the
+ * header with rm46_cc1120_spi_transfer first, then deassert CS from the callback.
+ * 
+ * @param bus - The bus handle of the device, with no block in progress.
+ * @param tx - The bytes to send, or NULL to send zeros. Must stay valid until the block is done.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ * @param done - Called once the block is done, from interrupt context unless the block was all polled, or NULL.
+ * @param ctx - Passed to done.
+ */
+void rm46_cc1120_spi_transfer_block_async(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len,
+                                          void (*done)(void *ctx), void *ctx) {
+    rm46_cc1120_bus_t *port = (rm46_cc1120_bus_t *)bus;
+
+    port->tx = tx;
+    port->rx = rx;
+    port->done = done;
+    port->doneCtx = ctx;
+    port->chunk = 0;
+
+    // Too long to plan: one polled chunk, which the planner never needs for real FIFO accesses
+    if (cc1120_rm46_plan(&port->plan, len, CC1120_RM46_MIBSPI_BUFFERS, port->dmaMinLen) == 0 && len > 0) {
+        rm46_cc1120_poll_block(port, tx, rx, len);
+        port->plan.numChunks = 0;
+    }
+
+    rm46_cc1120_block_next(port);
+}
+
+/**
+ * @brief Checks whether a block transfer is still in progress on a bus.
+ * 
+ * @param bus - The bus handle.
+ * @return true - If a block started by rm46_cc1120_spi_transfer_block_async has not finished.
+ */
+bool rm46_cc1120_spi_busy(void *bus) {
+    return ((rm46_cc1120_bus_t *)bus)->phase != RM46_BLOCK_IDLE;
+}
+
+/**
+ * @brief Advances the block in progress once the bus' transfer group has finished.
+ * Call from mibspiGroupNotification.
+ * 
+ * @param bus - The bus handle.
+ */
+void rm46_cc1120_spi_group_isr(void *bus) {
+    rm46_cc1120_bus_t *port = (rm46_cc1120_bus_t *)bus;
+    const cc1120_rm46_chunk_t *chunk = &port->plan.chunks[port->chunk];
+
+    if (port->phase != RM46_BLOCK_SHIFT)
+        return;
+
+    if (port->rx != NULL) {
+        port->phase = RM46_BLOCK_DRAIN;
+        rm46_mibspi_read_group(port, &port->rx[chunk->offset], chunk->len);
+        return;
+    }
+
+    port->chunk++;
+    rm46_cc1120_block_next(port);
+}
+
+/**
+ * @brief Advances the block in progress once a DMA copy has finished.
+ * Call from dmaGroupANotification on BTC.
+ * 
+ * @param bus - The bus handle.
+ * @param channel - The DMA channel that finished.
+ */
+void rm46_cc1120_spi_dma_isr(void *bus, uint32_t channel) {
+    rm46_cc1120_bus_t *port = (rm46_cc1120_bus_t *)bus;
+
+    if (port->phase == RM46_BLOCK_LOAD && channel == port->dmaTxChannel) {
+        port->phase = RM46_BLOCK_SHIFT;
+        rm46_mibspi_start_group(port, port->plan.chunks[port->chunk].len);
+    } else if (port->phase == RM46_BLOCK_DRAIN && channel == port->dmaRxChannel) {
+        port->chunk++;
+        rm46_cc1120_block_next(port);
+    }
 }
 
 /**
  * @brief Pulls the CS pin low.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
  */
-void rm46_cc1120_cs_assert() {
-    /* Fill in later */
-    return;
+void rm46_cc1120_cs_assert(void *bus, uint8_t csPin) {
+    rm46_mibspi_set_cs((rm46_cc1120_bus_t *)bus, csPin, 0);
 }
 
 /**
  * @brief Pulls the CS pin high.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
  */
-void rm46_cc1120_cs_deassert() {
-    /* Fill in later */
-    return;
+void rm46_cc1120_cs_deassert(void *bus, uint8_t csPin) {
+    rm46_mibspi_set_cs((rm46_cc1120_bus_t *)bus, csPin, 1);
+}
+
+/**
+ * @brief Sets the SPI clock.
+ * 
+ * @param bus - The bus handle of the device.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz.
+ */
+uint32_t rm46_cc1120_spi_set_clock(void *bus, uint32_t hz) {
+    return rm46_mibspi_set_clock((rm46_cc1120_bus_t *)bus, hz);
+}
+
+/**
+ * @brief Sets the pins the CC1120 GPIOs are wired to. Call before mapping any signal.
+ * 
+ * @param pins - The pin of each CC1120 GPIO (0-3).
+ */
+void rm46_cc1120_gpio_pins(const rm46_cc1120_pin_t pins[CC1120_GPIO_COUNT]) {
+    uint8_t gpio;
+    for (gpio = 0; gpio < CC1120_GPIO_COUNT; gpio++)
+        rm46GpioPins[gpio] = pins[gpio];
+}
+
+/**
+ * @brief Forwards a pin interrupt to the dispatcher of the CC1120 GPIO wired to it.
+ * 
+ * @param port - The port that interrupted, RM46_PIN_*.
+ * @param pinOrEdge - The GIO pin, or the N2HET1 edge detect.
+ */
+void rm46_cc1120_gpio_isr(uint8_t port, uint32_t pinOrEdge) {
+    uint8_t gpio;
+    for (gpio = 0; gpio < CC1120_GPIO_COUNT; gpio++) {
+        const rm46_cc1120_pin_t *pin = &rm46GpioPins[gpio];
+        uint32_t id = (port == RM46_PIN_N2HET1) ? pin->edge : pin->pin;
+
+        if (pin->port == port && id == pinOrEdge && rm46GpioDispatcher[gpio] != NULL)
+            cc1120_gpio_dispatch(rm46GpioDispatcher[gpio], gpio, rm46_gio_read(pin->port, pin->pin));
+    }
+}
+
+/**
+ * @brief Reads the level of one of the CC1120 GPIO pins.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @return uint8_t - 1 if the pin is high, 0 if it is low.
+ */
+uint8_t rm46_cc1120_gpio_read(uint8_t gpio) {
+    if (gpio >= CC1120_GPIO_COUNT)
+        return 0;
+    return rm46_gio_read(rm46GpioPins[gpio].port, rm46GpioPins[gpio].pin);
 }
+
+/**
+ * @brief Routes the change interrupt of one of the CC1120 GPIO pins to a dispatcher.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @param dispatcher - The dispatcher to call cc1120_gpio_dispatch on, or NULL to detach the interrupt.
+ */
+void rm46_cc1120_gpio_attach(uint8_t gpio, cc1120_gpio_dispatcher_t *dispatcher) {
+    if (gpio >= CC1120_GPIO_COUNT)
+        return;
+
+    const rm46_cc1120_pin_t *pin = &rm46GpioPins[gpio];
+    rm46_gio_irq(pin->port, pin->pin, pin->edge, false);
+    rm46GpioDispatcher[gpio] = dispatcher;
+    if (dispatcher != NULL)
+        rm46_gio_irq(pin->port, pin->pin, pin->edge, true);
+}
+
+/**
+ * @brief Starts the microsecond clock and reserves an RTI compare unit for rm46_timer_at.
+ * Call after rtiInit().
+ * 
+ * @param compare - The compare unit, 0-3.
+ */
+void rm46_cc1120_timer_init(uint8_t compare) {
+    rm46TimerCompare = compare;
+    rm46_rti_init(compare);
+    rm46TimerReady = true;
+}
+
+/**
+ * @brief Calls the rm46_timer_at callback if the notification is from its compare unit.
+ * Call from rtiNotification.
+ * 
+ * @param notification - The HALCoGen RTI notification, rtiNOTIFICATION_*.
+ */
+void rm46_cc1120_timer_isr(uint32_t notification) {
+    if (!rm46TimerReady || notification != (1UL << rm46TimerCompare))
+        return;
+
+    rm46_rti_compare_stop(rm46TimerCompare);
+    if (rm46TimerCallback != NULL)
+        rm46TimerCallback(rm46TimerCtx);
+}
+
+/**
+ * @brief Gets a free-running microsecond timestamp.
+ * 
+ * @return uint32_t - The current time in microseconds.
+ */
+uint32_t rm46_get_time_us() {
+    return rm46_rti_now();
+}
+
+/**
+ * @brief Calls a function from a one-shot timer interrupt at a given time.
+ * 
+ * @param atUs - The rm46_get_time_us time to call it at.
+ * @param callback - The function to call from the interrupt.
+ * @param ctx - Passed to the callback.
+ * @return true - If the timer was started.
+ * @return false - If rm46_cc1120_timer_init was not called, or the time is less than RM46_TIMER_MIN_LEAD_US away.
+ */
+bool rm46_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx) {
+    if (!rm46TimerReady)
+        return false;
+
+    // The compare only matches when the counter equals it, so a time already passed would wait for the wrap
+    if ((int32_t)(atUs - rm46_rti_now()) < (int32_t)RM46_TIMER_MIN_LEAD_US)
+        return false;
+
+    rm46_rti_compare_stop(rm46TimerCompare);
+    rm46TimerCallback = callback;
+    rm46TimerCtx = ctx;
+    rm46_rti_compare_at(rm46TimerCompare, atUs);
+    return true;
+}
+
+/**
+ * @brief Initializes a MibSPI bus for CC1120s. The port must already be set up, e.g. by mibspiInit().
+ * 
+ * @param bus - The bus to initialize.
+ * @param port - The MibSPI port: 1, 3 or 5.
+ * @param group - The transfer group to use for blocks.
+ * @param dmaTxChannel - The DMA channel to load the TX buffers with.
+ * @param dmaRxChannel - The DMA channel to drain the RX buffers with.
+ */
+void rm46_cc1120_bus_init(rm46_cc1120_bus_t *bus, uint8_t port, uint8_t group, uint8_t dmaTxChannel, uint8_t dmaRxChannel) {
+    bus->port = port;
+    bus->group = group;
+    bus->dmaTxChannel = dmaTxChannel;
+    bus->dmaRxChannel = dmaRxChannel;
+    bus->dmaMinLen = CC1120_RM46_DMA_MIN_LEN;
+    bus->multiBuffer = false;
+    bus->phase = RM46_BLOCK_IDLE;
+    bus->plan.numChunks = 0;
+    bus->chunk = 0;
+    bus->done = NULL;
+    rm46_mibspi_init(bus);
+}
+
+#endif
@@ -2,8 +2,55 @@
 #define CC1120_RM46_H
 
 #include "cc1120_logging.h"
+#include "cc1120_gpio.h"
+#include "cc1120_rm46_sched.h"
+#include "cc1120_rm46_gio.h"
+#include "cc1120_rm46_rti.h"
 #include <stdarg.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * One MibSPI port with CC1120s on it. Pass a pointer to one as the bus of cc1120_dev_init.
+ * The CC1120 transfer group owns the whole buffer RAM of the port and must be the highest group enabled.
+ * The CC1120 chip selects must be MibSPI CS pins configured as GIO.
+ *
+ * Blocks are moved by interrupts: the DMA block-complete interrupt of each channel and the completion
+ * interrupt of the transfer group start the next step, so enable them in the VIM and forward them from
+ * the HALCoGen notifications:
+ *
+ *   void mibspiGroupNotification(mibspiBASE_t *mibspi, uint32 group) {
+ *       rm46_cc1120_spi_group_isr(&radioBus);
+ *   }
+ *   void dmaGroupANotification(dmaInterrupt_t inttype, uint32 channel) {
+ *       if (inttype == BTC)
+ *           rm46_cc1120_spi_dma_isr(&radioBus, channel);
+ *   }
+ */
+typedef enum {
+    RM46_BLOCK_IDLE = 0,
+    RM46_BLOCK_LOAD,        /* DMA copying the chunk into the TX buffers */
+    RM46_BLOCK_SHIFT,       /* Transfer group shifting the chunk */
+    RM46_BLOCK_DRAIN        /* DMA copying the chunk out of the RX buffers */
+} rm46_block_phase_t;
+
+typedef struct {
+    uint8_t port;           /* MibSPI port: 1, 3 or 5 */
+    uint8_t group;          /* Transfer group used for blocks */
+    uint8_t dmaTxChannel;   /* DMA channel loading the TX buffers */
+    uint8_t dmaRxChannel;   /* DMA channel draining the RX buffers */
+    uint8_t dmaMinLen;      /* Blocks shorter than this are polled, see CC1120_RM46_DMA_MIN_LEN */
+    bool multiBuffer;       /* Whether the port is currently in multi-buffer mode */
+
+    /* Block in progress, advanced from the interrupts */
+    volatile rm46_block_phase_t phase;
+    cc1120_rm46_plan_t plan;
+    uint8_t chunk;          /* Chunk of plan being transferred */
+    const uint8_t *tx;
+    uint8_t *rx;
+    void (*done)(void *ctx);
+    void *doneCtx;
+} rm46_cc1120_bus_t;
 
 /**
  * @brief Logs a string to the serial port.
@@ -14,31 +61,220 @@
 void rm46_serial_log(cc1120_log_level_t level, char str[]);
 
 /**
- * @brief Logs a string to a file.
+ * @brief Logs a string to a file. The string is buffered in RAM, see rm46_file_log_flush.
  * 
  * @param level  - The log level.
  * @param str - The string to log.
  */
 void rm46_file_log(cc1120_log_level_t level, char str[]);
 
+/* First bank 7 sector of the log, which takes CC1120_FLOG_SECTORS sectors from there, see cc1120_rm46_f021.h */
+#ifndef RM46_FLOG_FIRST_SECTOR
+#define RM46_FLOG_FIRST_SECTOR 0U
+#endif
+
+/**
+ * @brief Sets up the F021 flash API for bank 7 and finds where the log in flash ends, so that logging
+ * continues after it. Call once at startup.
+ * 
+ * @return cc1120_status_code - Whether or not the flash API could be set up and the log flash read
+ */
+cc1120_status_code rm46_file_log_mount(void);
+
+/**
+ * @brief Writes the buffered log pages to flash. Call from a low-priority task, never from an SPI path.
+ * 
+ * @return cc1120_status_code - Whether or not the flash writes were successful
+ */
+cc1120_status_code rm46_file_log_flush(void);
+
 /**
  * @brief Simultaneously sends and receives a byte over CC1120 SPI interface
  * 
+ * @param bus - The bus handle of the device.
  * @param data - Data to transfer 
  * @return uint8_t - Data received from CC1120
  */
-uint8_t rm46_cc1120_spi_transfer(uint8_t data);
+uint8_t rm46_cc1120_spi_transfer(void *bus, uint8_t data);
+
+/**
+ * @brief Transfers a block of bytes over CC1120 SPI interface
+ * Long blocks are moved by DMA and shifted by a transfer group, short ones are polled.
+ * The driver needs the block done before it raises CS, so this waits for the interrupts to finish it.
+ * 
+ * @param bus - The bus handle of the device.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+void rm46_cc1120_spi_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len);
+
+/**
+ * @brief Starts transferring a block of bytes over CC1120 SPI interface and returns.
+ * The interrupts finish the block, and the CPU is free meanwhile. For a FIFO burst, assert CS and send the
+ * header with rm46_cc1120_spi_transfer first, then deassert CS from the callback.
+ * 
+ * @param bus - The bus handle of the device, with no block in progress.
+ * @param tx - The bytes to send, or NULL to send zeros. Must stay valid until the block is done.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ * @param done - Called once the block is done, from interrupt context unless the block was all polled, or NULL.
+ * @param ctx - Passed to done.
+ */
+void rm46_cc1120_spi_transfer_block_async(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len,
+                                          void (*done)(void *ctx), void *ctx);
+
+/**
+ * @brief Checks whether a block transfer is still in progress on a bus.
+ * 
+ * @param bus - The bus handle.
+ * @return true - If a block started by rm46_cc1120_spi_transfer_block_async has not finished.
+ */
+bool rm46_cc1120_spi_busy(void *bus);
+
+/**
+ * @brief Advances the block in progress once the bus' transfer group has finished.
+ * Call from mibspiGroupNotification.
+ * 
+ * @param bus - The bus handle.
+ */
+void rm46_cc1120_spi_group_isr(void *bus);
+
+/**
+ * @brief Advances the block in progress once a DMA copy has finished.
+ * Call from dmaGroupANotification on BTC.
+ * 
+ * @param bus - The bus handle.
+ * @param channel - The DMA channel that finished.
+ */
+void rm46_cc1120_spi_dma_isr(void *bus, uint32_t channel);
 
 /**
  * @brief Pulls the CS pin low.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
  */
-void rm46_cc1120_cs_assert();
+void rm46_cc1120_cs_assert(void *bus, uint8_t csPin);
 
 /**
  * @brief Pulls the CS pin high.
  * 
+ * @param bus - The bus handle of the device.
+ * @param csPin - The chip select line of the device.
+ */
+void rm46_cc1120_cs_deassert(void *bus, uint8_t csPin);
+
+/**
+ * @brief Sets the SPI clock.
+ * 
+ * @param bus - The bus handle of the device.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz.
+ */
+uint32_t rm46_cc1120_spi_set_clock(void *bus, uint32_t hz);
+
+/* Where a CC1120 GPIO is wired on the RM46 */
+typedef struct {
+    uint8_t port;           /* RM46_PIN_GIOA, RM46_PIN_GIOB, RM46_PIN_N2HET1, or RM46_PIN_NONE if not wired */
+    uint8_t pin;            /* Pin in the port */
+    uint8_t edge;           /* N2HET1 only: the HET program's edge detect on the pin, set to both edges */
+} rm46_cc1120_pin_t;
+
+/**
+ * @brief Sets the pins the CC1120 GPIOs are wired to. Call before mapping any signal.
+ * The interrupts of the pins must be enabled in the VIM and forwarded from the HALCoGen notifications:
+ *
+ *   void gioNotification(gioPORT_t *port, uint32 bit) {
+ *       rm46_cc1120_gpio_isr((port == gioPORTA) ? RM46_PIN_GIOA : RM46_PIN_GIOB, bit);
+ *   }
+ *   void edgeNotification(hetBASE_t *hetREG, uint32 edge) {
+ *       rm46_cc1120_gpio_isr(RM46_PIN_N2HET1, edge);
+ *   }
+ * 
+ * @param pins - The pin of each CC1120 GPIO (0-3).
+ */
+void rm46_cc1120_gpio_pins(const rm46_cc1120_pin_t pins[CC1120_GPIO_COUNT]);
+
+/**
+ * @brief Forwards a pin interrupt to the dispatcher of the CC1120 GPIO wired to it.
+ * 
+ * @param port - The port that interrupted, RM46_PIN_*.
+ * @param pinOrEdge - The GIO pin, or the N2HET1 edge detect.
+ */
+void rm46_cc1120_gpio_isr(uint8_t port, uint32_t pinOrEdge);
+
+/**
+ * @brief Reads the level of one of the CC1120 GPIO pins.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @return uint8_t - 1 if the pin is high, 0 if it is low.
+ */
+uint8_t rm46_cc1120_gpio_read(uint8_t gpio);
+
+/**
+ * @brief Routes the change interrupt of one of the CC1120 GPIO pins to a dispatcher.
+ * 
+ * @param gpio - The CC1120 GPIO number (0-3).
+ * @param dispatcher - The dispatcher to call cc1120_gpio_dispatch on, or NULL to detach the interrupt.
+ */
+void rm46_cc1120_gpio_attach(uint8_t gpio, cc1120_gpio_dispatcher_t *dispatcher);
+
+/*
+ * The clock and the one-shot timer run on RTI counter block 0 at 1 MHz, see cc1120_rm46_rti.h.
+ * Enable the interrupt of the compare unit given to rm46_cc1120_timer_init in the VIM and forward it:
+ *
+ *   void rtiNotification(uint32 notification) {
+ *       rm46_cc1120_timer_isr(notification);
+ *   }
+ */
+
+/* Shortest time ahead rm46_timer_at accepts, so that the compare is set before the counter passes it */
+#define RM46_TIMER_MIN_LEAD_US 5UL
+
+/**
+ * @brief Starts the microsecond clock and reserves an RTI compare unit for rm46_timer_at.
+ * Call after rtiInit().
+ * 
+ * @param compare - The compare unit, 0-3.
+ */
+void rm46_cc1120_timer_init(uint8_t compare);
+
+/**
+ * @brief Calls the rm46_timer_at callback if the notification is from its compare unit.
+ * Call from rtiNotification.
+ * 
+ * @param notification - The HALCoGen RTI notification, rtiNOTIFICATION_*.
+ */
+void rm46_cc1120_timer_isr(uint32_t notification);
+
+/**
+ * @brief Gets a free-running microsecond timestamp.
+ * 
+ * @return uint32_t - The current time in microseconds.
+ */
+uint32_t rm46_get_time_us();
+
+/**
+ * @brief Calls a function from a one-shot timer interrupt at a given time.
+ * 
+ * @param atUs - The rm46_get_time_us time to call it at.
+ * @param callback - The function to call from the interrupt.
+ * @param ctx - Passed to the callback.
+ * @return true - If the timer was started.
+ * @return false - If rm46_cc1120_timer_init was not called, or the time is less than RM46_TIMER_MIN_LEAD_US away.
+ */
+bool rm46_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx);
+
+/**
+ * @brief Initializes a MibSPI bus for CC1120s. The port must already be set up, e.g. by mibspiInit().
+ * 
+ * @param bus - The bus to initialize.
+ * @param port - The MibSPI port: 1, 3 or 5.
+ * @param group - The transfer group to use for blocks.
+ * @param dmaTxChannel - The DMA channel to load the TX buffers with.
+ * @param dmaRxChannel - The DMA channel to drain the RX buffers with.
  */
-void rm46_cc1120_cs_deassert();
+void rm46_cc1120_bus_init(rm46_cc1120_bus_t *bus, uint8_t port, uint8_t group, uint8_t dmaTxChannel, uint8_t dmaRxChannel);
 
 #endif /* CC1120_RM46_H */
@@ -0,0 +1,73 @@
+#include "cc1120_rm46_f021.h"
+
+#if defined(CC1120_PLATFORM_RM46)
+
+#include "F021.h"
+
+/**
+ * @brief Waits for the flash state machine to finish a command.
+ *
+ * @return true - If it finished with no error in FMSTAT.
+ */
+static bool rm46_f021_wait(void) {
+    while (FAPI_CHECK_FSM_READY_BUSY == Fapi_Status_FsmBusy)
+        ;
+
+    return FAPI_GET_FSM_STATUS == 0U;
+}
+
+/**
+ * @brief Sets up the flash state machine for HCLK, selects bank 7 and enables its sectors for erase and program.
+ *
+ * @return true - If the F021 API accepted every call.
+ */
+bool rm46_f021_init(void) {
+    if (Fapi_initializeFlashBanks(RM46_F021_HCLK_MHZ) != Fapi_Status_Success)
+        return false;
+
+    if (Fapi_setActiveFlashBank(Fapi_FlashBank7) != Fapi_Status_Success)
+        return false;
+
+    return Fapi_enableEepromBankSectors((1UL << RM46_F021_BANK7_SECTORS) - 1UL, 0U) == Fapi_Status_Success;
+}
+
+/**
+ * @brief Erases a bank 7 sector and waits for the flash state machine.
+ *
+ * @param addr - The start of the sector.
+ * @return true - If the erase finished with no error in FMSTAT.
+ */
+bool rm46_f021_erase(uint32_t addr) {
+    if (Fapi_issueAsyncCommandWithAddress(Fapi_EraseSector, (uint32_t *)(uintptr_t)addr) != Fapi_Status_Success)
+        return false;
+
+    return rm46_f021_wait();
+}
+
+/**
+ * @brief Programs bank 7 with ECC generated, RM46_F021_BANK7_WIDTH bytes per command, waiting for each.
+ *
+ * @param addr - The first address, aligned to RM46_F021_BANK7_WIDTH.
+ * @param data - The bytes to program.
+ * @param len - The number of bytes, a multiple of RM46_F021_BANK7_WIDTH.
+ * @return true - If every command finished with no error in FMSTAT.
+ */
+bool rm46_f021_program(uint32_t addr, const uint8_t data[], uint32_t len) {
+    uint32_t offset;
+
+    for (offset = 0; offset < len; offset += RM46_F021_BANK7_WIDTH) {
+        // The API takes a non-const buffer but only reads it
+        Fapi_StatusType status = Fapi_issueProgrammingCommand((uint32_t *)(uintptr_t)(addr + offset),
+                                                              (uint8_t *)&data[offset], RM46_F021_BANK7_WIDTH,
+                                                              0, 0U, Fapi_AutoEccGeneration);
+        if (status != Fapi_Status_Success)
+            return false;
+
+        if (!rm46_f021_wait())
+            return false;
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CC1120_RM46_F021_H
+#define CC1120_RM46_F021_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Thin layer over the TI F021 Flash API for the EEPROM emulation bank, bank 7, which code never runs from,
+ * so the API can run from flash. Bank 7 is 64 KB at 0xF0200000 in 16 sectors of 4 KB and programs
+ * 64 bits at a time. Erased words carry no valid ECC, so leave ECC checking of bank 7 reads off.
+ */
+
+/* Start of bank 7 */
+#define RM46_F021_BANK7_BASE 0xF0200000UL
+
+#define RM46_F021_BANK7_SECTOR_SIZE 4096UL
+#define RM46_F021_BANK7_SECTORS 16U
+
+/* Bytes one program command writes in bank 7 */
+#define RM46_F021_BANK7_WIDTH 8U
+
+/* HCLK the flash wait states are computed for, in MHz */
+#ifndef RM46_F021_HCLK_MHZ
+#define RM46_F021_HCLK_MHZ 220U
+#endif
+
+/**
+ * @brief Sets up the flash state machine for HCLK, selects bank 7 and enables its sectors for erase and program.
+ *
+ * @return true - If the F021 API accepted every call.
+ */
+bool rm46_f021_init(void);
+
+/**
+ * @brief Erases a bank 7 sector and waits for the flash state machine.
+ *
+ * @param addr - The start of the sector.
+ * @return true - If the erase finished with no error in FMSTAT.
+ */
+bool rm46_f021_erase(uint32_t addr);
+
+/**
+ * @brief Programs bank 7 with ECC generated, RM46_F021_BANK7_WIDTH bytes per command, waiting for each.
+ *
+ * @param addr - The first address, aligned to RM46_F021_BANK7_WIDTH.
+ * @param data - The bytes to program.
+ * @param len - The number of bytes, a multiple of RM46_F021_BANK7_WIDTH.
+ * @return true - If every command finished with no error in FMSTAT.
+ */
+bool rm46_f021_program(uint32_t addr, const uint8_t data[], uint32_t len);
+
+#endif /* CC1120_RM46_F021_H */
@@ -0,0 +1,81 @@
+#include "cc1120_rm46_gio.h"
+
+#if defined(CC1120_PLATFORM_RM46)
+
+#include "gio.h"
+#include "het.h"
+#include <stddef.h>
+
+/* GIOB's bits follow GIOA's in the GIO interrupt registers */
+#define RM46_GIO_PORTB_SHIFT 8U
+
+/**
+ * @brief Gets the GIO view of a port.
+ *
+ * @param port - The port, RM46_PIN_*.
+ * @return gioPORT_t* - The pin port, or NULL for RM46_PIN_NONE.
+ */
+static gioPORT_t *rm46_gio_port(uint8_t port) {
+    switch (port) {
+        case RM46_PIN_GIOA:
+            return gioPORTA;
+        case RM46_PIN_GIOB:
+            return gioPORTB;
+        case RM46_PIN_N2HET1:
+            return hetPORT1;
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief Reads the level of a pin.
+ *
+ * @param port - The port, RM46_PIN_*.
+ * @param pin - The pin in the port.
+ * @return uint8_t - 1 if the pin is high, 0 if it is low or the port is RM46_PIN_NONE.
+ */
+uint8_t rm46_gio_read(uint8_t port, uint8_t pin) {
+    gioPORT_t *pins = rm46_gio_port(port);
+
+    if (pins == NULL)
+        return 0;
+    return (uint8_t)gioGetBit(pins, pin);
+}
+
+/**
+ * @brief Enables or disables the interrupt on both edges of a pin.
+ * GIO pins are set to both edges here. N2HET1 pins interrupt through an edge detect of the HET program,
+ * which must be set to both edges in HALCoGen.
+ *
+ * @param port - The port, RM46_PIN_*.
+ * @param pin - The pin in the port.
+ * @param edge - The N2HET1 edge detect on the pin. Unused for GIO.
+ * @param enable - true to enable the interrupt, false to disable it.
+ */
+void rm46_gio_irq(uint8_t port, uint8_t pin, uint8_t edge, bool enable) {
+    if (port == RM46_PIN_N2HET1) {
+        if (enable)
+            edgeEnableNotification(hetREG1, edge);
+        else
+            edgeDisableNotification(hetREG1, edge);
+        return;
+    }
+
+    gioPORT_t *pins = rm46_gio_port(port);
+    if (pins == NULL)
+        return;
+
+    if (!enable) {
+        gioDisableNotification(pins, pin);
+        return;
+    }
+
+    // INTDET set means both edges, whatever POL says. Drop an edge left over from before.
+    uint32 bit = (uint32)1U << (pin + ((port == RM46_PIN_GIOB) ? RM46_GIO_PORTB_SHIFT : 0U));
+    gioREG->INTDET |= bit;
+    gioREG->FLG = bit;
+    gioEnableNotification(pins, pin);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef CC1120_RM46_GIO_H
+#define CC1120_RM46_GIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Thin register-level layer over the GIO and N2HET1 pins the CC1120 GPIOs are wired to.
+ * Which CC1120 GPIO is on which pin lives in cc1120_rm46.c, see rm46_cc1120_gpio_pins.
+ */
+
+/* Ports a CC1120 GPIO can be wired to */
+#define RM46_PIN_NONE 0U
+#define RM46_PIN_GIOA 1U
+#define RM46_PIN_GIOB 2U
+#define RM46_PIN_N2HET1 3U
+
+/**
+ * @brief Reads the level of a pin.
+ *
+ * @param port - The port, RM46_PIN_*.
+ * @param pin - The pin in the port.
+ * @return uint8_t - 1 if the pin is high, 0 if it is low or the port is RM46_PIN_NONE.
+ */
+uint8_t rm46_gio_read(uint8_t port, uint8_t pin);
+
+/**
+ * @brief Enables or disables the interrupt on both edges of a pin.
+ * GIO pins are set to both edges here. N2HET1 pins interrupt through an edge detect of the HET program,
+ * which must be set to both edges in HALCoGen.
+ *
+ * @param port - The port, RM46_PIN_*.
+ * @param pin - The pin in the port.
+ * @param edge - The N2HET1 edge detect on the pin. Unused for GIO.
+ * @param enable - true to enable the interrupt, false to disable it.
+ */
+void rm46_gio_irq(uint8_t port, uint8_t pin, uint8_t edge, bool enable);
+
+#endif /* CC1120_RM46_GIO_H */
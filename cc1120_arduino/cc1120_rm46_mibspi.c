@@ -0,0 +1,263 @@
+#include "cc1120_rm46_mibspi.h"
+
+#if defined(CC1120_PLATFORM_RM46)
+
+#include "cc1120_rm46_sched.h"
+#include "reg_mibspi.h"
+#include "mibspi.h"
+#include "gio.h"
+#include "sys_dma.h"
+#include "system.h"
+#include <stddef.h>
+
+/* TX buffer control: BUFMODE "always", CSHOLD, no hardware chip select (the CS pins are GIO) */
+#define RM46_MIBSPI_BUF_CONTROL ((uint16)((4U << 13) | (1U << 12) | 0x00FFU))
+
+/* SPIDAT1 control bits for a compatibility mode byte: CSHOLD, no hardware chip select */
+#define RM46_MIBSPI_DAT1_CONTROL ((1U << 28) | (0xFFU << 16))
+
+#define RM46_MIBSPI_FLG_RXINT 0x00000100U
+#define RM46_MIBSPI_MIBSPIE_MSPIENA 0x00000001U
+#define RM46_MIBSPI_TGCTRL_TGENA 0x80000000U
+#define RM46_MIBSPI_TGCTRL_ONESHOT 0x40000000U
+#define RM46_MIBSPI_TGCTRL_TRIGEVT_ALWAYS (7U << 20)
+#define RM46_MIBSPI_LTGPEND_MASK 0x00007F00U
+#define RM46_MIBSPI_FMT_PRESCALE_MASK 0x0000FF00U
+
+/* Bytes between consecutive entries of the buffer RAM */
+#define RM46_MIBSPI_RAM_STRIDE 4U
+
+static const uint8 RM46_MIBSPI_ZERO = 0U;
+
+/**
+ * @brief Gets the registers of the bus' MibSPI port.
+ *
+ * @param bus - The bus.
+ * @return mibspiBASE_t* - The port registers.
+ */
+static mibspiBASE_t *rm46_mibspi_reg(const rm46_cc1120_bus_t *bus) {
+    switch (bus->port) {
+        case 3:
+            return mibspiREG3;
+        case 5:
+            return mibspiREG5;
+        default:
+            return mibspiREG1;
+    }
+}
+
+/**
+ * @brief Gets the buffer RAM of the bus' MibSPI port.
+ *
+ * @param bus - The bus.
+ * @return mibspiRAM_t* - The buffer RAM.
+ */
+static mibspiRAM_t *rm46_mibspi_ram(const rm46_cc1120_bus_t *bus) {
+    switch (bus->port) {
+        case 3:
+            return mibspiRAM3;
+        case 5:
+            return mibspiRAM5;
+        default:
+            return mibspiRAM1;
+    }
+}
+
+/**
+ * @brief Gets the GIO view of the bus' MibSPI pins.
+ *
+ * @param bus - The bus.
+ * @return gioPORT_t* - The pin port.
+ */
+static gioPORT_t *rm46_mibspi_pins(const rm46_cc1120_bus_t *bus) {
+    switch (bus->port) {
+        case 3:
+            return mibspiPORT3;
+        case 5:
+            return mibspiPORT5;
+        default:
+            return mibspiPORT1;
+    }
+}
+
+/**
+ * @brief Switches the port between compatibility and multi-buffer mode, if needed.
+ *
+ * @param bus - The bus.
+ * @param multiBuffer - true for multi-buffer mode, false for compatibility mode.
+ */
+static void rm46_mibspi_set_mode(rm46_cc1120_bus_t *bus, bool multiBuffer) {
+    if (bus->multiBuffer == multiBuffer)
+        return;
+
+    mibspiBASE_t *reg = rm46_mibspi_reg(bus);
+    if (multiBuffer)
+        reg->MIBSPIE |= RM46_MIBSPI_MIBSPIE_MSPIENA;
+    else
+        reg->MIBSPIE &= ~RM46_MIBSPI_MIBSPIE_MSPIENA;
+    bus->multiBuffer = multiBuffer;
+}
+
+/**
+ * @brief Starts a software-triggered block copy of bytes on a DMA channel.
+ * The channel's block-complete interrupt fires when it is done.
+ *
+ * @param channel - The DMA channel.
+ * @param src - The source address.
+ * @param srcMode - ADDR_FIXED, ADDR_INC1 or ADDR_OFFSET for the source.
+ * @param dst - The destination address.
+ * @param dstMode - ADDR_INC1 or ADDR_OFFSET for the destination.
+ * @param len - The number of bytes.
+ */
+static void rm46_mibspi_dma_copy(uint8_t channel, uint32 src, uint32 srcMode, uint32 dst, uint32 dstMode, uint8_t len) {
+    g_dmaCTRL ctrl;
+
+    ctrl.SADD = src;
+    ctrl.DADD = dst;
+    ctrl.CHCTRL = 0U;
+    ctrl.FRCNT = 1U;
+    ctrl.ELCNT = len;
+    ctrl.ELSOFFSET = (srcMode == ADDR_OFFSET) ? RM46_MIBSPI_RAM_STRIDE : 0U;
+    ctrl.ELDOFFSET = (dstMode == ADDR_OFFSET) ? RM46_MIBSPI_RAM_STRIDE : 0U;
+    ctrl.FRSOFFSET = 0U;
+    ctrl.FRDOFFSET = 0U;
+    ctrl.PORTASGN = PORTB_READ_PORTB_WRITE;
+    ctrl.RDSIZE = ACCESS_8_BIT;
+    ctrl.WRSIZE = ACCESS_8_BIT;
+    ctrl.TTYPE = BLOCK_TRANSFER;
+    ctrl.ADDMODERD = srcMode;
+    ctrl.ADDMODEWR = dstMode;
+    ctrl.AUTOINIT = AUTOINIT_OFF;
+
+    dmaSetCtrlPacket((dmaChannel_t)channel, ctrl);
+    dmaSetChEnable((dmaChannel_t)channel, (dmaTriggerType_t)DMA_SW);
+}
+
+/**
+ * @brief Programs the buffer control words of the bus' transfer group, and enables DMA and the
+ * group completion and DMA block-complete interrupts.
+ * The MibSPI port itself must already be initialized, e.g. by mibspiInit().
+ *
+ * @param bus - The bus to initialize.
+ */
+void rm46_mibspi_init(rm46_cc1120_bus_t *bus) {
+    mibspiRAM_t *ram = rm46_mibspi_ram(bus);
+
+    uint8_t i;
+    for (i = 0; i < CC1120_RM46_MIBSPI_BUFFERS; i++) {
+        ram->tx[i].control = RM46_MIBSPI_BUF_CONTROL;
+        ram->tx[i].data = 0U;
+    }
+
+    rm46_mibspi_set_mode(bus, false);
+    mibspiEnableGroupNotification(rm46_mibspi_reg(bus), bus->group, 0U);
+    dmaEnableInterrupt((dmaChannel_t)bus->dmaTxChannel, BTC);
+    dmaEnableInterrupt((dmaChannel_t)bus->dmaRxChannel, BTC);
+    dmaEnable();
+}
+
+/**
+ * @brief Sends and receives one byte in compatibility mode, polling for completion.
+ *
+ * @param bus - The bus to use.
+ * @param data - Data to transfer
+ * @return uint8_t - Data received from CC1120
+ */
+uint8_t rm46_mibspi_transfer_byte(rm46_cc1120_bus_t *bus, uint8_t data) {
+    mibspiBASE_t *reg = rm46_mibspi_reg(bus);
+
+    rm46_mibspi_set_mode(bus, false);
+    reg->DAT1 = RM46_MIBSPI_DAT1_CONTROL | data;
+    while ((reg->FLG & RM46_MIBSPI_FLG_RXINT) == 0U)
+        ;
+
+    return (uint8_t)reg->BUF;
+}
+
+/**
+ * @brief Starts copying bytes into the transfer group's TX buffers with DMA.
+ * The block-complete interrupt of the bus' TX DMA channel fires when the copy is done.
+ *
+ * @param bus - The bus to use.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param len - The number of bytes, at most CC1120_RM46_MIBSPI_BUFFERS.
+ */
+void rm46_mibspi_load_group(rm46_cc1120_bus_t *bus, const uint8_t tx[], uint8_t len) {
+    mibspiRAM_t *ram = rm46_mibspi_ram(bus);
+
+    rm46_mibspi_set_mode(bus, true);
+
+    // The low byte of each TX entry's data field, one entry per byte
+    if (tx != NULL)
+        rm46_mibspi_dma_copy(bus->dmaTxChannel, (uint32)tx, ADDR_INC1, (uint32)&ram->tx[0].data, ADDR_OFFSET, len);
+    else
+        rm46_mibspi_dma_copy(bus->dmaTxChannel, (uint32)&RM46_MIBSPI_ZERO, ADDR_FIXED, (uint32)&ram->tx[0].data, ADDR_OFFSET, len);
+}
+
+/**
+ * @brief Starts shifting the loaded TX buffers out with the bus' transfer group.
+ * The group's completion interrupt fires when the last byte has been shifted.
+ *
+ * @param bus - The bus to use.
+ * @param len - The number of bytes, as passed to rm46_mibspi_load_group.
+ */
+void rm46_mibspi_start_group(rm46_cc1120_bus_t *bus, uint8_t len) {
+    mibspiBASE_t *reg = rm46_mibspi_reg(bus);
+
+    // The group starts at buffer 0, and as the last group it ends at LTGPEND
+    reg->LTGPEND = (reg->LTGPEND & ~RM46_MIBSPI_LTGPEND_MASK) | ((uint32)(len - 1U) << 8);
+    reg->TGCTRL[bus->group] = RM46_MIBSPI_TGCTRL_ONESHOT | RM46_MIBSPI_TGCTRL_TRIGEVT_ALWAYS;
+    reg->TGCTRL[bus->group] |= RM46_MIBSPI_TGCTRL_TGENA;
+}
+
+/**
+ * @brief Starts copying the bytes received by the finished transfer group out of the RX buffers with DMA.
+ * The block-complete interrupt of the bus' RX DMA channel fires when the copy is done.
+ *
+ * @param bus - The bus to use.
+ * @param rx - The array to store the received bytes in.
+ * @param len - The number of bytes, as passed to rm46_mibspi_load_group.
+ */
+void rm46_mibspi_read_group(rm46_cc1120_bus_t *bus, uint8_t rx[], uint8_t len) {
+    mibspiRAM_t *ram = rm46_mibspi_ram(bus);
+
+    rm46_mibspi_dma_copy(bus->dmaRxChannel, (uint32)&ram->rx[0].data, ADDR_OFFSET, (uint32)rx, ADDR_INC1, len);
+}
+
+/**
+ * @brief Drives a MibSPI chip select pin, used as a GIO.
+ *
+ * @param bus - The bus to use.
+ * @param csPin - The chip select pin.
+ * @param level - The level to drive.
+ */
+void rm46_mibspi_set_cs(rm46_cc1120_bus_t *bus, uint8_t csPin, uint8_t level) {
+    gioSetBit(rm46_mibspi_pins(bus), csPin, level);
+}
+
+/**
+ * @brief Sets the SPICLK prescaler of the bus' data format 0.
+ *
+ * @param bus - The bus to use.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz unless hz is below the slowest rate.
+ */
+uint32_t rm46_mibspi_set_clock(rm46_cc1120_bus_t *bus, uint32_t hz) {
+    mibspiBASE_t *reg = rm46_mibspi_reg(bus);
+    uint32_t vclk = (uint32_t)(VCLK1_FREQ * 1000000.0F);
+
+    if (hz == 0U)
+        hz = 1U;
+
+    // SPICLK = VCLK / (PRESCALE + 1), with PRESCALE from 1 to 255
+    uint32_t divider = (vclk + hz - 1U) / hz;
+    if (divider < 2U)
+        divider = 2U;
+    if (divider > 256U)
+        divider = 256U;
+
+    reg->FMT0 = (reg->FMT0 & ~RM46_MIBSPI_FMT_PRESCALE_MASK) | ((divider - 1U) << 8);
+    return vclk / divider;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CC1120_RM46_MIBSPI_H
+#define CC1120_RM46_MIBSPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_rm46.h"
+
+/*
+ * Thin register-level layer over one MibSPI port for the RM46 backend.
+ * Everything here touches hardware. Decisions about what to transfer and how live in cc1120_rm46_sched.h.
+ */
+
+/**
+ * @brief Programs the buffer control words of the bus' transfer group, and enables DMA and the
+ * group completion and DMA block-complete interrupts.
+ * The MibSPI port itself must already be initialized, e.g. by mibspiInit().
+ *
+ * @param bus - The bus to initialize.
+ */
+void rm46_mibspi_init(rm46_cc1120_bus_t *bus);
+
+/**
+ * @brief Sends and receives one byte in compatibility mode, polling for completion.
+ *
+ * @param bus - The bus to use.
+ * @param data - Data to transfer
+ * @return uint8_t - Data received from CC1120
+ */
+uint8_t rm46_mibspi_transfer_byte(rm46_cc1120_bus_t *bus, uint8_t data);
+
+/**
+ * @brief Starts copying bytes into the transfer group's TX buffers with DMA.
+ * The block-complete interrupt of the bus' TX DMA channel fires when the copy is done.
+ *
+ * @param bus - The bus to use.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param len - The number of bytes, at most CC1120_RM46_MIBSPI_BUFFERS.
+ */
+void rm46_mibspi_load_group(rm46_cc1120_bus_t *bus, const uint8_t tx[], uint8_t len);
+
+/**
+ * @brief Starts shifting the loaded TX buffers out with the bus' transfer group.
+ * The group's completion interrupt fires when the last byte has been shifted.
+ *
+ * @param bus - The bus to use.
+ * @param len - The number of bytes, as passed to rm46_mibspi_load_group.
+ */
+void rm46_mibspi_start_group(rm46_cc1120_bus_t *bus, uint8_t len);
+
+/**
+ * @brief Starts copying the bytes received by the finished transfer group out of the RX buffers with DMA.
+ * The block-complete interrupt of the bus' RX DMA channel fires when the copy is done.
+ *
+ * @param bus - The bus to use.
+ * @param rx - The array to store the received bytes in.
+ * @param len - The number of bytes, as passed to rm46_mibspi_load_group.
+ */
+void rm46_mibspi_read_group(rm46_cc1120_bus_t *bus, uint8_t rx[], uint8_t len);
+
+/**
+ * @brief Drives a MibSPI chip select pin, used as a GIO.
+ *
+ * @param bus - The bus to use.
+ * @param csPin - The chip select pin.
+ * @param level - The level to drive.
+ */
+void rm46_mibspi_set_cs(rm46_cc1120_bus_t *bus, uint8_t csPin, uint8_t level);
+
+/**
+ * @brief Sets the SPICLK prescaler of the bus' data format 0.
+ *
+ * @param bus - The bus to use.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, at most hz unless hz is below the slowest rate.
+ */
+uint32_t rm46_mibspi_set_clock(rm46_cc1120_bus_t *bus, uint32_t hz);
+
+#endif /* CC1120_RM46_MIBSPI_H */
@@ -0,0 +1,54 @@
+#include "cc1120_rm46_rti.h"
+
+#if defined(CC1120_PLATFORM_RM46)
+
+#include "rti.h"
+#include "reg_rti.h"
+
+/* COMPCTRL has one 4-bit field per compare unit selecting its counter block */
+#define RM46_RTI_COMPSEL_SHIFT(compare) (4U * (compare))
+
+/**
+ * @brief Routes a compare unit to counter block 0 with its interrupt off, and starts the counter.
+ *
+ * @param compare - The compare unit, 0-3.
+ */
+void rm46_rti_init(uint8_t compare) {
+    rtiDisableNotification(1U << compare);
+    rtiREG1->COMPCTRL &= ~(1U << RM46_RTI_COMPSEL_SHIFT(compare));
+    rtiStartCounter(rtiCOUNTER_BLOCK0);
+}
+
+/**
+ * @brief Reads the free-running counter of counter block 0.
+ *
+ * @return uint32_t - The time in microseconds.
+ */
+uint32_t rm46_rti_now(void) {
+    return rtiREG1->CNT[0U].FRCx;
+}
+
+/**
+ * @brief Makes a compare unit interrupt once when the counter reaches a value.
+ *
+ * @param compare - The compare unit, 0-3.
+ * @param atUs - The counter value.
+ */
+void rm46_rti_compare_at(uint8_t compare, uint32_t atUs) {
+    // The compare would move on by UDCP after the match, which the interrupt turns off anyway
+    rtiREG1->CMP[compare].COMPx = atUs;
+    rtiREG1->CMP[compare].UDCPx = 0U;
+    rtiEnableNotification(1U << compare);
+}
+
+/**
+ * @brief Disables the interrupt of a compare unit and clears its flag.
+ *
+ * @param compare - The compare unit, 0-3.
+ */
+void rm46_rti_compare_stop(uint8_t compare) {
+    rtiDisableNotification(1U << compare);
+    rtiREG1->INTFLAG = 1U << compare;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CC1120_RM46_RTI_H
+#define CC1120_RM46_RTI_H
+
+#include <stdint.h>
+
+/*
+ * Thin register-level layer over RTI counter block 0, which must be set up in HALCoGen to count at 1 MHz,
+ * e.g. a compare-up counter of 79 with an 80 MHz RTICLK. Its free-running counter is the microsecond
+ * clock, and one compare unit matched against it is the one-shot timer.
+ */
+
+/**
+ * @brief Routes a compare unit to counter block 0 with its interrupt off, and starts the counter.
+ *
+ * @param compare - The compare unit, 0-3.
+ */
+void rm46_rti_init(uint8_t compare);
+
+/**
+ * @brief Reads the free-running counter of counter block 0.
+ *
+ * @return uint32_t - The time in microseconds.
+ */
+uint32_t rm46_rti_now(void);
+
+/**
+ * @brief Makes a compare unit interrupt once when the counter reaches a value.
+ *
+ * @param compare - The compare unit, 0-3.
+ * @param atUs - The counter value.
+ */
+void rm46_rti_compare_at(uint8_t compare, uint32_t atUs);
+
+/**
+ * @brief Disables the interrupt of a compare unit and clears its flag.
+ *
+ * @param compare - The compare unit, 0-3.
+ */
+void rm46_rti_compare_stop(uint8_t compare);
+
+#endif /* CC1120_RM46_RTI_H */
@@ -0,0 +1,41 @@
+#include "cc1120_rm46_sched.h"
+
+/**
+ * @brief Plans the transfer of a block as a sequence of chunks, in order.
+ * Runs of at least dmaMinLen bytes go through transfer groups of at most numBuffers bytes,
+ * and a shorter remainder is polled. If a group cannot hold dmaMinLen bytes, the whole block is polled.
+ *
+ * @param plan - The plan to fill.
+ * @param len - The number of bytes in the block.
+ * @param numBuffers - The number of MibSPI buffers available to one transfer group, at least 1.
+ * @param dmaMinLen - The shortest run worth a transfer group.
+ * @return uint8_t - The number of chunks, or 0 if the block needs more than CC1120_RM46_MAX_CHUNKS.
+ */
+uint8_t cc1120_rm46_plan(cc1120_rm46_plan_t *plan, uint16_t len, uint8_t numBuffers, uint8_t dmaMinLen) {
+    uint16_t offset = 0;
+
+    plan->numChunks = 0;
+    while (offset < len) {
+        if (plan->numChunks == CC1120_RM46_MAX_CHUNKS) {
+            plan->numChunks = 0;
+            return 0;
+        }
+
+        uint16_t left = len - offset;
+        cc1120_rm46_chunk_t *chunk = &plan->chunks[plan->numChunks++];
+        chunk->offset = offset;
+
+        if (left < dmaMinLen || numBuffers < dmaMinLen) {
+            // Polled in chunks as long as a chunk can describe
+            chunk->len = (left > UINT8_MAX) ? UINT8_MAX : (uint8_t)left;
+            chunk->mode = CC1120_RM46_CHUNK_POLLED;
+        } else {
+            chunk->len = (left > numBuffers) ? numBuffers : (uint8_t)left;
+            chunk->mode = CC1120_RM46_CHUNK_GROUP_DMA;
+        }
+
+        offset += chunk->len;
+    }
+
+    return plan->numChunks;
+}
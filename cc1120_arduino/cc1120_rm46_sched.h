@@ -0,0 +1,49 @@
+#ifndef CC1120_RM46_SCHED_H
+#define CC1120_RM46_SCHED_H
+
+#include <stdint.h>
+
+/*
+ * Splits an SPI block into MibSPI transfer groups.
+ * This is plain logic with no register access, so it builds and runs on the host.
+ */
+
+/* Buffers in the MibSPI1 buffer RAM, the most one transfer group can move */
+#define CC1120_RM46_MIBSPI_BUFFERS 128U
+
+/* Below this many bytes, polling each byte is cheaper than setting up DMA and a transfer group */
+#define CC1120_RM46_DMA_MIN_LEN 8U
+
+/* Enough for the largest FIFO access, 2 x 128 bytes */
+#define CC1120_RM46_MAX_CHUNKS 4U
+
+typedef enum {
+    CC1120_RM46_CHUNK_POLLED = 0,   /* One byte at a time in compatibility mode */
+    CC1120_RM46_CHUNK_GROUP_DMA     /* Buffers loaded and drained by DMA, shifted out by one transfer group */
+} cc1120_rm46_chunk_mode_t;
+
+typedef struct {
+    uint16_t offset;    /* First byte of the block in this chunk */
+    uint8_t len;
+    cc1120_rm46_chunk_mode_t mode;
+} cc1120_rm46_chunk_t;
+
+typedef struct {
+    cc1120_rm46_chunk_t chunks[CC1120_RM46_MAX_CHUNKS];
+    uint8_t numChunks;
+} cc1120_rm46_plan_t;
+
+/**
+ * @brief Plans the transfer of a block as a sequence of chunks, in order.
+ * Runs of at least dmaMinLen bytes go through transfer groups of at most numBuffers bytes,
+ * and a shorter remainder is polled. If a group cannot hold dmaMinLen bytes, the whole block is polled.
+ *
+ * @param plan - The plan to fill.
+ * @param len - The number of bytes in the block.
+ * @param numBuffers - The number of MibSPI buffers available to one transfer group, at least 1.
+ * @param dmaMinLen - The shortest run worth a transfer group.
+ * @return uint8_t - The number of chunks, or 0 if the block needs more than CC1120_RM46_MAX_CHUNKS.
+ */
+uint8_t cc1120_rm46_plan(cc1120_rm46_plan_t *plan, uint16_t len, uint8_t numBuffers, uint8_t dmaMinLen);
+
+#endif /* CC1120_RM46_SCHED_H */
@@ -0,0 +1,153 @@
+#include "cc1120_scan.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+
+/**
+ * @brief Waits for RSSI_VALID and burst reads RSSI1/RSSI0.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param scanner - The scanner, for its wait mode and timeout.
+ * @param rssi - Array of 2 bytes to store RSSI1 and RSSI0 in.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a valid RSSI was read.
+ * @return An error code - If RSSI_VALID timed out, or an SPI transfer failed.
+ */
+static cc1120_status_code cc1120_scan_read_rssi(cc1120_dev_t *dev, cc1120_scanner_t *scanner, uint8_t rssi[]) {
+    cc1120_status_code status;
+    uint32_t start = mcu_get_time_us();
+
+    do {
+        if (scanner->waitMode == CC1120_SCAN_WAIT_GPIO) {
+            if (!mcu_cc1120_gpio_read(scanner->rssiValidGpio))
+                continue;
+            return cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_RSSI1, rssi, 2);
+        }
+
+        /* Poll with the full burst so the final poll already holds the result */
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_RSSI1, rssi, 2);
+        RETURN_IF_ERROR(status)
+
+        if (rssi[1] & CC1120_RSSI0_RSSI_VALID)
+            return CC1120_ERROR_CODE_SUCCESS;
+    } while (mcu_get_time_us() - start < scanner->timeoutUs);
+
+    mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_scan_read_rssi: Timed out waiting for RSSI_VALID!\n");
+    return CC1120_ERROR_CODE_RSSI_VALID_TIMEOUT;
+}
+
+/**
+ * @brief Initializes a scanner over a list of RF frequencies.
+ * Converts each frequency to a FREQ2..0 word and marks its calibration as stale.
+ * In GPIO mode, routes RSSI_VALID to the selected CC1120 GPIO.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param scanner - The scanner to initialize.
+ * @param channels - Preallocated channel array with numChannels entries.
+ * @param rssiDbm - Preallocated result array with numChannels entries.
+ * @param freqHz - The RF frequency of each channel in Hz.
+ * @param numChannels - The number of channels to sweep.
+ * @param waitMode - Whether to poll RSSI0 or a GPIO for RSSI_VALID.
+ * @param rssiValidGpio - The CC1120 GPIO (0-3) carrying RSSI_VALID in GPIO mode.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the scanner was initialized.
+ * @return An error code - If a parameter is invalid, or the SPI write failed.
+ */
+cc1120_status_code cc1120_scan_init(cc1120_dev_t *dev, cc1120_scanner_t *scanner, cc1120_fscal_channel_t channels[],
+                                    int16_t rssiDbm[], const uint32_t freqHz[], uint8_t numChannels,
+                                    cc1120_scan_wait_t waitMode, uint8_t rssiValidGpio) {
+    if (numChannels < 1 || (waitMode == CC1120_SCAN_WAIT_GPIO && rssiValidGpio > 3)) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_scan_init: Invalid parameters!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    uint8_t i;
+    for (i = 0; i < numChannels; i++)
+        cc1120_fscal_set_freq(&channels[i], freqHz[i]);
+
+    cc1120_fscal_init(&scanner->cal, channels, numChannels);
+    scanner->rssiDbm = rssiDbm;
+    scanner->waitMode = waitMode;
+    scanner->rssiValidGpio = rssiValidGpio;
+    scanner->timeoutUs = CC1120_SCAN_DEFAULT_TIMEOUT_US;
+    scanner->lastSweepUs = 0;
+    scanner->pointsPerSecond = 0;
+
+    if (waitMode == CC1120_SCAN_WAIT_GPIO) {
+        uint8_t iocfg = CC1120_GPIO_CFG_RSSI_VALID;
+        return cc1120_write_spi(dev, CC1120_REGS_IOCFG0 - rssiValidGpio, &iocfg, 1);
+    }
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Sweeps every channel once and stores the RSSI of each in dBm.
+ * The first sweep calibrates the synthesizer on each channel and caches the results.
+ * Later sweeps write the cached values with autocalibration off, so each point
+ * costs only the RSSI settling time plus a few short SPI transactions.
+ * Leaves the radio in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param scanner - The initialized scanner.
+ * @return CC1120_ERROR_CODE_SUCCESS - If every channel was measured.
+ * @return An error code - If a calibration or RSSI measurement timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_scan_sweep(cc1120_dev_t *dev, cc1120_scanner_t *scanner) {
+    cc1120_status_code status;
+    uint8_t rssi[2];
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    // Disable autocalibration so IDLE -> RX does not recalibrate on every point
+    status = cc1120_fscal_disable_autocal(dev, &scanner->cal);
+    RETURN_IF_ERROR(status)
+
+    uint32_t start = mcu_get_time_us();
+
+    uint8_t i;
+    for (i = 0; i < scanner->cal.numChannels; i++) {
+        status = cc1120_fscal_hop(dev, &scanner->cal, i);
+        if (status != CC1120_ERROR_CODE_SUCCESS)
+            break;
+
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+        if (status != CC1120_ERROR_CODE_SUCCESS)
+            break;
+
+        status = cc1120_scan_read_rssi(dev, scanner, rssi);
+        if (status != CC1120_ERROR_CODE_SUCCESS)
+            break;
+
+        scanner->rssiDbm[i] = cc1120_rssi_to_dbm(rssi[0], rssi[1]);
+
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+        if (status != CC1120_ERROR_CODE_SUCCESS)
+            break;
+    }
+
+    scanner->lastSweepUs = mcu_get_time_us() - start;
+    if (status == CC1120_ERROR_CODE_SUCCESS && scanner->lastSweepUs > 0)
+        scanner->pointsPerSecond = (uint32_t)((uint64_t)scanner->cal.numChannels * 1000000ULL / scanner->lastSweepUs);
+
+    cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    cc1120_status_code restoreStatus = cc1120_fscal_restore_autocal(dev, &scanner->cal);
+    RETURN_IF_ERROR(status)
+
+    return restoreStatus;
+}
+
+/**
+ * @brief Converts a RSSI1/RSSI0 register pair to dBm.
+ *
+ * @param rssi1 - The RSSI1 register value.
+ * @param rssi0 - The RSSI0 register value.
+ * @return int16_t - The RSSI in dBm, rounded to the nearest integer.
+ */
+int16_t cc1120_rssi_to_dbm(uint8_t rssi1, uint8_t rssi0) {
+    // RSSI is a 12-bit two's complement value in 1/16 dB steps, split across RSSI1[7:0] and RSSI0[6:3]
+    int16_t sixteenths = (int16_t)((int8_t)rssi1) * 16 +
+                         ((rssi0 & CC1120_RSSI0_RSSI_LSB_MASK) >> CC1120_RSSI0_RSSI_LSB_SHIFT);
+
+    // Shift up before dividing so negative values round to nearest, not toward zero
+    return (int16_t)((sixteenths + 8 + 16 * 256) / 16 - 256) - CC1120_RSSI_OFFSET_DB;
+}
@@ -0,0 +1,70 @@
+#ifndef CC1120_SCAN_H
+#define CC1120_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_regs.h"
+#include "cc1120_fscal.h"
+
+#define CC1120_SCAN_DEFAULT_TIMEOUT_US 2000U
+
+typedef enum {
+    CC1120_SCAN_WAIT_RSSI0 = 0,
+    CC1120_SCAN_WAIT_GPIO
+} cc1120_scan_wait_t;
+
+typedef struct {
+    cc1120_fscal_cache_t cal;       /* Channel list and per-channel calibration */
+    int16_t *rssiDbm;               /* One entry per channel, filled by cc1120_scan_sweep */
+    cc1120_scan_wait_t waitMode;
+    uint8_t rssiValidGpio;          /* Only used with CC1120_SCAN_WAIT_GPIO */
+    uint32_t timeoutUs;             /* Maximum time to wait for RSSI_VALID on one channel */
+    uint32_t lastSweepUs;
+    uint32_t pointsPerSecond;
+} cc1120_scanner_t;
+
+/**
+ * @brief Initializes a scanner over a list of RF frequencies.
+ * Converts each frequency to a FREQ2..0 word and marks its calibration as stale.
+ * In GPIO mode, routes RSSI_VALID to the selected CC1120 GPIO.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param scanner - The scanner to initialize.
+ * @param channels - Preallocated channel array with numChannels entries.
+ * @param rssiDbm - Preallocated result array with numChannels entries.
+ * @param freqHz - The RF frequency of each channel in Hz.
+ * @param numChannels - The number of channels to sweep.
+ * @param waitMode - Whether to poll RSSI0 or a GPIO for RSSI_VALID.
+ * @param rssiValidGpio - The CC1120 GPIO (0-3) carrying RSSI_VALID in GPIO mode.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the scanner was initialized.
+ * @return An error code - If a parameter is invalid, or the SPI write failed.
+ */
+cc1120_status_code cc1120_scan_init(cc1120_dev_t *dev, cc1120_scanner_t *scanner, cc1120_fscal_channel_t channels[],
+                                    int16_t rssiDbm[], const uint32_t freqHz[], uint8_t numChannels,
+                                    cc1120_scan_wait_t waitMode, uint8_t rssiValidGpio);
+
+/**
+ * @brief Sweeps every channel once and stores the RSSI of each in dBm.
+ * The first sweep calibrates the synthesizer on each channel and caches the results.
+ * Later sweeps write the cached values with autocalibration off, so each point
+ * costs only the RSSI settling time plus a few short SPI transactions.
+ * Leaves the radio in IDLE.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param scanner - The initialized scanner.
+ * @return CC1120_ERROR_CODE_SUCCESS - If every channel was measured.
+ * @return An error code - If a calibration or RSSI measurement timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_scan_sweep(cc1120_dev_t *dev, cc1120_scanner_t *scanner);
+
+/**
+ * @brief Converts a RSSI1/RSSI0 register pair to dBm.
+ *
+ * @param rssi1 - The RSSI1 register value.
+ * @param rssi0 - The RSSI0 register value.
+ * @return int16_t - The RSSI in dBm, rounded to the nearest integer.
+ */
+int16_t cc1120_rssi_to_dbm(uint8_t rssi1, uint8_t rssi0);
+
+#endif /* CC1120_SCAN_H */
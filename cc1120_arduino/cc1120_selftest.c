@@ -0,0 +1,336 @@
+#include "cc1120_selftest.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_spi_tests.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Reset values of the three readable blocks of the extended space */
+static const uint8_t CC1120_SELFTEST_EXT_BLOCK0[] = {
+    CC1120_EXT_DEFAULTS_IF_MIX_CFG,
+    CC1120_EXT_DEFAULTS_FREQOFF_CFG,
+    CC1120_EXT_DEFAULTS_TOC_CFG,
+    CC1120_EXT_DEFAULTS_MARC_SPARE,
+    CC1120_EXT_DEFAULTS_ECG_CFG,
+    CC1120_EXT_DEFAULTS_CFM_DATA_CFG,
+    CC1120_EXT_DEFAULTS_EXT_CTRL,
+    CC1120_EXT_DEFAULTS_RCCAL_FINE,
+    CC1120_EXT_DEFAULTS_RCCAL_COARSE,
+    CC1120_EXT_DEFAULTS_RCCAL_OFFSET,
+    CC1120_EXT_DEFAULTS_FREQOFF1,
+    CC1120_EXT_DEFAULTS_FREQOFF0,
+    CC1120_EXT_DEFAULTS_FREQ2,
+    CC1120_EXT_DEFAULTS_FREQ1,
+    CC1120_EXT_DEFAULTS_FREQ0,
+    CC1120_EXT_DEFAULTS_IF_ADC2,
+    CC1120_EXT_DEFAULTS_IF_ADC1,
+    CC1120_EXT_DEFAULTS_IF_ADC0,
+    CC1120_EXT_DEFAULTS_FS_DIG1,
+    CC1120_EXT_DEFAULTS_FS_DIG0,
+    CC1120_EXT_DEFAULTS_FS_CAL3,
+    CC1120_EXT_DEFAULTS_FS_CAL2,
+    CC1120_EXT_DEFAULTS_FS_CAL1,
+    CC1120_EXT_DEFAULTS_FS_CAL0,
+    CC1120_EXT_DEFAULTS_FS_CHP,
+    CC1120_EXT_DEFAULTS_FS_DIVTWO,
+    CC1120_EXT_DEFAULTS_FS_DSM1,
+    CC1120_EXT_DEFAULTS_FS_DSM0,
+    CC1120_EXT_DEFAULTS_FS_DVC1,
+    CC1120_EXT_DEFAULTS_FS_DVC0,
+    CC1120_EXT_DEFAULTS_FS_LBI,
+    CC1120_EXT_DEFAULTS_FS_PFD,
+    CC1120_EXT_DEFAULTS_FS_PRE,
+    CC1120_EXT_DEFAULTS_FS_REG_DIV_CML,
+    CC1120_EXT_DEFAULTS_FS_SPARE,
+    CC1120_EXT_DEFAULTS_FS_VCO4,
+    CC1120_EXT_DEFAULTS_FS_VCO3,
+    CC1120_EXT_DEFAULTS_FS_VCO2,
+    CC1120_EXT_DEFAULTS_FS_VCO1,
+    CC1120_EXT_DEFAULTS_FS_VCO0,
+    CC1120_EXT_DEFAULTS_GBIAS6,
+    CC1120_EXT_DEFAULTS_GBIAS5,
+    CC1120_EXT_DEFAULTS_GBIAS4,
+    CC1120_EXT_DEFAULTS_GBIAS3,
+    CC1120_EXT_DEFAULTS_GBIAS2,
+    CC1120_EXT_DEFAULTS_GBIAS1,
+    CC1120_EXT_DEFAULTS_GBIAS0,
+    CC1120_EXT_DEFAULTS_IFAMP,
+    CC1120_EXT_DEFAULTS_LNA,
+    CC1120_EXT_DEFAULTS_RXMIX,
+    CC1120_EXT_DEFAULTS_XOSC5,
+    CC1120_EXT_DEFAULTS_XOSC4,
+    CC1120_EXT_DEFAULTS_XOSC3,
+    CC1120_EXT_DEFAULTS_XOSC2,
+    CC1120_EXT_DEFAULTS_XOSC1,
+    CC1120_EXT_DEFAULTS_XOSC0,
+    CC1120_EXT_DEFAULTS_ANALOG_SPARE,
+    CC1120_EXT_DEFAULTS_PA_CFG3
+};
+
+static const uint8_t CC1120_SELFTEST_EXT_BLOCK1[] = {
+    CC1120_EXT_DEFAULTS_WOR_TIME1,
+    CC1120_EXT_DEFAULTS_WOR_TIME0,
+    CC1120_EXT_DEFAULTS_WOR_CAPTURE1,
+    CC1120_EXT_DEFAULTS_WOR_CAPTURE0,
+    CC1120_EXT_DEFAULTS_BIST,
+    CC1120_EXT_DEFAULTS_DCFILTOFFSET_I1,
+    CC1120_EXT_DEFAULTS_DCFILTOFFSET_I0,
+    CC1120_EXT_DEFAULTS_DCFILTOFFSET_Q1,
+    CC1120_EXT_DEFAULTS_DCFILTOFFSET_Q0,
+    CC1120_EXT_DEFAULTS_IQIE_I1,
+    CC1120_EXT_DEFAULTS_IQIE_I0,
+    CC1120_EXT_DEFAULTS_IQIE_Q1,
+    CC1120_EXT_DEFAULTS_IQIE_Q0,
+    CC1120_EXT_DEFAULTS_RSSI1,
+    CC1120_EXT_DEFAULTS_RSSI0,
+    CC1120_EXT_DEFAULTS_MARCSTATE,
+    CC1120_EXT_DEFAULTS_LQI_VAL,
+    CC1120_EXT_DEFAULTS_PQT_SYNC_ERR,
+    CC1120_EXT_DEFAULTS_DEM_STATUS,
+    CC1120_EXT_DEFAULTS_FREQOFF_EST1,
+    CC1120_EXT_DEFAULTS_FREQOFF_EST0,
+    CC1120_EXT_DEFAULTS_AGC_GAIN3,
+    CC1120_EXT_DEFAULTS_AGC_GAIN2,
+    CC1120_EXT_DEFAULTS_AGC_GAIN1,
+    CC1120_EXT_DEFAULTS_AGC_GAIN0,
+    CC1120_EXT_DEFAULTS_CFM_RX_DATA_OUT,
+    CC1120_EXT_DEFAULTS_CFM_TX_DATA_IN,
+    CC1120_EXT_DEFAULTS_ASK_SOFT_RX_DATA,
+    CC1120_EXT_DEFAULTS_RNDGEN,
+    CC1120_EXT_DEFAULTS_MAGN2,
+    CC1120_EXT_DEFAULTS_MAGN1,
+    CC1120_EXT_DEFAULTS_MAGN0,
+    CC1120_EXT_DEFAULTS_ANG1,
+    CC1120_EXT_DEFAULTS_ANG0,
+    CC1120_EXT_DEFAULTS_CHFILT_I2,
+    CC1120_EXT_DEFAULTS_CHFILT_I1,
+    CC1120_EXT_DEFAULTS_CHFILT_I0,
+    CC1120_EXT_DEFAULTS_CHFILT_Q2,
+    CC1120_EXT_DEFAULTS_CHFILT_Q1,
+    CC1120_EXT_DEFAULTS_CHFILT_Q0,
+    CC1120_EXT_DEFAULTS_GPIO_STATUS,
+    CC1120_EXT_DEFAULTS_FSCAL_CTRL,
+    CC1120_EXT_DEFAULTS_PHASE_ADJUST,
+    CC1120_EXT_DEFAULTS_PARTNUMBER,
+    CC1120_EXT_DEFAULTS_PARTVERSION,
+    CC1120_EXT_DEFAULTS_SERIAL_STATUS,
+    CC1120_EXT_DEFAULTS_MODEM_STATUS1,
+    CC1120_EXT_DEFAULTS_MODEM_STATUS0,
+    CC1120_EXT_DEFAULTS_MARC_STATUS1,
+    CC1120_EXT_DEFAULTS_MARC_STATUS0,
+    CC1120_EXT_DEFAULTS_PA_IFAMP_TEST,
+    CC1120_EXT_DEFAULTS_FSRF_TEST,
+    CC1120_EXT_DEFAULTS_PRE_TEST,
+    CC1120_EXT_DEFAULTS_PRE_OVR,
+    CC1120_EXT_DEFAULTS_ADC_TEST,
+    CC1120_EXT_DEFAULTS_DVC_TEST,
+    CC1120_EXT_DEFAULTS_ATEST,
+    CC1120_EXT_DEFAULTS_ATEST_LVDS,
+    CC1120_EXT_DEFAULTS_ATEST_MODE,
+    CC1120_EXT_DEFAULTS_XOSC_TEST1,
+    CC1120_EXT_DEFAULTS_XOSC_TEST0
+};
+
+static const uint8_t CC1120_SELFTEST_EXT_BLOCK2[] = {
+    CC1120_EXT_DEFAULTS_RXFIRST,
+    CC1120_EXT_DEFAULTS_TXFIRST,
+    CC1120_EXT_DEFAULTS_RXLAST,
+    CC1120_EXT_DEFAULTS_TXLAST,
+    CC1120_EXT_DEFAULTS_NUM_TXBYTES,
+    CC1120_EXT_DEFAULTS_NUM_RXBYTES,
+    CC1120_EXT_DEFAULTS_FIFO_NUM_TXBYTES,
+    CC1120_EXT_DEFAULTS_FIFO_NUM_RXBYTES
+};
+
+typedef struct {
+    uint8_t first;
+    const uint8_t *defaults;
+    uint8_t len;
+} cc1120_selftest_block_t;
+
+static const cc1120_selftest_block_t CC1120_SELFTEST_EXT_BLOCKS[] = {
+    { CC1120_REGS_EXT_IF_MIX_CFG, CC1120_SELFTEST_EXT_BLOCK0, sizeof(CC1120_SELFTEST_EXT_BLOCK0) },
+    { CC1120_REGS_EXT_WOR_TIME1, CC1120_SELFTEST_EXT_BLOCK1, sizeof(CC1120_SELFTEST_EXT_BLOCK1) },
+    { CC1120_REGS_EXT_RXFIRST, CC1120_SELFTEST_EXT_BLOCK2, sizeof(CC1120_SELFTEST_EXT_BLOCK2) },
+};
+
+/* Status registers that follow the radio or the chip revision rather than the reset value, as first-last ranges */
+static const uint8_t CC1120_SELFTEST_EXT_LIVE[][2] = {
+    { CC1120_REGS_EXT_WOR_TIME1, CC1120_REGS_EXT_WOR_CAPTURE0 },
+    { CC1120_REGS_EXT_DCFILTOFFSET_I1, CC1120_REGS_EXT_RSSI0 },
+    { CC1120_REGS_EXT_LQI_VAL, CC1120_REGS_EXT_ASK_SOFT_RX_DATA },
+    { CC1120_REGS_EXT_RNDGEN, CC1120_REGS_EXT_GPIO_STATUS },
+    { CC1120_REGS_EXT_PARTNUMBER, CC1120_REGS_EXT_MODEM_STATUS0 },
+};
+
+/**
+ * @brief Checks whether an extended register holds live status that the self-test skips.
+ *
+ * @param addr - The extended register address.
+ * @return true - If the register is skipped.
+ * @return false - If it is compared with its reset value.
+ */
+static bool cc1120_selftest_is_live(uint8_t addr) {
+    uint8_t i;
+    for (i = 0; i < sizeof(CC1120_SELFTEST_EXT_LIVE) / sizeof(CC1120_SELFTEST_EXT_LIVE[0]); i++) {
+        if (addr >= CC1120_SELFTEST_EXT_LIVE[i][0] && addr <= CC1120_SELFTEST_EXT_LIVE[i][1])
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Records a mismatch in the report, if there is room for it.
+ *
+ * @param report - The report.
+ * @param space - Where the byte is.
+ * @param addr - The address of the byte.
+ * @param expected - The value it should have.
+ * @param actual - The value read.
+ */
+static void cc1120_selftest_add_diff(cc1120_selftest_report_t *report, cc1120_selftest_space_t space, uint8_t addr,
+                                     uint8_t expected, uint8_t actual) {
+    if (report->numDiffs == CC1120_SELFTEST_MAX_DIFFS)
+        return;
+
+    cc1120_selftest_diff_t *diff = &report->diffs[report->numDiffs++];
+    diff->space = space;
+    diff->addr = addr;
+    diff->expected = expected;
+    diff->actual = actual;
+}
+
+/**
+ * @brief Fills a FIFO chunk with walking ones, or their inverse.
+ *
+ * @param buf - The chunk.
+ * @param addr - The FIFO address of the first byte.
+ * @param inverse - Whether to invert the pattern.
+ */
+static void cc1120_selftest_fifo_pattern(uint8_t buf[CC1120_SELFTEST_FIFO_CHUNK], uint8_t addr, bool inverse) {
+    uint8_t i;
+    for (i = 0; i < CC1120_SELFTEST_FIFO_CHUNK; i++) {
+        uint8_t walking = (uint8_t)(1U << ((uint8_t)(addr + i) & 7U));
+        buf[i] = inverse ? (uint8_t)~walking : walking;
+    }
+}
+
+/**
+ * @brief Resets the chip and checks the whole register map and FIFO memory in a few burst transactions:
+ * the standard space against its reset values, the three extended space blocks against
+ * CC1120_EXT_DEFAULTS_*, skipping live status registers, then walking ones and their inverse
+ * through direct FIFO access. The chip is left reset, so configure it again afterwards.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param report - Filled with the counts, the first CC1120_SELFTEST_MAX_DIFFS mismatches and the duration.
+ * @return CC1120_ERROR_CODE_SUCCESS - If every register and FIFO byte matched.
+ * @return CC1120_ERROR_CODE_SELFTEST_FAILED - If anything mismatched.
+ * @return An error code - If the chip did not come out of reset, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_selftest_run(cc1120_dev_t *dev, cc1120_selftest_report_t *report) {
+    cc1120_status_code status;
+    uint8_t buf[CC1120_SELFTEST_FIFO_CHUNK];
+    uint8_t i;
+
+    memset(report, 0, sizeof(*report));
+    uint32_t start = mcu_get_time_us();
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SRES);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_chip_ready(dev, CC1120_SELFTEST_RESET_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+    report->transactions = 2;
+
+    status = cc1120_read_spi(dev, 0x00U, buf, CC1120_REGS_STD_SPACE_SIZE);
+    RETURN_IF_ERROR(status)
+    report->transactions++;
+
+    for (i = 0; i < CC1120_REGS_STD_SPACE_SIZE; i++) {
+        report->regsChecked++;
+        if (buf[i] != CC1120_REGS_DEFAULTS[i]) {
+            report->regMismatches++;
+            cc1120_selftest_add_diff(report, CC1120_SELFTEST_SPACE_STD, i, CC1120_REGS_DEFAULTS[i], buf[i]);
+        }
+    }
+
+    uint8_t b;
+    for (b = 0; b < sizeof(CC1120_SELFTEST_EXT_BLOCKS) / sizeof(CC1120_SELFTEST_EXT_BLOCKS[0]); b++) {
+        const cc1120_selftest_block_t *block = &CC1120_SELFTEST_EXT_BLOCKS[b];
+
+        status = cc1120_read_ext_addr_spi(dev, block->first, buf, block->len);
+        RETURN_IF_ERROR(status)
+        report->transactions++;
+
+        for (i = 0; i < block->len; i++) {
+            uint8_t addr = block->first + i;
+            if (cc1120_selftest_is_live(addr))
+                continue;
+
+            report->regsChecked++;
+            if (buf[i] != block->defaults[i]) {
+                report->regMismatches++;
+                cc1120_selftest_add_diff(report, CC1120_SELFTEST_SPACE_EXT, addr, block->defaults[i], buf[i]);
+            }
+        }
+    }
+
+    // Each bit of each FIFO byte is seen at 1 and at 0, and neighbouring bytes differ
+    uint8_t pass;
+    for (pass = 0; pass < 2; pass++) {
+        uint8_t addr;
+        for (addr = CC1120_FIFO_TX_START;; addr += CC1120_SELFTEST_FIFO_CHUNK) {
+            cc1120_selftest_fifo_pattern(buf, addr, pass == 1);
+            status = cc1120_write_fifo_direct(dev, addr, buf, CC1120_SELFTEST_FIFO_CHUNK);
+            RETURN_IF_ERROR(status)
+
+            status = cc1120_read_fifo_direct(dev, addr, buf, CC1120_SELFTEST_FIFO_CHUNK);
+            RETURN_IF_ERROR(status)
+            report->transactions += 2;
+
+            uint8_t expected[CC1120_SELFTEST_FIFO_CHUNK];
+            cc1120_selftest_fifo_pattern(expected, addr, pass == 1);
+            for (i = 0; i < CC1120_SELFTEST_FIFO_CHUNK; i++) {
+                report->fifoBytesChecked++;
+                if (buf[i] != expected[i]) {
+                    report->fifoMismatches++;
+                    cc1120_selftest_add_diff(report, CC1120_SELFTEST_SPACE_FIFO, addr + i, expected[i], buf[i]);
+                }
+            }
+
+            if (addr == CC1120_FIFO_RX_START)
+                break;
+        }
+    }
+
+    report->durationUs = mcu_get_time_us() - start;
+
+    if (report->regMismatches != 0 || report->fifoMismatches != 0)
+        return CC1120_ERROR_CODE_SELFTEST_FAILED;
+
+    return status;
+}
+
+/**
+ * @brief Logs a self-test report, one line per mismatch.
+ *
+ * @param report - The report from cc1120_selftest_run.
+ */
+void cc1120_selftest_log(const cc1120_selftest_report_t *report) {
+    static const char *const SPACE_NAMES[] = { "STD", "EXT", "FIFO" };
+    cc1120_log_level_t level = (report->regMismatches != 0 || report->fifoMismatches != 0) ? CC1120_LOG_LEVEL_ERROR :
+                                                                                             CC1120_LOG_LEVEL_INFO;
+
+    mcu_log(level, "CC1120 self-test: %u/%u registers, %u/%u FIFO bytes bad, %u transactions, %lu us\n",
+            report->regMismatches, report->regsChecked, report->fifoMismatches, report->fifoBytesChecked,
+            report->transactions, (unsigned long)report->durationUs);
+
+    uint8_t i;
+    for (i = 0; i < report->numDiffs; i++) {
+        const cc1120_selftest_diff_t *diff = &report->diffs[i];
+        mcu_log(level, "  %s 0x%02X: read 0x%02X, expected 0x%02X\n", SPACE_NAMES[diff->space], diff->addr,
+                diff->actual, diff->expected);
+    }
+}
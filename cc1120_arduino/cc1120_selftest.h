@@ -0,0 +1,63 @@
+#ifndef CC1120_SELFTEST_H
+#define CC1120_SELFTEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/* Mismatches kept in the report. The count covers all of them. */
+#define CC1120_SELFTEST_MAX_DIFFS 16U
+
+/* Time for the crystal to start after SRES */
+#define CC1120_SELFTEST_RESET_TIMEOUT_US 5000UL
+
+/* FIFO bytes per direct access burst, half the 256-byte FIFO memory */
+#define CC1120_SELFTEST_FIFO_CHUNK 128U
+
+typedef enum {
+    CC1120_SELFTEST_SPACE_STD = 0,
+    CC1120_SELFTEST_SPACE_EXT,
+    CC1120_SELFTEST_SPACE_FIFO      /* addr is the FIFO memory address */
+} cc1120_selftest_space_t;
+
+typedef struct {
+    cc1120_selftest_space_t space;
+    uint8_t addr;
+    uint8_t expected;
+    uint8_t actual;
+} cc1120_selftest_diff_t;
+
+typedef struct {
+    uint16_t regsChecked;
+    uint16_t regMismatches;
+    uint16_t fifoBytesChecked;
+    uint16_t fifoMismatches;
+    uint8_t transactions;           /* SPI transactions used, including the reset */
+    uint32_t durationUs;
+    uint8_t numDiffs;
+    cc1120_selftest_diff_t diffs[CC1120_SELFTEST_MAX_DIFFS];
+} cc1120_selftest_report_t;
+
+/**
+ * @brief Resets the chip and checks the whole register map and FIFO memory in a few burst transactions:
+ * the standard space against its reset values, the three extended space blocks against
+ * CC1120_EXT_DEFAULTS_*, skipping live status registers, then walking ones and their inverse
+ * through direct FIFO access. The chip is left reset, so configure it again afterwards.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param report - Filled with the counts, the first CC1120_SELFTEST_MAX_DIFFS mismatches and the duration.
+ * @return CC1120_ERROR_CODE_SUCCESS - If every register and FIFO byte matched.
+ * @return CC1120_ERROR_CODE_SELFTEST_FAILED - If anything mismatched.
+ * @return An error code - If the chip did not come out of reset, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_selftest_run(cc1120_dev_t *dev, cc1120_selftest_report_t *report);
+
+/**
+ * @brief Logs a self-test report, one line per mismatch.
+ *
+ * @param report - The report from cc1120_selftest_run.
+ */
+void cc1120_selftest_log(const cc1120_selftest_report_t *report);
+
+#endif /* CC1120_SELFTEST_H */
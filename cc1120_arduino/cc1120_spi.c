@@ -1,20 +1,25 @@
 #include "cc1120_spi.h"
 #include "cc1120_regs.h"
+#include "cc1120_fields.h"
 #include "cc1120_mcu.h"
+#include "cc1120_hal.h"
+#include "cc1120_stats.h"
+#include <stddef.h>
 
 /**
  * @brief - Reads from consecutive registers from the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to read.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_read_spi(uint8_t addr, uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_read_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
     
-    if (addr >= CC1120_REGS_EXT_ADDR) {
+    if (CC1120_SPI_CHECK_ADDR && !CC1120_REG_ADDR_VALID(CC1120_SPACE_STD, addr)) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_read_spi: Not a valid register!\n");
         status = CC1120_ERROR_CODE_INVALID_PARAM;
         return status;
@@ -29,39 +34,36 @@ cc1120_status_code cc1120_read_spi(uint8_t addr, uint8_t data[], uint8_t len) {
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         uint8_t header = (len > 1) ? (R_BIT | BURST_BIT | addr) : (R_BIT | addr);
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, (len > 1) ? CC1120_SPI_ACCESS_BURST : CC1120_SPI_ACCESS_SINGLE);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        uint8_t i;
-        for(i = 0; i < len; i++) {
-            data[i] = mcu_cc1120_spi_transfer(0x00);
-        }
+        cc1120_hal_spi_transfer_block(dev, NULL, data, len);
     }
 
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Reads from consecutive extended address space registers on the CC1120
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to read.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_read_ext_addr_spi(uint8_t addr, uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_read_ext_addr_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
-    if ((addr > CC1120_REGS_EXT_PA_CFG3 && addr < CC1120_REGS_EXT_WOR_TIME1) ||
-        (addr > CC1120_REGS_EXT_XOSC_TEST0 && addr < CC1120_REGS_EXT_RXFIRST) ||
-        (addr > CC1120_REGS_EXT_FIFO_NUM_RXBYTES)) {
+    if (CC1120_SPI_CHECK_ADDR && !CC1120_REG_ADDR_VALID(CC1120_SPACE_EXT, addr)) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_read_ext_addr_spi: Not a valid register!\n");
         status = CC1120_ERROR_CODE_INVALID_PARAM; // invalid params
         return status;
@@ -78,45 +80,45 @@ cc1120_status_code cc1120_read_ext_addr_spi(uint8_t addr, uint8_t data[], uint8_
         uint8_t header = (len > 1) ? (R_BIT | BURST_BIT | CC1120_REGS_EXT_ADDR) :
                                      (R_BIT | CC1120_REGS_EXT_ADDR);
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_EXT);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        if (mcu_cc1120_spi_transfer(addr) != 0x00) { // When sending the extended address, SO will return all zeros. See section 3.2.
+        if (cc1120_hal_spi_transfer(dev, addr) != 0x00) { // When sending the extended address, SO will return all zeros. See section 3.2.
             mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_read_ext_addr_spi: CC1120_read_ext_addr_spi failed\n");
             status = CC1120_ERROR_CODE_READ_EXT_ADDR_SPI_FAILED;
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        uint8_t i;
-        for(i = 0; i < len; i++) {
-            data[i] = mcu_cc1120_spi_transfer(0x00);
-        }
+        cc1120_hal_spi_transfer_block(dev, NULL, data, len);
     }
 
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Writes to consecutive registers on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to write to.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_write_spi(uint8_t addr, uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_write_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
-    if(addr >= CC1120_REGS_EXT_ADDR) {
+    if (CC1120_SPI_CHECK_ADDR && !CC1120_REG_ADDR_VALID(CC1120_SPACE_STD, addr)) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_write_spi: Not a valid register!\n");
         status = CC1120_ERROR_CODE_INVALID_PARAM;
         return status;
@@ -131,9 +133,10 @@ cc1120_status_code cc1120_write_spi(uint8_t addr, uint8_t data[], uint8_t len) {
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         uint8_t header = (len > 1) ? (BURST_BIT | addr) : addr;
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, (len > 1) ? CC1120_SPI_ACCESS_BURST : CC1120_SPI_ACCESS_SINGLE);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
@@ -141,32 +144,32 @@ cc1120_status_code cc1120_write_spi(uint8_t addr, uint8_t data[], uint8_t len) {
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         uint8_t i;
         for(i = 0; i < len; i++) {
-            status = cc1120_send_byte_receive_status(data[i]);
+            status = cc1120_send_byte_receive_status(dev, data[i]);
             if (status != CC1120_ERROR_CODE_SUCCESS) {
+                cc1120_hal_cs_deassert(dev);
                 return status;
             }
         }
     }
 
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Writes to consecutive extended address space registers on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to write to.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_write_ext_addr_spi(uint8_t addr, uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_write_ext_addr_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
-    if ((addr > CC1120_REGS_EXT_PA_CFG3 && addr < CC1120_REGS_EXT_WOR_TIME1) ||
-        (addr > CC1120_REGS_EXT_XOSC_TEST0 && addr < CC1120_REGS_EXT_RXFIRST) ||
-        (addr > CC1120_REGS_EXT_FIFO_NUM_RXBYTES)) {
+    if (CC1120_SPI_CHECK_ADDR && !CC1120_REG_ADDR_VALID(CC1120_SPACE_EXT, addr)) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_write_ext_addr_spi: Not a valid register!\n");
         status = CC1120_ERROR_CODE_INVALID_PARAM;
         return status;
@@ -181,17 +184,19 @@ cc1120_status_code cc1120_write_ext_addr_spi(uint8_t addr, uint8_t data[], uint8
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         uint8_t header = (len > 1) ? (BURST_BIT | CC1120_REGS_EXT_ADDR) : CC1120_REGS_EXT_ADDR;
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_EXT);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        if (mcu_cc1120_spi_transfer(addr) != 0x00) { // When sending the extended address, SO will return all zeros. See section 3.2.
+        if (cc1120_hal_spi_transfer(dev, addr) != 0x00) { // When sending the extended address, SO will return all zeros. See section 3.2.
             mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_write_ext_addr_spi: CC1120 write_ext_addr_spi failed\n");
             status = CC1120_ERROR_CODE_WRITE_EXT_ADDR_SPI_FAILED;
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
@@ -199,25 +204,28 @@ cc1120_status_code cc1120_write_ext_addr_spi(uint8_t addr, uint8_t data[], uint8
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         uint8_t i;
         for(i = 0; i < len; i++) {
-            status = cc1120_send_byte_receive_status(data[i]);
+            status = cc1120_send_byte_receive_status(dev, data[i]);
             if (status != CC1120_ERROR_CODE_SUCCESS) {
+                cc1120_hal_cs_deassert(dev);
                 return status;
             }
         }
     }
     
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
- * @brief Calls a strobe command on the CC1120.
+ * @brief Calls a strobe command on the CC1120. SRES also marks the register shadow invalid, and STX, SRX
+ * and SIDLE pass the state they enter to the link statistics.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the strobe command.
  * @return CC1120_ERROR_CODE_SUCCESS - If the strobe command was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_strobe_spi(uint8_t addr) {
+cc1120_status_code cc1120_strobe_spi(cc1120_dev_t *dev, uint8_t addr) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
     if (addr < CC1120_STROBE_SRES || addr > CC1120_STROBE_SNOP) {
@@ -226,27 +234,71 @@ cc1120_status_code cc1120_strobe_spi(uint8_t addr) {
         return status;
     }
 
+    // The reset puts every register back to its default, so the shadow copies no longer hold
+    if (addr == CC1120_STROBE_SRES)
+        dev->shadow.valid = false;
+
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        mcu_cc1120_cs_assert();    
-        status = cc1120_send_byte_receive_status(addr);
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_SINGLE);    
+        status = cc1120_send_byte_receive_status(dev, addr);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
+
+    // The status byte shows the state before the strobe, so the link statistics get the one it enters
+    if (dev->linkStats != NULL) {
+        if (addr == CC1120_STROBE_STX)
+            cc1120_stats_on_state(dev->linkStats, CC1120_STATE_TX, mcu_get_time_us());
+        else if (addr == CC1120_STROBE_SRX)
+            cc1120_stats_on_state(dev->linkStats, CC1120_STATE_RX, mcu_get_time_us());
+        else if (addr == CC1120_STROBE_SIDLE)
+            cc1120_stats_on_state(dev->linkStats, CC1120_STATE_IDLE, mcu_get_time_us());
+    }
     return status;
 }
 
+/**
+ * @brief Wakes the CC1120 from SLEEP or XOFF by holding CS low until the chip reports ready.
+ * The chip drives CHIP_RDYn low once its crystal is running.
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @param timeoutUs - The maximum time to wait in microseconds.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the chip is ready.
+ * @return CC1120_ERROR_CODE_STATE_TIMEOUT - If the chip did not become ready in time.
+ */
+cc1120_status_code cc1120_wait_chip_ready(cc1120_dev_t *dev, uint32_t timeoutUs) {
+    union cc_st ccstatus;
+    uint32_t start = mcu_get_time_us();
+
+    cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_SINGLE);
+    do {
+        ccstatus.data = cc1120_hal_spi_transfer(dev, CC1120_STROBE_SNOP);
+        if (ccstatus.ccst.chip_ready == 0) {
+            dev->lastStatus = ccstatus.data;
+            cc1120_hal_cs_deassert(dev);
+            return CC1120_ERROR_CODE_SUCCESS;
+        }
+    } while (mcu_get_time_us() - start < timeoutUs);
+    cc1120_hal_cs_deassert(dev);
+
+    mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wait_chip_ready: CC1120 did not wake up!\n");
+    return CC1120_ERROR_CODE_STATE_TIMEOUT;
+}
+
 /**
  * @brief - Reads consecutive registers from the FIFO memory.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the status byte is invalid.
  */
-cc1120_status_code cc1120_read_fifo(uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_read_fifo(cc1120_dev_t *dev, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
     if (len < 1) {
@@ -259,32 +311,31 @@ cc1120_status_code cc1120_read_fifo(uint8_t data[], uint8_t len) {
         uint8_t header = (len > 1) ? (R_BIT | BURST_BIT | CC1120_REGS_FIFO_ACCESS_STD) :
                                     (R_BIT | CC1120_REGS_FIFO_ACCESS_STD);
 
-        mcu_cc1120_cs_assert();
-        if (cc1120_send_byte_receive_status(header) != CC1120_ERROR_CODE_SUCCESS) {
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_FIFO);
+        if (cc1120_send_byte_receive_status(dev, header) != CC1120_ERROR_CODE_SUCCESS) {
             status = CC1120_ERROR_CODE_INVALID_PARAM;
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        uint8_t i;
-        for(i = 0; i < len; i++) {
-            data[i] = mcu_cc1120_spi_transfer(0x00);
-        }
+        cc1120_hal_spi_transfer_block(dev, NULL, data, len);
     }
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Writes consecutive registers to the FIFO memory.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the status byte is invalid.
  */
-cc1120_status_code cc1120_write_fifo(uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_write_fifo(cc1120_dev_t *dev, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
     if (len < 1) {
@@ -297,34 +348,33 @@ cc1120_status_code cc1120_write_fifo(uint8_t data[], uint8_t len) {
         uint8_t header = (len > 1) ? (BURST_BIT | CC1120_REGS_FIFO_ACCESS_STD) :
                                     CC1120_REGS_FIFO_ACCESS_STD;
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_FIFO);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        uint8_t i;
-        for(i = 0; i < len; i++) {
-            mcu_cc1120_spi_transfer(data[i]);
-        }
+        cc1120_hal_spi_transfer_block(dev, data, NULL, len);
     }
 
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Reads consecutive registers directly from the FIFO on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to read. Range 0x00 - 0xFF.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_read_fifo_direct(uint8_t addr, uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_read_fifo_direct(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
     if (addr < CC1120_FIFO_TX_START || addr > CC1120_FIFO_RX_END) {
@@ -343,35 +393,34 @@ cc1120_status_code cc1120_read_fifo_direct(uint8_t addr, uint8_t data[], uint8_t
         uint8_t header = (len > 1) ? (R_BIT | BURST_BIT | CC1120_REGS_FIFO_ACCESS_DIR) :
                                     (R_BIT | CC1120_REGS_FIFO_ACCESS_DIR);
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_FIFO);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status != CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        mcu_cc1120_spi_transfer(addr);
-        uint8_t i;
-        for(i = 0; i < len; i++) {
-            data[i] = mcu_cc1120_spi_transfer(0x00);
-        }
+        cc1120_hal_spi_transfer(dev, addr);
+        cc1120_hal_spi_transfer_block(dev, NULL, data, len);
     }
 
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Writes consecutive registers directly to the FIFO on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to write to. Range 0x00 - 0xFF.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_write_fifo_direct(uint8_t addr, uint8_t data[], uint8_t len) {
+cc1120_status_code cc1120_write_fifo_direct(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
     cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
 
     if (addr < CC1120_FIFO_TX_START || addr > CC1120_FIFO_RX_END) {
@@ -391,39 +440,40 @@ cc1120_status_code cc1120_write_fifo_direct(uint8_t addr, uint8_t data[], uint8_
                                     CC1120_REGS_FIFO_ACCESS_DIR;
 
 
-        mcu_cc1120_cs_assert();
-        status = cc1120_send_byte_receive_status(header);
+        cc1120_hal_cs_assert(dev, CC1120_SPI_ACCESS_FIFO);
+        status = cc1120_send_byte_receive_status(dev, header);
         if (status!= CC1120_ERROR_CODE_SUCCESS) {
+            cc1120_hal_cs_deassert(dev);
             return status;
         }
     }
 
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        mcu_cc1120_spi_transfer(addr);
-        uint8_t i;
-        for(i = 0; i < len; i++) {
-            mcu_cc1120_spi_transfer(data[i]);
-        }
+        cc1120_hal_spi_transfer(dev, addr);
+        cc1120_hal_spi_transfer_block(dev, data, NULL, len);
     }
-    mcu_cc1120_cs_deassert();
+    cc1120_hal_cs_deassert(dev);
     return status;
 }
 
 /**
  * @brief - Reads the status register on the CC1120 and consecutively sends a byte over SPI.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - The data to send to the status register.
  * @return CC1120_ERROR_CODE_SUCCESS - If the status byte is valid.
  * @return CC1120_ERROR_CODE_SEND_BYTE_RECEIVE_STATUS_INVALID_STATUS_BYTE - If the status byte is invalid.
  */
-cc1120_status_code cc1120_send_byte_receive_status(uint8_t data) {
+cc1120_status_code cc1120_send_byte_receive_status(cc1120_dev_t *dev, uint8_t data) {
     cc1120_status_code status = CC1120_ERROR_CODE_INVALID_STATUS_BYTE;
     union cc_st ccstatus;
 
     uint8_t i;
     for (i = 1; i <= 5; i++) {
-        ccstatus.data = mcu_cc1120_spi_transfer(data);
+        ccstatus.data = cc1120_hal_spi_transfer(dev, data);
+        dev->lastStatus = ccstatus.data;
         if (ccstatus.ccst.chip_ready == 1) {
+            dev->stats.chipReadyRetries++;
             mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_send_byte_receive_status: CC1120 chip not ready. Retrying... (%u/5)\n", i);
         } else {
             status = CC1120_ERROR_CODE_SUCCESS;
@@ -431,5 +481,8 @@ cc1120_status_code cc1120_send_byte_receive_status(uint8_t data) {
         }
     }
 
+    if (status != CC1120_ERROR_CODE_SUCCESS)
+        dev->stats.invalidStatus++;
+
     return status;
 }
@@ -4,8 +4,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "cc1120_logging.h"
+#include "cc1120_dev.h"
 
 
+/*
+ * Run-time address checks in the register functions. Accesses through cc1120_fields.h are
+ * checked at compile time, so release builds (NDEBUG) leave them out.
+ */
+#ifndef CC1120_SPI_CHECK_ADDR
+#ifdef NDEBUG
+#define CC1120_SPI_CHECK_ADDR 0
+#else
+#define CC1120_SPI_CHECK_ADDR 1
+#endif
+#endif
+
 #define R_BIT 1 << 7
 #define BURST_BIT 1 << 6
 
@@ -23,105 +36,127 @@ union cc_st {
 /**
  * @brief - Reads from consecutive registers from the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to read.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_read_spi(uint8_t addr, uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_read_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Reads from consecutive extended address space registers on the CC1120
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to read.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_read_ext_addr_spi(uint8_t addr, uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_read_ext_addr_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Writes to consecutive registers on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to write to.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_write_spi(uint8_t addr, uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_write_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Writes to consecutive extended address space registers on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to write to.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_write_ext_addr_spi(uint8_t addr, uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_write_ext_addr_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len);
 
 /**
- * @brief Calls a strobe command on the CC1120.
+ * @brief Calls a strobe command on the CC1120. SRES also marks the register shadow invalid, and STX, SRX
+ * and SIDLE pass the state they enter to the link statistics.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the strobe command.
  * @return CC1120_ERROR_CODE_SUCCESS - If the strobe command was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_strobe_spi(uint8_t addr);
+cc1120_status_code cc1120_strobe_spi(cc1120_dev_t *dev, uint8_t addr);
+
+/**
+ * @brief Wakes the CC1120 from SLEEP or XOFF by holding CS low until the chip reports ready.
+ * The chip drives CHIP_RDYn low once its crystal is running.
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @param timeoutUs - The maximum time to wait in microseconds.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the chip is ready.
+ * @return CC1120_ERROR_CODE_STATE_TIMEOUT - If the chip did not become ready in time.
+ */
+cc1120_status_code cc1120_wait_chip_ready(cc1120_dev_t *dev, uint32_t timeoutUs);
 
 /**
  * @brief - Reads consecutive registers from the FIFO memory.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the status byte is invalid.
  */
-cc1120_status_code cc1120_read_fifo(uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_read_fifo(cc1120_dev_t *dev, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Writes consecutive registers to the FIFO memory.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the status byte is invalid.
  */
-cc1120_status_code cc1120_write_fifo(uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_write_fifo(cc1120_dev_t *dev, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Reads consecutive registers directly from the FIFO on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to read. Range 0x00 - 0xFF.
  * @param data - The array to store the read data, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to read.
  * @return CC1120_ERROR_CODE_SUCCESS - If the read was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_read_fifo_direct(uint8_t addr, uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_read_fifo_direct(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Writes consecutive registers directly to the FIFO on the CC1120.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param addr - The address of the first register to write to. Range 0x00 - 0xFF.
  * @param data - The array of data to write to the registers, or a pointer to a single uint8_t if len=1.
  * @param len - The number of registers to write.
  * @return CC1120_ERROR_CODE_SUCCESS - If the write was successful.
  * @return An error code - If the register is not valid, or the status byte is invalid.
  */
-cc1120_status_code cc1120_write_fifo_direct(uint8_t addr, uint8_t data[], uint8_t len);
+cc1120_status_code cc1120_write_fifo_direct(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len);
 
 /**
  * @brief - Reads the status register on the CC1120 and consecutively sends a byte over SPI.
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - The data to send to the status register.
  * @return CC1120_ERROR_CODE_SUCCESS - If the status byte is valid.
  * @return CC1120_ERROR_CODE_SEND_BYTE_RECEIVE_STATUS_INVALID_STATUS_BYTE - If the status byte is invalid.
  */
-cc1120_status_code cc1120_send_byte_receive_status(uint8_t data);
+cc1120_status_code cc1120_send_byte_receive_status(cc1120_dev_t *dev, uint8_t data);
 
 #endif /* CC1120_SPI_H */
@@ -3,8 +3,6 @@
 #include "cc1120_mcu.h"
 #include <string.h>
 
-union cc_st ccstatus;
-
 uint8_t CC1120_REGS_DEFAULTS[CC1120_REGS_STD_SPACE_SIZE] = {
     CC1120_DEFAULTS_IOCFG3,
     CC1120_DEFAULTS_IOCFG2,
@@ -62,16 +60,17 @@ uint8_t CC1120_REGS_DEFAULTS[CC1120_REGS_STD_SPACE_SIZE] = {
  * Burst reads all the values and compares them to the default values.
  * Burst reads FREQ registers in extended address space and compares them to defaults.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If all registers are read correctly and have the right value.
  * @return An error code - If any register does not have the expected value,
  *                 or status byte is invalid.
  */
-cc1120_status_code cc1120_test_spi_read() { 
+cc1120_status_code cc1120_test_spi_read(cc1120_dev_t *dev) { 
     cc1120_status_code status;
     uint8_t addr = 0x00U;
     uint8_t data;
     uint8_t burstData[CC1120_REGS_EXT_ADDR];
-    status = cc1120_read_spi(addr, burstData, CC1120_REGS_EXT_ADDR);
+    status = cc1120_read_spi(dev, addr, burstData, CC1120_REGS_EXT_ADDR);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 burst read test failed.\n");
@@ -85,7 +84,7 @@ cc1120_status_code cc1120_test_spi_read() {
     }
     
     if (status == CC1120_ERROR_CODE_SUCCESS) {
-        status = cc1120_read_ext_addr_spi(CC1120_REGS_EXT_MARCSTATE, &data, 1);
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARCSTATE, &data, 1);
         
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 read test failed.\n");
@@ -103,7 +102,7 @@ cc1120_status_code cc1120_test_spi_read() {
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         uint8_t extBurstData[3];
         uint8_t expected[3] = {0x00U, 0x00U, 0x00U};
-        status = cc1120_read_ext_addr_spi(CC1120_REGS_EXT_FREQ2, extBurstData, 3);
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2, extBurstData, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 burst read test failed.\n");
@@ -130,23 +129,24 @@ cc1120_status_code cc1120_test_spi_read() {
  * Burst writes to the sync word registers, then burst reads to see if the writes were successful.
  * Burst writes to the FREQ registers, then burst reads to see if the writes were successful.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If both writes are successful.
  * @return An error code - If any register does not have the expected value,
  *                 or status byte is invalid.
  */
-cc1120_status_code cc1120_test_spi_write() {
+cc1120_status_code cc1120_test_spi_write(cc1120_dev_t *dev) {
     cc1120_status_code status;
     uint8_t w_data = 0xFFU;
     uint8_t r_data;
 
-    status = cc1120_write_spi(CC1120_REGS_EXT_FREQOFF0, &w_data, 1);
+    status = cc1120_write_spi(dev, CC1120_REGS_EXT_FREQOFF0, &w_data, 1);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 write test failed.\n");
         return status;
     } 
 
-    status = cc1120_read_spi(CC1120_REGS_EXT_FREQOFF0, &r_data, 1);
+    status = cc1120_read_spi(dev, CC1120_REGS_EXT_FREQOFF0, &r_data, 1);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 write test failed.\n");
@@ -164,14 +164,14 @@ cc1120_status_code cc1120_test_spi_write() {
         uint8_t burstData[4] = {0xFFU, 0xFFU, 0xFFU, 0xFFU};
         uint8_t burstDataRead[4];
 
-        status = cc1120_write_spi(CC1120_REGS_SYNC3, burstData, 4);
+        status = cc1120_write_spi(dev, CC1120_REGS_SYNC3, burstData, 4);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 burst write test failed.\n");
             return status;
         } 
 
-        status = cc1120_read_spi(CC1120_REGS_SYNC3, burstDataRead, 4);
+        status = cc1120_read_spi(dev, CC1120_REGS_SYNC3, burstDataRead, 4);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 burst write test failed.\n");
@@ -188,14 +188,14 @@ cc1120_status_code cc1120_test_spi_write() {
     if (status == CC1120_ERROR_CODE_SUCCESS) {
         w_data = 0x80U;
 
-        status = cc1120_write_ext_addr_spi(CC1120_REGS_EXT_FREQ1, &w_data, 1);
+        status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ1, &w_data, 1);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI write test failed.\n");
             return status;
         } 
 
-        status = cc1120_read_ext_addr_spi(CC1120_REGS_EXT_FREQ1, &r_data, 1);
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ1, &r_data, 1);
         
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI write test failed.\n");
@@ -214,14 +214,14 @@ cc1120_status_code cc1120_test_spi_write() {
         uint8_t extBurstData[3] = {0x70U, 0x80U, 0x00U};
         uint8_t extBurstRead[3];
 
-        status = cc1120_write_ext_addr_spi(CC1120_REGS_EXT_FREQ2, extBurstData, 3);
+        status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2, extBurstData, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI write test failed.\n");
             return status;
         } 
 
-        status = cc1120_read_ext_addr_spi(CC1120_REGS_EXT_FREQ2, extBurstRead, 3);
+        status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FREQ2, extBurstRead, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI write test failed.\n");
@@ -245,20 +245,21 @@ cc1120_status_code cc1120_test_spi_write() {
  * @brief E2E test for SPI strobe functionality.
  * Runs the reset strobe and checks the MARCSTATE register.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If MARCSTATE is 0x41 after reset.
  * @return An error code - If MARCSTATE is not 0x41 after reset, or status byte is invalid.
  */
-cc1120_status_code cc1120_test_spi_strobe() {
+cc1120_status_code cc1120_test_spi_strobe(cc1120_dev_t *dev) {
     cc1120_status_code status;
     uint8_t data;
     
-    status = cc1120_strobe_spi(CC1120_STROBE_SRES);
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SRES);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI strobe test failed.\n");
         return status;
     }
-    status = cc1120_read_ext_addr_spi(CC1120_REGS_EXT_MARCSTATE, &data, 1);
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARCSTATE, &data, 1);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI strobe test failed.\n");
@@ -283,22 +284,23 @@ cc1120_status_code cc1120_test_spi_strobe() {
  * Writes to the FIFO and then does a direct read to see if the write was successful.
  * Wries directly to the FIFO and then reads the FIFO to see if the write was successful.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If the FIFO read and write tests pass.
  * @return An error code - If the FIFO read and write tests fail.
  */
-cc1120_status_code cc1120_test_fifo_read_write() {
+cc1120_status_code cc1120_test_fifo_read_write(cc1120_dev_t *dev) {
     cc1120_status_code status;
     uint8_t w_data = 0x0AU;
     uint8_t r_data;
 
-    status = cc1120_write_fifo(&w_data, 1);
+    status = cc1120_write_fifo(dev, &w_data, 1);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
         return status;
     } 
     
-    status = cc1120_read_fifo_direct(CC1120_FIFO_TX_START, &r_data, 1);
+    status = cc1120_read_fifo_direct(dev, CC1120_FIFO_TX_START, &r_data, 1);
 
     if (status != CC1120_ERROR_CODE_SUCCESS) {
         mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
@@ -315,14 +317,14 @@ cc1120_status_code cc1120_test_fifo_read_write() {
         uint8_t burstWriteData[3] = {0x0BU, 0x0CU, 0x0DU};
         uint8_t burstReadData[3];
 
-        status = cc1120_write_fifo(burstWriteData, 3);
+        status = cc1120_write_fifo(dev, burstWriteData, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
             return status;
         } 
 
-        status = cc1120_read_fifo_direct(CC1120_FIFO_TX_START+1, burstReadData, 3);
+        status = cc1120_read_fifo_direct(dev, CC1120_FIFO_TX_START+1, burstReadData, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
@@ -342,28 +344,28 @@ cc1120_status_code cc1120_test_fifo_read_write() {
         uint8_t ignore;
         w_data = 0x0EU;
 
-        status = cc1120_write_ext_addr_spi(CC1120_REGS_EXT_RXLAST, &rxLastPos, 1);
+        status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_RXLAST, &rxLastPos, 1);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
             return status;
         } 
 
-        status = cc1120_write_fifo_direct(CC1120_FIFO_RX_START, &w_data, 1);
+        status = cc1120_write_fifo_direct(dev, CC1120_FIFO_RX_START, &w_data, 1);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
             return status;
         } 
 
-        status = cc1120_read_fifo(&ignore, 1);
+        status = cc1120_read_fifo(dev, &ignore, 1);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
             return status;
         } 
 
-        status = cc1120_read_fifo(&r_data, 1);
+        status = cc1120_read_fifo(dev, &r_data, 1);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
@@ -383,14 +385,14 @@ cc1120_status_code cc1120_test_fifo_read_write() {
         uint8_t burstReadData2[3];
         bool incorrectValues = false;
         
-        status = cc1120_write_fifo_direct(CC1120_FIFO_RX_START+1, burstWriteData2, 3);
+        status = cc1120_write_fifo_direct(dev, CC1120_FIFO_RX_START+1, burstWriteData2, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
             return status; 
         }
 
-        status = cc1120_read_fifo(burstReadData2, 3);
+        status = cc1120_read_fifo(dev, burstReadData2, 3);
 
         if (status != CC1120_ERROR_CODE_SUCCESS) {
             mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 FIFO test failed.\n");
@@ -409,3 +411,36 @@ cc1120_status_code cc1120_test_fifo_read_write() {
     
     return status;
 }
+
+/**
+ * @brief Measures the average time per byte of SPI burst reads, including the driver overhead.
+ * Burst reads the standard register space CC1120_TEST_SPI_BYTE_TIME_REPS times.
+ * Compare platform builds with and without CC1120_HAL_FUNCTION_TABLE to see the dispatch cost.
+ * Host builds always dispatch through the transport ops, so the flag changes nothing there.
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @param nsPerByte - A pointer to store the average time per byte in nanoseconds.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reads were successful.
+ * @return An error code - If the status byte is invalid.
+ */
+cc1120_status_code cc1120_test_spi_byte_time(cc1120_dev_t *dev, uint32_t *nsPerByte) {
+    cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
+    uint8_t burstData[CC1120_REGS_EXT_ADDR];
+
+    uint32_t start = mcu_get_time_us();
+    uint8_t i;
+    for (i = 0; i < CC1120_TEST_SPI_BYTE_TIME_REPS; i++) {
+        status = cc1120_read_spi(dev, 0x00U, burstData, CC1120_REGS_EXT_ADDR);
+        if (status != CC1120_ERROR_CODE_SUCCESS) {
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "CC1120 SPI byte time test failed.\n");
+            return status;
+        }
+    }
+    uint32_t elapsed = mcu_get_time_us() - start;
+
+    // Each burst is the header byte followed by the data
+    *nsPerByte = elapsed * 1000UL / (CC1120_TEST_SPI_BYTE_TIME_REPS * (CC1120_REGS_EXT_ADDR + 1UL));
+    mcu_log(CC1120_LOG_LEVEL_INFO, "CC1120 SPI byte time: %lu ns\n", (unsigned long)*nsPerByte);
+
+    return status;
+}
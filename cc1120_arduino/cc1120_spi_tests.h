@@ -3,8 +3,14 @@
 
 #include <stdbool.h>
 #include "cc1120_spi.h"
+#include "cc1120_regs.h"
 #include "cc1120_logging.h"
 
+#define CC1120_TEST_SPI_BYTE_TIME_REPS 16U
+
+/* Reset values of the standard register space */
+extern uint8_t CC1120_REGS_DEFAULTS[CC1120_REGS_STD_SPACE_SIZE];
+
 /**
  * @brief E2E test for SPI read function.
  * Reads through all registers up to the extended register space,
@@ -12,11 +18,12 @@
  * Burst reads all the values and compares them to the default values.
  * Burst reads FREQ registers in extended address space and compares them to defaults.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If all registers are read correctly and have the right value.
  * @return An error code - If any register does not have the expected value,
  *                 or status byte is invalid.
  */
-cc1120_status_code cc1120_test_spi_read();
+cc1120_status_code cc1120_test_spi_read(cc1120_dev_t *dev);
 
 /**
  * @brief E2E test for SPI write function.
@@ -25,29 +32,45 @@ cc1120_status_code cc1120_test_spi_read();
  * Burst writes to the sync word registers, then burst reads to see if the writes were successful.
  * Burst writes to the FREQ registers, then burst reads to see if the writes were successful.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If both writes are successful.
  * @return An error code - If any register does not have the expected value,
  *                 or status byte is invalid.
  */
-cc1120_status_code cc1120_test_spi_write();
+cc1120_status_code cc1120_test_spi_write(cc1120_dev_t *dev);
 
 /**
  * @brief E2E test for SPI strobe functionality.
  * Runs the reset strobe and checks the MARCSTATE register.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If MARCSTATE is 0x41 after reset.
  * @return An error code - If MARCSTATE is not 0x41 after reset, or status byte is invalid.
  */
-cc1120_status_code cc1120_test_spi_strobe();
+cc1120_status_code cc1120_test_spi_strobe(cc1120_dev_t *dev);
 
 /**
  * @brief - E2E test for the CC1120's FIFO read and write functionality.
  * Writes to the FIFO and then does a direct read to see if the write was successful.
  * Wries directly to the FIFO and then reads the FIFO to see if the write was successful.
  * 
+ * @param dev - The CC1120 to talk to.
  * @return CC1120_ERROR_CODE_SUCCESS - If the FIFO read and write tests pass.
  * @return An error code - If the FIFO read and write tests fail.
  */
-cc1120_status_code cc1120_test_fifo_read_write();
+cc1120_status_code cc1120_test_fifo_read_write(cc1120_dev_t *dev);
+
+/**
+ * @brief Measures the average time per byte of SPI burst reads, including the driver overhead.
+ * Burst reads the standard register space CC1120_TEST_SPI_BYTE_TIME_REPS times.
+ * Compare platform builds with and without CC1120_HAL_FUNCTION_TABLE to see the dispatch cost.
+ * Host builds always dispatch through the transport ops, so the flag changes nothing there.
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @param nsPerByte - A pointer to store the average time per byte in nanoseconds.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reads were successful.
+ * @return An error code - If the status byte is invalid.
+ */
+cc1120_status_code cc1120_test_spi_byte_time(cc1120_dev_t *dev, uint32_t *nsPerByte);
 
 #endif /* CC1120_SPI_TESTS_H */
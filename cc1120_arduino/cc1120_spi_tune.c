@@ -0,0 +1,185 @@
+#include "cc1120_spi_tune.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_hal.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Each pattern is written alternating with its complement, so every data line toggles */
+static const uint8_t CC1120_SPI_TUNE_PATTERNS[] = {0x55U, 0x00U, 0x0FU, 0x96U, 0x33U};
+
+/**
+ * @brief Writes a pattern with one kind of access and reads it back.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param access - The kind of access to use.
+ * @param pattern - The pattern to write.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the pattern was read back intact.
+ * @return CC1120_ERROR_CODE_SPI_TUNE_FAILED - If the read back data differs.
+ * @return An error code - If an SPI transfer failed.
+ */
+static cc1120_status_code cc1120_spi_tune_verify(cc1120_dev_t *dev, cc1120_spi_access_t access, uint8_t pattern) {
+    cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
+    uint8_t written[CC1120_SPI_TUNE_FIFO_LEN];
+    uint8_t read[CC1120_SPI_TUNE_FIFO_LEN];
+    uint8_t len;
+    uint8_t i;
+
+    for (i = 0; i < CC1120_SPI_TUNE_FIFO_LEN; i++)
+        written[i] = (i & 1) ? (uint8_t)~pattern : pattern;
+
+    switch (access) {
+        case CC1120_SPI_ACCESS_SINGLE:
+            len = 4;
+            for (i = 0; i < len && status == CC1120_ERROR_CODE_SUCCESS; i++) {
+                status = cc1120_write_spi(dev, CC1120_REGS_SYNC3 + i, &written[i], 1);
+                if (status == CC1120_ERROR_CODE_SUCCESS)
+                    status = cc1120_read_spi(dev, CC1120_REGS_SYNC3 + i, &read[i], 1);
+            }
+            break;
+        case CC1120_SPI_ACCESS_BURST:
+            len = 4;
+            status = cc1120_write_spi(dev, CC1120_REGS_SYNC3, written, len);
+            if (status == CC1120_ERROR_CODE_SUCCESS)
+                status = cc1120_read_spi(dev, CC1120_REGS_SYNC3, read, len);
+            break;
+        case CC1120_SPI_ACCESS_EXT:
+            len = 2;
+            status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQOFF1, written, len);
+            if (status == CC1120_ERROR_CODE_SUCCESS)
+                status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FREQOFF1, read, len);
+            break;
+        default:
+            len = CC1120_SPI_TUNE_FIFO_LEN;
+            status = cc1120_write_fifo_direct(dev, CC1120_FIFO_TX_START, written, len);
+            if (status == CC1120_ERROR_CODE_SUCCESS)
+                status = cc1120_read_fifo_direct(dev, CC1120_FIFO_TX_START, read, len);
+            break;
+    }
+    RETURN_IF_ERROR(status)
+
+    if (memcmp(written, read, len))
+        return CC1120_ERROR_CODE_SPI_TUNE_FAILED;
+
+    return status;
+}
+
+/**
+ * @brief Finds the fastest reliable SPI clock for one kind of access and stores it in dev->spiClockHz.
+ * Climbs the candidate rates, writing and reading back patterns until one fails,
+ * then settles marginSteps candidates below the fastest rate that passed.
+ * Uses SYNC3..0, FREQOFF1/0 and the start of the TX FIFO memory as scratch, and restores the registers.
+ * Access types that have not been tuned yet are set to the slowest candidate.
+ * The radio should be in IDLE with an empty TX FIFO.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param access - The kind of access to tune.
+ * @param maxHz - The fastest rate to try.
+ * @param marginSteps - The number of candidates to step back from the fastest passing rate.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a rate was found.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the bus clock cannot be changed.
+ * @return CC1120_ERROR_CODE_SPI_TUNE_FAILED - If even the slowest candidate failed.
+ * @return An error code - If restoring the scratch registers failed.
+ */
+cc1120_status_code cc1120_spi_tune_access(cc1120_dev_t *dev, cc1120_spi_access_t access, uint32_t maxHz, uint8_t marginSteps) {
+    cc1120_status_code status;
+    uint8_t sync[4];
+    uint8_t freqOff[2];
+    uint32_t passed[CC1120_SPI_TUNE_STEPS];
+    uint8_t numPassed = 0;
+    uint32_t lastApplied = 0;
+
+    if (access >= CC1120_SPI_ACCESS_COUNT) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_spi_tune_access: Not a valid access type!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // Pin access types that have not been tuned yet to the slowest candidate, so the scratch
+    // registers are not saved or restored at whatever rate the bus was last left at
+    uint8_t i;
+    for (i = 0; i < CC1120_SPI_ACCESS_COUNT; i++) {
+        if (dev->spiClockHz[i] == 0)
+            dev->spiClockHz[i] = maxHz >> (CC1120_SPI_TUNE_STEPS - 1);
+    }
+
+    status = cc1120_read_spi(dev, CC1120_REGS_SYNC3, sync, 4);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_FREQOFF1, freqOff, 2);
+    RETURN_IF_ERROR(status)
+
+    uint32_t saved = dev->spiClockHz[access];
+
+    int8_t n;
+    for (n = CC1120_SPI_TUNE_STEPS - 1; n >= 0; n--) {
+        uint32_t hz = maxHz >> n;
+        uint32_t applied = cc1120_hal_set_clock(dev, hz);
+
+        if (applied == 0) {
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_spi_tune_access: The bus clock cannot be changed!\n");
+            return CC1120_ERROR_CODE_INVALID_PARAM;
+        }
+
+        // The bus may round several candidates to the same rate
+        if (applied == lastApplied)
+            continue;
+        lastApplied = applied;
+        dev->spiClockHz[access] = hz;
+
+        bool ok = true;
+        uint8_t rep;
+        uint8_t p;
+        for (rep = 0; rep < CC1120_SPI_TUNE_REPEATS && ok; rep++) {
+            for (p = 0; p < sizeof(CC1120_SPI_TUNE_PATTERNS) && ok; p++)
+                ok = cc1120_spi_tune_verify(dev, access, CC1120_SPI_TUNE_PATTERNS[p]) == CC1120_ERROR_CODE_SUCCESS;
+        }
+
+        if (!ok)
+            break;
+        passed[numPassed++] = hz;
+    }
+
+    if (numPassed > 0) {
+        uint8_t back = (marginSteps < numPassed) ? marginSteps : numPassed - 1;
+        dev->spiClockHz[access] = passed[numPassed - 1 - back];
+        mcu_log(CC1120_LOG_LEVEL_INFO, "cc1120_spi_tune_access: Access type %u tuned to %lu Hz\n",
+                access, (unsigned long)dev->spiClockHz[access]);
+    } else {
+        dev->spiClockHz[access] = saved;
+    }
+
+    status = cc1120_write_spi(dev, CC1120_REGS_SYNC3, sync, 4);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_write_ext_addr_spi(dev, CC1120_REGS_EXT_FREQOFF1, freqOff, 2);
+    RETURN_IF_ERROR(status)
+
+    if (numPassed == 0) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_spi_tune_access: No reliable rate for access type %u!\n", access);
+        return CC1120_ERROR_CODE_SPI_TUNE_FAILED;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Tunes the SPI clock for every kind of access. See cc1120_spi_tune_access.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param maxHz - The fastest rate to try.
+ * @param marginSteps - The number of candidates to step back from the fastest passing rate.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a rate was found for every kind of access.
+ * @return An error code - If tuning any kind of access failed.
+ */
+cc1120_status_code cc1120_spi_tune(cc1120_dev_t *dev, uint32_t maxHz, uint8_t marginSteps) {
+    cc1120_status_code status = CC1120_ERROR_CODE_SUCCESS;
+
+    uint8_t access;
+    for (access = 0; access < CC1120_SPI_ACCESS_COUNT; access++) {
+        status = cc1120_spi_tune_access(dev, (cc1120_spi_access_t)access, maxHz, marginSteps);
+        RETURN_IF_ERROR(status)
+    }
+
+    return status;
+}
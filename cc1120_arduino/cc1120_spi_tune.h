@@ -0,0 +1,52 @@
+#ifndef CC1120_SPI_TUNE_H
+#define CC1120_SPI_TUNE_H
+
+#include <stdint.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/* Fastest SCLK in the SPI timing table of the datasheet */
+#define CC1120_SPI_MAX_HZ 10000000UL
+
+/* Candidate rates are maxHz / 2^n for n = CC1120_SPI_TUNE_STEPS - 1 .. 0 */
+#define CC1120_SPI_TUNE_STEPS 6U
+
+/* Times every pattern is written and read back at a candidate rate */
+#define CC1120_SPI_TUNE_REPEATS 8U
+
+/* Bytes written per FIFO pattern */
+#define CC1120_SPI_TUNE_FIFO_LEN 16U
+
+#define CC1120_SPI_TUNE_DEFAULT_MARGIN_STEPS 1U
+
+/**
+ * @brief Finds the fastest reliable SPI clock for one kind of access and stores it in dev->spiClockHz.
+ * Climbs the candidate rates, writing and reading back patterns until one fails,
+ * then settles marginSteps candidates below the fastest rate that passed.
+ * Uses SYNC3..0, FREQOFF1/0 and the start of the TX FIFO memory as scratch, and restores the registers.
+ * Access types that have not been tuned yet are set to the slowest candidate.
+ * The radio should be in IDLE with an empty TX FIFO.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param access - The kind of access to tune.
+ * @param maxHz - The fastest rate to try.
+ * @param marginSteps - The number of candidates to step back from the fastest passing rate.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a rate was found.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the bus clock cannot be changed.
+ * @return CC1120_ERROR_CODE_SPI_TUNE_FAILED - If even the slowest candidate failed.
+ * @return An error code - If restoring the scratch registers failed.
+ */
+cc1120_status_code cc1120_spi_tune_access(cc1120_dev_t *dev, cc1120_spi_access_t access, uint32_t maxHz, uint8_t marginSteps);
+
+/**
+ * @brief Tunes the SPI clock for every kind of access. See cc1120_spi_tune_access.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param maxHz - The fastest rate to try.
+ * @param marginSteps - The number of candidates to step back from the fastest passing rate.
+ * @return CC1120_ERROR_CODE_SUCCESS - If a rate was found for every kind of access.
+ * @return An error code - If tuning any kind of access failed.
+ */
+cc1120_status_code cc1120_spi_tune(cc1120_dev_t *dev, uint32_t maxHz, uint8_t marginSteps);
+
+#endif /* CC1120_SPI_TUNE_H */
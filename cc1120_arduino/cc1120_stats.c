@@ -0,0 +1,205 @@
+#include "cc1120_stats.h"
+#include "cc1120_hal.h"
+#include "cc1120_regs.h"
+#include "cc1120_rate.h"
+#include <string.h>
+
+/**
+ * @brief Clears the counts, with the link extremes set so that the first packet replaces them.
+ *
+ * @param counts - The counts.
+ */
+static void cc1120_stats_clear(cc1120_stats_counts_t *counts) {
+    memset(counts, 0, sizeof(*counts));
+    counts->rssiMin = INT16_MAX;
+    counts->rssiMax = INT16_MIN;
+    counts->lqiMin = UINT8_MAX;
+}
+
+/**
+ * @brief Writes a 16-bit little-endian field, saturating the count.
+ *
+ * @param p - Where to write.
+ * @param val - The count.
+ */
+static void cc1120_stats_put_u16(uint8_t *p, uint32_t val) {
+    if (val > UINT16_MAX)
+        val = UINT16_MAX;
+
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+}
+
+/**
+ * @brief Writes a 32-bit little-endian field.
+ *
+ * @param p - Where to write.
+ * @param val - The value.
+ */
+static void cc1120_stats_put_u32(uint8_t *p, uint32_t val) {
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+    p[2] = (uint8_t)(val >> 16);
+    p[3] = (uint8_t)(val >> 24);
+}
+
+/**
+ * @brief Clamps an RSSI to the signed byte of the record.
+ *
+ * @param dbm - The RSSI in dBm.
+ * @return uint8_t - The record byte.
+ */
+static uint8_t cc1120_stats_rssi_byte(int32_t dbm) {
+    if (dbm <= INT8_MIN)
+        dbm = INT8_MIN + 1;
+    else if (dbm > INT8_MAX)
+        dbm = INT8_MAX;
+
+    return (uint8_t)(int8_t)dbm;
+}
+
+/**
+ * @brief Initializes the statistics of a radio and attaches them, so that the driver updates them.
+ *
+ * @param stats - The statistics, which must outlive their use by the driver.
+ * @param dev - The radio whose driver counters go in the record.
+ * @param nowUs - The current time.
+ */
+void cc1120_stats_init(cc1120_stats_t *stats, cc1120_dev_t *dev, uint32_t nowUs) {
+    memset(stats, 0, sizeof(*stats));
+    cc1120_stats_clear(&stats->counts);
+    stats->dev = dev;
+    stats->state = CC1120_STATE_IDLE;
+    stats->stateSinceUs = nowUs;
+    stats->periodStartUs = nowUs;
+    stats->fifoBase = dev->fifoStats;
+    stats->chipReadyRetriesBase = dev->stats.chipReadyRetries;
+    dev->linkStats = stats;
+}
+
+/**
+ * @brief Counts a packet sent.
+ *
+ * @param stats - The statistics.
+ * @param len - The payload length in bytes.
+ */
+void cc1120_stats_on_tx(cc1120_stats_t *stats, uint32_t len) {
+    stats->counts.packetsSent++;
+    stats->counts.bytesSent += len;
+}
+
+/**
+ * @brief Counts a packet received, from the two status bytes the CC1120 appends.
+ * RSSI and LQI include packets that failed CRC, since they describe the link.
+ *
+ * @param stats - The statistics.
+ * @param len - The payload length in bytes.
+ * @param status - The RSSI and CRC_OK/LQI bytes appended by the CC1120.
+ */
+void cc1120_stats_on_rx(cc1120_stats_t *stats, uint32_t len, const uint8_t status[2]) {
+    cc1120_stats_counts_t *counts = &stats->counts;
+    int16_t rssiDbm = (int16_t)((int8_t)status[0]) - CC1120_RSSI_OFFSET_DB;
+    uint8_t lqi = status[1] & CC1120_STATUS_LQI_MASK;
+
+    if (status[1] & CC1120_STATUS_CRC_OK) {
+        counts->packetsReceived++;
+        counts->bytesReceived += len;
+    } else {
+        counts->crcFailures++;
+    }
+
+    counts->linkSamples++;
+    counts->rssiSum += rssiDbm;
+    if (rssiDbm < counts->rssiMin)
+        counts->rssiMin = rssiDbm;
+    if (rssiDbm > counts->rssiMax)
+        counts->rssiMax = rssiDbm;
+
+    counts->lqiSum += lqi;
+    if (lqi < counts->lqiMin)
+        counts->lqiMin = lqi;
+    if (lqi > counts->lqiMax)
+        counts->lqiMax = lqi;
+}
+
+/**
+ * @brief Notes a radio state change, adding the time spent in the previous state to TX or RX time.
+ *
+ * @param stats - The statistics.
+ * @param state - The new STATE field of the status byte, e.g. dev->lastStatus & CC1120_STATE_MASK.
+ * @param nowUs - The time of the change.
+ */
+void cc1120_stats_on_state(cc1120_stats_t *stats, uint8_t state, uint32_t nowUs) {
+    uint32_t elapsed = nowUs - stats->stateSinceUs;
+
+    if (stats->state == CC1120_STATE_TX)
+        stats->counts.txTimeUs += elapsed;
+    else if (stats->state == CC1120_STATE_RX)
+        stats->counts.rxTimeUs += elapsed;
+
+    stats->state = state;
+    stats->stateSinceUs = nowUs;
+}
+
+/**
+ * @brief Serializes the statistics since the last snapshot into a record and clears them.
+ * The copy and clear are atomic against ISRs updating the statistics.
+ *
+ * @param stats - The statistics.
+ * @param nowUs - The current time, which ends the period.
+ * @param record - Filled with CC1120_STATS_RECORD_LEN bytes.
+ */
+void cc1120_stats_snapshot(cc1120_stats_t *stats, uint32_t nowUs, uint8_t record[CC1120_STATS_RECORD_LEN]) {
+    cc1120_stats_counts_t counts;
+    cc1120_dev_fifo_stats_t fifo;
+    uint32_t chipReadyRetries;
+
+    uint32_t irq = cc1120_hal_irq_save();
+    // Close the current state so its time so far lands in this period
+    cc1120_stats_on_state(stats, stats->state, nowUs);
+    counts = stats->counts;
+    cc1120_stats_clear(&stats->counts);
+    uint32_t periodUs = nowUs - stats->periodStartUs;
+    stats->periodStartUs = nowUs;
+    fifo = stats->dev->fifoStats;
+    chipReadyRetries = stats->dev->stats.chipReadyRetries;
+    cc1120_hal_irq_restore(irq);
+
+    // The driver counters only grow, so the period's events are the difference from the last snapshot
+    record[0] = CC1120_STATS_RECORD_VERSION;
+    record[1] = 0;
+    cc1120_stats_put_u16(&record[2], counts.packetsSent);
+    cc1120_stats_put_u16(&record[4], counts.packetsReceived);
+    cc1120_stats_put_u32(&record[6], counts.bytesSent);
+    cc1120_stats_put_u32(&record[10], counts.bytesReceived);
+    cc1120_stats_put_u16(&record[14], counts.crcFailures);
+    cc1120_stats_put_u16(&record[16], fifo.txUnderflows - stats->fifoBase.txUnderflows);
+    cc1120_stats_put_u16(&record[18], fifo.txOverflows - stats->fifoBase.txOverflows);
+    cc1120_stats_put_u16(&record[20], fifo.rxOverflows - stats->fifoBase.rxOverflows);
+    cc1120_stats_put_u16(&record[22], fifo.rxUnderflows - stats->fifoBase.rxUnderflows);
+    cc1120_stats_put_u16(&record[24], chipReadyRetries - stats->chipReadyRetriesBase);
+    cc1120_stats_put_u16(&record[26], fifo.recoveries - stats->fifoBase.recoveries);
+    cc1120_stats_put_u32(&record[28], periodUs / 1000UL);
+    cc1120_stats_put_u32(&record[32], counts.txTimeUs / 1000UL);
+    cc1120_stats_put_u32(&record[36], counts.rxTimeUs / 1000UL);
+
+    stats->fifoBase = fifo;
+    stats->chipReadyRetriesBase = chipReadyRetries;
+
+    if (counts.linkSamples == 0) {
+        record[40] = (uint8_t)CC1120_STATS_RSSI_NONE;
+        record[41] = (uint8_t)CC1120_STATS_RSSI_NONE;
+        record[42] = (uint8_t)CC1120_STATS_RSSI_NONE;
+        record[43] = CC1120_STATS_LQI_NONE;
+        record[44] = CC1120_STATS_LQI_NONE;
+        record[45] = CC1120_STATS_LQI_NONE;
+        return;
+    }
+
+    record[40] = cc1120_stats_rssi_byte(counts.rssiMin);
+    record[41] = cc1120_stats_rssi_byte(counts.rssiSum / (int32_t)counts.linkSamples);
+    record[42] = cc1120_stats_rssi_byte(counts.rssiMax);
+    record[43] = counts.lqiMin;
+    record[44] = (uint8_t)(counts.lqiSum / counts.linkSamples);
+    record[45] = counts.lqiMax;
+}
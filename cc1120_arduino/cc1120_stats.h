@@ -0,0 +1,116 @@
+#ifndef CC1120_STATS_H
+#define CC1120_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_dev.h"
+
+/*
+ * Link statistics for telemetry. cc1120_stats_init attaches them to a radio, and the driver then updates
+ * them: cc1120_send and cc1120_tx_load count packets sent, cc1120_receive counts packets received with
+ * appended status, and the STX, SRX and SIDLE strobes, state reads, FIFO checks and recoveries time TX and RX. Each update has a
+ * single writer, the ISR or the main loop, and cc1120_stats_snapshot copies and clears them with
+ * interrupts masked.
+ * Times are kept in microseconds and wrap after 71 minutes, so take a snapshot at least once per pass.
+ *
+ * Record layout, little-endian, CC1120_STATS_RECORD_LEN bytes:
+ *   0  u8  version, CC1120_STATS_RECORD_VERSION
+ *   1  u8  reserved, 0
+ *   2  u16 packets sent
+ *   4  u16 packets received with CRC OK
+ *   6  u32 bytes sent
+ *   10 u32 bytes received with CRC OK
+ *   14 u16 CRC failures
+ *   16 u16 TX FIFO underflows
+ *   18 u16 TX FIFO overflows
+ *   20 u16 RX FIFO overflows
+ *   22 u16 RX FIFO underflows
+ *   24 u16 chip-ready retries
+ *   26 u16 FIFO error recoveries
+ *   28 u32 period since the last snapshot in ms
+ *   32 u32 time in TX in ms
+ *   36 u32 time in RX in ms
+ *   40 i8  RSSI min, avg, max in dBm, CC1120_STATS_RSSI_NONE with no packets
+ *   43 u8  LQI min, avg, max, CC1120_STATS_LQI_NONE with no packets
+ * 16-bit counts saturate rather than wrap.
+ */
+#define CC1120_STATS_RECORD_VERSION 1U
+#define CC1120_STATS_RECORD_LEN 46U
+
+#define CC1120_STATS_RSSI_NONE INT8_MIN
+#define CC1120_STATS_LQI_NONE 0xFFU
+
+typedef struct {
+    uint32_t packetsSent;
+    uint32_t bytesSent;
+    uint32_t packetsReceived;
+    uint32_t bytesReceived;
+    uint32_t crcFailures;
+    uint32_t txTimeUs;
+    uint32_t rxTimeUs;
+    int16_t rssiMin;
+    int16_t rssiMax;
+    int32_t rssiSum;
+    uint32_t linkSamples;       /* Packets in the RSSI and LQI sums, CRC failures included */
+    uint8_t lqiMin;
+    uint8_t lqiMax;
+    uint32_t lqiSum;
+} cc1120_stats_counts_t;
+
+struct cc1120_stats {
+    cc1120_dev_t *dev;
+    cc1120_stats_counts_t counts;
+    uint8_t state;              /* Status byte STATE being timed */
+    uint32_t stateSinceUs;
+    uint32_t periodStartUs;
+    cc1120_dev_fifo_stats_t fifoBase;   /* Driver counters at the last snapshot */
+    uint32_t chipReadyRetriesBase;
+};
+
+/**
+ * @brief Initializes the statistics of a radio and attaches them, so that the driver updates them.
+ *
+ * @param stats - The statistics, which must outlive their use by the driver.
+ * @param dev - The radio whose driver counters go in the record.
+ * @param nowUs - The current time.
+ */
+void cc1120_stats_init(cc1120_stats_t *stats, cc1120_dev_t *dev, uint32_t nowUs);
+
+/**
+ * @brief Counts a packet sent.
+ *
+ * @param stats - The statistics.
+ * @param len - The payload length in bytes.
+ */
+void cc1120_stats_on_tx(cc1120_stats_t *stats, uint32_t len);
+
+/**
+ * @brief Counts a packet received, from the two status bytes the CC1120 appends.
+ * RSSI and LQI include packets that failed CRC, since they describe the link.
+ *
+ * @param stats - The statistics.
+ * @param len - The payload length in bytes.
+ * @param status - The RSSI and CRC_OK/LQI bytes appended by the CC1120.
+ */
+void cc1120_stats_on_rx(cc1120_stats_t *stats, uint32_t len, const uint8_t status[2]);
+
+/**
+ * @brief Notes a radio state change, adding the time spent in the previous state to TX or RX time.
+ *
+ * @param stats - The statistics.
+ * @param state - The new STATE field of the status byte, e.g. dev->lastStatus & CC1120_STATE_MASK.
+ * @param nowUs - The time of the change.
+ */
+void cc1120_stats_on_state(cc1120_stats_t *stats, uint8_t state, uint32_t nowUs);
+
+/**
+ * @brief Serializes the statistics since the last snapshot into a record and clears them.
+ * The copy and clear are atomic against ISRs updating the statistics.
+ *
+ * @param stats - The statistics.
+ * @param nowUs - The current time, which ends the period.
+ * @param record - Filled with CC1120_STATS_RECORD_LEN bytes.
+ */
+void cc1120_stats_snapshot(cc1120_stats_t *stats, uint32_t nowUs, uint8_t record[CC1120_STATS_RECORD_LEN]);
+
+#endif /* CC1120_STATS_H */
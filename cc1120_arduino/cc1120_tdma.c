@@ -0,0 +1,248 @@
+#include "cc1120_tdma.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_txrx.h"
+
+/**
+ * @brief Strobes STX for the armed packet and notes when it happened.
+ *
+ * @param tdma - The schedule.
+ */
+static void cc1120_tdma_strobe(cc1120_tdma_t *tdma) {
+    tdma->armed = false;
+    tdma->strobedUs = mcu_get_time_us();
+
+    // Late enough that the preamble starts past the guard time
+    if ((int32_t)(tdma->strobedUs - tdma->strobeAtUs) > (int32_t)tdma->guardUs)
+        tdma->missed++;
+
+    tdma->sent = cc1120_strobe_spi(tdma->dev, CC1120_STROBE_STX) == CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Initializes a TDMA schedule. The frame starts at time 0 until
+ * cc1120_tdma_set_epoch or cc1120_tdma_align_to_sync is called.
+ *
+ * @param tdma - The schedule to initialize.
+ * @param dev - The CC1120 to transmit on.
+ * @param slotUs - The length of a slot.
+ * @param numSlots - The number of slots per frame.
+ * @param guardUs - The time from slot start to the first preamble bit.
+ * @param syncLeadUs - The airtime of the preamble and sync word.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the schedule was initialized.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If there are no slots, or the guard time does not fit in a slot.
+ */
+cc1120_status_code cc1120_tdma_init(cc1120_tdma_t *tdma, cc1120_dev_t *dev, uint32_t slotUs, uint8_t numSlots,
+                                    uint32_t guardUs, uint32_t syncLeadUs) {
+    if (numSlots == 0 || guardUs >= slotUs) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_tdma_init: Not a valid slot layout!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    tdma->dev = dev;
+    tdma->slotUs = slotUs;
+    tdma->numSlots = numSlots;
+    tdma->guardUs = guardUs;
+    tdma->syncLeadUs = syncLeadUs;
+    tdma->strobeLeadUs = CC1120_TDMA_DEFAULT_STROBE_LEAD_US;
+    tdma->settling = CC1120_TDMA_SETTLE_SAMPLES;
+    tdma->epochUs = 0;
+    tdma->armed = false;
+    tdma->sent = false;
+    tdma->timerStarted = false;
+    tdma->lastSyncUs = 0;
+    cc1120_tdma_reset_stats(tdma);
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Sets the start of slot 0.
+ *
+ * @param tdma - The schedule.
+ * @param epochUs - The mcu_get_time_us time at which some frame starts.
+ */
+void cc1120_tdma_set_epoch(cc1120_tdma_t *tdma, uint32_t epochUs) {
+    tdma->epochUs = epochUs;
+}
+
+/**
+ * @brief Aligns the frame to a sync word received from the station that owns a slot,
+ * for example the beacon of the frame master.
+ *
+ * @param tdma - The schedule.
+ * @param syncUs - The time of the sync word edge, e.g. lastSyncUs.
+ * @param slot - The slot the packet was sent in.
+ */
+void cc1120_tdma_align_to_sync(cc1120_tdma_t *tdma, uint32_t syncUs, uint8_t slot) {
+    tdma->epochUs = syncUs - tdma->syncLeadUs - tdma->guardUs - (uint32_t)slot * tdma->slotUs;
+}
+
+/**
+ * @brief Gets the start of the next occurrence of a slot.
+ *
+ * @param tdma - The schedule.
+ * @param slot - The slot.
+ * @param afterUs - The slot start returned is at or after this time.
+ * @return uint32_t - The mcu_get_time_us time the slot starts.
+ */
+uint32_t cc1120_tdma_next_slot_start(const cc1120_tdma_t *tdma, uint8_t slot, uint32_t afterUs) {
+    uint32_t frameUs = tdma->slotUs * tdma->numSlots;
+    uint32_t baseUs = tdma->epochUs + (uint32_t)slot * tdma->slotUs;
+
+    // Wrap-safe as long as the epoch is within 2^31 us, which cc1120_tdma_arm keeps it
+    int32_t frames = (int32_t)(afterUs - baseUs) / (int32_t)frameUs;
+    uint32_t startUs = baseUs + (uint32_t)frames * frameUs;
+    if ((int32_t)(startUs - afterUs) < 0)
+        startUs += frameUs;
+
+    return startUs;
+}
+
+/**
+ * @brief Loads a packet for the next occurrence of a slot and starts the timer that strobes STX,
+ * so the preamble starts guardUs after the slot start. The radio must be in FSTXON,
+ * e.g. as left by cc1120_tx_init, so the strobe needs no calibration.
+ * Do not use the radio from the main loop until the packet has been sent.
+ *
+ * @param tdma - The schedule.
+ * @param slot - The slot to transmit in.
+ * @param data - The packet to transmit.
+ * @param len - The size of the packet, at most CC1120_TX_FIFO_SIZE - 1.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was armed.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the slot is out of range, or a packet is already armed.
+ * @return An error code - If the packet is too long, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_tdma_arm(cc1120_tdma_t *tdma, uint8_t slot, uint8_t *data, uint8_t len) {
+    if (slot >= tdma->numSlots) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_tdma_arm: Slot out of range!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    if (tdma->armed) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_tdma_arm: A packet is already armed!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // The strobe must leave time to load the FIFO and start the timer
+    uint32_t earliestUs = mcu_get_time_us() + CC1120_TDMA_MIN_ARM_US + tdma->strobeLeadUs - tdma->guardUs;
+    uint32_t slotStartUs = cc1120_tdma_next_slot_start(tdma, slot, earliestUs);
+    tdma->epochUs = slotStartUs - (uint32_t)slot * tdma->slotUs;
+
+    cc1120_status_code status = cc1120_tx_load(tdma->dev, data, len);
+    RETURN_IF_ERROR(status)
+
+    tdma->txStartUs = slotStartUs + tdma->guardUs;
+    tdma->strobeAtUs = tdma->txStartUs - tdma->strobeLeadUs;
+    tdma->sent = false;
+    tdma->armed = true;
+    tdma->timerStarted = mcu_timer_at(tdma->strobeAtUs, cc1120_tdma_on_timer, tdma);
+
+    return status;
+}
+
+/**
+ * @brief Timer callback that strobes STX for the armed packet. Started by cc1120_tdma_arm.
+ *
+ * @param ctx - The schedule.
+ */
+void cc1120_tdma_on_timer(void *ctx) {
+    cc1120_tdma_t *tdma = (cc1120_tdma_t *)ctx;
+
+    if (tdma->armed)
+        cc1120_tdma_strobe(tdma);
+}
+
+/**
+ * @brief Strobes STX for the armed packet when the platform has no timer. Call often from the main loop;
+ * within CC1120_TDMA_SPIN_US of the strobe time it spins until the strobe is due.
+ *
+ * @param tdma - The schedule.
+ */
+void cc1120_tdma_poll(cc1120_tdma_t *tdma) {
+    if (!tdma->armed || tdma->timerStarted)
+        return;
+
+    if ((int32_t)(tdma->strobeAtUs - mcu_get_time_us()) > (int32_t)CC1120_TDMA_SPIN_US)
+        return;
+
+    while ((int32_t)(tdma->strobeAtUs - mcu_get_time_us()) > 0);
+
+    cc1120_tdma_strobe(tdma);
+}
+
+/**
+ * @brief GPIO handler that timestamps sync words and measures how far the preamble was from its slot.
+ * Map CC1120_GPIO_CFG_PKT_SYNC_RXTX on the rising edge to it with the schedule as ctx.
+ * Each measurement also corrects the strobe lead, which removes the constant part of the offset.
+ * Offsets only count as jitter once CC1120_TDMA_SETTLE_SAMPLES corrections have let the lead settle.
+ *
+ * @param ctx - The schedule.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level.
+ * @param timeUs - The time of the edge.
+ */
+void cc1120_tdma_on_pkt_sync(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs) {
+    cc1120_tdma_t *tdma = (cc1120_tdma_t *)ctx;
+    (void)gpio;
+
+    if (!level)
+        return;
+
+    tdma->lastSyncUs = timeUs;
+    if (!tdma->sent)
+        return;
+    tdma->sent = false;
+
+    int32_t offsetUs = (int32_t)(timeUs - tdma->syncLeadUs - tdma->txStartUs);
+    tdma->strobeLeadUs += offsetUs / (1 << CC1120_TDMA_LEAD_GAIN_SHIFT);
+
+    // Until the lead has settled the offsets are mostly its start-up error, which would inflate the guard
+    if (tdma->settling > 0) {
+        tdma->settling--;
+        return;
+    }
+
+    cc1120_tdma_jitter_t *jitter = &tdma->jitter;
+    if (jitter->count == 0 || offsetUs < jitter->minUs)
+        jitter->minUs = offsetUs;
+    if (jitter->count == 0 || offsetUs > jitter->maxUs)
+        jitter->maxUs = offsetUs;
+    jitter->lastUs = offsetUs;
+    jitter->totalUs += offsetUs;
+    jitter->totalAbsUs += (offsetUs < 0) ? -offsetUs : offsetUs;
+    jitter->count++;
+}
+
+/**
+ * @brief Gets the guard time the measured jitter calls for: the largest offset seen either way after the lead settled.
+ *
+ * @param tdma - The schedule.
+ * @return uint32_t - The guard time, or guardUs if nothing was measured.
+ */
+uint32_t cc1120_tdma_suggested_guard_us(const cc1120_tdma_t *tdma) {
+    const cc1120_tdma_jitter_t *jitter = &tdma->jitter;
+
+    if (jitter->count == 0)
+        return tdma->guardUs;
+
+    uint32_t early = (jitter->minUs < 0) ? (uint32_t)-jitter->minUs : 0;
+    uint32_t late = (jitter->maxUs > 0) ? (uint32_t)jitter->maxUs : 0;
+    return (early > late) ? early : late;
+}
+
+/**
+ * @brief Clears the jitter measurements and the missed slot count.
+ *
+ * @param tdma - The schedule.
+ */
+void cc1120_tdma_reset_stats(cc1120_tdma_t *tdma) {
+    tdma->jitter.count = 0;
+    tdma->jitter.lastUs = 0;
+    tdma->jitter.minUs = 0;
+    tdma->jitter.maxUs = 0;
+    tdma->jitter.totalUs = 0;
+    tdma->jitter.totalAbsUs = 0;
+    tdma->missed = 0;
+}
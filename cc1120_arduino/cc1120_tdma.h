@@ -0,0 +1,157 @@
+#ifndef CC1120_TDMA_H
+#define CC1120_TDMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/* Earliest a slot can be armed ahead of its strobe, to load the FIFO and start the timer */
+#define CC1120_TDMA_MIN_ARM_US 1000UL
+
+/* When the timer is unavailable, cc1120_tdma_poll spins for at most this long before the strobe */
+#define CC1120_TDMA_SPIN_US 2000UL
+
+/* STX to first preamble bit from FSTXON, used until it has been measured */
+#define CC1120_TDMA_DEFAULT_STROBE_LEAD_US 150L
+
+/* The strobe lead moves by 1/2^shift of each measured offset, averaging out interrupt latency */
+#define CC1120_TDMA_LEAD_GAIN_SHIFT 3
+
+/* Corrections before offsets count as jitter, enough for the lead to be within 2% of its final value */
+#define CC1120_TDMA_SETTLE_SAMPLES (4U << CC1120_TDMA_LEAD_GAIN_SHIFT)
+
+/* Offsets of the first preamble bit from where the slot put it, positive when late */
+typedef struct {
+    uint32_t count;
+    int32_t lastUs;
+    int32_t minUs;
+    int32_t maxUs;
+    int32_t totalUs;
+    uint32_t totalAbsUs;
+} cc1120_tdma_jitter_t;
+
+typedef struct {
+    cc1120_dev_t *dev;
+    uint32_t slotUs;
+    uint8_t numSlots;               /* Slots per frame */
+    uint32_t guardUs;               /* Time from slot start to the first preamble bit */
+    uint32_t syncLeadUs;            /* Airtime of the preamble and sync word */
+    int32_t strobeLeadUs;           /* Time from STX to the first preamble bit, corrected from measurements */
+    uint16_t settling;              /* Corrections left before offsets count as jitter */
+    uint32_t epochUs;               /* Start of slot 0 of some frame */
+    volatile bool armed;            /* A packet is loaded and waiting for the strobe */
+    volatile bool sent;             /* STX was strobed and the sync edge has not been seen yet */
+    bool timerStarted;
+    uint32_t txStartUs;             /* When the first preamble bit is due */
+    uint32_t strobeAtUs;
+    volatile uint32_t strobedUs;    /* When STX was actually strobed */
+    volatile uint32_t lastSyncUs;   /* Time of the last sync word edge, sent or received */
+    cc1120_tdma_jitter_t jitter;
+    uint32_t missed;                /* Slots whose strobe time had passed before it happened */
+} cc1120_tdma_t;
+
+/**
+ * @brief Initializes a TDMA schedule. The frame starts at time 0 until
+ * cc1120_tdma_set_epoch or cc1120_tdma_align_to_sync is called.
+ *
+ * @param tdma - The schedule to initialize.
+ * @param dev - The CC1120 to transmit on.
+ * @param slotUs - The length of a slot.
+ * @param numSlots - The number of slots per frame.
+ * @param guardUs - The time from slot start to the first preamble bit.
+ * @param syncLeadUs - The airtime of the preamble and sync word.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the schedule was initialized.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If there are no slots, or the guard time does not fit in a slot.
+ */
+cc1120_status_code cc1120_tdma_init(cc1120_tdma_t *tdma, cc1120_dev_t *dev, uint32_t slotUs, uint8_t numSlots,
+                                    uint32_t guardUs, uint32_t syncLeadUs);
+
+/**
+ * @brief Sets the start of slot 0.
+ *
+ * @param tdma - The schedule.
+ * @param epochUs - The mcu_get_time_us time at which some frame starts.
+ */
+void cc1120_tdma_set_epoch(cc1120_tdma_t *tdma, uint32_t epochUs);
+
+/**
+ * @brief Aligns the frame to a sync word received from the station that owns a slot,
+ * for example the beacon of the frame master.
+ *
+ * @param tdma - The schedule.
+ * @param syncUs - The time of the sync word edge, e.g. lastSyncUs.
+ * @param slot - The slot the packet was sent in.
+ */
+void cc1120_tdma_align_to_sync(cc1120_tdma_t *tdma, uint32_t syncUs, uint8_t slot);
+
+/**
+ * @brief Gets the start of the next occurrence of a slot.
+ *
+ * @param tdma - The schedule.
+ * @param slot - The slot.
+ * @param afterUs - The slot start returned is at or after this time.
+ * @return uint32_t - The mcu_get_time_us time the slot starts.
+ */
+uint32_t cc1120_tdma_next_slot_start(const cc1120_tdma_t *tdma, uint8_t slot, uint32_t afterUs);
+
+/**
+ * @brief Loads a packet for the next occurrence of a slot and starts the timer that strobes STX,
+ * so the preamble starts guardUs after the slot start. The radio must be in FSTXON,
+ * e.g. as left by cc1120_tx_init, so the strobe needs no calibration.
+ * Do not use the radio from the main loop until the packet has been sent.
+ *
+ * @param tdma - The schedule.
+ * @param slot - The slot to transmit in.
+ * @param data - The packet to transmit.
+ * @param len - The size of the packet, at most CC1120_TX_FIFO_SIZE - 1.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was armed.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the slot is out of range, or a packet is already armed.
+ * @return An error code - If the packet is too long, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_tdma_arm(cc1120_tdma_t *tdma, uint8_t slot, uint8_t *data, uint8_t len);
+
+/**
+ * @brief Timer callback that strobes STX for the armed packet. Started by cc1120_tdma_arm.
+ *
+ * @param ctx - The schedule.
+ */
+void cc1120_tdma_on_timer(void *ctx);
+
+/**
+ * @brief Strobes STX for the armed packet when the platform has no timer. Call often from the main loop;
+ * within CC1120_TDMA_SPIN_US of the strobe time it spins until the strobe is due.
+ *
+ * @param tdma - The schedule.
+ */
+void cc1120_tdma_poll(cc1120_tdma_t *tdma);
+
+/**
+ * @brief GPIO handler that timestamps sync words and measures how far the preamble was from its slot.
+ * Map CC1120_GPIO_CFG_PKT_SYNC_RXTX on the rising edge to it with the schedule as ctx.
+ * Each measurement also corrects the strobe lead, which removes the constant part of the offset.
+ * Offsets only count as jitter once CC1120_TDMA_SETTLE_SAMPLES corrections have let the lead settle.
+ *
+ * @param ctx - The schedule.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level.
+ * @param timeUs - The time of the edge.
+ */
+void cc1120_tdma_on_pkt_sync(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs);
+
+/**
+ * @brief Gets the guard time the measured jitter calls for: the largest offset seen either way after the lead settled.
+ *
+ * @param tdma - The schedule.
+ * @return uint32_t - The guard time, or guardUs if nothing was measured.
+ */
+uint32_t cc1120_tdma_suggested_guard_us(const cc1120_tdma_t *tdma);
+
+/**
+ * @brief Clears the jitter measurements and the missed slot count.
+ *
+ * @param tdma - The schedule.
+ */
+void cc1120_tdma_reset_stats(cc1120_tdma_t *tdma);
+
+#endif /* CC1120_TDMA_H */
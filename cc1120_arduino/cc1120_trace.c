@@ -0,0 +1,490 @@
+#include "cc1120_trace.h"
+#include "cc1120_regs.h"
+#include "cc1120_spi.h"
+#include "cc1120_mcu.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Bytes per BLOCK record, so that a record fits in a small ring */
+#define CC1120_TRACE_BLOCK_CHUNK 64U
+
+/* Bytes of data shown by cc1120_trace_describe */
+#define CC1120_TRACE_DESCRIBE_BYTES 8U
+
+static const char *const CC1120_TRACE_STROBES[] = {
+    "SRES", "SFSTXON", "SXOFF", "SCAL", "SRX", "STX", "SIDLE", "0x37",
+    "SWOR", "SPWD", "SFRX", "SFTX", "SWORRST", "SNOP",
+};
+
+/**
+ * @brief Writes a record to the ring, or counts it as lost if it does not fit.
+ * Reports earlier losses first, so the decoder knows where the gap is.
+ *
+ * @param trace - The recorder.
+ * @param rec - The record.
+ * @param len - The record length.
+ */
+static void cc1120_trace_put(cc1120_trace_t *trace, const uint8_t rec[], uint16_t len) {
+    uint16_t head = trace->head;
+    uint16_t used = (uint16_t)((head + trace->size - trace->tail) % trace->size);
+    uint16_t space = trace->size - 1 - used;
+    uint16_t lostLen = (trace->pendingLost != 0) ? 3 : 0;
+
+    if ((uint32_t)len + lostLen > space) {
+        if (trace->pendingLost != UINT16_MAX)
+            trace->pendingLost++;
+        trace->stats.lost++;
+        return;
+    }
+
+    if (lostLen != 0) {
+        trace->buf[head] = CC1120_TRACE_TAG_LOST;
+        head = (head + 1) % trace->size;
+        trace->buf[head] = (uint8_t)trace->pendingLost;
+        head = (head + 1) % trace->size;
+        trace->buf[head] = (uint8_t)(trace->pendingLost >> 8);
+        head = (head + 1) % trace->size;
+        trace->pendingLost = 0;
+    }
+
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        trace->buf[head] = rec[i];
+        head = (head + 1) % trace->size;
+    }
+
+    // Publish the record only once it is complete
+    trace->head = head;
+    trace->stats.records++;
+}
+
+/**
+ * @brief Records a CS edge with a timestamp.
+ *
+ * @param trace - The recorder.
+ * @param tag - CC1120_TRACE_TAG_CS_ASSERT or CC1120_TRACE_TAG_CS_DEASSERT.
+ * @param csPin - The chip select line.
+ */
+static void cc1120_trace_put_edge(cc1120_trace_t *trace, uint8_t tag, uint8_t csPin) {
+    uint8_t rec[6];
+    uint8_t n = 0;
+    uint32_t now = mcu_get_time_us();
+
+    rec[n++] = tag;
+    if (tag == CC1120_TRACE_TAG_CS_ASSERT)
+        rec[n++] = csPin;
+    rec[n++] = (uint8_t)now;
+    rec[n++] = (uint8_t)(now >> 8);
+    rec[n++] = (uint8_t)(now >> 16);
+    rec[n++] = (uint8_t)(now >> 24);
+
+    cc1120_trace_put(trace, rec, n);
+}
+
+/**
+ * @brief Transfers a byte on the traced transport and records it.
+ *
+ * @param bus - The recorder.
+ * @param data - Data to transfer
+ * @return uint8_t - Data received
+ */
+static uint8_t cc1120_trace_transfer(void *bus, uint8_t data) {
+    cc1120_trace_t *trace = (cc1120_trace_t *)bus;
+    uint8_t received = trace->ops->transfer(trace->bus, data);
+
+    if (trace->enabled) {
+        uint8_t rec[3] = { CC1120_TRACE_TAG_BYTE, data, received };
+        cc1120_trace_put(trace, rec, sizeof(rec));
+        trace->stats.bytes++;
+    }
+
+    return received;
+}
+
+/**
+ * @brief Pulls the CS pin low on the traced transport and records the edge.
+ *
+ * @param bus - The recorder.
+ * @param csPin - The chip select line.
+ */
+static void cc1120_trace_cs_assert(void *bus, uint8_t csPin) {
+    cc1120_trace_t *trace = (cc1120_trace_t *)bus;
+
+    if (trace->enabled)
+        cc1120_trace_put_edge(trace, CC1120_TRACE_TAG_CS_ASSERT, csPin);
+    trace->ops->csAssert(trace->bus, csPin);
+}
+
+/**
+ * @brief Pulls the CS pin high on the traced transport and records the edge.
+ *
+ * @param bus - The recorder.
+ * @param csPin - The chip select line.
+ */
+static void cc1120_trace_cs_deassert(void *bus, uint8_t csPin) {
+    cc1120_trace_t *trace = (cc1120_trace_t *)bus;
+
+    trace->ops->csDeassert(trace->bus, csPin);
+    if (trace->enabled)
+        cc1120_trace_put_edge(trace, CC1120_TRACE_TAG_CS_DEASSERT, csPin);
+}
+
+/**
+ * @brief Sets the SPI clock of the traced transport. Not recorded.
+ *
+ * @param bus - The recorder.
+ * @param hz - The requested rate.
+ * @return uint32_t - The rate applied, or 0 if the traced clock is fixed.
+ */
+static uint32_t cc1120_trace_set_clock(void *bus, uint32_t hz) {
+    cc1120_trace_t *trace = (cc1120_trace_t *)bus;
+
+    if (trace->ops->setClock == NULL)
+        return 0;
+    return trace->ops->setClock(trace->bus, hz);
+}
+
+/**
+ * @brief Transfers a block on the traced transport and records it in BLOCK records.
+ *
+ * @param bus - The recorder.
+ * @param tx - The bytes to send, or NULL to send zeros.
+ * @param rx - The array to store the received bytes in, or NULL to discard them.
+ * @param len - The number of bytes to transfer.
+ */
+static void cc1120_trace_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    cc1120_trace_t *trace = (cc1120_trace_t *)bus;
+    uint8_t rec[2 + 2 * CC1120_TRACE_BLOCK_CHUNK];
+    uint16_t done = 0;
+
+    while (done < len) {
+        uint8_t n = ((uint16_t)(len - done) > CC1120_TRACE_BLOCK_CHUNK) ? CC1120_TRACE_BLOCK_CHUNK : (uint8_t)(len - done);
+        uint8_t *mosi = &rec[2];
+        uint8_t *miso = &rec[2 + n];
+        uint8_t i;
+
+        if (tx != NULL)
+            memcpy(mosi, &tx[done], n);
+        else
+            memset(mosi, 0, n);
+
+        if (trace->ops->transferBlock != NULL) {
+            trace->ops->transferBlock(trace->bus, mosi, miso, n);
+        } else {
+            for (i = 0; i < n; i++)
+                miso[i] = trace->ops->transfer(trace->bus, mosi[i]);
+        }
+
+        if (rx != NULL)
+            memcpy(&rx[done], miso, n);
+
+        if (trace->enabled) {
+            rec[0] = CC1120_TRACE_TAG_BLOCK;
+            rec[1] = n;
+            cc1120_trace_put(trace, rec, 2 + 2 * n);
+            trace->stats.bytes += n;
+        }
+
+        done += n;
+    }
+}
+
+const cc1120_transport_ops_t CC1120_TRACE_TRANSPORT = {
+    cc1120_trace_transfer,
+    cc1120_trace_cs_assert,
+    cc1120_trace_cs_deassert,
+    cc1120_trace_set_clock,
+    cc1120_trace_transfer_block,
+};
+
+/**
+ * @brief Initializes a recorder on a transport. Recording starts enabled.
+ *
+ * @param trace - The recorder.
+ * @param ops - The transport to trace.
+ * @param bus - The bus handle of that transport.
+ * @param buf - The ring buffer.
+ * @param size - The size of the ring buffer, at most 65535.
+ */
+void cc1120_trace_init(cc1120_trace_t *trace, const cc1120_transport_ops_t *ops, void *bus, uint8_t buf[],
+                       uint16_t size) {
+    memset(trace, 0, sizeof(*trace));
+    trace->ops = ops;
+    trace->bus = bus;
+    trace->buf = buf;
+    trace->size = size;
+    trace->enabled = true;
+}
+
+/**
+ * @brief Starts or stops recording. The bus keeps working either way.
+ *
+ * @param trace - The recorder.
+ * @param enabled - Whether to record.
+ */
+void cc1120_trace_enable(cc1120_trace_t *trace, bool enabled) {
+    trace->enabled = enabled;
+}
+
+/**
+ * @brief Removes recorded bytes from the ring, e.g. to write them to serial.
+ *
+ * @param trace - The recorder.
+ * @param out - Filled with trace bytes.
+ * @param max - The size of out.
+ * @return uint16_t - The number of bytes removed.
+ */
+uint16_t cc1120_trace_drain(cc1120_trace_t *trace, uint8_t out[], uint16_t max) {
+    uint16_t head = trace->head;
+    uint16_t tail = trace->tail;
+    uint16_t n = 0;
+
+    while (tail != head && n < max) {
+        out[n++] = trace->buf[tail];
+        tail = (tail + 1) % trace->size;
+    }
+
+    trace->tail = tail;
+    return n;
+}
+
+/**
+ * @brief Reads a 32-bit little-endian value.
+ *
+ * @param p - The bytes.
+ * @return uint32_t - The value.
+ */
+static uint32_t cc1120_trace_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Adds a transferred byte to a transaction being decoded.
+ *
+ * @param txn - The transaction.
+ * @param mosi - The byte sent.
+ * @param miso - The byte received.
+ */
+static void cc1120_trace_txn_add(cc1120_trace_txn_t *txn, uint8_t mosi, uint8_t miso) {
+    if (txn->len < CC1120_TRACE_TXN_MAX) {
+        txn->mosi[txn->len] = mosi;
+        txn->miso[txn->len] = miso;
+    }
+    txn->len++;
+}
+
+/**
+ * @brief Splits a drained trace into transactions.
+ *
+ * @param data - The trace.
+ * @param len - The trace length.
+ * @param onTxn - Called for each complete transaction.
+ * @param ctx - Passed to onTxn.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the whole trace was decoded. A transaction cut off at the end is skipped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the trace has an unknown record.
+ */
+cc1120_status_code cc1120_trace_decode(const uint8_t data[], uint32_t len,
+                                       void (*onTxn)(void *ctx, const cc1120_trace_txn_t *txn), void *ctx) {
+    cc1120_trace_txn_t txn;
+    bool open = false;
+    uint16_t lost = 0;
+    uint32_t i = 0;
+
+    while (i < len) {
+        uint8_t tag = data[i];
+        uint32_t left = len - i - 1;
+        const uint8_t *p = &data[i + 1];
+
+        if (tag == CC1120_TRACE_TAG_CS_ASSERT && left >= 5) {
+            memset(&txn, 0, offsetof(cc1120_trace_txn_t, mosi));
+            txn.csPin = p[0];
+            txn.startUs = cc1120_trace_get_u32(&p[1]);
+            txn.lostBefore = lost;
+            lost = 0;
+            open = true;
+            i += 6;
+        } else if (tag == CC1120_TRACE_TAG_CS_DEASSERT && left >= 4) {
+            if (open) {
+                txn.endUs = cc1120_trace_get_u32(p);
+                onTxn(ctx, &txn);
+            }
+            open = false;
+            i += 5;
+        } else if (tag == CC1120_TRACE_TAG_BYTE && left >= 2) {
+            if (open)
+                cc1120_trace_txn_add(&txn, p[0], p[1]);
+            i += 3;
+        } else if (tag == CC1120_TRACE_TAG_BLOCK && left >= 1 && left >= 1 + 2 * (uint32_t)p[0]) {
+            uint8_t n = p[0];
+            uint8_t j;
+            if (open) {
+                for (j = 0; j < n; j++)
+                    cc1120_trace_txn_add(&txn, p[1 + j], p[1 + n + j]);
+            }
+            i += 2 + 2 * (uint32_t)n;
+        } else if (tag == CC1120_TRACE_TAG_LOST && left >= 2) {
+            // Part of the open transaction may be missing, so it is not reported
+            lost += (uint16_t)(p[0] | (p[1] << 8));
+            open = false;
+            i += 3;
+        } else if (tag >= CC1120_TRACE_TAG_CS_ASSERT && tag <= CC1120_TRACE_TAG_LOST) {
+            // Cut off at the end of the trace
+            break;
+        } else {
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_trace_decode: Unknown record 0x%02X!\n", tag);
+            return CC1120_ERROR_CODE_INVALID_PARAM;
+        }
+    }
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Appends formatted text to a description, stopping at the end of the buffer.
+ *
+ * @param out - The description.
+ * @param size - The size of out.
+ * @param n - The length so far, updated.
+ * @param fmt - The format.
+ * @param ... - The arguments.
+ */
+static void cc1120_trace_print(char out[], size_t size, size_t *n, const char *fmt, ...) {
+    va_list args;
+
+    if (*n >= size)
+        return;
+
+    va_start(args, fmt);
+    int written = vsnprintf(&out[*n], size - *n, fmt, args);
+    va_end(args);
+
+    if (written > 0)
+        *n += (size_t)written;
+}
+
+/**
+ * @brief Describes a transaction as a register, FIFO or strobe operation, e.g. "R EXT 0x73 = 41".
+ *
+ * @param txn - The transaction.
+ * @param out - Filled with the description.
+ * @param size - The size of out.
+ */
+void cc1120_trace_describe(const cc1120_trace_txn_t *txn, char out[], size_t size) {
+    size_t n = 0;
+    uint16_t kept = (txn->len < CC1120_TRACE_TXN_MAX) ? txn->len : CC1120_TRACE_TXN_MAX;
+
+    if (size == 0)
+        return;
+    out[0] = '\0';
+
+    cc1120_trace_print(out, size, &n, "cs%u %luus ", txn->csPin, (unsigned long)(txn->endUs - txn->startUs));
+    if (kept == 0) {
+        cc1120_trace_print(out, size, &n, "empty");
+        return;
+    }
+
+    uint8_t header = txn->mosi[0];
+    bool read = (header & (R_BIT)) != 0;
+    uint8_t addr = header & 0x3FU;
+    uint16_t dataStart = 1;
+
+    if (addr >= CC1120_STROBE_SRES && addr <= CC1120_STROBE_SNOP && kept == 1) {
+        cc1120_trace_print(out, size, &n, "STROBE %s (st 0x%02X)", CC1120_TRACE_STROBES[addr - CC1120_STROBE_SRES],
+                           txn->miso[0]);
+        return;
+    }
+
+    const char *dir = read ? "R" : "W";
+    if (addr == CC1120_REGS_EXT_ADDR && kept >= 2) {
+        cc1120_trace_print(out, size, &n, "%s EXT 0x%02X", dir, txn->mosi[1]);
+        dataStart = 2;
+    } else if (addr == CC1120_REGS_FIFO_ACCESS_DIR && kept >= 2) {
+        cc1120_trace_print(out, size, &n, "%s DIRECT FIFO 0x%02X", dir, txn->mosi[1]);
+        dataStart = 2;
+    } else if (addr == CC1120_REGS_FIFO_ACCESS_STD) {
+        cc1120_trace_print(out, size, &n, "%s FIFO", dir);
+    } else {
+        cc1120_trace_print(out, size, &n, "%s REG 0x%02X", dir, addr);
+    }
+
+    uint16_t dataLen = (txn->len > dataStart) ? txn->len - dataStart : 0;
+    cc1120_trace_print(out, size, &n, " [%u] =", dataLen);
+
+    const uint8_t *bytes = read ? txn->miso : txn->mosi;
+    uint16_t i;
+    for (i = dataStart; i < kept && i < dataStart + CC1120_TRACE_DESCRIBE_BYTES; i++)
+        cc1120_trace_print(out, size, &n, " %02X", bytes[i]);
+
+    if (dataLen > CC1120_TRACE_DESCRIBE_BYTES)
+        cc1120_trace_print(out, size, &n, " ...");
+
+    cc1120_trace_print(out, size, &n, " (st 0x%02X)", txn->miso[0]);
+}
+
+typedef struct {
+    const cc1120_transport_ops_t *ops;
+    void *bus;
+    uint8_t csPin;
+    cc1120_trace_replay_t *result;
+} cc1120_trace_replay_ctx_t;
+
+/**
+ * @brief Replays one decoded transaction and compares the MISO bytes.
+ *
+ * @param ctx - The replay context.
+ * @param txn - The transaction.
+ */
+static void cc1120_trace_replay_txn(void *ctx, const cc1120_trace_txn_t *txn) {
+    cc1120_trace_replay_ctx_t *replay = (cc1120_trace_replay_ctx_t *)ctx;
+    cc1120_trace_replay_t *result = replay->result;
+    uint8_t csPin = (replay->csPin != 0xFFU) ? replay->csPin : txn->csPin;
+    uint16_t kept = (txn->len < CC1120_TRACE_TXN_MAX) ? txn->len : CC1120_TRACE_TXN_MAX;
+    bool matched = true;
+    uint16_t i;
+
+    replay->ops->csAssert(replay->bus, csPin);
+    for (i = 0; i < kept; i++) {
+        if (replay->ops->transfer(replay->bus, txn->mosi[i]) != txn->miso[i]) {
+            result->mismatches++;
+            matched = false;
+        }
+    }
+    replay->ops->csDeassert(replay->bus, csPin);
+
+    if (!matched && result->firstMismatchTxn == UINT32_MAX)
+        result->firstMismatchTxn = result->transactions;
+
+    result->transactions++;
+    result->bytes += kept;
+}
+
+/**
+ * @brief Replays a trace against a transport, e.g. a simulated device, sending the recorded MOSI bytes
+ * and comparing what comes back with the recorded MISO bytes.
+ *
+ * @param data - The trace.
+ * @param len - The trace length.
+ * @param ops - The transport to replay on.
+ * @param bus - The bus handle of that transport.
+ * @param csPin - The chip select to use, or 0xFF to use the recorded ones.
+ * @param result - Filled with the counts.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the trace replayed and every MISO byte matched.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the trace has an unknown record.
+ * @return CC1120_ERROR_CODE_TRACE_MISMATCH - If any MISO byte differed.
+ */
+cc1120_status_code cc1120_trace_replay(const uint8_t data[], uint32_t len, const cc1120_transport_ops_t *ops,
+                                       void *bus, uint8_t csPin, cc1120_trace_replay_t *result) {
+    cc1120_trace_replay_ctx_t replay = { ops, bus, csPin, result };
+
+    memset(result, 0, sizeof(*result));
+    result->firstMismatchTxn = UINT32_MAX;
+
+    cc1120_status_code status = cc1120_trace_decode(data, len, cc1120_trace_replay_txn, &replay);
+    RETURN_IF_ERROR(status)
+
+    if (result->mismatches != 0)
+        return CC1120_ERROR_CODE_TRACE_MISMATCH;
+
+    return status;
+}
@@ -0,0 +1,142 @@
+#ifndef CC1120_TRACE_H
+#define CC1120_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/*
+ * SPI trace recorder. Wraps a transport and records every CS edge and byte into a ring buffer,
+ * which can be drained over serial while the driver runs. Install it with
+ * cc1120_dev_init(&dev, &CC1120_TRACE_TRANSPORT, &trace, csPin). On a platform, define
+ * CC1120_HAL_FUNCTION_TABLE so that the driver dispatches through the transport.
+ *
+ * Records, little-endian:
+ *   CC1120_TRACE_TAG_CS_ASSERT    u8 csPin, u32 timeUs
+ *   CC1120_TRACE_TAG_CS_DEASSERT  u32 timeUs
+ *   CC1120_TRACE_TAG_BYTE         u8 mosi, u8 miso
+ *   CC1120_TRACE_TAG_BLOCK        u8 len, len mosi bytes, len miso bytes
+ *   CC1120_TRACE_TAG_LOST         u16 records dropped because the ring was full
+ * A record is written whole or not at all, so a drained trace always decodes from its first byte.
+ */
+
+#define CC1120_TRACE_TAG_CS_ASSERT 0x01U
+#define CC1120_TRACE_TAG_CS_DEASSERT 0x02U
+#define CC1120_TRACE_TAG_BYTE 0x03U
+#define CC1120_TRACE_TAG_BLOCK 0x04U
+#define CC1120_TRACE_TAG_LOST 0x05U
+
+/* Bytes of one decoded transaction kept, enough for a header, address and a full FIFO */
+#define CC1120_TRACE_TXN_MAX 260U
+
+typedef struct {
+    uint32_t records;
+    uint32_t bytes;             /* SPI bytes recorded */
+    uint32_t lost;              /* Records dropped because the ring was full */
+} cc1120_trace_stats_t;
+
+typedef struct {
+    const cc1120_transport_ops_t *ops;  /* The transport being traced */
+    void *bus;
+    uint8_t *buf;
+    uint16_t size;
+    volatile uint16_t head;     /* Written by the recorder */
+    volatile uint16_t tail;     /* Written by cc1120_trace_drain */
+    uint16_t pendingLost;       /* Drops not yet reported with a LOST record */
+    bool enabled;
+    cc1120_trace_stats_t stats;
+} cc1120_trace_t;
+
+/* One transaction, from CS assert to CS deassert */
+typedef struct {
+    uint8_t csPin;
+    uint32_t startUs;
+    uint32_t endUs;
+    uint16_t len;               /* Bytes transferred, of which at most CC1120_TRACE_TXN_MAX are kept */
+    uint16_t lostBefore;        /* Records dropped just before this transaction */
+    uint8_t mosi[CC1120_TRACE_TXN_MAX];
+    uint8_t miso[CC1120_TRACE_TXN_MAX];
+} cc1120_trace_txn_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t mismatches;        /* MISO bytes that differed from the trace */
+    uint32_t firstMismatchTxn;  /* Index of the first transaction that differed */
+} cc1120_trace_replay_t;
+
+/* Transport that records, with a cc1120_trace_t as the bus */
+extern const cc1120_transport_ops_t CC1120_TRACE_TRANSPORT;
+
+/**
+ * @brief Initializes a recorder on a transport. Recording starts enabled.
+ *
+ * @param trace - The recorder.
+ * @param ops - The transport to trace.
+ * @param bus - The bus handle of that transport.
+ * @param buf - The ring buffer.
+ * @param size - The size of the ring buffer, at most 65535.
+ */
+void cc1120_trace_init(cc1120_trace_t *trace, const cc1120_transport_ops_t *ops, void *bus, uint8_t buf[],
+                       uint16_t size);
+
+/**
+ * @brief Starts or stops recording. The bus keeps working either way.
+ *
+ * @param trace - The recorder.
+ * @param enabled - Whether to record.
+ */
+void cc1120_trace_enable(cc1120_trace_t *trace, bool enabled);
+
+/**
+ * @brief Removes recorded bytes from the ring, e.g. to write them to serial.
+ *
+ * @param trace - The recorder.
+ * @param out - Filled with trace bytes.
+ * @param max - The size of out.
+ * @return uint16_t - The number of bytes removed.
+ */
+uint16_t cc1120_trace_drain(cc1120_trace_t *trace, uint8_t out[], uint16_t max);
+
+/**
+ * @brief Splits a drained trace into transactions.
+ *
+ * @param data - The trace.
+ * @param len - The trace length.
+ * @param onTxn - Called for each complete transaction.
+ * @param ctx - Passed to onTxn.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the whole trace was decoded. A transaction cut off at the end is skipped.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the trace has an unknown record.
+ */
+cc1120_status_code cc1120_trace_decode(const uint8_t data[], uint32_t len,
+                                       void (*onTxn)(void *ctx, const cc1120_trace_txn_t *txn), void *ctx);
+
+/**
+ * @brief Describes a transaction as a register, FIFO or strobe operation, e.g. "R EXT 0x73 = 41".
+ *
+ * @param txn - The transaction.
+ * @param out - Filled with the description.
+ * @param size - The size of out.
+ */
+void cc1120_trace_describe(const cc1120_trace_txn_t *txn, char out[], size_t size);
+
+/**
+ * @brief Replays a trace against a transport, e.g. a simulated device, sending the recorded MOSI bytes
+ * and comparing what comes back with the recorded MISO bytes.
+ *
+ * @param data - The trace.
+ * @param len - The trace length.
+ * @param ops - The transport to replay on.
+ * @param bus - The bus handle of that transport.
+ * @param csPin - The chip select to use, or 0xFF to use the recorded ones.
+ * @param result - Filled with the counts.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the trace replayed and every MISO byte matched.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the trace has an unknown record.
+ * @return CC1120_ERROR_CODE_TRACE_MISMATCH - If any MISO byte differed.
+ */
+cc1120_status_code cc1120_trace_replay(const uint8_t data[], uint32_t len, const cc1120_transport_ops_t *ops,
+                                       void *bus, uint8_t csPin, cc1120_trace_replay_t *result);
+
+#endif /* CC1120_TRACE_H */
@@ -0,0 +1,172 @@
+#include "cc1120_turnaround.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_fields.h"
+#include "cc1120_txrx.h"
+
+/**
+ * @brief Calibrates the synthesizer from IDLE and parks the radio in FSTXON.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The turnaround context.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was calibrated.
+ * @return An error code - If the calibration timed out, or an SPI transfer failed.
+ */
+static cc1120_status_code cc1120_turnaround_calibrate(cc1120_dev_t *dev, cc1120_turnaround_t *ta) {
+    cc1120_status_code status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_IDLE, CC1120_TURNAROUND_CAL_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SCAL);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_IDLE, CC1120_TURNAROUND_CAL_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    ta->lastCalUs = mcu_get_time_us();
+    return cc1120_strobe_spi(dev, CC1120_STROBE_SFSTXON);
+}
+
+/**
+ * @brief Programs the states the radio enters when a packet ends, preloads the packet settings
+ * and calibrates the synthesizer. Leaves the radio in FSTXON.
+ * With txoffMode RX, the radio listens for the reply as soon as the last bit is out.
+ * With rxoffMode TX, the radio sends the packet armed with cc1120_turnaround_arm_reply as soon as a packet is received.
+ * Since the radio never passes through IDLE between packets, it does not recalibrate in the turnaround.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The turnaround context to initialize.
+ * @param rxoffMode - The state after RX, one of CC1120_OFF_MODE_*.
+ * @param txoffMode - The state after TX, one of CC1120_OFF_MODE_*.
+ * @param syncLeadUs - The airtime of the preamble and sync word, subtracted from measured gaps.
+ * @param recalIntervalUs - The time after which cc1120_turnaround_send recalibrates first.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was configured.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If an off mode is invalid.
+ * @return An error code - If the calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_turnaround_init(cc1120_dev_t *dev, cc1120_turnaround_t *ta, uint8_t rxoffMode, uint8_t txoffMode,
+                                          uint32_t syncLeadUs, uint32_t recalIntervalUs) {
+    cc1120_status_code status;
+
+    if (rxoffMode > CC1120_OFF_MODE_RX || txoffMode > CC1120_OFF_MODE_RX) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_turnaround_init: Not a valid off mode!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    status = CC1120_FIELD_WRITE(dev, RFEND_CFG1_RXOFF_MODE, rxoffMode);
+    RETURN_IF_ERROR(status)
+
+    status = CC1120_FIELD_WRITE(dev, RFEND_CFG0_TXOFF_MODE, txoffMode);
+    RETURN_IF_ERROR(status)
+
+    // TX and RX share the packet settings, so nothing is rewritten between packets
+    status = cc1120_set_variable_packet_len(dev);
+    RETURN_IF_ERROR(status)
+
+    ta->rxoffMode = rxoffMode;
+    ta->txoffMode = txoffMode;
+    ta->syncLeadUs = syncLeadUs;
+    ta->recalIntervalUs = recalIntervalUs;
+    ta->packetEnded = false;
+    cc1120_turnaround_reset_stats(ta);
+
+    return cc1120_turnaround_calibrate(dev, ta);
+}
+
+/**
+ * @brief Queues a packet and strobes STX. From FSTXON or RX this is a fast TX on without calibration,
+ * unless the recalibration interval has passed, in which case the radio is calibrated first.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The initialized turnaround context.
+ * @param data - The packet to transmit.
+ * @param len - The size of the packet, at most CC1120_TX_FIFO_SIZE - 1.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was queued and STX strobed.
+ * @return An error code - If the packet is too long, the calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_turnaround_send(cc1120_dev_t *dev, cc1120_turnaround_t *ta, uint8_t *data, uint8_t len) {
+    cc1120_status_code status;
+
+    if (mcu_get_time_us() - ta->lastCalUs >= ta->recalIntervalUs) {
+        status = cc1120_turnaround_calibrate(dev, ta);
+        RETURN_IF_ERROR(status)
+    }
+
+    status = cc1120_tx_load(dev, data, len);
+    RETURN_IF_ERROR(status)
+
+    return cc1120_strobe_spi(dev, CC1120_STROBE_STX);
+}
+
+/**
+ * @brief Queues a reply while the radio is receiving. With rxoffMode TX, the chip sends it
+ * on its own when the received packet ends, so no SPI access happens in the turnaround.
+ * The reply must be armed before the received packet ends, or the TX FIFO underflows.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The initialized turnaround context.
+ * @param data - The reply to transmit.
+ * @param len - The size of the reply, at most CC1120_TX_FIFO_SIZE - 1.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reply was queued.
+ * @return An error code - If the reply is too long, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_turnaround_arm_reply(cc1120_dev_t *dev, cc1120_turnaround_t *ta, uint8_t *data, uint8_t len) {
+    if (ta->rxoffMode != CC1120_OFF_MODE_TX)
+        mcu_log(CC1120_LOG_LEVEL_WARN, "cc1120_turnaround_arm_reply: RXOFF_MODE is not TX, the reply waits for STX\n");
+
+    return cc1120_tx_load(dev, data, len);
+}
+
+/**
+ * @brief GPIO handler that measures the gap from the last bit of one packet to the first bit of the next.
+ * Map CC1120_GPIO_CFG_PKT_SYNC_RXTX on both edges to it with the turnaround context as ctx:
+ * the signal falls at the end of each packet and rises when the next sync word is sent or received.
+ *
+ * @param ctx - The turnaround context.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level.
+ * @param timeUs - The time of the edge.
+ */
+void cc1120_turnaround_on_pkt_sync(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs) {
+    cc1120_turnaround_t *ta = (cc1120_turnaround_t *)ctx;
+    (void)gpio;
+
+    if (!level) {
+        ta->packetEndUs = timeUs;
+        ta->packetEnded = true;
+        return;
+    }
+
+    if (!ta->packetEnded)
+        return;
+    ta->packetEnded = false;
+
+    // The next packet started a preamble and sync word before the sync edge
+    uint32_t gapUs = timeUs - ta->packetEndUs;
+    gapUs = (gapUs > ta->syncLeadUs) ? gapUs - ta->syncLeadUs : 0;
+
+    cc1120_turnaround_stats_t *stats = &ta->stats;
+    if (stats->count == 0 || gapUs < stats->minUs)
+        stats->minUs = gapUs;
+    if (gapUs > stats->maxUs)
+        stats->maxUs = gapUs;
+    stats->lastUs = gapUs;
+    stats->totalUs += gapUs;
+    stats->count++;
+}
+
+/**
+ * @brief Clears the turnaround measurements.
+ *
+ * @param ta - The turnaround context.
+ */
+void cc1120_turnaround_reset_stats(cc1120_turnaround_t *ta) {
+    ta->stats.count = 0;
+    ta->stats.lastUs = 0;
+    ta->stats.minUs = 0;
+    ta->stats.maxUs = 0;
+    ta->stats.totalUs = 0;
+}
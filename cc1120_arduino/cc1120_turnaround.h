@@ -0,0 +1,100 @@
+#ifndef CC1120_TURNAROUND_H
+#define CC1120_TURNAROUND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+
+/* Time after which the synthesizer is recalibrated before the next send */
+#define CC1120_TURNAROUND_DEFAULT_RECAL_US 10000000UL
+
+/* Maximum time for a manual calibration to finish */
+#define CC1120_TURNAROUND_CAL_TIMEOUT_US 2000UL
+
+typedef struct {
+    uint32_t count;             /* Gaps measured */
+    uint32_t lastUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t totalUs;
+} cc1120_turnaround_stats_t;
+
+typedef struct {
+    uint8_t rxoffMode;          /* RFEND_CFG1.RXOFF_MODE, one of CC1120_OFF_MODE_* */
+    uint8_t txoffMode;          /* RFEND_CFG0.TXOFF_MODE, one of CC1120_OFF_MODE_* */
+    uint32_t recalIntervalUs;
+    uint32_t lastCalUs;
+    uint32_t syncLeadUs;        /* Airtime of the preamble and sync word */
+    volatile uint32_t packetEndUs;
+    volatile bool packetEnded;
+    cc1120_turnaround_stats_t stats;
+} cc1120_turnaround_t;
+
+/**
+ * @brief Programs the states the radio enters when a packet ends, preloads the packet settings
+ * and calibrates the synthesizer. Leaves the radio in FSTXON.
+ * With txoffMode RX, the radio listens for the reply as soon as the last bit is out.
+ * With rxoffMode TX, the radio sends the packet armed with cc1120_turnaround_arm_reply as soon as a packet is received.
+ * Since the radio never passes through IDLE between packets, it does not recalibrate in the turnaround.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The turnaround context to initialize.
+ * @param rxoffMode - The state after RX, one of CC1120_OFF_MODE_*.
+ * @param txoffMode - The state after TX, one of CC1120_OFF_MODE_*.
+ * @param syncLeadUs - The airtime of the preamble and sync word, subtracted from measured gaps.
+ * @param recalIntervalUs - The time after which cc1120_turnaround_send recalibrates first.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the radio was configured.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If an off mode is invalid.
+ * @return An error code - If the calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_turnaround_init(cc1120_dev_t *dev, cc1120_turnaround_t *ta, uint8_t rxoffMode, uint8_t txoffMode,
+                                          uint32_t syncLeadUs, uint32_t recalIntervalUs);
+
+/**
+ * @brief Queues a packet and strobes STX. From FSTXON or RX this is a fast TX on without calibration,
+ * unless the recalibration interval has passed, in which case the radio is calibrated first.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The initialized turnaround context.
+ * @param data - The packet to transmit.
+ * @param len - The size of the packet, at most CC1120_TX_FIFO_SIZE - 1.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was queued and STX strobed.
+ * @return An error code - If the packet is too long, the calibration timed out, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_turnaround_send(cc1120_dev_t *dev, cc1120_turnaround_t *ta, uint8_t *data, uint8_t len);
+
+/**
+ * @brief Queues a reply while the radio is receiving. With rxoffMode TX, the chip sends it
+ * on its own when the received packet ends, so no SPI access happens in the turnaround.
+ * The reply must be armed before the received packet ends, or the TX FIFO underflows.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param ta - The initialized turnaround context.
+ * @param data - The reply to transmit.
+ * @param len - The size of the reply, at most CC1120_TX_FIFO_SIZE - 1.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the reply was queued.
+ * @return An error code - If the reply is too long, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_turnaround_arm_reply(cc1120_dev_t *dev, cc1120_turnaround_t *ta, uint8_t *data, uint8_t len);
+
+/**
+ * @brief GPIO handler that measures the gap from the last bit of one packet to the first bit of the next.
+ * Map CC1120_GPIO_CFG_PKT_SYNC_RXTX on both edges to it with the turnaround context as ctx:
+ * the signal falls at the end of each packet and rises when the next sync word is sent or received.
+ *
+ * @param ctx - The turnaround context.
+ * @param gpio - The CC1120 GPIO that changed.
+ * @param level - The new level.
+ * @param timeUs - The time of the edge.
+ */
+void cc1120_turnaround_on_pkt_sync(void *ctx, uint8_t gpio, uint8_t level, uint32_t timeUs);
+
+/**
+ * @brief Clears the turnaround measurements.
+ *
+ * @param ta - The turnaround context.
+ */
+void cc1120_turnaround_reset_stats(cc1120_turnaround_t *ta);
+
+#endif /* CC1120_TURNAROUND_H */
@@ -2,6 +2,9 @@
 #include "cc1120_logging.h"
 #include "cc1120_mcu.h"
 #include "cc1120_spi.h"
+#include "cc1120_fields.h"
+#include "cc1120_rate.h"
+#include "cc1120_stats.h"
 #include <stdbool.h>
 #define min(a, b) (a < b ? a : b)
 
@@ -11,14 +14,16 @@ registerSetting_t txSettingsStd[] = {
     {CC1120_REGS_IOCFG1, 0xB0U},
     {CC1120_REGS_IOCFG0, 0x40U},
     {CC1120_REGS_SYNC_CFG1, 0x08U},
-    {CC1120_REGS_DEVIATION_M, 0x3AU},
-    {CC1120_REGS_MODCFG_DEV_E, 0x0AU},
+    {CC1120_REGS_DEVIATION_M, CC1120_MODEM_DEVIATION_M(CC1120_TX_DEVIATION_HZ, CC1120_XOSC_FREQ_HZ)},
+    {CC1120_REGS_MODCFG_DEV_E, CC1120_MODEM_MODCFG_DEV_E(CC1120_TX_DEVIATION_HZ, CC1120_XOSC_FREQ_HZ, CC1120_MODCFG_MOD_FORMAT_2GFSK)},
     {CC1120_REGS_DCFILT_CFG, 0x1CU},
     {CC1120_REGS_PREAMBLE_CFG1, 0x18U},
     {CC1120_REGS_IQIC, 0xC6U},
-    {CC1120_REGS_CHAN_BW, 0x08U},
-    {CC1120_REGS_MDMCFG0, 0x05U},
-    {CC1120_REGS_SYMBOL_RATE2, 0x73U},
+    {CC1120_REGS_CHAN_BW, CC1120_MODEM_CHAN_BW(CC1120_TX_RX_BW_HZ, CC1120_XOSC_FREQ_HZ)},
+    {CC1120_REGS_MDMCFG0, CC1120_MODEM_MDMCFG0},
+    {CC1120_REGS_SYMBOL_RATE2, CC1120_MODEM_SYMBOL_RATE2(CC1120_TX_SYMBOL_RATE, CC1120_XOSC_FREQ_HZ)},
+    {CC1120_REGS_SYMBOL_RATE1, CC1120_MODEM_SYMBOL_RATE1(CC1120_TX_SYMBOL_RATE, CC1120_XOSC_FREQ_HZ)},
+    {CC1120_REGS_SYMBOL_RATE0, CC1120_MODEM_SYMBOL_RATE0(CC1120_TX_SYMBOL_RATE, CC1120_XOSC_FREQ_HZ)},
     {CC1120_REGS_AGC_REF, 0x20U},
     {CC1120_REGS_AGC_CS_THR, 0x19U},
     {CC1120_REGS_AGC_CFG1, 0xA9U},
@@ -32,9 +37,9 @@ registerSetting_t txSettingsStd[] = {
 registerSetting_t txSettingsExt[] = {
     {CC1120_REGS_EXT_IF_MIX_CFG, 0x00U},
     {CC1120_REGS_EXT_FREQOFF_CFG, 0x22U},
-    {CC1120_REGS_EXT_FREQ2, 0x6CU},
-    {CC1120_REGS_EXT_FREQ1, 0x7AU},
-    {CC1120_REGS_EXT_FREQ0, 0xE1U},
+    {CC1120_REGS_EXT_FREQ2, (uint8_t)(CC1120_FREQ_WORD(CC1120_TX_CARRIER_HZ) >> 16)},
+    {CC1120_REGS_EXT_FREQ1, (uint8_t)(CC1120_FREQ_WORD(CC1120_TX_CARRIER_HZ) >> 8)},
+    {CC1120_REGS_EXT_FREQ0, (uint8_t)CC1120_FREQ_WORD(CC1120_TX_CARRIER_HZ)},
     {CC1120_REGS_EXT_FS_DIG1, 0x00U},
     {CC1120_REGS_EXT_FS_DIG0, 0x5FU},
     {CC1120_REGS_EXT_FS_CAL1, 0x40U},
@@ -50,62 +55,229 @@ registerSetting_t txSettingsExt[] = {
     {CC1120_REGS_EXT_XOSC5, 0x0EU},
     {CC1120_REGS_EXT_XOSC1, 0x03U}};
 
+/**
+ * @brief Writes a packet register unless the device shadow says it already holds the value
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param addr - The register address.
+ * @param shadow - The shadow copy of the register in dev.
+ * @param val - The value to write.
+ * @return cc1120_status_code - Whether or not the register write was successful
+ */
+static cc1120_status_code cc1120_write_shadowed(cc1120_dev_t *dev, uint8_t addr, uint8_t *shadow, uint8_t val)
+{
+    if (dev->shadow.valid && *shadow == val)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    cc1120_status_code status = cc1120_write_spi(dev, addr, &val, 1);
+    RETURN_IF_ERROR(status)
+
+    *shadow = val;
+    return status;
+}
+
+/**
+ * @brief Passes a radio state to the link statistics, if any are attached
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param state - The STATE field of the status byte
+ */
+static void cc1120_note_state(cc1120_dev_t *dev, uint8_t state)
+{
+    if (dev->linkStats != NULL)
+        cc1120_stats_on_state(dev->linkStats, state, mcu_get_time_us());
+}
+
 /**
  * @brief Gets the number of packets queued in the TX FIFO
  *
+ * @param dev - The CC1120 to talk to.
  * @param numPackets - A pointer to an 8-bit integer to store the number of packets in
  * @return cc1120_status_code - Whether or not the registe read was successful
  */
-cc1120_status_code cc1120_get_packets_in_tx_fifo(uint8_t *numPackets)
+cc1120_status_code cc1120_get_packets_in_tx_fifo(cc1120_dev_t *dev, uint8_t *numPackets)
 {
-    return cc1120_read_ext_addr_spi(CC1120_REGS_EXT_NUM_TXBYTES, numPackets, 1);
+    return cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_NUM_TXBYTES, numPackets, 1);
 }
 
 /**
  * @brief Gets the state of the CC1120 from the MARCSTATE register
  *
+ * @param dev - The CC1120 to talk to.
  * @param stateNum - A pointer to an 8-bit integer to store the state in
  * @return cc1120_status_code - Whether or not the register read was successful
  */
-cc1120_status_code cc1120_get_state(uint8_t *stateNum)
+cc1120_status_code cc1120_get_state(cc1120_dev_t *dev, uint8_t *stateNum)
 {
-    cc1120_status_code status = cc1120_read_ext_addr_spi(CC1120_REGS_EXT_MARCSTATE, stateNum, 1);
-    *stateNum &= 0b11111;
+    cc1120_status_code status = CC1120_FIELD_READ(dev, MARCSTATE_MARC_STATE, stateNum);
+    RETURN_IF_ERROR(status)
+
+    cc1120_note_state(dev, dev->lastStatus & CC1120_STATE_MASK);
     return status;
 }
 
+/**
+ * @brief Polls MARCSTATE until the CC1120 reaches the given state
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param stateNum - The MARCSTATE value to wait for
+ * @param timeoutUs - The maximum time to wait in microseconds
+ * @return CC1120_ERROR_CODE_SUCCESS - If the state was reached
+ * @return CC1120_ERROR_CODE_STATE_TIMEOUT - If the state was not reached in time
+ */
+cc1120_status_code cc1120_wait_for_state(cc1120_dev_t *dev, uint8_t stateNum, uint32_t timeoutUs)
+{
+    cc1120_status_code status;
+    uint32_t start = mcu_get_time_us();
+    uint8_t state;
+
+    do
+    {
+        status = cc1120_get_state(dev, &state);
+        RETURN_IF_ERROR(status)
+
+        if (state == stateNum)
+            return CC1120_ERROR_CODE_SUCCESS;
+    } while (mcu_get_time_us() - start < timeoutUs);
+
+    mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wait_for_state: Timed out waiting for state 0x%02X, in 0x%02X\n", stateNum, state);
+    return CC1120_ERROR_CODE_STATE_TIMEOUT;
+}
+
+/**
+ * @brief Clears a TX or RX FIFO error without reinitializing, if the last status byte shows one:
+ * counts the cause from MARC_STATUS1, flushes the FIFO in error, puts back the packet length
+ * registers that a large packet changed, and returns to FSTXON after a TX error or RX after an RX error.
+ * Packets queued by the caller can then be sent again.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the recovery was successful. Success if there was no error.
+ */
+cc1120_status_code cc1120_fifo_recover(cc1120_dev_t *dev)
+{
+    cc1120_status_code status;
+    uint8_t state = dev->lastStatus & CC1120_STATE_MASK;
+
+    if (state != CC1120_STATE_TX_FIFO_ERR && state != CC1120_STATE_RX_FIFO_ERR)
+        return CC1120_ERROR_CODE_SUCCESS;
+
+    uint32_t start = mcu_get_time_us();
+
+    // Reading MARC_STATUS1 clears it, so the cause is counted once
+    uint8_t marcStatus;
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_MARC_STATUS1, &marcStatus, 1);
+    RETURN_IF_ERROR(status)
+
+    switch (marcStatus)
+    {
+    case CC1120_MARC_STATUS1_TX_FIFO_UNDERFLOW:
+        dev->fifoStats.txUnderflows++;
+        break;
+    case CC1120_MARC_STATUS1_TX_FIFO_OVERFLOW:
+        dev->fifoStats.txOverflows++;
+        break;
+    case CC1120_MARC_STATUS1_RX_FIFO_OVERFLOW:
+        dev->fifoStats.rxOverflows++;
+        break;
+    case CC1120_MARC_STATUS1_RX_FIFO_UNDERFLOW:
+        dev->fifoStats.rxUnderflows++;
+        break;
+    default:
+        dev->fifoStats.unknown++;
+        break;
+    }
+
+    // The flush strobes are accepted in the FIFO error states and leave the radio in IDLE
+    if (state == CC1120_STATE_TX_FIFO_ERR)
+    {
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SFTX);
+        RETURN_IF_ERROR(status)
+
+        // A large packet leaves infinite or fixed length mode behind. The shadow skips the writes otherwise.
+        status = cc1120_set_variable_packet_len(dev);
+        RETURN_IF_ERROR(status)
+
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SFSTXON);
+    }
+    else
+    {
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SFRX);
+        RETURN_IF_ERROR(status)
+
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SRX);
+    }
+    RETURN_IF_ERROR(status)
+
+    // The status byte of a strobe shows the state before it
+    cc1120_note_state(dev, (state == CC1120_STATE_TX_FIFO_ERR) ? CC1120_STATE_FSTXON : CC1120_STATE_RX);
+
+    uint32_t elapsed = mcu_get_time_us() - start;
+    dev->fifoStats.recoveries++;
+    dev->fifoStats.lastRecoveryUs = elapsed;
+    if (elapsed > dev->fifoStats.maxRecoveryUs)
+        dev->fifoStats.maxRecoveryUs = elapsed;
+
+    mcu_log(CC1120_LOG_LEVEL_WARN, "cc1120_fifo_recover: Cleared FIFO error 0x%02X in %lu us\n", marcStatus,
+            (unsigned long)elapsed);
+    return status;
+}
+
+/**
+ * @brief Refreshes the status byte with SNOP and recovers from a FIFO error if there is one
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the check and any recovery were successful
+ */
+cc1120_status_code cc1120_fifo_check(cc1120_dev_t *dev)
+{
+    cc1120_status_code status = cc1120_strobe_spi(dev, CC1120_STROBE_SNOP);
+    RETURN_IF_ERROR(status)
+
+    cc1120_note_state(dev, dev->lastStatus & CC1120_STATE_MASK);
+    return cc1120_fifo_recover(dev);
+}
+
 /**
  * @brief Resets CC1120 & initializes transmit mode
  *
+ * @param dev - The CC1120 to talk to.
  * @return cc1120_status_code - Whether or not the setup was a success
  */
-cc1120_status_code cc1120_tx_init()
+cc1120_status_code cc1120_tx_init(cc1120_dev_t *dev)
 {
     cc1120_status_code status;
 
+    dev->shadow.valid = false;
     for (uint8_t i = 0; i < sizeof(txSettingsStd) / sizeof(registerSetting_t); i++)
     {
-        status = cc1120_write_spi(txSettingsStd[i].addr, &txSettingsStd[i].val, 1);
+        status = cc1120_write_spi(dev, txSettingsStd[i].addr, &txSettingsStd[i].val, 1);
         RETURN_IF_ERROR(status)
+
+        if (txSettingsStd[i].addr == CC1120_REGS_PKT_CFG0)
+            dev->shadow.pktCfg0 = txSettingsStd[i].val;
+        else if (txSettingsStd[i].addr == CC1120_REGS_PKT_LEN)
+            dev->shadow.pktLen = txSettingsStd[i].val;
     }
+    dev->shadow.valid = true;
 
     for (uint8_t i = 0; i < sizeof(txSettingsExt) / sizeof(registerSetting_t); i++)
     {
-        status = cc1120_write_ext_addr_spi(txSettingsExt[i].addr, &txSettingsExt[i].val, 1);
+        status = cc1120_write_ext_addr_spi(dev, txSettingsExt[i].addr, &txSettingsExt[i].val, 1);
         RETURN_IF_ERROR(status)
     }
 
-    return cc1120_strobe_spi(CC1120_STROBE_SFSTXON);
+    return cc1120_strobe_spi(dev, CC1120_STROBE_SFSTXON);
 }
 
 /**
  * @brief Adds the given data to the CC1120 FIFO buffer and transmits
  *
+ * @param dev - The CC1120 to talk to.
  * @param data - The packet to transmit
  * @param len - The size of the provided packet in bytes
  * @return cc1120_status_code
  */
-cc1120_status_code cc1120_send(uint8_t *data, uint32_t len)
+cc1120_status_code cc1120_send(cc1120_dev_t *dev, uint8_t *data, uint32_t len)
 {
     cc1120_status_code status;
 
@@ -115,39 +287,36 @@ cc1120_status_code cc1120_send(uint8_t *data, uint32_t len)
         return CC1120_ERROR_CODE_INVALID_PARAM;
     }
 
+    // STX is ignored in TX_FIFO_ERR, so clear a previous underflow before queueing
+    status = cc1120_fifo_check(dev);
+    RETURN_IF_ERROR(status)
+
     bool largePacketFlag = false;
 
     // See section 8.1.5
     if (len > CC1120_MAX_PACKET_LEN)
     {
         // Temporarily set packet size to infinite
-        uint8_t temp = 0x40;
-        status = cc1120_write_spi(CC1120_REGS_PKT_CFG0, &temp, 1);
+        status = cc1120_write_shadowed(dev, CC1120_REGS_PKT_CFG0, &dev->shadow.pktCfg0,
+                                       CC1120_FIELD_VAL(PKT_CFG0_LENGTH_CONFIG, CC1120_LENGTH_CONFIG_INFINITE));
         RETURN_IF_ERROR(status)
 
         // Set packet length to mod(len, 256) so that the correct number of bits
         // are sent when fixed packet mode gets reactivated
-        temp = len % 256;
-        status = cc1120_write_spi(CC1120_REGS_PKT_LEN, &temp, 1);
+        status = cc1120_write_shadowed(dev, CC1120_REGS_PKT_LEN, &dev->shadow.pktLen, len % 256);
         RETURN_IF_ERROR(status)
 
         largePacketFlag = true;
     }
     else
     { // If packet size < 255, use variable packet length mode
-        // Set to variable packet length mode
-        uint8_t temp = 0x20;
-        status = cc1120_write_spi(CC1120_REGS_PKT_CFG0, &temp, 1);
-        RETURN_IF_ERROR(status)
-
-        // Set max packet size
-        temp = CC1120_MAX_PACKET_LEN;
-        status = cc1120_write_spi(CC1120_REGS_PKT_LEN, &temp, 1);
+        // Set to variable packet length mode with the max packet size
+        status = cc1120_set_variable_packet_len(dev);
         RETURN_IF_ERROR(status)
 
         // Write current packet size
         uint8_t variableDataLen = (uint8_t)len;
-        status = cc1120_write_fifo(&variableDataLen, 1); // Write packet size
+        status = cc1120_write_fifo(dev, &variableDataLen, 1); // Write packet size
         RETURN_IF_ERROR(status)
     }
 
@@ -156,40 +325,163 @@ cc1120_status_code cc1120_send(uint8_t *data, uint32_t len)
     for (i = 0; i < len / (2 * CC1120_TX_FIFO_SIZE); i++)
     {
 
-        status = cc1120_write_fifo(data + 2 * i * CC1120_TX_FIFO_SIZE, CC1120_TX_FIFO_SIZE);
+        status = cc1120_write_fifo(dev, data + 2 * i * CC1120_TX_FIFO_SIZE, CC1120_TX_FIFO_SIZE);
         RETURN_IF_ERROR(status)
 
-        status = cc1120_strobe_spi(CC1120_STROBE_STX);
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_STX);
         RETURN_IF_ERROR(status)
 
-        status = cc1120_write_fifo(data + (2 * i + 1) * CC1120_TX_FIFO_SIZE, CC1120_TX_FIFO_SIZE);
+        status = cc1120_write_fifo(dev, data + (2 * i + 1) * CC1120_TX_FIFO_SIZE, CC1120_TX_FIFO_SIZE);
         RETURN_IF_ERROR(status)
 
-        status = cc1120_strobe_spi(CC1120_STROBE_STX);
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_STX);
         RETURN_IF_ERROR(status)
     }
 
     if (largePacketFlag)
     {
-        uint8_t temp = 0;
-        status = cc1120_write_spi(CC1120_REGS_PKT_CFG0, &temp, 1);
+        status = cc1120_write_shadowed(dev, CC1120_REGS_PKT_CFG0, &dev->shadow.pktCfg0,
+                                       CC1120_FIELD_VAL(PKT_CFG0_LENGTH_CONFIG, CC1120_LENGTH_CONFIG_FIXED));
         RETURN_IF_ERROR(status)
     }
 
-    status = cc1120_write_fifo(data + 2 * i * CC1120_TX_FIFO_SIZE, min(CC1120_TX_FIFO_SIZE, len - i * CC1120_TX_FIFO_SIZE));
+    status = cc1120_write_fifo(dev, data + 2 * i * CC1120_TX_FIFO_SIZE, min(CC1120_TX_FIFO_SIZE, len - i * CC1120_TX_FIFO_SIZE));
     RETURN_IF_ERROR(status)
 
-    status = cc1120_strobe_spi(CC1120_STROBE_STX);
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_STX);
     RETURN_IF_ERROR(status)
 
     if (len % 256 > 128)
     {
-        status = cc1120_write_fifo(data + (2 * i + 1) * CC1120_TX_FIFO_SIZE, len % CC1120_TX_FIFO_SIZE);
+        status = cc1120_write_fifo(dev, data + (2 * i + 1) * CC1120_TX_FIFO_SIZE, len % CC1120_TX_FIFO_SIZE);
         RETURN_IF_ERROR(status)
 
-        status = cc1120_strobe_spi(CC1120_STROBE_STX);
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_STX);
         RETURN_IF_ERROR(status)
     }
 
+    if (dev->linkStats != NULL)
+        cc1120_stats_on_tx(dev->linkStats, len);
+    return status;
+}
+
+/**
+ * @brief Selects variable packet length mode with the maximum packet size, unless it is already selected
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the register writes were successful
+ */
+cc1120_status_code cc1120_set_variable_packet_len(cc1120_dev_t *dev)
+{
+    cc1120_status_code status = cc1120_write_shadowed(dev, CC1120_REGS_PKT_CFG0, &dev->shadow.pktCfg0,
+                                                      CC1120_FIELD_VAL(PKT_CFG0_LENGTH_CONFIG, CC1120_LENGTH_CONFIG_VARIABLE));
+    RETURN_IF_ERROR(status)
+
+    return cc1120_write_shadowed(dev, CC1120_REGS_PKT_LEN, &dev->shadow.pktLen, CC1120_MAX_PACKET_LEN);
+}
+
+/**
+ * @brief Queues a variable length packet that fits in the TX FIFO without strobing STX
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param data - An array of 8-bit data to transmit
+ * @param len - The size of the provided array, at most CC1120_TX_FIFO_SIZE - 1
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was queued
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the packet does not fit in the TX FIFO
+ * @return An error code - If an SPI transfer failed
+ */
+cc1120_status_code cc1120_tx_load(cc1120_dev_t *dev, uint8_t *data, uint8_t len)
+{
+    cc1120_status_code status;
+
+    // The length byte takes one FIFO entry
+    if (len < 1 || len > CC1120_TX_FIFO_SIZE - 1)
+    {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_tx_load: Invalid data size!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    status = cc1120_set_variable_packet_len(dev);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_write_fifo(dev, &len, 1);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_write_fifo(dev, data, len);
+    RETURN_IF_ERROR(status)
+
+    if (dev->linkStats != NULL)
+        cc1120_stats_on_tx(dev->linkStats, len);
     return status;
 }
+
+/**
+ * @brief Reads one variable length packet out of the RX FIFO, after the radio has left RX
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param buf - Filled with the payload, without the length byte
+ * @param max - The size of buf
+ * @param len - Set to the payload length, 0 if there was no packet
+ * @param rxStatus - Set to the RSSI and CRC_OK/LQI bytes appended by PKT_CFG1.APPEND_STATUS, or zeros without them
+ * @return CC1120_ERROR_CODE_SUCCESS - If a packet was read, or the RX FIFO was empty
+ * @return CC1120_ERROR_CODE_CRC_FAILED - If the appended status shows a CRC failure. The payload is still read.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the packet did not fit in buf. The RX FIFO is flushed.
+ * @return CC1120_ERROR_CODE_FIFO_ERROR - If the RX FIFO had overflowed. The error is cleared and RX restarted.
+ * @return An error code - If an SPI transfer failed
+ */
+cc1120_status_code cc1120_receive(cc1120_dev_t *dev, uint8_t buf[], uint8_t max, uint8_t *len, uint8_t rxStatus[2])
+{
+    cc1120_status_code status;
+    uint8_t numBytes;
+    uint8_t pktLen;
+
+    *len = 0;
+    rxStatus[0] = 0;
+    rxStatus[1] = 0;
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SNOP);
+    RETURN_IF_ERROR(status)
+    cc1120_note_state(dev, dev->lastStatus & CC1120_STATE_MASK);
+
+    if ((dev->lastStatus & CC1120_STATE_MASK) == CC1120_STATE_RX_FIFO_ERR)
+    {
+        status = cc1120_fifo_recover(dev);
+        RETURN_IF_ERROR(status)
+        return CC1120_ERROR_CODE_FIFO_ERROR;
+    }
+
+    status = cc1120_read_ext_addr_spi(dev, CC1120_REGS_EXT_NUM_RXBYTES, &numBytes, 1);
+    RETURN_IF_ERROR(status)
+
+    if (numBytes == 0)
+        return status;
+
+    status = cc1120_read_fifo(dev, &pktLen, 1);
+    RETURN_IF_ERROR(status)
+
+    if (pktLen > max || (uint16_t)pktLen + 1 > numBytes)
+    {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_receive: Packet of %u bytes does not fit!\n", pktLen);
+        status = cc1120_strobe_spi(dev, CC1120_STROBE_SFRX);
+        RETURN_IF_ERROR(status)
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    if (pktLen > 0)
+    {
+        status = cc1120_read_fifo(dev, buf, pktLen);
+        RETURN_IF_ERROR(status)
+    }
+    *len = pktLen;
+
+    // APPEND_STATUS adds RSSI and CRC_OK/LQI after the payload
+    if (numBytes - 1 - pktLen < 2)
+        return status;
+
+    status = cc1120_read_fifo(dev, rxStatus, 2);
+    RETURN_IF_ERROR(status)
+
+    if (dev->linkStats != NULL)
+        cc1120_stats_on_rx(dev->linkStats, pktLen, rxStatus);
+    return (rxStatus[1] & CC1120_STATUS_CRC_OK) ? CC1120_ERROR_CODE_SUCCESS : CC1120_ERROR_CODE_CRC_FAILED;
+}
@@ -4,10 +4,25 @@
 #include <stdint.h>
 #include "cc1120_regs.h"
 #include "cc1120_logging.h"
+#include "cc1120_dev.h"
+#include "cc1120_modem.h"
 
 #define CC1120_MAX_PACKET_LEN 255
 #define CC1120_TX_FIFO_SIZE 128
 
+/* Crystal frequency and LO divider used by txSettingsExt (FS_CFG.FSD_BANDSELECT = 410-480 MHz) */
+#define CC1120_XOSC_FREQ_HZ 32000000ULL
+#define CC1120_LO_DIVIDER 8ULL
+
+/* FREQ2..0 word for an RF frequency in Hz. See section 9.12 of the user guide. */
+#define CC1120_FREQ_WORD(hz) ((uint32_t)CC1120_MODEM_FREQ(hz, CC1120_LO_DIVIDER, CC1120_XOSC_FREQ_HZ))
+
+/* Modem parameters used to generate txSettingsStd/txSettingsExt */
+#define CC1120_TX_SYMBOL_RATE 9600UL
+#define CC1120_TX_DEVIATION_HZ 2396UL
+#define CC1120_TX_RX_BW_HZ 25000UL
+#define CC1120_TX_CARRIER_HZ 433920000UL
+
 typedef struct {
     uint8_t addr;
     uint8_t val;
@@ -16,33 +31,103 @@ typedef struct {
 /**
  * @brief Gets the number of packets queued in the TX FIFO
  * 
+ * @param dev - The CC1120 to talk to.
  * @param numPackets - A pointer to an 8-bit integer to store the number of packets in
  * @return cc1120_status_code - Whether or not the registe read was successful
  */
-cc1120_status_code cc1120_get_packets_in_tx_fifo(uint8_t *numPackets);
+cc1120_status_code cc1120_get_packets_in_tx_fifo(cc1120_dev_t *dev, uint8_t *numPackets);
 
 /**
  * @brief Gets the state of the CC1120 from the MARCSTATE register
  * 
+ * @param dev - The CC1120 to talk to.
  * @param stateNum - A pointer to an 8-bit integer to store the state in
  * @return cc1120_status_code - Whether or not the register read was successful
  */
-cc1120_status_code cc1120_get_state(uint8_t *stateNum);
+cc1120_status_code cc1120_get_state(cc1120_dev_t *dev, uint8_t *stateNum);
+
+/**
+ * @brief Polls MARCSTATE until the CC1120 reaches the given state
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @param stateNum - The MARCSTATE value to wait for
+ * @param timeoutUs - The maximum time to wait in microseconds
+ * @return CC1120_ERROR_CODE_SUCCESS - If the state was reached
+ * @return CC1120_ERROR_CODE_STATE_TIMEOUT - If the state was not reached in time
+ */
+cc1120_status_code cc1120_wait_for_state(cc1120_dev_t *dev, uint8_t stateNum, uint32_t timeoutUs);
+
+/**
+ * @brief Clears a TX or RX FIFO error without reinitializing, if the last status byte shows one:
+ * counts the cause from MARC_STATUS1, flushes the FIFO in error, puts back the packet length
+ * registers that a large packet changed, and returns to FSTXON after a TX error or RX after an RX error.
+ * Packets queued by the caller can then be sent again.
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the recovery was successful. Success if there was no error.
+ */
+cc1120_status_code cc1120_fifo_recover(cc1120_dev_t *dev);
+
+/**
+ * @brief Refreshes the status byte with SNOP and recovers from a FIFO error if there is one
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the check and any recovery were successful
+ */
+cc1120_status_code cc1120_fifo_check(cc1120_dev_t *dev);
 
 /**
  * @brief Resets CC1120 & initializes transmit mode
  * 
+ * @param dev - The CC1120 to talk to.
  * @return cc1120_status_code - Whether or not the setup was a success
  */
-cc1120_status_code cc1120_tx_init();
+cc1120_status_code cc1120_tx_init(cc1120_dev_t *dev);
 
 /**
  * @brief Adds the given data to the CC1120 FIFO buffer and transmits
  * 
+ * @param dev - The CC1120 to talk to.
  * @param data - An array of 8-bit data to transmit
  * @param len - The size of the provided array
  * @return cc1120_status_code 
  */
-cc1120_status_code cc1120_send(uint8_t *data, uint32_t len);
+cc1120_status_code cc1120_send(cc1120_dev_t *dev, uint8_t *data, uint32_t len);
+
+/**
+ * @brief Selects variable packet length mode with the maximum packet size, unless it is already selected
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @return cc1120_status_code - Whether or not the register writes were successful
+ */
+cc1120_status_code cc1120_set_variable_packet_len(cc1120_dev_t *dev);
+
+/**
+ * @brief Queues a variable length packet that fits in the TX FIFO without strobing STX
+ * 
+ * @param dev - The CC1120 to talk to.
+ * @param data - An array of 8-bit data to transmit
+ * @param len - The size of the provided array, at most CC1120_TX_FIFO_SIZE - 1
+ * @return CC1120_ERROR_CODE_SUCCESS - If the packet was queued
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the packet does not fit in the TX FIFO
+ * @return An error code - If an SPI transfer failed
+ */
+cc1120_status_code cc1120_tx_load(cc1120_dev_t *dev, uint8_t *data, uint8_t len);
+
+/**
+ * @brief Reads one variable length packet out of the RX FIFO, after the radio has left RX
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param buf - Filled with the payload, without the length byte
+ * @param max - The size of buf
+ * @param len - Set to the payload length, 0 if there was no packet
+ * @param rxStatus - Set to the RSSI and CRC_OK/LQI bytes appended by PKT_CFG1.APPEND_STATUS, or zeros without them
+ * @return CC1120_ERROR_CODE_SUCCESS - If a packet was read, or the RX FIFO was empty
+ * @return CC1120_ERROR_CODE_CRC_FAILED - If the appended status shows a CRC failure. The payload is still read.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the packet did not fit in buf. The RX FIFO is flushed.
+ * @return CC1120_ERROR_CODE_FIFO_ERROR - If the RX FIFO had overflowed. The error is cleared and RX restarted.
+ * @return An error code - If an SPI transfer failed
+ */
+cc1120_status_code cc1120_receive(cc1120_dev_t *dev, uint8_t buf[], uint8_t max, uint8_t *len, uint8_t rxStatus[2]);
 
 #endif /* CC1120_TXRX_H */
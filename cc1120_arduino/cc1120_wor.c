@@ -0,0 +1,219 @@
+#include "cc1120_wor.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_fields.h"
+#include <stddef.h>
+
+/* RC oscillator periods from wake-up to the crystal being stable, per WOR_CFG1.EVENT1 code */
+static const uint8_t CC1120_WOR_EVENT1_PERIODS[] = {4, 6, 8, 12, 16, 24, 32, 48};
+
+/* Maximum time for the radio to reach IDLE before starting WOR */
+#define CC1120_WOR_IDLE_TIMEOUT_US 1000UL
+
+/**
+ * @brief Gets the RX timeout for an RX_TIME code. See section 9.4 of the user guide:
+ * MAX(1, EVENT0 / 2^(RX_TIME + 3)) * 2^(4 * WOR_RES) * 1250 / f_XOSC.
+ *
+ * @param event0 - WOR_EVENT0.
+ * @param worRes - WOR_CFG1.WOR_RES.
+ * @param rxTime - RFEND_CFG1.RX_TIME, 0-6.
+ * @return uint32_t - The RX timeout in microseconds.
+ */
+static uint32_t cc1120_wor_rx_timeout_us(uint16_t event0, uint8_t worRes, uint8_t rxTime) {
+    uint64_t units = event0 >> (rxTime + 3);
+    if (units < 1)
+        units = 1;
+
+    return (uint32_t)((units << (4 * worRes)) * 1250ULL * 1000000ULL / CC1120_XOSC_FREQ_HZ);
+}
+
+/**
+ * @brief Computes the eWOR register values for a sniff configuration without touching the radio.
+ * Picks the finest WOR_RES that fits the interval in EVENT0, and the shortest RX timeout
+ * that is at least the requested RX window, and the time RX takes when carrier sense or PQT ends it early.
+ *
+ * @param cfg - The sniff configuration.
+ * @param timing - Filled with the register values and the resulting times.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the configuration can be met.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the interval is out of range, or the RX window does not fit in it.
+ */
+cc1120_status_code cc1120_wor_compute(const cc1120_wor_cfg_t *cfg, cc1120_wor_timing_t *timing) {
+    if (cfg->rxWindowUs == 0 || cfg->rxWindowUs >= cfg->sniffIntervalUs || cfg->event1 > CC1120_WOR_CFG1_EVENT1_MASK) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wor_compute: Invalid parameters!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // t_EVENT0 = EVENT0 * 2^(5 * WOR_RES) / f_RCOSC
+    uint64_t event0 = 0;
+    uint8_t worRes;
+    for (worRes = 0; worRes <= CC1120_WOR_MAX_RES; worRes++) {
+        uint64_t periodDiv = 1000000ULL << (5 * worRes);
+        event0 = ((uint64_t)cfg->sniffIntervalUs * CC1120_WOR_RCOSC_HZ + periodDiv / 2) / periodDiv;
+        if (event0 <= UINT16_MAX)
+            break;
+    }
+
+    if (worRes > CC1120_WOR_MAX_RES || event0 == 0) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wor_compute: Sniff interval out of range!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    // Larger RX_TIME codes give shorter timeouts, so take the largest one that still covers the window
+    int8_t rxTime;
+    for (rxTime = CC1120_RFEND_CFG1_RX_TIME_FOREVER - 1; rxTime >= 0; rxTime--) {
+        if (cc1120_wor_rx_timeout_us((uint16_t)event0, worRes, rxTime) >= cfg->rxWindowUs)
+            break;
+    }
+
+    if (rxTime < 0) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wor_compute: RX window too long for the sniff interval!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    timing->worRes = worRes;
+    timing->event0 = (uint16_t)event0;
+    timing->event1 = cfg->event1;
+    timing->rxTime = (uint8_t)rxTime;
+    timing->intervalUs = (uint32_t)((event0 << (5 * worRes)) * 1000000ULL / CC1120_WOR_RCOSC_HZ);
+    timing->event1Us = (uint32_t)(CC1120_WOR_EVENT1_PERIODS[cfg->event1] * 1000000ULL / CC1120_WOR_RCOSC_HZ);
+    timing->rxTimeoutUs = cc1120_wor_rx_timeout_us(timing->event0, worRes, timing->rxTime);
+
+    // With nothing on air, carrier sense or PQT ends RX long before the timeout
+    timing->termUs = timing->rxTimeoutUs;
+    if (cfg->symbolRate != 0) {
+        uint32_t symbols = (cfg->term == CC1120_WOR_TERM_CS) ? CC1120_WOR_CS_TERM_SYMBOLS : CC1120_WOR_PQT_TERM_SYMBOLS;
+        uint64_t termUs = ((uint64_t)symbols * 1000000ULL + cfg->symbolRate - 1) / cfg->symbolRate;
+        if (termUs < timing->termUs)
+            timing->termUs = (uint32_t)termUs;
+    }
+
+    // A preamble that starts just after one RX window ended must still be on air when the next one decides
+    timing->minPreambleUs = timing->intervalUs + timing->termUs;
+
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Programs eWOR: the event timing, the RX timeout, early RX termination on carrier sense or PQT,
+ * and the RC oscillator calibration. Routes PKT_CRC_OK to the wake GPIO so the MCU is only
+ * interrupted for a packet that passed CRC. The radio returns to IDLE after the packet,
+ * so call cc1120_wor_start again after reading it. Does not start WOR.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dispatcher - The GPIO dispatcher of this CC1120.
+ * @param cfg - The sniff configuration.
+ * @param timing - Filled with the register values and the resulting times.
+ * @param onPacket - Called from interrupt context when a packet is received.
+ * @param ctx - Passed to onPacket.
+ * @return CC1120_ERROR_CODE_SUCCESS - If eWOR was configured.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the configuration cannot be met.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_wor_init(cc1120_dev_t *dev, cc1120_gpio_dispatcher_t *dispatcher, const cc1120_wor_cfg_t *cfg,
+                                   cc1120_wor_timing_t *timing, cc1120_gpio_handler_t onPacket, void *ctx) {
+    cc1120_status_code status;
+
+    if (cfg->term > CC1120_WOR_TERM_PQT || cfg->pqt > CC1120_PREAMBLE_CFG0_PQT_MASK) {
+        mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wor_init: Invalid termination settings!\n");
+        return CC1120_ERROR_CODE_INVALID_PARAM;
+    }
+
+    status = cc1120_wor_compute(cfg, timing);
+    RETURN_IF_ERROR(status)
+
+    // WOR_CFG1, WOR_CFG0 and WOR_EVENT0 are consecutive
+    uint8_t wor[4];
+    wor[0] = (timing->worRes << CC1120_WOR_CFG1_WOR_RES_SHIFT) | (CC1120_WOR_MODE_NORMAL << CC1120_WOR_CFG1_WOR_MODE_SHIFT) |
+             timing->event1;
+    wor[1] = CC1120_WOR_CFG0_DIV_256HZ_EN | CC1120_WOR_CFG0_RC_MODE_CAL;
+    wor[2] = (uint8_t)(timing->event0 >> 8);
+    wor[3] = (uint8_t)timing->event0;
+    status = cc1120_write_spi(dev, CC1120_REGS_WOR_CFG1, wor, 4);
+    RETURN_IF_ERROR(status)
+
+    // Terminate RX at the timeout unless sync, PQT or carrier sense was seen, and go back to IDLE after a packet
+    status = CC1120_FIELD_WRITE3(dev, RFEND_CFG1_RXOFF_MODE, CC1120_OFF_MODE_IDLE, RFEND_CFG1_RX_TIME, timing->rxTime,
+                                 RFEND_CFG1_RX_TIME_QUAL, 1);
+    RETURN_IF_ERROR(status)
+
+    // End RX as soon as carrier sense or PQT shows nothing is there, instead of at the timeout
+    status = CC1120_FIELD_WRITE(dev, RFEND_CFG0_ANT_DIV_RX_TERM_CFG,
+                                (cfg->term == CC1120_WOR_TERM_CS) ? CC1120_RX_TERM_CS : CC1120_RX_TERM_PQT);
+    RETURN_IF_ERROR(status)
+
+    if (cfg->term == CC1120_WOR_TERM_CS) {
+        int16_t csThr = cfg->csThresholdDbm + CC1120_RSSI_OFFSET_DB;
+        if (csThr > INT8_MAX) {
+            mcu_log(CC1120_LOG_LEVEL_ERROR, "cc1120_wor_init: Carrier sense threshold out of range!\n");
+            return CC1120_ERROR_CODE_INVALID_PARAM;
+        }
+
+        uint8_t agcCsThr = (uint8_t)(int8_t)csThr;
+        status = cc1120_write_spi(dev, CC1120_REGS_AGC_CS_THR, &agcCsThr, 1);
+        RETURN_IF_ERROR(status)
+    } else {
+        status = CC1120_FIELD_WRITE2(dev, PREAMBLE_CFG0_PQT_EN, 1, PREAMBLE_CFG0_PQT, cfg->pqt);
+        RETURN_IF_ERROR(status)
+    }
+
+    return cc1120_gpio_map(dev, dispatcher, cfg->wakeGpio, CC1120_GPIO_CFG_PKT_CRC_OK, false,
+                           CC1120_GPIO_EDGE_RISING, onPacket, ctx);
+}
+
+/**
+ * @brief Resets the WOR timer and starts sniffing. The radio sleeps between wake-ups.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If WOR was started.
+ * @return An error code - If the radio did not reach IDLE, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_wor_start(cc1120_dev_t *dev) {
+    cc1120_status_code status = cc1120_strobe_spi(dev, CC1120_STROBE_SIDLE);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_wait_for_state(dev, CC1120_MARCSTATE_IDLE, CC1120_WOR_IDLE_TIMEOUT_US);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SFRX);
+    RETURN_IF_ERROR(status)
+
+    status = cc1120_strobe_spi(dev, CC1120_STROBE_SWORRST);
+    RETURN_IF_ERROR(status)
+
+    return cc1120_strobe_spi(dev, CC1120_STROBE_SWOR);
+}
+
+/**
+ * @brief Estimates the average current and worst-case wake latency of a sniff configuration.
+ * The latency runs from the start of a transmission to the radio locking on to it,
+ * so add the packet airtime for the time until the MCU is woken.
+ *
+ * @param timing - The timing from cc1120_wor_compute.
+ * @param power - The current draw per state, or NULL for the CC1120_WOR_DEFAULT_* values.
+ * @param avgCurrentNa - Set to the average current in nA when no packets arrive, with RX ended early.
+ * @param worstLatencyUs - Set to the worst-case wake latency.
+ */
+void cc1120_wor_estimate(const cc1120_wor_timing_t *timing, const cc1120_wor_power_t *power,
+                         uint32_t *avgCurrentNa, uint32_t *worstLatencyUs) {
+    static const cc1120_wor_power_t defaults = {
+        CC1120_WOR_DEFAULT_SLEEP_NA,
+        CC1120_WOR_DEFAULT_IDLE_NA,
+        CC1120_WOR_DEFAULT_RX_NA,
+    };
+
+    if (power == NULL)
+        power = &defaults;
+
+    uint64_t awakeUs = (uint64_t)timing->event1Us + CC1120_WOR_SETTLE_US + timing->termUs;
+    uint64_t sleepUs = (timing->intervalUs > awakeUs) ? timing->intervalUs - awakeUs : 0;
+
+    // Charge per interval in nA*us, averaged over the interval
+    uint64_t charge = sleepUs * power->sleepNa +
+                      ((uint64_t)timing->event1Us + CC1120_WOR_SETTLE_US) * power->idleNa +
+                      (uint64_t)timing->termUs * power->rxNa;
+    *avgCurrentNa = (uint32_t)(charge / (sleepUs + awakeUs));
+
+    // A transmission that starts just as an RX window closes is heard in the next one
+    *worstLatencyUs = timing->intervalUs + timing->event1Us + CC1120_WOR_SETTLE_US;
+}
@@ -0,0 +1,128 @@
+#ifndef CC1120_WOR_H
+#define CC1120_WOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cc1120_logging.h"
+#include "cc1120_dev.h"
+#include "cc1120_gpio.h"
+#include "cc1120_txrx.h"
+
+/* The RC oscillator is calibrated to f_XOSC / 1000. See section 9.6 of the user guide. */
+#define CC1120_WOR_RCOSC_HZ (CC1120_XOSC_FREQ_HZ / 1000ULL)
+
+#define CC1120_WOR_MAX_RES 3U
+
+/* EVENT1 code 4 is 16 RC periods, 500 us for the crystal to start before RX */
+#define CC1120_WOR_DEFAULT_EVENT1 4U
+
+/* Synthesizer settling between the crystal being stable and the start of RX */
+#define CC1120_WOR_SETTLE_US 100UL
+
+/*
+ * Symbols RX takes to decide that nothing is there when terminated early: the RSSI becoming valid for carrier
+ * sense, or the preamble quality being evaluated for PQT. Estimates for the default AGC and PQT settings.
+ */
+#ifndef CC1120_WOR_CS_TERM_SYMBOLS
+#define CC1120_WOR_CS_TERM_SYMBOLS 8U
+#endif
+#ifndef CC1120_WOR_PQT_TERM_SYMBOLS
+#define CC1120_WOR_PQT_TERM_SYMBOLS 16U
+#endif
+
+/* Current draw per state in nA, from the datasheet, for cc1120_wor_estimate */
+#define CC1120_WOR_DEFAULT_SLEEP_NA 500UL           /* SLEEP with the RC oscillator running */
+#define CC1120_WOR_DEFAULT_IDLE_NA 1500000UL        /* Crystal starting up and synthesizer settling */
+#define CC1120_WOR_DEFAULT_RX_NA 22000000UL         /* RX, high performance mode */
+
+/* What keeps the radio in RX: without it, RX ends early, and with it RX lasts until sync or the RX timeout */
+typedef enum {
+    CC1120_WOR_TERM_CS = 0,     /* Carrier sense above the AGC_CS_THR threshold */
+    CC1120_WOR_TERM_PQT         /* Preamble quality above the PQT threshold */
+} cc1120_wor_term_t;
+
+typedef struct {
+    uint32_t sniffIntervalUs;   /* Time between wake-ups */
+    uint32_t rxWindowUs;        /* Minimum time in RX per wake-up to find sync once carrier sense or PQT was seen */
+    uint32_t symbolRate;        /* Symbols per second, for the early termination time, or 0 if not known */
+    cc1120_wor_term_t term;
+    int8_t csThresholdDbm;      /* Only used with CC1120_WOR_TERM_CS */
+    uint8_t pqt;                /* Only used with CC1120_WOR_TERM_PQT, 0-15 */
+    uint8_t event1;             /* WOR_CFG1.EVENT1, see CC1120_WOR_DEFAULT_EVENT1 */
+    uint8_t wakeGpio;           /* CC1120 GPIO carrying PKT_CRC_OK to the MCU */
+} cc1120_wor_cfg_t;
+
+/* Register values computed by cc1120_wor_compute, and the times they give */
+typedef struct {
+    uint8_t worRes;
+    uint16_t event0;
+    uint8_t event1;
+    uint8_t rxTime;
+    uint32_t intervalUs;        /* Actual time between wake-ups */
+    uint32_t event1Us;          /* Time from wake-up to the crystal being stable */
+    uint32_t rxTimeoutUs;       /* Longest time in RX per wake-up, when carrier sense or PQT is seen without sync */
+    uint32_t termUs;            /* Time in RX per wake-up when nothing is heard, at most rxTimeoutUs */
+    uint32_t minPreambleUs;     /* Shortest preamble a transmitter must send to be heard */
+} cc1120_wor_timing_t;
+
+/* Current draw per state in nA */
+typedef struct {
+    uint32_t sleepNa;
+    uint32_t idleNa;
+    uint32_t rxNa;
+} cc1120_wor_power_t;
+
+/**
+ * @brief Computes the eWOR register values for a sniff configuration without touching the radio.
+ * Picks the finest WOR_RES that fits the interval in EVENT0, and the shortest RX timeout
+ * that is at least the requested RX window, and the time RX takes when carrier sense or PQT ends it early.
+ *
+ * @param cfg - The sniff configuration.
+ * @param timing - Filled with the register values and the resulting times.
+ * @return CC1120_ERROR_CODE_SUCCESS - If the configuration can be met.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the interval is out of range, or the RX window does not fit in it.
+ */
+cc1120_status_code cc1120_wor_compute(const cc1120_wor_cfg_t *cfg, cc1120_wor_timing_t *timing);
+
+/**
+ * @brief Programs eWOR: the event timing, the RX timeout, early RX termination on carrier sense or PQT,
+ * and the RC oscillator calibration. Routes PKT_CRC_OK to the wake GPIO so the MCU is only
+ * interrupted for a packet that passed CRC. The radio returns to IDLE after the packet,
+ * so call cc1120_wor_start again after reading it. Does not start WOR.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @param dispatcher - The GPIO dispatcher of this CC1120.
+ * @param cfg - The sniff configuration.
+ * @param timing - Filled with the register values and the resulting times.
+ * @param onPacket - Called from interrupt context when a packet is received.
+ * @param ctx - Passed to onPacket.
+ * @return CC1120_ERROR_CODE_SUCCESS - If eWOR was configured.
+ * @return CC1120_ERROR_CODE_INVALID_PARAM - If the configuration cannot be met.
+ * @return An error code - If an SPI transfer failed.
+ */
+cc1120_status_code cc1120_wor_init(cc1120_dev_t *dev, cc1120_gpio_dispatcher_t *dispatcher, const cc1120_wor_cfg_t *cfg,
+                                   cc1120_wor_timing_t *timing, cc1120_gpio_handler_t onPacket, void *ctx);
+
+/**
+ * @brief Resets the WOR timer and starts sniffing. The radio sleeps between wake-ups.
+ *
+ * @param dev - The CC1120 to talk to.
+ * @return CC1120_ERROR_CODE_SUCCESS - If WOR was started.
+ * @return An error code - If the radio did not reach IDLE, or an SPI transfer failed.
+ */
+cc1120_status_code cc1120_wor_start(cc1120_dev_t *dev);
+
+/**
+ * @brief Estimates the average current and worst-case wake latency of a sniff configuration.
+ * The latency runs from the start of a transmission to the radio locking on to it,
+ * so add the packet airtime for the time until the MCU is woken.
+ *
+ * @param timing - The timing from cc1120_wor_compute.
+ * @param power - The current draw per state, or NULL for the CC1120_WOR_DEFAULT_* values.
+ * @param avgCurrentNa - Set to the average current in nA when no packets arrive, with RX ended early.
+ * @param worstLatencyUs - Set to the worst-case wake latency.
+ */
+void cc1120_wor_estimate(const cc1120_wor_timing_t *timing, const cc1120_wor_power_t *power,
+                         uint32_t *avgCurrentNa, uint32_t *worstLatencyUs);
+
+#endif /* CC1120_WOR_H */
@@ -0,0 +1,162 @@
+/*
+ * Host test of the coroutine executor, cc1120_co, over the link emulator: a thousand emulated links, each
+ * with a pinging and an echoing coroutine, run from one executor. Checks that most pings come back over a
+ * lossy channel and that cc1120_co_send only finishes once the packet is out, and reports the executor's work.
+ *
+ *   cc -std=c99 -Wall -DCC1120_CO_MAX_TASKS=2000U -I../cc1120_arduino co_test.c ../cc1120_arduino/cc1120_co.c \
+ *       ../cc1120_arduino/cc1120_emu.c ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_spi.c \
+ *       ../cc1120_arduino/cc1120_txrx.c ../cc1120_arduino/cc1120_fields.c ../cc1120_arduino/cc1120_mcu.c \
+ *       ../cc1120_arduino/cc1120_modem.c ../cc1120_arduino/cc1120_stats.c ../cc1120_arduino/cc1120_spi_tests.c \
+ *       -o co_test
+ */
+#include "host_test.h"
+#include "cc1120_emu.h"
+#include "cc1120_co.h"
+#include "cc1120_txrx.h"
+#include "cc1120_spi.h"
+#include "cc1120_mcu.h"
+#include <string.h>
+
+#define LINKS 1000U
+#define PINGS 10U
+#define PING_LEN 20U
+
+/* Executor pass period, in virtual time */
+#define PASS_US 200U
+
+/* Virtual time of one SPI byte, short because the links share the clock */
+#define SPI_BYTE_NS 10U
+
+#if CC1120_CO_MAX_TASKS < 2 * LINKS
+#error "co_test needs CC1120_CO_MAX_TASKS of at least 2 * LINKS"
+#endif
+
+#if CC1120_EMU_MAX_LINKS < LINKS
+#error "co_test needs CC1120_EMU_MAX_LINKS of at least LINKS"
+#endif
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+typedef struct {
+    cc1120_dev_t *dev;
+    cc1120_emu_radio_t *radio;
+    uint8_t buf[32];
+    uint8_t len;
+    uint8_t i;
+} ping_t;
+
+typedef struct {
+    uint32_t ok;
+    uint32_t failed;
+    uint32_t sendsEarly;        /* Sends that finished with the packet not fully on air */
+} ping_counts_t;
+
+static cc1120_co_exec_t exec;
+static cc1120_emu_link_t links[LINKS];
+static cc1120_dev_t devs[2 * LINKS];
+static ping_counts_t counts;
+
+/**
+ * @brief Checks that a send which finished left nothing of the packet behind.
+ *
+ * @param co - The coroutine that awaited cc1120_co_send.
+ * @param radio - The emulated radio that sent.
+ */
+static void check_sent(cc1120_co_t *co, const cc1120_emu_radio_t *radio) {
+    if (co->result == CC1120_ERROR_CODE_SUCCESS && (radio->state == CC1120_STATE_TX || radio->txCount != 0))
+        counts.sendsEarly++;
+}
+
+static void pinger(cc1120_co_t *co) {
+    ping_t *p = co->frame;
+
+    CC1120_CO_BEGIN(co);
+    for (p->i = 0; p->i < PINGS; p->i++) {
+        memset(p->buf, p->i, PING_LEN);
+        CC1120_CO_AWAIT(co, cc1120_co_send(co, p->dev, p->buf, PING_LEN, 100000));
+        check_sent(co, p->radio);
+        if (co->result != CC1120_ERROR_CODE_SUCCESS) {
+            counts.failed++;
+            continue;
+        }
+
+        CC1120_CO_AWAIT(co, cc1120_co_receive(co, p->dev, p->buf, sizeof(p->buf), &p->len, 200000));
+        if (co->result == CC1120_ERROR_CODE_SUCCESS && p->len == PING_LEN && p->buf[PING_LEN - 1] == p->i)
+            counts.ok++;
+        else
+            counts.failed++;
+        CC1120_CO_AWAIT(co, cc1120_co_sleep(co, 5000));
+    }
+    CC1120_CO_END(co);
+}
+
+static void echo(cc1120_co_t *co) {
+    ping_t *p = co->frame;
+
+    CC1120_CO_BEGIN(co);
+    for (;;) {
+        CC1120_CO_AWAIT(co, cc1120_co_receive(co, p->dev, p->buf, sizeof(p->buf), &p->len, 1000000));
+        if (co->result == CC1120_ERROR_CODE_STATE_TIMEOUT)
+            break;
+        if (co->result != CC1120_ERROR_CODE_SUCCESS)
+            continue;
+        CC1120_CO_AWAIT(co, cc1120_co_send(co, p->dev, p->buf, p->len, 100000));
+        check_sent(co, p->radio);
+    }
+    CC1120_CO_END(co);
+}
+
+int main(void) {
+    cc1120_emu_channel_t channel = {0};
+    uint32_t passes = 0;
+    uint32_t l;
+
+    channel.delayUs = 100;
+    channel.rssiDbm = -80;
+    channel.lqi = 10;
+    channel.ber = 2e-4;
+    channel.lossProb = 0.02;
+
+    cc1120_co_exec_init(&exec);
+    for (l = 0; l < LINKS; l++) {
+        uint8_t side;
+        HOST_CHECK(cc1120_emu_link_init(&links[l], &channel, SPI_BYTE_NS, l + 1) == CC1120_ERROR_CODE_SUCCESS);
+        for (side = 0; side < 2; side++) {
+            cc1120_dev_t *dev = &devs[2 * l + side];
+            cc1120_dev_init(dev, &CC1120_EMU_TRANSPORT, &links[l].radios[side], 0);
+            HOST_CHECK(cc1120_tx_init(dev) == CC1120_ERROR_CODE_SUCCESS);
+
+            cc1120_co_t *co = cc1120_co_spawn(&exec, side == 0 ? pinger : echo, sizeof(ping_t));
+            HOST_CHECK(co != NULL);
+            if (co == NULL)
+                return HOST_TEST_RESULT("co_test");
+            ping_t *p = co->frame;
+            p->dev = dev;
+            p->radio = &links[l].radios[side];
+        }
+    }
+
+    uint64_t startNs = cc1120_emu_time_ns();
+    do {
+        cc1120_emu_advance(PASS_US);
+        passes++;
+    } while (cc1120_co_exec_run(&exec, mcu_get_time_us()) > 0);
+    double seconds = (double)(cc1120_emu_time_ns() - startNs) / 1e9;
+
+    uint32_t sent = 0;
+    for (l = 0; l < LINKS; l++)
+        sent += links[l].stats[0].packetsSent + links[l].stats[1].packetsSent;
+
+    printf("%u links, %lu coroutines: %lu/%u pings back, %lu failed, %lu packets in %.2f s virtual\n", LINKS,
+           (unsigned long)exec.stats.spawned, (unsigned long)counts.ok, LINKS * PINGS, (unsigned long)counts.failed,
+           (unsigned long)sent, seconds);
+    printf("%lu passes, %lu resumes, %lu polls, high water %u\n", (unsigned long)passes,
+           (unsigned long)exec.stats.resumes, (unsigned long)exec.stats.polls, exec.stats.highWater);
+
+    HOST_CHECK(exec.stats.finished == 2 * LINKS && exec.stats.highWater == 2 * LINKS);
+    HOST_CHECK(counts.ok + counts.failed == LINKS * PINGS);
+    HOST_CHECK(counts.ok >= LINKS * PINGS * 8 / 10);
+    HOST_CHECK(counts.sendsEarly == 0);
+
+    return HOST_TEST_RESULT("co_test");
+}
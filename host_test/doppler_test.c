@@ -0,0 +1,256 @@
+/*
+ * Host test of the Doppler tracker, cc1120_doppler: the RX loop follows the Doppler profile of an overhead
+ * pass through a simulated FREQOFF/FREQOFF_EST register pair, with noisy estimates, false syncs and
+ * pre-compensated transmissions in between. Checks that the loop converges and stays within its clamp,
+ * that false syncs are rejected, and that a transmission leaves the RX loop offset alone.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino doppler_test.c ../cc1120_arduino/cc1120_doppler.c \
+ *       ../cc1120_arduino/cc1120_spi.c ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_fields.c \
+ *       ../cc1120_arduino/cc1120_stats.c -lm -o doppler_test
+ */
+#include "host_test.h"
+#include "cc1120_doppler.h"
+#include "cc1120_regs.h"
+#include <math.h>
+#include <string.h>
+
+#define CARRIER_HZ 437000000.0
+#define LIGHT_KM_S 299792.458
+
+/* Overhead pass from horizon to horizon */
+#define PASS_MS 800000UL
+#define ALTITUDE_KM 500.0
+#define GROUND_SPEED_KM_S 7.5
+
+/* A packet is received every PACKET_MS, and every TX_EVERY packets the station transmits */
+#define PACKET_MS 500UL
+#define TX_EVERY 5U
+
+/* Every OUTLIER_EVERY packets the estimate comes from a false sync */
+#define OUTLIER_EVERY 50U
+
+/* Spread of FREQOFF_EST around the true offset, in LSBs */
+#define EST_NOISE_LSB 3
+
+/* Packets the loop gets to pull in from zero offset */
+#define SETTLE_PACKETS 30U
+
+/* Worst tracking error allowed after settling; the loop lags by about 2^gainShift packets of Doppler rate */
+#define MAX_ERROR_HZ 500
+
+#define CURVE_STEP_MS 10000UL
+#define CURVE_LEN (PASS_MS / CURVE_STEP_MS + 1)
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+/* Register file answering like a CC1120 in IDLE */
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ext[256];
+    uint16_t pos;
+    uint8_t header;
+    uint8_t addr;
+    bool isExt;
+    uint32_t transactions;
+} sim_t;
+
+typedef struct {
+    int32_t maxErrorHz;         /* Worst |loop offset - Doppler| after settling */
+    int32_t maxOffsetHz;        /* Worst |loop offset| over the pass */
+    uint32_t outliers;          /* False syncs injected */
+    uint32_t txLeaks;           /* Transmissions that moved the loop or left the TX offset in the radio */
+} track_result_t;
+
+static cc1120_doppler_point_t curve[CURVE_LEN];
+static uint32_t nowUs;
+static uint32_t seed;
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+uint32_t mcu_get_time_us() {
+    return nowUs += 3;
+}
+
+static uint8_t sim_transfer(void *bus, uint8_t data) {
+    sim_t *sim = bus;
+    uint8_t reply = 0;
+
+    if (sim->pos == 0) {
+        sim->header = data;
+        sim->addr = data & 0x3FU;
+        sim->isExt = (sim->addr == 0x2FU);
+    } else if (sim->isExt && sim->pos == 1) {
+        sim->addr = data;
+    } else {
+        uint8_t *mem = sim->isExt ? sim->ext : sim->regs;
+        if (sim->header & 0x80U)
+            reply = mem[sim->addr];
+        else
+            mem[sim->addr] = data;
+        if (sim->header & 0x40U)
+            sim->addr++;
+    }
+
+    sim->pos++;
+    return reply;
+}
+
+static void sim_cs_assert(void *bus, uint8_t csPin) {
+    sim_t *sim = bus;
+
+    (void)csPin;
+    sim->pos = 0;
+    sim->transactions++;
+}
+
+static void sim_cs_deassert(void *bus, uint8_t csPin) {
+    (void)bus;
+    (void)csPin;
+}
+
+static const cc1120_transport_ops_t SIM_OPS = { sim_transfer, sim_cs_assert, sim_cs_deassert, NULL, NULL };
+
+static int16_t sim_get16(const sim_t *sim, uint8_t ext) {
+    return (int16_t)(((uint16_t)sim->ext[ext] << 8) | sim->ext[ext + 1]);
+}
+
+static void sim_set16(sim_t *sim, uint8_t ext, int16_t value) {
+    sim->ext[ext] = (uint8_t)((uint16_t)value >> 8);
+    sim->ext[ext + 1] = (uint8_t)value;
+}
+
+/**
+ * @brief Draws a uniform integer in [-spread, spread] from a fixed seed, so every run sees the same pass.
+ *
+ * @param spread - The largest magnitude.
+ * @return int32_t - The number.
+ */
+static int32_t noise(int32_t spread) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return (int32_t)((seed >> 8) % (uint32_t)(2 * spread + 1)) - spread;
+}
+
+/**
+ * @brief Gets the Doppler shift of the pass, positive while the satellite approaches.
+ *
+ * @param timeMs - The time since the start of the pass.
+ * @return double - The shift in Hz.
+ */
+static double pass_doppler_hz(uint32_t timeMs) {
+    double alongKm = GROUND_SPEED_KM_S * ((double)timeMs - PASS_MS / 2.0) / 1000.0;
+    double rangeKm = sqrt(alongKm * alongKm + ALTITUDE_KM * ALTITUDE_KM);
+
+    return -CARRIER_HZ * GROUND_SPEED_KM_S / LIGHT_KM_S * alongKm / rangeKm;
+}
+
+static int32_t abs32(int32_t value) {
+    return value < 0 ? -value : value;
+}
+
+/**
+ * @brief Receives a pass, updating the loop after every packet and pre-compensating every TX_EVERY packets.
+ *
+ * @param tracker - The tracker, initialized with its gain and limit.
+ * @param result - Filled with the tracking error and the outlier and TX counts.
+ */
+static void track_pass(cc1120_doppler_t *tracker, track_result_t *result) {
+    static sim_t sim;
+    cc1120_dev_t dev;
+    uint32_t packet = 0;
+    uint32_t timeMs;
+
+    memset(&sim, 0, sizeof(sim));
+    memset(result, 0, sizeof(*result));
+    seed = 4321;
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    cc1120_doppler_set_curve(tracker, curve, CURVE_LEN);
+
+    for (timeMs = 0; timeMs <= PASS_MS; timeMs += PACKET_MS, packet++) {
+        int16_t trueOff = cc1120_doppler_hz_to_freqoff((int32_t)lround(pass_doppler_hz(timeMs)));
+
+        // The radio estimates the offset left after the FREQOFF it is receiving with
+        int16_t estimate = (int16_t)(trueOff - sim_get16(&sim, CC1120_REGS_EXT_FREQOFF1) + noise(EST_NOISE_LSB));
+        if (packet % OUTLIER_EVERY == OUTLIER_EVERY - 1) {
+            estimate = (int16_t)((packet & 1U) ? 2 * tracker->limit + 1 : -2 * tracker->limit - 1);
+            result->outliers++;
+        }
+        sim_set16(&sim, CC1120_REGS_EXT_FREQOFF_EST1, estimate);
+
+        int16_t before = tracker->freqOff;
+        HOST_CHECK(cc1120_doppler_update_rx(&dev, tracker) == CC1120_ERROR_CODE_SUCCESS);
+        HOST_CHECK(sim_get16(&sim, CC1120_REGS_EXT_FREQOFF1) == tracker->freqOff);
+        if (packet % OUTLIER_EVERY == OUTLIER_EVERY - 1)
+            HOST_CHECK(tracker->freqOff == before);
+
+        int32_t offsetHz = cc1120_doppler_freqoff_to_hz(tracker->freqOff);
+        if (abs32(offsetHz) > result->maxOffsetHz)
+            result->maxOffsetHz = abs32(offsetHz);
+        int32_t errorHz = offsetHz - cc1120_doppler_freqoff_to_hz(trueOff);
+        if (packet >= SETTLE_PACKETS && abs32(errorHz) > result->maxErrorHz)
+            result->maxErrorHz = abs32(errorHz);
+
+        if (packet % TX_EVERY != TX_EVERY - 1)
+            continue;
+
+        // A transmission writes its own offset, which must neither move the loop nor stay in the radio for RX
+        before = tracker->freqOff;
+        HOST_CHECK(cc1120_doppler_precompensate_tx(&dev, tracker, timeMs) == CC1120_ERROR_CODE_SUCCESS);
+        HOST_CHECK(sim_get16(&sim, CC1120_REGS_EXT_FREQOFF1) == tracker->txFreqOff);
+        HOST_CHECK(cc1120_doppler_restore_rx(&dev, tracker) == CC1120_ERROR_CODE_SUCCESS);
+        if (tracker->freqOff != before || sim_get16(&sim, CC1120_REGS_EXT_FREQOFF1) != before)
+            result->txLeaks++;
+    }
+
+    // Restoring an offset the radio already holds costs no SPI transaction
+    uint32_t transactions = sim.transactions;
+    HOST_CHECK(cc1120_doppler_restore_rx(&dev, tracker) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(sim.transactions == transactions);
+}
+
+int main(void) {
+    cc1120_doppler_t tracker;
+    track_result_t wide;
+    track_result_t narrow;
+    uint16_t i;
+
+    for (i = 0; i < CURVE_LEN; i++) {
+        curve[i].timeMs = i * CURVE_STEP_MS;
+        curve[i].dopplerHz = (int32_t)lround(pass_doppler_hz(curve[i].timeMs));
+    }
+    printf("pass Doppler %+.0f Hz to %+.0f Hz\n", pass_doppler_hz(0), pass_doppler_hz(PASS_MS));
+
+    // The default limit covers the whole pass, so the loop follows it closely
+    cc1120_doppler_init(&tracker, CC1120_DOPPLER_DEFAULT_GAIN_SHIFT, CC1120_DOPPLER_DEFAULT_LIMIT_HZ);
+    track_pass(&tracker, &wide);
+    printf("limit %5ld Hz: max error %ld Hz, max offset %ld Hz, %lu/%lu outliers rejected, %lu TX leaks\n",
+           (long)CC1120_DOPPLER_DEFAULT_LIMIT_HZ, (long)wide.maxErrorHz, (long)wide.maxOffsetHz,
+           (unsigned long)tracker.rejected, (unsigned long)wide.outliers, (unsigned long)wide.txLeaks);
+    HOST_CHECK(wide.maxErrorHz <= MAX_ERROR_HZ);
+    HOST_CHECK(wide.maxOffsetHz <= CC1120_DOPPLER_DEFAULT_LIMIT_HZ);
+    HOST_CHECK(tracker.rejected == wide.outliers && wide.outliers > 0);
+    HOST_CHECK(tracker.updates + tracker.rejected == PASS_MS / PACKET_MS + 1);
+    HOST_CHECK(wide.txLeaks == 0);
+
+    // A limit below the peak Doppler holds the loop at the clamp near the horizons
+    int32_t limitHz = (int32_t)(fabs(pass_doppler_hz(0)) * 0.6);
+    int32_t clampHz = cc1120_doppler_freqoff_to_hz(cc1120_doppler_hz_to_freqoff(limitHz));
+    cc1120_doppler_init(&tracker, CC1120_DOPPLER_DEFAULT_GAIN_SHIFT, limitHz);
+    track_pass(&tracker, &narrow);
+    printf("limit %5ld Hz: max offset %ld Hz, %lu/%lu outliers rejected, %lu TX leaks\n", (long)limitHz,
+           (long)narrow.maxOffsetHz, (unsigned long)tracker.rejected, (unsigned long)narrow.outliers,
+           (unsigned long)narrow.txLeaks);
+    HOST_CHECK(narrow.maxOffsetHz == clampHz);
+    HOST_CHECK(abs32(tracker.txFreqOff) <= tracker.limit);
+    HOST_CHECK(tracker.rejected == narrow.outliers);
+    HOST_CHECK(narrow.txLeaks == 0);
+
+    // A single estimate moves the loop by a rounded 1/2^gainShift of it
+    cc1120_doppler_init(&tracker, 2, CC1120_DOPPLER_DEFAULT_LIMIT_HZ);
+    HOST_CHECK(cc1120_doppler_step(&tracker, 10) == 3 && cc1120_doppler_step(&tracker, -10) == -3);
+    HOST_CHECK(cc1120_doppler_step(&tracker, 1) == 0 && tracker.updates == 3);
+
+    return HOST_TEST_RESULT("doppler_test");
+}
@@ -0,0 +1,251 @@
+/*
+ * Host test of the downlink scheduler, cc1120_downlink. Checks the choice of the next packet on a stubbed
+ * clock, then runs mixed traffic through cc1120_downlink_service against the link emulator and reports
+ * how much of the time the radio spends on air, next to draining the TX FIFO between packets.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino downlink_test.c ../cc1120_arduino/cc1120_downlink.c \
+ *       ../cc1120_arduino/cc1120_emu.c ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_spi.c \
+ *       ../cc1120_arduino/cc1120_txrx.c ../cc1120_arduino/cc1120_fields.c ../cc1120_arduino/cc1120_mcu.c \
+ *       ../cc1120_arduino/cc1120_modem.c ../cc1120_arduino/cc1120_stats.c ../cc1120_arduino/cc1120_spi_tests.c \
+ *       -o downlink_test
+ */
+#include "host_test.h"
+#include "cc1120_downlink.h"
+#include "cc1120_emu.h"
+#include "cc1120_txrx.h"
+#include "cc1120_spi.h"
+#include "cc1120_mcu.h"
+#include "cc1120_regs.h"
+
+/* Virtual time the scheduler run lasts, and the main loop period: the loop has other work to do,
+ * but comes round well within a packet airtime */
+#define RUN_US 20000000UL
+#define LOOP_US 5000U
+
+/* Time given at the end for the queues and the TX FIFO to empty */
+#define DRAIN_US 10000000UL
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+static uint32_t stubUs;
+static uint8_t payload[CC1120_TX_FIFO_SIZE];
+static uint32_t doneCount[CC1120_DOWNLINK_CLASS_COUNT];
+
+static uint32_t stub_time_us(void) {
+    return stubUs;
+}
+
+static void on_done(void *ctx, cc1120_downlink_class_t cls, uint8_t *data, cc1120_status_code status) {
+    (void)ctx;
+    (void)data;
+    if (status == CC1120_ERROR_CODE_SUCCESS)
+        doneCount[cls]++;
+}
+
+/**
+ * @brief Takes the next packet and checks its class.
+ *
+ * @param dl - The scheduler.
+ * @param expected - The class that should be chosen.
+ */
+static void expect_next(cc1120_downlink_t *dl, cc1120_downlink_class_t expected) {
+    cc1120_downlink_class_t cls = CC1120_DOWNLINK_CLASS_COUNT;
+    cc1120_downlink_pkt_t pkt;
+
+    HOST_CHECK(cc1120_downlink_next(dl, stubUs, &cls, &pkt));
+    HOST_CHECK(cls == expected);
+}
+
+/**
+ * @brief Checks queueing, priority, deadlines, token buckets, expiry and the latency percentiles.
+ */
+static void test_scheduler(void) {
+    cc1120_downlink_class_cfg_t cfg[CC1120_DOWNLINK_CLASS_COUNT] = {{0}};
+    cc1120_downlink_t dl;
+    cc1120_downlink_class_t cls;
+    cc1120_downlink_pkt_t pkt;
+    uint8_t i;
+
+    mcu_host_time_us = stub_time_us;
+    stubUs = 1000;
+
+    cfg[CC1120_DOWNLINK_ACK].rateBytesPerSec = 1000;
+    cfg[CC1120_DOWNLINK_ACK].burstBytes = 20;
+    cfg[CC1120_DOWNLINK_HOUSEKEEPING].deadlineUs = 30000;
+    cfg[CC1120_DOWNLINK_BULK].maxAgeUs = 50000;
+    cc1120_downlink_init(&dl, cfg, NULL, NULL);
+
+    HOST_CHECK(!cc1120_downlink_next(&dl, stubUs, &cls, &pkt));
+    HOST_CHECK(cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_CLASS_COUNT, payload, 10) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_BULK, payload, 0) == CC1120_ERROR_CODE_INVALID_PARAM);
+
+    for (i = 0; i < CC1120_DOWNLINK_QUEUE_LEN; i++)
+        HOST_CHECK(cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_BEACON, payload, 10) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_BEACON, payload, 10) == CC1120_ERROR_CODE_QUEUE_FULL);
+    HOST_CHECK(dl.queues[CC1120_DOWNLINK_BEACON].stats.rejected == 1);
+    for (i = 0; i < CC1120_DOWNLINK_QUEUE_LEN; i++)
+        expect_next(&dl, CC1120_DOWNLINK_BEACON);
+
+    // Priority, then the ACK bucket holds one 20 byte packet, then anything queued goes rather than idling
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_HOUSEKEEPING, payload, 60);
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_ACK, payload, 20);
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_ACK, payload, 20);
+    expect_next(&dl, CC1120_DOWNLINK_ACK);
+    expect_next(&dl, CC1120_DOWNLINK_HOUSEKEEPING);
+    expect_next(&dl, CC1120_DOWNLINK_ACK);
+
+    // A housekeeping packet within urgentUs of its deadline goes ahead of an ACK with tokens
+    stubUs += 100000;
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_HOUSEKEEPING, payload, 60);
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_ACK, payload, 20);
+    stubUs += 5000;
+    expect_next(&dl, CC1120_DOWNLINK_ACK);
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_ACK, payload, 20);
+    stubUs += 100000;
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_ACK, payload, 20);
+    expect_next(&dl, CC1120_DOWNLINK_HOUSEKEEPING);
+    expect_next(&dl, CC1120_DOWNLINK_ACK);
+    expect_next(&dl, CC1120_DOWNLINK_ACK);
+
+    // Bulk packets past their maximum age are dropped, not sent
+    cc1120_downlink_enqueue(&dl, CC1120_DOWNLINK_BULK, payload, 100);
+    stubUs += 60000;
+    HOST_CHECK(!cc1120_downlink_next(&dl, stubUs, &cls, &pkt));
+    HOST_CHECK(dl.queues[CC1120_DOWNLINK_BULK].stats.expired == 1);
+
+    HOST_CHECK(cc1120_downlink_latency_percentile_us(&dl, CC1120_DOWNLINK_BEACON, 50) == 0);
+    HOST_CHECK(cc1120_downlink_latency_percentile_us(&dl, CC1120_DOWNLINK_HOUSEKEEPING, 100) ==
+               dl.queues[CC1120_DOWNLINK_HOUSEKEEPING].stats.maxLatencyUs);
+    HOST_CHECK(cc1120_downlink_latency_percentile_us(&dl, CC1120_DOWNLINK_BULK, 50) == 0);
+
+    cc1120_downlink_reset_stats(&dl);
+    HOST_CHECK(dl.queues[CC1120_DOWNLINK_BEACON].stats.rejected == 0);
+}
+
+/**
+ * @brief Keeps every class queue topped up with its share of mixed traffic.
+ *
+ * @param dl - The scheduler.
+ * @param nowUs - The current time.
+ * @param lastUs - The time of the last top-up, updated.
+ */
+static void offer_traffic(cc1120_downlink_t *dl, uint32_t nowUs, uint32_t lastUs[CC1120_DOWNLINK_CLASS_COUNT]) {
+    static const uint32_t periodUs[CC1120_DOWNLINK_CLASS_COUNT] = {1000000, 50000, 100000, 0};
+    static const uint8_t len[CC1120_DOWNLINK_CLASS_COUNT] = {20, 10, 60, 100};
+    uint8_t c;
+
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++) {
+        // Bulk always has something waiting, so the link is saturated
+        if (periodUs[c] == 0) {
+            while (cc1120_downlink_enqueue(dl, (cc1120_downlink_class_t)c, payload, len[c]) == CC1120_ERROR_CODE_SUCCESS)
+                ;
+        } else if (nowUs - lastUs[c] >= periodUs[c]) {
+            cc1120_downlink_enqueue(dl, (cc1120_downlink_class_t)c, payload, len[c]);
+            lastUs[c] = nowUs;
+        }
+    }
+}
+
+/**
+ * @brief The service loop before loading behind the packet on air: wait for TX to end and the FIFO
+ * to drain, then cc1120_send.
+ *
+ * @param dev - The transmitter.
+ * @param dl - The scheduler.
+ */
+static void drain_service(cc1120_dev_t *dev, cc1120_downlink_t *dl) {
+    cc1120_downlink_class_t cls;
+    cc1120_downlink_pkt_t pkt;
+    uint8_t txBytes;
+
+    cc1120_strobe_spi(dev, CC1120_STROBE_SNOP);
+    if ((dev->lastStatus & CC1120_STATE_MASK) == CC1120_STATE_TX)
+        return;
+    cc1120_fifo_recover(dev);
+    cc1120_get_packets_in_tx_fifo(dev, &txBytes);
+    if (txBytes != 0 || !cc1120_downlink_next(dl, mcu_get_time_us(), &cls, &pkt))
+        return;
+    if (cc1120_send(dev, pkt.data, pkt.len) == CC1120_ERROR_CODE_SUCCESS)
+        doneCount[cls]++;
+}
+
+/**
+ * @brief Runs saturated mixed traffic over the emulated link.
+ *
+ * @param preload - true for cc1120_downlink_service, false for drain_service.
+ * @param preloaded - Set to the number of packets loaded behind the one on air.
+ * @return double - The fraction of the time the transmitter was on air.
+ */
+static double run_link(bool preload, uint32_t *preloaded) {
+    static cc1120_emu_link_t link;
+    cc1120_emu_channel_t channel = {0};
+    cc1120_dev_t ground;
+    cc1120_downlink_t dl;
+    uint32_t lastUs[CC1120_DOWNLINK_CLASS_COUNT] = {0};
+    uint32_t sent = 0;
+    uint8_t c;
+
+    channel.rssiDbm = -90;
+    HOST_CHECK(cc1120_emu_link_init(&link, &channel, 1000, 1) == CC1120_ERROR_CODE_SUCCESS);
+    cc1120_dev_init(&ground, &CC1120_EMU_TRANSPORT, &link.radios[0], 0);
+    HOST_CHECK(cc1120_tx_init(&ground) == CC1120_ERROR_CODE_SUCCESS);
+
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++)
+        doneCount[c] = 0;
+    cc1120_downlink_init(&dl, NULL, on_done, NULL);
+    HOST_CHECK(cc1120_downlink_radio_init(&ground, &dl) == CC1120_ERROR_CODE_SUCCESS);
+
+    uint64_t startNs = cc1120_emu_time_ns();
+    while (cc1120_emu_time_ns() - startNs < RUN_US * 1000ULL) {
+        offer_traffic(&dl, mcu_get_time_us(), lastUs);
+        if (preload)
+            HOST_CHECK(cc1120_downlink_service(&ground, &dl) == CC1120_ERROR_CODE_SUCCESS);
+        else
+            drain_service(&ground, &dl);
+        cc1120_emu_advance(LOOP_US);
+    }
+
+    uint64_t endNs = cc1120_emu_time_ns();
+    uint64_t airtimeNs = link.stats[0].airtimeNs;
+    uint32_t onAir = link.stats[0].packetsSent;
+
+    // Let what is queued and loaded go out
+    while (cc1120_emu_time_ns() - endNs < DRAIN_US * 1000ULL) {
+        if (preload)
+            HOST_CHECK(cc1120_downlink_service(&ground, &dl) == CC1120_ERROR_CODE_SUCCESS);
+        else
+            drain_service(&ground, &dl);
+        cc1120_emu_advance(LOOP_US);
+    }
+
+    for (c = 0; c < CC1120_DOWNLINK_CLASS_COUNT; c++)
+        sent += doneCount[c];
+
+    // Every packet handed to the radio went out whole
+    HOST_CHECK(link.stats[0].txUnderflows == 0);
+    HOST_CHECK(link.stats[0].packetsSent == sent);
+    HOST_CHECK(doneCount[CC1120_DOWNLINK_BEACON] > 0 && doneCount[CC1120_DOWNLINK_HOUSEKEEPING] > 0);
+
+    double busy = (double)airtimeNs / (endNs - startNs);
+    printf("%-8s packets %6lu (beacon %lu, ack %lu, housekeeping %lu, bulk %lu)  on air %5.1f%%  %.0f packets/s\n",
+           preload ? "preload" : "drain", (unsigned long)sent, (unsigned long)doneCount[0], (unsigned long)doneCount[1],
+           (unsigned long)doneCount[2], (unsigned long)doneCount[3], busy * 100,
+           onAir * 1e9 / (double)(endNs - startNs));
+
+    *preloaded = dl.preloaded;
+    return busy;
+}
+
+int main(void) {
+    uint32_t preloaded;
+
+    test_scheduler();
+
+    double drained = run_link(false, &preloaded);
+    double loaded = run_link(true, &preloaded);
+    HOST_CHECK(preloaded > 0);
+    HOST_CHECK(loaded > drained);
+    HOST_CHECK(loaded > 0.95);
+
+    return HOST_TEST_RESULT("downlink_test");
+}
@@ -0,0 +1,207 @@
+/*
+ * Host test of the link emulator, cc1120_emu: two unmodified drivers ping each other over an emulated
+ * link, first on a clean channel and then on a lossy one, and the goodput and round trip time are
+ * reported. Also checks that a second link shares the clock, so its packets go out while only the first
+ * link is being driven.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino emu_test.c ../cc1120_arduino/cc1120_emu.c \
+ *       ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_spi.c ../cc1120_arduino/cc1120_txrx.c \
+ *       ../cc1120_arduino/cc1120_fields.c ../cc1120_arduino/cc1120_mcu.c ../cc1120_arduino/cc1120_modem.c \
+ *       ../cc1120_arduino/cc1120_stats.c ../cc1120_arduino/cc1120_spi_tests.c -o emu_test
+ */
+#include "host_test.h"
+#include "cc1120_emu.h"
+#include "cc1120_txrx.h"
+#include "cc1120_spi.h"
+#include "cc1120_mcu.h"
+#include <string.h>
+
+#define PINGS 200U
+#define PING_LEN 60U
+
+/* How long a side listens for the other before giving up on the round trip */
+#define PING_TIMEOUT_US 200000U
+
+/* Polling period while waiting on the radio */
+#define POLL_US 200U
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+typedef struct {
+    uint32_t roundTrips;
+    uint32_t timeouts;
+    uint32_t crcFailures;
+    uint32_t mismatches;
+    uint64_t rttNs;
+    uint64_t elapsedNs;
+} ping_result_t;
+
+/**
+ * @brief Polls a radio until it leaves a state, letting virtual time pass in between.
+ *
+ * @param dev - The radio.
+ * @param state - The MARCSTATE to wait out.
+ * @param timeoutUs - How long to wait.
+ * @return bool - true if the radio left the state in time.
+ */
+static bool wait_leave(cc1120_dev_t *dev, uint8_t state, uint32_t timeoutUs) {
+    uint32_t startUs = mcu_get_time_us();
+    uint8_t now;
+
+    do {
+        cc1120_emu_advance(POLL_US);
+        HOST_CHECK(cc1120_get_state(dev, &now) == CC1120_ERROR_CODE_SUCCESS);
+        if (now != state)
+            return true;
+    } while (mcu_get_time_us() - startUs < timeoutUs);
+
+    return false;
+}
+
+/**
+ * @brief Sends a packet from one radio to the other, which is put in RX first.
+ *
+ * @param from - The sender.
+ * @param to - The receiver.
+ * @param data - The payload.
+ * @param buf - Filled with the received payload.
+ * @param result - Counts timeouts, CRC failures and corrupted payloads.
+ * @return bool - true if the payload arrived intact.
+ */
+static bool hop(cc1120_dev_t *from, cc1120_dev_t *to, uint8_t data[], uint8_t buf[], ping_result_t *result) {
+    uint8_t rxStatus[2];
+    uint8_t len;
+
+    HOST_CHECK(cc1120_strobe_spi(to, CC1120_STROBE_SRX) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_send(from, data, PING_LEN) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(wait_leave(from, CC1120_MARCSTATE_TX, PING_TIMEOUT_US));
+
+    // A lost packet leaves the receiver listening, with no RX timeout to end it
+    if (!wait_leave(to, CC1120_MARCSTATE_RX, PING_TIMEOUT_US)) {
+        result->timeouts++;
+        HOST_CHECK(cc1120_strobe_spi(to, CC1120_STROBE_SIDLE) == CC1120_ERROR_CODE_SUCCESS);
+        HOST_CHECK(cc1120_strobe_spi(to, CC1120_STROBE_SFRX) == CC1120_ERROR_CODE_SUCCESS);
+        return false;
+    }
+
+    cc1120_status_code status = cc1120_receive(to, buf, 128, &len, rxStatus);
+    if (status == CC1120_ERROR_CODE_CRC_FAILED) {
+        result->crcFailures++;
+        return false;
+    }
+    HOST_CHECK(status == CC1120_ERROR_CODE_SUCCESS);
+    if (len != PING_LEN || memcmp(buf, data, PING_LEN) != 0) {
+        result->mismatches++;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Pings from ground to sat, which sends the payload back, and times the round trips.
+ *
+ * @param ground - The side starting each round trip.
+ * @param sat - The side answering.
+ * @param result - Filled with the counts and times.
+ */
+static void ping(cc1120_dev_t *ground, cc1120_dev_t *sat, ping_result_t *result) {
+    uint8_t data[PING_LEN];
+    uint8_t echo[128];
+    uint8_t back[128];
+    uint32_t i;
+
+    memset(result, 0, sizeof(*result));
+    uint64_t startNs = cc1120_emu_time_ns();
+
+    for (i = 0; i < PINGS; i++) {
+        uint8_t k;
+        for (k = 0; k < PING_LEN; k++)
+            data[k] = (uint8_t)(i + k);
+
+        uint64_t sentNs = cc1120_emu_time_ns();
+        if (!hop(ground, sat, data, echo, result))
+            continue;
+        if (!hop(sat, ground, echo, back, result))
+            continue;
+
+        result->roundTrips++;
+        result->rttNs += cc1120_emu_time_ns() - sentNs;
+    }
+
+    result->elapsedNs = cc1120_emu_time_ns() - startNs;
+}
+
+static void report(const char *name, const ping_result_t *result) {
+    double seconds = (double)result->elapsedNs / 1e9;
+    double rttMs = result->roundTrips > 0 ? (double)result->rttNs / result->roundTrips / 1e6 : 0.0;
+
+    printf("%-6s %3lu/%u round trips, %lu timeouts, %lu CRC failures, rtt %.1f ms, goodput %.0f bit/s\n", name,
+           (unsigned long)result->roundTrips, PINGS, (unsigned long)result->timeouts,
+           (unsigned long)result->crcFailures, rttMs, 2.0 * PING_LEN * 8 * result->roundTrips / seconds);
+}
+
+int main(void) {
+    static cc1120_emu_link_t link;
+    static cc1120_emu_link_t other;
+    cc1120_emu_channel_t channel = {0};
+    cc1120_dev_t ground;
+    cc1120_dev_t sat;
+    cc1120_dev_t otherTx;
+    cc1120_dev_t otherRx;
+    ping_result_t clean;
+    ping_result_t lossy;
+
+    channel.delayUs = 3300;
+    channel.rssiDbm = -90;
+    channel.lqi = 20;
+    HOST_CHECK(cc1120_emu_link_init(&link, &channel, 1000, 42) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_emu_link_init(&other, &channel, 1000, 7) == CC1120_ERROR_CODE_SUCCESS);
+    cc1120_dev_init(&ground, &CC1120_EMU_TRANSPORT, &link.radios[0], 0);
+    cc1120_dev_init(&sat, &CC1120_EMU_TRANSPORT, &link.radios[1], 0);
+    cc1120_dev_init(&otherTx, &CC1120_EMU_TRANSPORT, &other.radios[0], 0);
+    cc1120_dev_init(&otherRx, &CC1120_EMU_TRANSPORT, &other.radios[1], 0);
+    HOST_CHECK(cc1120_tx_init(&ground) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_tx_init(&sat) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_tx_init(&otherTx) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_tx_init(&otherRx) == CC1120_ERROR_CODE_SUCCESS);
+
+    // A packet on the second link arrives while only the first one is polled
+    uint8_t data[PING_LEN] = {0};
+    HOST_CHECK(cc1120_strobe_spi(&otherRx, CC1120_STROBE_SRX) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_send(&otherTx, data, PING_LEN) == CC1120_ERROR_CODE_SUCCESS);
+    uint32_t airtimeUs = cc1120_emu_airtime_us(&other.radios[0], PING_LEN + 1) + channel.delayUs;
+    uint32_t startUs = mcu_get_time_us();
+    uint8_t state;
+    while (mcu_get_time_us() - startUs < 2 * airtimeUs)
+        HOST_CHECK(cc1120_get_state(&ground, &state) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(other.stats[0].packetsSent == 1 && other.stats[0].packetsDelivered == 1);
+    cc1120_emu_link_remove(&other);
+
+    ping(&ground, &sat, &clean);
+    report("clean", &clean);
+    HOST_CHECK(clean.roundTrips == PINGS);
+    HOST_CHECK(link.stats[0].packetsSent == PINGS && link.stats[1].packetsSent == PINGS);
+    HOST_CHECK(link.stats[0].packetsDelivered == PINGS && link.stats[1].packetsDelivered == PINGS);
+    HOST_CHECK(link.stats[0].txUnderflows == 0 && link.stats[1].txUnderflows == 0);
+
+    // Every round trip is at least both packets on air plus the propagation delay each way
+    uint64_t minRttNs = 2 * ((uint64_t)cc1120_emu_airtime_us(&link.radios[0], PING_LEN + 1) + channel.delayUs) * 1000;
+    HOST_CHECK(clean.rttNs / clean.roundTrips >= minRttNs);
+
+    uint8_t i;
+    for (i = 0; i < 2; i++) {
+        link.channel[i].lossProb = 0.05;
+        link.channel[i].ber = 1e-4;
+        link.channel[i].burstEnter = 1e-4;
+        link.channel[i].burstBer = 0.1;
+        link.channel[i].burstExit = 0.05;
+    }
+    ping(&ground, &sat, &lossy);
+    report("lossy", &lossy);
+    HOST_CHECK(lossy.roundTrips > 0 && lossy.roundTrips < PINGS);
+    HOST_CHECK(lossy.timeouts > 0 && lossy.crcFailures > 0 && lossy.mismatches == 0);
+    HOST_CHECK(lossy.roundTrips * clean.elapsedNs < clean.roundTrips * lossy.elapsedNs);
+
+    return HOST_TEST_RESULT("emu_test");
+}
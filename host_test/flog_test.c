@@ -0,0 +1,186 @@
+/*
+ * Host test of the flash log, cc1120_flog, over the file backend CC1120_FLOG_FILE_OPS: the log reads back
+ * in order after wrapping the sector ring, erases are spread evenly, a remount resumes after the newest
+ * page, a torn page is skipped, and messages are dropped rather than blocking when both buffers wait.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino flog_test.c ../cc1120_arduino/cc1120_flog.c -o flog_test
+ */
+#include "host_test.h"
+#include "cc1120_flog.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MESSAGES 3000U
+
+/* Pages of the whole ring */
+#define RING_PAGES (CC1120_FLOG_SECTORS * CC1120_FLOG_PAGES_PER_SECTOR)
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+static uint32_t erasesPerSector[CC1120_FLOG_SECTORS];
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+static bool count_erase(void *ctx, uint16_t sector) {
+    erasesPerSector[sector]++;
+    return CC1120_FLOG_FILE_OPS.erase(ctx, sector);
+}
+
+static bool pass_program(void *ctx, uint16_t sector, uint16_t page, const uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    return CC1120_FLOG_FILE_OPS.program(ctx, sector, page, data);
+}
+
+static bool pass_read(void *ctx, uint16_t sector, uint16_t page, uint8_t data[CC1120_FLOG_PAGE_SIZE]) {
+    return CC1120_FLOG_FILE_OPS.read(ctx, sector, page, data);
+}
+
+/* The file backend, counting erases per sector */
+static const cc1120_flog_flash_ops_t COUNTING_OPS = { count_erase, pass_program, pass_read };
+
+/**
+ * @brief Reads every valid page of the ring and joins their payloads in sequence order.
+ *
+ * @param flash - The flash file.
+ * @param out - Filled with the text, NUL terminated.
+ * @param size - The size of out.
+ * @return uint32_t - The number of valid pages.
+ */
+static uint32_t read_back(FILE *flash, char *out, size_t size) {
+    static uint8_t pages[RING_PAGES][CC1120_FLOG_PAGE_SIZE];
+    uint32_t seqs[RING_PAGES];
+    uint32_t valid = 0;
+    size_t used = 0;
+    uint16_t s;
+    uint16_t p;
+
+    for (s = 0; s < CC1120_FLOG_SECTORS; s++) {
+        for (p = 0; p < CC1120_FLOG_PAGES_PER_SECTOR; p++) {
+            uint8_t *page = pages[valid];
+            HOST_CHECK(CC1120_FLOG_FILE_OPS.read(flash, s, p, page));
+            if (page[0] != (CC1120_FLOG_MAGIC & 0xFFU) || page[1] != (CC1120_FLOG_MAGIC >> 8))
+                continue;
+            seqs[valid++] = (uint32_t)page[2] | ((uint32_t)page[3] << 8) | ((uint32_t)page[4] << 16) |
+                            ((uint32_t)page[5] << 24);
+        }
+    }
+
+    // Few pages, so a selection of the next sequence number each time is enough
+    uint32_t next = 0;
+    uint32_t i;
+    for (i = 0; i < valid; i++) {
+        uint32_t best = valid;
+        uint32_t j;
+        for (j = 0; j < valid; j++) {
+            if (seqs[j] >= next && (best == valid || seqs[j] < seqs[best]))
+                best = j;
+        }
+
+        uint16_t len = (uint16_t)(pages[best][6] | (pages[best][7] << 8));
+        HOST_CHECK(used + len < size);
+        memcpy(&out[used], &pages[best][CC1120_FLOG_HEADER_LEN], len);
+        used += len;
+        next = seqs[best] + 1;
+    }
+
+    out[used] = '\0';
+    return valid;
+}
+
+int main(void) {
+    static cc1120_flog_t log;
+    static char text[RING_PAGES * CC1120_FLOG_PAGE_SIZE];
+    char msg[32];
+    uint32_t i;
+
+    FILE *flash = tmpfile();
+    HOST_CHECK(flash != NULL);
+    HOST_CHECK(cc1120_flog_mount(&log, &COUNTING_OPS, flash) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(log.sector == 0 && log.page == 0 && log.seq == 0);
+
+    // Enough to go round the ring more than once
+    for (i = 0; i < MESSAGES; i++) {
+        sprintf(msg, "message %lu\n", (unsigned long)i);
+        cc1120_flog_append(&log, CC1120_LOG_LEVEL_INFO, msg);
+        if (i % 5 == 0)
+            HOST_CHECK(cc1120_flog_flush(&log) == CC1120_ERROR_CODE_SUCCESS);
+    }
+    HOST_CHECK(cc1120_flog_sync(&log) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(log.stats.dropped == 0 && log.stats.flashErrors == 0);
+    HOST_CHECK(log.stats.pagesWritten > RING_PAGES);
+
+    // The newest messages read back whole and in order, up to the last one. The sector being filled
+    // still has its erased pages.
+    uint32_t pages = read_back(flash, text, sizeof(text));
+    HOST_CHECK(pages == RING_PAGES - (log.page == 0 ? 0 : CC1120_FLOG_PAGES_PER_SECTOR - log.page));
+    char *last = strstr(text, "message 2999\n");
+    HOST_CHECK(last != NULL && last[13] == '\0');
+    unsigned long first = MESSAGES;
+    char *start = strstr(text, "\n4 message ");
+    HOST_CHECK(start != NULL && sscanf(start, "\n4 message %lu", &first) == 1);
+    for (i = first; i < MESSAGES; i++) {
+        sprintf(msg, "4 message %lu\n", (unsigned long)i);
+        HOST_CHECK(strncmp(start + 1, msg, strlen(msg)) == 0);
+        start += strlen(msg);
+    }
+
+    // Every sector is erased as often as the others, give or take the one being filled
+    uint32_t minErases = erasesPerSector[0];
+    uint32_t maxErases = erasesPerSector[0];
+    for (i = 1; i < CC1120_FLOG_SECTORS; i++) {
+        if (erasesPerSector[i] < minErases)
+            minErases = erasesPerSector[i];
+        if (erasesPerSector[i] > maxErases)
+            maxErases = erasesPerSector[i];
+    }
+    HOST_CHECK(maxErases - minErases <= 1);
+
+    // A remount resumes where the log left off
+    uint16_t sector = log.sector;
+    uint16_t page = log.page;
+    uint32_t seq = log.seq;
+    memset(&log, 0, sizeof(log));
+    HOST_CHECK(cc1120_flog_mount(&log, &COUNTING_OPS, flash) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(log.sector == sector && log.page == page && log.seq == seq);
+    HOST_CHECK(log.stats.tornPages == 0);
+
+    // Power lost while programming the last page: it is skipped, and the log goes on after it
+    uint16_t tornSector = sector;
+    uint16_t tornPage = page;
+    if (tornPage == 0) {
+        tornPage = CC1120_FLOG_PAGES_PER_SECTOR - 1;
+        tornSector = (tornSector + CC1120_FLOG_SECTORS - 1) % CC1120_FLOG_SECTORS;
+    } else {
+        tornPage--;
+    }
+    long tornAt = ((long)tornSector * CC1120_FLOG_PAGES_PER_SECTOR + tornPage) * CC1120_FLOG_PAGE_SIZE;
+    HOST_CHECK(fseek(flash, tornAt + 100, SEEK_SET) == 0);
+    fputc(0, flash);
+    fflush(flash);
+    memset(&log, 0, sizeof(log));
+    HOST_CHECK(cc1120_flog_mount(&log, &COUNTING_OPS, flash) == CC1120_ERROR_CODE_SUCCESS);
+    if (tornPage != 0) {
+        HOST_CHECK(log.stats.tornPages == 1);
+        HOST_CHECK(log.sector == sector && log.page == page);
+    }
+    HOST_CHECK(log.seq < seq);
+
+    // With both buffers waiting for flash, appends drop instead of blocking. Each record is the level
+    // digit, a space and the message.
+    for (i = 0; i < 3 * CC1120_FLOG_PAYLOAD_LEN / 11; i++)
+        cc1120_flog_append(&log, CC1120_LOG_LEVEL_WARN, "12345678\n");
+    HOST_CHECK(log.stats.dropped > 0);
+    HOST_CHECK(log.stats.appended == 2 * CC1120_FLOG_PAYLOAD_LEN);
+    HOST_CHECK(log.stats.appended + log.stats.dropped == i * 11);
+    HOST_CHECK(cc1120_flog_flush(&log) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(log.stats.pagesWritten == 2);
+
+    printf("%lu pages read back from message %lu, erases per sector %lu..%lu, %lu bytes dropped when full\n",
+           (unsigned long)pages, first, (unsigned long)minErases, (unsigned long)maxErases,
+           (unsigned long)log.stats.dropped);
+
+    fclose(flash);
+    return HOST_TEST_RESULT("flog_test");
+}
@@ -0,0 +1,25 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+/*
+ * Minimal checks for the host tests. Each test is a standalone main that links the driver modules it needs
+ * from ../cc1120_arduino, and returns non-zero if any check failed. The build line is at the top of each file.
+ */
+
+static int hostTestFailures = 0;
+
+/* Records a failure, with where it happened, if cond is false */
+#define HOST_CHECK(cond)                                                        \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);     \
+            hostTestFailures++;                                                 \
+        }                                                                       \
+    } while (0)
+
+/* Prints the result and gives the exit code of the test */
+#define HOST_TEST_RESULT(name) (printf("%s: %s\n", (name), hostTestFailures ? "FAILED" : "passed"), hostTestFailures != 0)
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,399 @@
+/*
+ * Host test of listen-before-talk, cc1120_lbt, against a mocked radio and a shared channel on a virtual clock.
+ * Checks the backoff window growth, the deadline and the counters, then runs a contention scenario and
+ * reports goodput and collision rate with and without carrier sense.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino lbt_test.c ../cc1120_arduino/cc1120_lbt.c ../cc1120_arduino/cc1120_fields.c -o lbt_test -lm
+ *
+ * The other stations on the channel send at Poisson arrival times and sense the channel the same way,
+ * seeing a transmission only CCA_LATENCY_US after it started, and drop their packet rather than back off
+ * when the channel is busy. Two transmissions that overlap both collide.
+ */
+#include <stdarg.h>
+#include <math.h>
+#include "host_test.h"
+#include "cc1120_lbt.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_txrx.h"
+
+/* Virtual time one SPI access or clock read takes */
+#define ACCESS_US 20U
+
+/* Time from a transmission starting until other stations sense it */
+#define CCA_LATENCY_US 200U
+
+/* Transmissions of the other stations kept to check for overlaps */
+#define INTERVALS 64U
+
+typedef struct {
+    uint32_t startUs;
+    uint32_t endUs;
+} interval_t;
+
+static uint32_t nowUs;
+static uint8_t state;
+static uint8_t marcStatus1;
+static uint64_t rng = 1;
+static bool fixedRnd;           /* RNDGEN reads 0xFF, for the longest backoff in each window */
+static uint32_t busyStx;        /* Further STX strobes that find the channel busy, outside the contention scenario */
+static uint32_t sidleCount;
+static uint32_t sftxCount;
+
+static bool contention;         /* Use the shared channel model */
+static bool blind;              /* Our station transmits without sensing */
+static double arrivalsPerUs;    /* Arrival rate of the other stations */
+static uint32_t airUs;          /* Airtime of every packet */
+static uint32_t nextArrivalUs;
+static interval_t others[INTERVALS];
+static uint32_t otherHead;
+static uint32_t othersSent;
+static uint32_t othersDropped;
+static interval_t ours;
+
+static uint32_t rng_next(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng >> 32);
+}
+
+static uint32_t rng_exp_us(double rate) {
+    double u = (rng_next() + 1.0) / 4294967297.0;
+    return (uint32_t)(-log(u) / rate) + 1U;
+}
+
+/**
+ * @brief Checks whether a station sensing at a time sees the channel busy.
+ *
+ * @param atUs - The time of the assessment.
+ * @return true - If a transmission that started at least CCA_LATENCY_US earlier is still on the air.
+ */
+static bool channel_sensed_busy(uint32_t atUs) {
+    uint32_t i;
+
+    if (ours.endUs > atUs && (int32_t)(atUs - ours.startUs) >= (int32_t)CCA_LATENCY_US)
+        return true;
+    for (i = 0; i < INTERVALS; i++)
+        if (others[i].endUs > atUs && (int32_t)(atUs - others[i].startUs) >= (int32_t)CCA_LATENCY_US)
+            return true;
+    return false;
+}
+
+/**
+ * @brief Lets the other stations send up to a time.
+ *
+ * @param toUs - The time.
+ */
+static void channel_advance(uint32_t toUs) {
+    while ((int32_t)(toUs - nextArrivalUs) >= 0) {
+        uint32_t at = nextArrivalUs;
+
+        if (channel_sensed_busy(at)) {
+            othersDropped++;
+        } else {
+            others[otherHead % INTERVALS].startUs = at;
+            others[otherHead % INTERVALS].endUs = at + airUs;
+            otherHead++;
+            othersSent++;
+        }
+        nextArrivalUs = at + rng_exp_us(arrivalsPerUs);
+    }
+}
+
+/**
+ * @brief Checks whether any transmission of another station overlapped ours.
+ *
+ * @return true - If our last packet collided.
+ */
+static bool ours_collided(void) {
+    uint32_t i;
+
+    for (i = 0; i < INTERVALS; i++)
+        if (others[i].startUs < ours.endUs && others[i].endUs > ours.startUs)
+            return true;
+    return false;
+}
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+uint32_t mcu_get_time_us() {
+    return nowUs += ACCESS_US;
+}
+
+cc1120_status_code cc1120_tx_load(cc1120_dev_t *dev, uint8_t *data, uint8_t len) {
+    (void)dev;
+    (void)data;
+    (void)len;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_wait_for_state(cc1120_dev_t *dev, uint8_t marcState, uint32_t timeoutUs) {
+    (void)dev;
+    (void)marcState;
+    (void)timeoutUs;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_strobe_spi(cc1120_dev_t *dev, uint8_t addr) {
+    nowUs += ACCESS_US;
+
+    if (addr == CC1120_STROBE_SRX) {
+        state = CC1120_STATE_RX;
+    } else if (addr == CC1120_STROBE_SIDLE) {
+        state = CC1120_STATE_IDLE;
+        sidleCount++;
+    } else if (addr == CC1120_STROBE_SFTX) {
+        sftxCount++;
+    } else if (addr == CC1120_STROBE_STX) {
+        bool busy;
+
+        if (contention) {
+            channel_advance(nowUs);
+            busy = !blind && channel_sensed_busy(nowUs);
+        } else {
+            busy = busyStx > 0;
+            if (busy)
+                busyStx--;
+        }
+
+        if (busy) {
+            marcStatus1 = CC1120_MARC_STATUS1_TXONCCA_FAILED;
+        } else {
+            state = CC1120_STATE_TX;
+            ours.startUs = nowUs;
+            ours.endUs = nowUs + airUs;
+        }
+    }
+
+    dev->lastStatus = state;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_read_ext_addr_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
+    (void)dev;
+    (void)len;
+    nowUs += ACCESS_US;
+
+    if (addr == CC1120_REGS_EXT_RSSI0) {
+        data[0] = CC1120_RSSI0_CARRIER_SENSE_VALID;
+    } else if (addr == CC1120_REGS_EXT_MARC_STATUS1) {
+        data[0] = marcStatus1;
+        marcStatus1 = 0;
+    } else if (addr == CC1120_REGS_EXT_RNDGEN) {
+        data[0] = fixedRnd ? 0xFFU : (uint8_t)rng_next();
+    } else {
+        data[0] = 0;
+    }
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_read_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
+    (void)dev;
+    (void)addr;
+    (void)len;
+    data[0] = 0;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_write_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
+    (void)dev;
+    (void)addr;
+    (void)data;
+    (void)len;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_write_ext_addr_spi(cc1120_dev_t *dev, uint8_t addr, uint8_t data[], uint8_t len) {
+    (void)dev;
+    (void)addr;
+    (void)data;
+    (void)len;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Checks the parameter checks of cc1120_lbt_init.
+ */
+static void test_init(void) {
+    cc1120_dev_t dev = {0};
+    cc1120_lbt_t lbt;
+
+    HOST_CHECK(cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, 0, 5) ==
+               CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, 2000, 0) ==
+               CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, 2000,
+                               CC1120_LBT_MAX_BACKOFF_EXP + 1) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, 2000, 5) ==
+               CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(lbt.stats.attempts == 0 && lbt.stats.backoffUs == 0);
+}
+
+/**
+ * @brief Checks that the backoff window doubles per busy attempt up to the largest, and that the counters add up.
+ */
+static void test_backoff_growth(void) {
+    cc1120_dev_t dev = {0};
+    cc1120_lbt_t lbt;
+    uint8_t packet[8] = {0};
+    const uint32_t slotUs = 1000;
+    const uint8_t maxExp = 3;
+    uint32_t busy = 6;
+    uint32_t expectedUs = 0;
+    uint32_t i;
+
+    contention = false;
+    fixedRnd = true;
+    airUs = 1000;
+    HOST_CHECK(cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, slotUs, maxExp) ==
+               CC1120_ERROR_CODE_SUCCESS);
+
+    // With RNDGEN at 0xFF every backoff is the whole window: 2, 4, 8, 8, 8, 8 slots
+    for (i = 1; i <= busy; i++)
+        expectedUs += (1UL << (i < maxExp ? i : maxExp)) * slotUs;
+
+    busyStx = busy;
+    HOST_CHECK(cc1120_lbt_send(&dev, &lbt, packet, sizeof(packet), 1000000) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(lbt.stats.attempts == busy + 1);
+    HOST_CHECK(lbt.stats.busy == busy);
+    HOST_CHECK(lbt.stats.sent == 1);
+    HOST_CHECK(lbt.stats.deadlineMisses == 0);
+    HOST_CHECK(lbt.stats.backoffUs == expectedUs);
+    HOST_CHECK(state == CC1120_STATE_TX);
+
+    // Random backoffs stay within 1 slot and the window
+    fixedRnd = false;
+    busyStx = 1;
+    HOST_CHECK(cc1120_lbt_send(&dev, &lbt, packet, sizeof(packet), 1000000) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(lbt.stats.backoffUs - expectedUs >= slotUs);
+    HOST_CHECK(lbt.stats.backoffUs - expectedUs <= 2 * slotUs);
+}
+
+/**
+ * @brief Checks that a packet is dropped, flushed and the radio left in IDLE before the deadline passes.
+ */
+static void test_deadline(void) {
+    cc1120_dev_t dev = {0};
+    cc1120_lbt_t lbt;
+    uint8_t packet[8] = {0};
+    const uint32_t timeoutUs = 20000;
+
+    contention = false;
+    fixedRnd = false;
+    HOST_CHECK(cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, 1000, 5) ==
+               CC1120_ERROR_CODE_SUCCESS);
+
+    busyStx = UINT32_MAX;
+    sidleCount = 0;
+    sftxCount = 0;
+    uint32_t start = nowUs;
+    HOST_CHECK(cc1120_lbt_send(&dev, &lbt, packet, sizeof(packet), timeoutUs) == CC1120_ERROR_CODE_CHANNEL_BUSY);
+    HOST_CHECK(nowUs - start < timeoutUs + CC1120_LBT_DECISION_TIMEOUT_US);
+    HOST_CHECK(lbt.stats.deadlineMisses == 1);
+    HOST_CHECK(lbt.stats.sent == 0);
+    HOST_CHECK(lbt.stats.attempts == lbt.stats.busy);
+    HOST_CHECK(sidleCount == 1 && sftxCount == 1);
+    HOST_CHECK(state == CC1120_STATE_IDLE);
+    busyStx = 0;
+}
+
+typedef struct {
+    uint32_t offered;
+    uint32_t sent;
+    uint32_t collided;
+    uint32_t dropped;
+    uint32_t elapsedUs;
+} contention_result_t;
+
+/**
+ * @brief Sends packets back to back on the shared channel for a time.
+ *
+ * @param load - The offered load of the other stations, in airtimes per airtime.
+ * @param sense - Whether our station uses LBT or transmits blindly.
+ * @param durationUs - The virtual time to run for.
+ * @return contention_result_t - What happened to our packets.
+ */
+static contention_result_t run_contention(double load, bool sense, uint32_t durationUs) {
+    cc1120_dev_t dev = {0};
+    cc1120_lbt_t lbt;
+    uint8_t packet[32] = {0};
+    contention_result_t result = {0};
+
+    contention = true;
+    blind = !sense;
+    fixedRnd = false;
+    rng = 0x9E3779B97F4A7C15ULL;
+    airUs = 5000;
+    arrivalsPerUs = load / airUs;
+    nowUs = 0;
+    nextArrivalUs = rng_exp_us(arrivalsPerUs);
+    otherHead = 0;
+    othersSent = 0;
+    othersDropped = 0;
+    for (uint32_t i = 0; i < INTERVALS; i++)
+        others[i].startUs = others[i].endUs = 0;
+    ours.startUs = ours.endUs = 0;
+
+    cc1120_lbt_init(&dev, &lbt, -90, CC1120_CCA_MODE_RSSI_BELOW_THR, 500, 5);
+
+    while (nowUs < durationUs) {
+        result.offered++;
+        cc1120_status_code status = cc1120_lbt_send(&dev, &lbt, packet, sizeof(packet), 50000);
+        if (status == CC1120_ERROR_CODE_SUCCESS) {
+            // Let the packet finish, then see whether anyone stepped on it
+            nowUs = ours.endUs;
+            channel_advance(nowUs);
+            result.sent++;
+            if (ours_collided())
+                result.collided++;
+            state = CC1120_STATE_IDLE;
+        } else {
+            result.dropped++;
+        }
+        // A short gap before the next packet, so that our station does not hold the channel forever
+        nowUs += rng_exp_us(1.0 / 2000.0);
+    }
+
+    result.elapsedUs = nowUs;
+    contention = false;
+    return result;
+}
+
+/**
+ * @brief Runs the contention scenario over a range of loads, prints goodput and collision rate,
+ * and checks that sensing the channel avoids most collisions.
+ */
+static void test_contention(void) {
+    static const double loads[] = {0.1, 0.3, 0.6, 1.0};
+    const uint32_t durationUs = 60000000;
+
+    printf("load  mode   sent  dropped  collided  goodput(pkt/s)  collision rate\n");
+    for (uint32_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        contention_result_t lbt = run_contention(loads[i], true, durationUs);
+        contention_result_t aloha = run_contention(loads[i], false, durationUs);
+        double lbtRate = lbt.sent ? (double)lbt.collided / lbt.sent : 0.0;
+        double alohaRate = aloha.sent ? (double)aloha.collided / aloha.sent : 0.0;
+
+        printf("%4.1f  lbt   %6u  %7u  %8u  %14.1f  %14.3f\n", loads[i], (unsigned)lbt.sent, (unsigned)lbt.dropped,
+               (unsigned)lbt.collided, (lbt.sent - lbt.collided) * 1e6 / lbt.elapsedUs, lbtRate);
+        printf("%4.1f  blind %6u  %7u  %8u  %14.1f  %14.3f\n", loads[i], (unsigned)aloha.sent,
+               (unsigned)aloha.dropped, (unsigned)aloha.collided, (aloha.sent - aloha.collided) * 1e6 / aloha.elapsedUs,
+               alohaRate);
+
+        HOST_CHECK(lbt.sent > 0);
+        HOST_CHECK(lbtRate < alohaRate);
+    }
+}
+
+int main(void) {
+    test_init();
+    test_backoff_growth();
+    test_deadline();
+    test_contention();
+    return HOST_TEST_RESULT("lbt_test");
+}
@@ -0,0 +1,219 @@
+/*
+ * Host test of several radios driven at once: each of MULTI_LINKS threads pings over its own emulated link,
+ * so the drivers of 2 * MULTI_LINKS devices run concurrently with their SPI bytes interleaved. The link
+ * emulator and its clock behind mcu_get_time_us are shared by every link, so they are locked; the devices
+ * are not. Checks that every payload arrives on its own link and that each device's counters and link
+ * statistics only count its own traffic. Built with -fsanitize=thread it also shows that the drivers share
+ * no state of their own.
+ *
+ *   cc -std=c99 -Wall -pthread -I../cc1120_arduino multi_test.c ../cc1120_arduino/cc1120_emu.c \
+ *       ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_spi.c ../cc1120_arduino/cc1120_txrx.c \
+ *       ../cc1120_arduino/cc1120_fields.c ../cc1120_arduino/cc1120_mcu.c ../cc1120_arduino/cc1120_modem.c \
+ *       ../cc1120_arduino/cc1120_stats.c ../cc1120_arduino/cc1120_spi_tests.c -o multi_test
+ */
+#include "host_test.h"
+#include "cc1120_emu.h"
+#include "cc1120_txrx.h"
+#include "cc1120_spi.h"
+#include "cc1120_mcu.h"
+#include "cc1120_stats.h"
+#include <pthread.h>
+#include <string.h>
+
+#define MULTI_LINKS 4U
+#define PINGS 50U
+#define PING_LEN 40U
+
+#define PING_TIMEOUT_US 200000U
+#define POLL_US 200U
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+/* Bus handle of one emulated radio, counting the transactions it sees */
+typedef struct {
+    cc1120_emu_radio_t *radio;
+    uint32_t transactions;
+} locked_bus_t;
+
+typedef struct {
+    uint8_t id;
+    cc1120_emu_link_t link;
+    locked_bus_t buses[2];
+    cc1120_dev_t devs[2];
+    cc1120_stats_t stats[2];
+    uint32_t roundTrips;
+    uint32_t foreign;           /* Payloads that carried another link's id */
+    uint32_t failures;
+} side_by_side_t;
+
+static pthread_mutex_t emuLock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t (*emuTimeUs)(void);
+static side_by_side_t pairs[MULTI_LINKS];
+
+static uint8_t locked_transfer(void *bus, uint8_t data) {
+    locked_bus_t *locked = bus;
+
+    pthread_mutex_lock(&emuLock);
+    uint8_t reply = CC1120_EMU_TRANSPORT.transfer(locked->radio, data);
+    pthread_mutex_unlock(&emuLock);
+    return reply;
+}
+
+static void locked_cs_assert(void *bus, uint8_t csPin) {
+    locked_bus_t *locked = bus;
+
+    pthread_mutex_lock(&emuLock);
+    CC1120_EMU_TRANSPORT.csAssert(locked->radio, csPin);
+    locked->transactions++;
+    pthread_mutex_unlock(&emuLock);
+}
+
+static void locked_cs_deassert(void *bus, uint8_t csPin) {
+    locked_bus_t *locked = bus;
+
+    pthread_mutex_lock(&emuLock);
+    CC1120_EMU_TRANSPORT.csDeassert(locked->radio, csPin);
+    pthread_mutex_unlock(&emuLock);
+}
+
+static const cc1120_transport_ops_t LOCKED_TRANSPORT = { locked_transfer, locked_cs_assert, locked_cs_deassert,
+                                                         NULL, NULL };
+
+static uint32_t locked_time_us(void) {
+    pthread_mutex_lock(&emuLock);
+    uint32_t us = emuTimeUs();
+    pthread_mutex_unlock(&emuLock);
+    return us;
+}
+
+static void locked_advance(uint32_t us) {
+    pthread_mutex_lock(&emuLock);
+    cc1120_emu_advance(us);
+    pthread_mutex_unlock(&emuLock);
+}
+
+/**
+ * @brief Polls a radio until it leaves a state, letting virtual time pass in between.
+ *
+ * @param dev - The radio.
+ * @param state - The MARCSTATE to wait out.
+ * @return bool - true if the radio left the state in time.
+ */
+static bool wait_leave(cc1120_dev_t *dev, uint8_t state) {
+    uint32_t startUs = mcu_get_time_us();
+    uint8_t now;
+
+    for (;;) {
+        locked_advance(POLL_US);
+
+        // Other threads move the shared clock while this one waits for the lock, so the deadline can pass
+        // between a poll and the time read after it. Poll once more after it has passed.
+        bool expired = mcu_get_time_us() - startUs >= PING_TIMEOUT_US;
+        if (cc1120_get_state(dev, &now) != CC1120_ERROR_CODE_SUCCESS)
+            return false;
+        if (now != state)
+            return true;
+        if (expired)
+            return false;
+    }
+}
+
+/**
+ * @brief Sends a packet from one radio of a pair to the other.
+ *
+ * @param pair - The pair, which counts payloads from other links.
+ * @param from - The index of the sender.
+ * @param data - The payload.
+ * @param buf - Filled with the received payload.
+ * @return bool - true if the payload arrived intact.
+ */
+static bool hop(side_by_side_t *pair, uint8_t from, uint8_t data[], uint8_t buf[]) {
+    cc1120_dev_t *tx = &pair->devs[from];
+    cc1120_dev_t *rx = &pair->devs[1 - from];
+    uint8_t rxStatus[2];
+    uint8_t len;
+
+    if (cc1120_strobe_spi(rx, CC1120_STROBE_SRX) != CC1120_ERROR_CODE_SUCCESS ||
+        cc1120_send(tx, data, PING_LEN) != CC1120_ERROR_CODE_SUCCESS || !wait_leave(tx, CC1120_MARCSTATE_TX) ||
+        !wait_leave(rx, CC1120_MARCSTATE_RX) ||
+        cc1120_receive(rx, buf, 128, &len, rxStatus) != CC1120_ERROR_CODE_SUCCESS || len != PING_LEN)
+        return false;
+
+    if (buf[0] != pair->id)
+        pair->foreign++;
+    return memcmp(buf, data, PING_LEN) == 0;
+}
+
+static void *ping_thread(void *arg) {
+    side_by_side_t *pair = arg;
+    uint8_t data[PING_LEN];
+    uint8_t echo[128];
+    uint8_t back[128];
+    uint32_t i;
+
+    for (i = 0; i < PINGS; i++) {
+        uint8_t k;
+        data[0] = pair->id;
+        for (k = 1; k < PING_LEN; k++)
+            data[k] = (uint8_t)(i * 7U + k + pair->id);
+
+        if (hop(pair, 0, data, echo) && hop(pair, 1, echo, back))
+            pair->roundTrips++;
+        else
+            pair->failures++;
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    cc1120_emu_channel_t channel = {0};
+    pthread_t threads[MULTI_LINKS];
+    uint8_t l;
+    uint8_t side;
+
+    for (l = 0; l < MULTI_LINKS; l++) {
+        side_by_side_t *pair = &pairs[l];
+
+        // Each link has its own RSSI, so statistics fed from another link would show
+        channel.delayUs = 500;
+        channel.rssiDbm = (int16_t)(-70 - 5 * l);
+        channel.lqi = (uint8_t)(10 + l);
+        pair->id = l;
+        HOST_CHECK(cc1120_emu_link_init(&pair->link, &channel, 1000, l + 1) == CC1120_ERROR_CODE_SUCCESS);
+        for (side = 0; side < 2; side++) {
+            pair->buses[side].radio = &pair->link.radios[side];
+            cc1120_dev_init(&pair->devs[side], &LOCKED_TRANSPORT, &pair->buses[side], 0);
+            HOST_CHECK(cc1120_tx_init(&pair->devs[side]) == CC1120_ERROR_CODE_SUCCESS);
+            cc1120_stats_init(&pair->stats[side], &pair->devs[side], mcu_get_time_us());
+        }
+    }
+
+    // Every thread reads the shared clock through the lock
+    emuTimeUs = mcu_host_time_us;
+    mcu_host_time_us = locked_time_us;
+
+    for (l = 0; l < MULTI_LINKS; l++)
+        HOST_CHECK(pthread_create(&threads[l], NULL, ping_thread, &pairs[l]) == 0);
+    for (l = 0; l < MULTI_LINKS; l++)
+        HOST_CHECK(pthread_join(threads[l], NULL) == 0);
+
+    for (l = 0; l < MULTI_LINKS; l++) {
+        side_by_side_t *pair = &pairs[l];
+
+        printf("link %u: %lu/%u round trips, %lu foreign payloads, %lu/%lu transactions\n", l,
+               (unsigned long)pair->roundTrips, PINGS, (unsigned long)pair->foreign,
+               (unsigned long)pair->devs[0].stats.transactions, (unsigned long)pair->devs[1].stats.transactions);
+        HOST_CHECK(pair->roundTrips == PINGS && pair->failures == 0 && pair->foreign == 0);
+        for (side = 0; side < 2; side++) {
+            const cc1120_stats_counts_t *counts = &pair->stats[side].counts;
+            HOST_CHECK(pair->devs[side].stats.transactions == pair->buses[side].transactions);
+            HOST_CHECK(pair->devs[side].stats.invalidStatus == 0);
+            HOST_CHECK(counts->packetsSent == PINGS && counts->packetsReceived == PINGS);
+            HOST_CHECK(counts->rssiMin == -70 - 5 * l && counts->rssiMax == -70 - 5 * l);
+            HOST_CHECK(counts->lqiMin == 10 + l && counts->lqiMax == 10 + l);
+        }
+    }
+
+    return HOST_TEST_RESULT("multi_test");
+}
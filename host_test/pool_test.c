@@ -0,0 +1,130 @@
+/*
+ * Host test of the packet buffer pool, cc1120_pool: size classes, reference counts, fault counting,
+ * then four threads allocating, sharing and freeing buffers at once with the atomic builtins.
+ *
+ *   cc -std=gnu99 -Wall -I../cc1120_arduino pool_test.c ../cc1120_arduino/cc1120_pool.c -o pool_test -lpthread
+ */
+#include "host_test.h"
+#include "cc1120_pool.h"
+#include <pthread.h>
+#include <string.h>
+
+#define THREADS 4
+#define ROUNDS 200000
+
+static volatile uint32_t corrupted;
+static volatile uint32_t refused;
+
+/**
+ * @brief Allocates up to three buffers of mixed sizes, fills each with the thread's id, then checks the
+ * fill, adds a reference and drops both.
+ *
+ * @param arg - The thread id.
+ * @return void* - NULL.
+ */
+static void *worker(void *arg) {
+    uint8_t id = (uint8_t)(uintptr_t)arg;
+    uint8_t *held[3];
+    uint32_t i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        uint8_t n = 0;
+        uint8_t k;
+        for (k = 0; k < 3; k++) {
+            uint8_t *buf = cc1120_pool_alloc((uint16_t)(20 + (i * 7 + k * 50) % 200));
+            if (buf != NULL) {
+                memset(buf, id, cc1120_pool_capacity(buf));
+                held[n++] = buf;
+            }
+        }
+
+        for (k = 0; k < n; k++) {
+            uint16_t j;
+            for (j = 0; j < cc1120_pool_capacity(held[k]); j++) {
+                if (held[k][j] != id) {
+                    __atomic_add_fetch(&corrupted, 1, __ATOMIC_RELAXED);
+                    break;
+                }
+            }
+            if (cc1120_pool_ref(held[k]) != CC1120_ERROR_CODE_SUCCESS ||
+                cc1120_pool_free(held[k]) != CC1120_ERROR_CODE_SUCCESS ||
+                cc1120_pool_free(held[k]) != CC1120_ERROR_CODE_SUCCESS)
+                __atomic_add_fetch(&refused, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_single(void) {
+    cc1120_pool_stats_t stats;
+    uint8_t other[4];
+
+    uint8_t *small = cc1120_pool_alloc(1);
+    uint8_t *medium = cc1120_pool_alloc(CC1120_POOL_SMALL_LEN + 1);
+    HOST_CHECK(cc1120_pool_capacity(small) == CC1120_POOL_SMALL_LEN);
+    HOST_CHECK(cc1120_pool_capacity(medium) == CC1120_POOL_MEDIUM_LEN);
+    HOST_CHECK(cc1120_pool_alloc(CC1120_POOL_LARGE_LEN + 1) == NULL);
+
+    // A second reference keeps the buffer until both are dropped
+    HOST_CHECK(cc1120_pool_ref(small) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_pool_free(small) == CC1120_ERROR_CODE_SUCCESS);
+    cc1120_pool_get_stats(CC1120_POOL_SMALL, &stats);
+    HOST_CHECK(stats.inUse == 1);
+    HOST_CHECK(cc1120_pool_free(small) == CC1120_ERROR_CODE_SUCCESS);
+    cc1120_pool_get_stats(CC1120_POOL_SMALL, &stats);
+    HOST_CHECK(stats.inUse == 0 && stats.highWater == 1 && stats.allocs == 1);
+
+    // Misuse is refused and counted, not logged
+    HOST_CHECK(cc1120_pool_faults() == 0);
+    HOST_CHECK(cc1120_pool_free(small) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_pool_ref(small) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_pool_free(other) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_pool_free(medium + 1) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_pool_faults() == 4);
+    HOST_CHECK(cc1120_pool_free(medium) == CC1120_ERROR_CODE_SUCCESS);
+
+    // Exhausting a class spills into the next one that fits
+    uint8_t *bufs[CC1120_POOL_SMALL_COUNT];
+    uint8_t i;
+    for (i = 0; i < CC1120_POOL_SMALL_COUNT; i++)
+        bufs[i] = cc1120_pool_alloc(1);
+    uint8_t *spilled = cc1120_pool_alloc(1);
+    HOST_CHECK(cc1120_pool_capacity(spilled) == CC1120_POOL_MEDIUM_LEN);
+    cc1120_pool_get_stats(CC1120_POOL_SMALL, &stats);
+    HOST_CHECK(stats.exhausted == 1);
+    for (i = 0; i < CC1120_POOL_SMALL_COUNT; i++)
+        cc1120_pool_free(bufs[i]);
+    cc1120_pool_free(spilled);
+
+    cc1120_pool_reset_stats();
+    HOST_CHECK(cc1120_pool_faults() == 0);
+}
+
+int main(void) {
+    pthread_t threads[THREADS];
+    uintptr_t t;
+    uint8_t c;
+
+    test_single();
+
+    for (t = 0; t < THREADS; t++)
+        HOST_CHECK(pthread_create(&threads[t], NULL, worker, (void *)(t + 1)) == 0);
+    for (t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+
+    HOST_CHECK(corrupted == 0);
+    HOST_CHECK(refused == 0);
+    HOST_CHECK(cc1120_pool_faults() == 0);
+
+    // Every buffer came back
+    for (c = 0; c < CC1120_POOL_CLASS_COUNT; c++) {
+        cc1120_pool_stats_t stats;
+        cc1120_pool_get_stats((cc1120_pool_class_t)c, &stats);
+        printf("class %u: %u x %u bytes, high water %lu, allocs %lu, exhausted %lu\n", c, stats.count, stats.len,
+               (unsigned long)stats.highWater, (unsigned long)stats.allocs, (unsigned long)stats.exhausted);
+        HOST_CHECK(stats.inUse == 0);
+    }
+
+    return HOST_TEST_RESULT("pool_test");
+}
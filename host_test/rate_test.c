@@ -0,0 +1,267 @@
+/*
+ * Host test of the adaptive data-rate controller, cc1120_rate: a satellite pass where the signal rises to a
+ * peak and falls again is received through three profiles. Checks that the controller steps up and back
+ * down once per profile without flapping on the noisy RSSI, that the radio ends up with the registers of
+ * the profile it is on, that it delivers more than any fixed rate over the pass, and that a header from a
+ * peer already on another profile is reported as out of sync.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino rate_test.c ../cc1120_arduino/cc1120_rate.c \
+ *       ../cc1120_arduino/cc1120_modem.c ../cc1120_arduino/cc1120_spi.c ../cc1120_arduino/cc1120_dev.c \
+ *       ../cc1120_arduino/cc1120_fields.c ../cc1120_arduino/cc1120_stats.c -lm -o rate_test
+ */
+#include "host_test.h"
+#include "cc1120_rate.h"
+#include "cc1120_regs.h"
+#include <math.h>
+#include <string.h>
+
+#define XOSC_HZ 32000000UL
+#define CARRIER_HZ 437000000UL
+
+/* Overhead pass: the range shrinks from the horizon to the orbit altitude and grows again, with free-space loss */
+#define PASS_S 800.0
+#define ALTITUDE_KM 500.0
+#define GROUND_SPEED_KM_S 7.5
+#define PASS_PEAK_DBM -98.0
+
+/* Spread of the reported RSSI around the true signal */
+#define RSSI_NOISE_DB 2.0
+
+#define PAYLOAD_LEN 64U
+#define OVERHEAD_LEN 10U
+
+/* Acknowledgement and turnaround time added to every frame */
+#define TURNAROUND_S 0.02
+
+#define NUM_PROFILES 3U
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+static const cc1120_modem_cfg_t CFG_1K2 =
+    CC1120_MODEM_CFG(1200UL, 4000UL, 10000UL, CARRIER_HZ, 8, XOSC_HZ, CC1120_MODCFG_MOD_FORMAT_2GFSK);
+static const cc1120_modem_cfg_t CFG_9K6 =
+    CC1120_MODEM_CFG(9600UL, 5000UL, 25000UL, CARRIER_HZ, 8, XOSC_HZ, CC1120_MODCFG_MOD_FORMAT_2GFSK);
+static const cc1120_modem_cfg_t CFG_38K4 =
+    CC1120_MODEM_CFG(38400UL, 20000UL, 100000UL, CARRIER_HZ, 8, XOSC_HZ, CC1120_MODCFG_MOD_FORMAT_2GFSK);
+
+/* Sensitivity of each profile, at 1% packet error rate; the thresholds leave 1 dB of margin above it */
+static const int16_t SENSITIVITY_DBM[NUM_PROFILES] = { -121, -112, -105 };
+
+static const cc1120_rate_profile_t PROFILES[NUM_PROFILES] = {
+    { &CFG_1K2, -120, 127 },
+    { &CFG_9K6, -111, 127 },
+    { &CFG_38K4, -104, 127 },
+};
+
+/* Register file answering like a CC1120 in IDLE */
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ext[256];
+    uint16_t pos;
+    uint8_t header;
+    uint8_t addr;
+    bool isExt;
+} sim_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t delivered;
+    uint32_t crcFails;
+    uint32_t switchesUp;
+    uint32_t switchesDown;
+    double seconds[NUM_PROFILES];
+} pass_result_t;
+
+static uint32_t nowUs;
+static uint32_t seed;
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+uint32_t mcu_get_time_us() {
+    return nowUs += 3;
+}
+
+static uint8_t sim_transfer(void *bus, uint8_t data) {
+    sim_t *sim = bus;
+    uint8_t reply = 0;
+
+    if (sim->pos == 0) {
+        sim->header = data;
+        sim->addr = data & 0x3FU;
+        sim->isExt = (sim->addr == 0x2FU);
+    } else if (sim->isExt && sim->pos == 1) {
+        sim->addr = data;
+    } else {
+        uint8_t *mem = sim->isExt ? sim->ext : sim->regs;
+        if (sim->header & 0x80U)
+            reply = mem[sim->addr];
+        else
+            mem[sim->addr] = data;
+        if (sim->header & 0x40U)
+            sim->addr++;
+    }
+
+    sim->pos++;
+    return reply;
+}
+
+static void sim_cs_assert(void *bus, uint8_t csPin) {
+    (void)csPin;
+    ((sim_t *)bus)->pos = 0;
+}
+
+static void sim_cs_deassert(void *bus, uint8_t csPin) {
+    (void)bus;
+    (void)csPin;
+}
+
+static const cc1120_transport_ops_t SIM_OPS = { sim_transfer, sim_cs_assert, sim_cs_deassert, NULL, NULL };
+
+/**
+ * @brief Draws a uniform number in [0, 1) from a fixed seed, so every run sees the same pass.
+ *
+ * @return double - The number.
+ */
+static double uniform(void) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return (double)(seed >> 8) / 16777216.0;
+}
+
+/**
+ * @brief Gets the packet error rate of a profile for a signal level.
+ *
+ * @param profile - The profile.
+ * @param rssiDbm - The true signal level.
+ * @return double - The probability that a packet fails CRC.
+ */
+static double packet_error_rate(uint8_t profile, double rssiDbm) {
+    double marginDb = rssiDbm - SENSITIVITY_DBM[profile];
+
+    // 1% at sensitivity, falling tenfold per dB above it and rising steeply below it
+    return 1.0 / (1.0 + 100.0 * pow(10.0, marginDb));
+}
+
+/**
+ * @brief Checks that the simulated radio holds the modem configuration of a profile.
+ *
+ * @param sim - The simulated radio.
+ * @param cfg - The expected configuration.
+ * @return bool - true if every modem register matches.
+ */
+static bool sim_holds(const sim_t *sim, const cc1120_modem_cfg_t *cfg) {
+    return memcmp(&sim->regs[CC1120_REGS_DEVIATION_M], cfg->deviation, sizeof(cfg->deviation)) == 0 &&
+           memcmp(&sim->regs[CC1120_REGS_CHAN_BW], cfg->modem, sizeof(cfg->modem)) == 0 &&
+           memcmp(&sim->ext[CC1120_REGS_EXT_FREQ2], cfg->freq, sizeof(cfg->freq)) == 0;
+}
+
+/**
+ * @brief Receives a pass, either adapting the rate or staying on one profile.
+ *
+ * @param initial - The profile to start on.
+ * @param adapt - Whether to follow the controller.
+ * @param hysteresisDb - The controller's step-up hysteresis.
+ * @param result - Filled with the counts and the time spent on each profile.
+ */
+static void run_pass(uint8_t initial, bool adapt, int8_t hysteresisDb, pass_result_t *result) {
+    static sim_t sim;
+    cc1120_rate_ctrl_t ctrl;
+    cc1120_dev_t dev;
+    double t = 0.0;
+
+    memset(&sim, 0, sizeof(sim));
+    memset(result, 0, sizeof(*result));
+    seed = 12345;
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    HOST_CHECK(cc1120_modem_apply(&dev, PROFILES[initial].cfg) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_rate_init(&ctrl, PROFILES, NUM_PROFILES, initial) == CC1120_ERROR_CODE_SUCCESS);
+    ctrl.hysteresisDb = hysteresisDb;
+
+    while (t < PASS_S) {
+        uint8_t profile = ctrl.current;
+        uint32_t symbolRate = cc1120_modem_symbol_rate(PROFILES[profile].cfg, XOSC_HZ);
+        double frameS = (PAYLOAD_LEN + OVERHEAD_LEN) * 8.0 / symbolRate + TURNAROUND_S;
+        double alongKm = GROUND_SPEED_KM_S * (t - PASS_S / 2.0);
+        double rssiDbm = PASS_PEAK_DBM - 10.0 * log10(1.0 + alongKm * alongKm / (ALTITUDE_KM * ALTITUDE_KM));
+
+        // Well below sensitivity nothing is heard at all; otherwise the packet is received, maybe with errors
+        if (rssiDbm >= SENSITIVITY_DBM[profile] - 4.0) {
+            bool crcOk = uniform() >= packet_error_rate(profile, rssiDbm);
+            double noise = (uniform() + uniform() + uniform() - 1.5) * 2.0 * RSSI_NOISE_DB;
+
+            if (adapt)
+                cc1120_rate_on_packet(&ctrl, (int16_t)lround(rssiDbm + noise), 10, crcOk);
+            if (crcOk)
+                result->delivered++;
+            else
+                result->crcFails++;
+        }
+
+        HOST_CHECK(cc1120_rate_frame_boundary(&dev, &ctrl) == CC1120_ERROR_CODE_SUCCESS);
+        result->seconds[profile] += frameS;
+        result->frames++;
+        t += frameS;
+    }
+
+    HOST_CHECK(sim_holds(&sim, PROFILES[ctrl.current].cfg));
+    result->switchesUp = ctrl.switchesUp;
+    result->switchesDown = ctrl.switchesDown;
+}
+
+static void report(const char *name, const pass_result_t *result) {
+    printf("%-10s %5lu frames, %5lu delivered, %4lu CRC failures, %lu up, %lu down, %.0f/%.0f/%.0f s, "
+           "%.0f bit/s\n", name, (unsigned long)result->frames, (unsigned long)result->delivered,
+           (unsigned long)result->crcFails, (unsigned long)result->switchesUp,
+           (unsigned long)result->switchesDown, result->seconds[0], result->seconds[1], result->seconds[2],
+           result->delivered * PAYLOAD_LEN * 8.0 / PASS_S);
+}
+
+int main(void) {
+    static const char *const NAMES[NUM_PROFILES] = { "fixed 1k2", "fixed 9k6", "fixed 38k4" };
+    pass_result_t adaptive;
+    pass_result_t fixed;
+    pass_result_t noHysteresis;
+    uint8_t p;
+
+    // One step up per profile on the way to the peak and one step down per profile after it
+    run_pass(0, true, CC1120_RATE_DEFAULT_HYSTERESIS_DB, &adaptive);
+    report("adaptive", &adaptive);
+    HOST_CHECK(adaptive.switchesUp == NUM_PROFILES - 1 && adaptive.switchesDown == NUM_PROFILES - 1);
+    for (p = 0; p < NUM_PROFILES; p++)
+        HOST_CHECK(adaptive.seconds[p] > 0.0);
+
+    // Without hysteresis the noisy RSSI around each threshold makes it flap
+    run_pass(0, true, 0, &noHysteresis);
+    report("hyst 0 dB", &noHysteresis);
+    HOST_CHECK(noHysteresis.switchesUp > adaptive.switchesUp);
+
+    for (p = 0; p < NUM_PROFILES; p++) {
+        run_pass(p, false, 0, &fixed);
+        report(NAMES[p], &fixed);
+        HOST_CHECK(adaptive.delivered > fixed.delivered);
+    }
+
+    // A peer already on another profile is out of sync, and is followed at the next frame boundary
+    static sim_t sim;
+    cc1120_rate_ctrl_t ctrl;
+    cc1120_dev_t dev;
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    HOST_CHECK(cc1120_modem_apply(&dev, PROFILES[0].cfg) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_rate_init(&ctrl, PROFILES, NUM_PROFILES, 0) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_rate_on_header(&ctrl, CC1120_RATE_HEADER(0, 0)) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_rate_on_header(&ctrl, CC1120_RATE_HEADER(3, 1)) == CC1120_ERROR_CODE_INVALID_RATE_HEADER);
+    HOST_CHECK(cc1120_rate_on_header(&ctrl, CC1120_RATE_HEADER(2, 0)) == CC1120_ERROR_CODE_RATE_OUT_OF_SYNC);
+    HOST_CHECK(cc1120_rate_header_field(&ctrl) == CC1120_RATE_HEADER(2, 1));
+    HOST_CHECK(cc1120_rate_frame_boundary(&dev, &ctrl) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(ctrl.current == 2 && sim_holds(&sim, PROFILES[2].cfg));
+
+    // An announced switch is applied after the announced number of frames
+    HOST_CHECK(cc1120_rate_on_header(&ctrl, CC1120_RATE_HEADER(1, 2)) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_rate_frame_boundary(&dev, &ctrl) == CC1120_ERROR_CODE_SUCCESS && ctrl.current == 2);
+    HOST_CHECK(cc1120_rate_frame_boundary(&dev, &ctrl) == CC1120_ERROR_CODE_SUCCESS && ctrl.current == 1);
+    HOST_CHECK(sim_holds(&sim, PROFILES[1].cfg));
+
+    return HOST_TEST_RESULT("rate_test");
+}
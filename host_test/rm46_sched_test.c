@@ -0,0 +1,90 @@
+/*
+ * Host test of the MibSPI transfer planner, cc1120_rm46_plan.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino rm46_sched_test.c ../cc1120_arduino/cc1120_rm46_sched.c -o rm46_sched_test
+ */
+#include "host_test.h"
+#include "cc1120_rm46_sched.h"
+
+/**
+ * @brief Checks that a plan covers a block exactly, in order, and only polls runs below the threshold.
+ *
+ * @param plan - The plan.
+ * @param len - The block length.
+ * @param numBuffers - The buffers per transfer group.
+ * @param dmaMinLen - The threshold.
+ */
+static void check_covers(const cc1120_rm46_plan_t *plan, uint16_t len, uint8_t numBuffers, uint8_t dmaMinLen) {
+    uint16_t offset = 0;
+    uint8_t i;
+
+    for (i = 0; i < plan->numChunks; i++) {
+        const cc1120_rm46_chunk_t *chunk = &plan->chunks[i];
+
+        HOST_CHECK(chunk->offset == offset);
+        HOST_CHECK(chunk->len > 0);
+        if (chunk->mode == CC1120_RM46_CHUNK_GROUP_DMA) {
+            HOST_CHECK(chunk->len >= dmaMinLen);
+            HOST_CHECK(chunk->len <= numBuffers);
+        } else {
+            HOST_CHECK(chunk->len < dmaMinLen);
+            HOST_CHECK(i == plan->numChunks - 1);
+        }
+        offset += chunk->len;
+    }
+
+    HOST_CHECK(offset == len);
+}
+
+int main(void) {
+    cc1120_rm46_plan_t plan;
+    uint16_t len;
+
+    // Below the threshold, one polled chunk
+    HOST_CHECK(cc1120_rm46_plan(&plan, 1, 128, 8) == 1);
+    HOST_CHECK(plan.chunks[0].mode == CC1120_RM46_CHUNK_POLLED && plan.chunks[0].len == 1);
+    HOST_CHECK(cc1120_rm46_plan(&plan, 7, 128, 8) == 1);
+    HOST_CHECK(plan.chunks[0].mode == CC1120_RM46_CHUNK_POLLED);
+
+    // At the threshold and at a full FIFO, one transfer group
+    HOST_CHECK(cc1120_rm46_plan(&plan, 8, 128, 8) == 1);
+    HOST_CHECK(plan.chunks[0].mode == CC1120_RM46_CHUNK_GROUP_DMA && plan.chunks[0].len == 8);
+    HOST_CHECK(cc1120_rm46_plan(&plan, 128, 128, 8) == 1);
+    HOST_CHECK(plan.chunks[0].mode == CC1120_RM46_CHUNK_GROUP_DMA && plan.chunks[0].len == 128);
+
+    // A short tail after a full group is polled, a long one gets its own group
+    HOST_CHECK(cc1120_rm46_plan(&plan, 130, 128, 8) == 2);
+    HOST_CHECK(plan.chunks[1].mode == CC1120_RM46_CHUNK_POLLED && plan.chunks[1].offset == 128);
+    HOST_CHECK(cc1120_rm46_plan(&plan, 136, 128, 8) == 2);
+    HOST_CHECK(plan.chunks[1].mode == CC1120_RM46_CHUNK_GROUP_DMA && plan.chunks[1].len == 8);
+
+    // Both FIFOs' worth fits, more than CC1120_RM46_MAX_CHUNKS groups does not
+    HOST_CHECK(cc1120_rm46_plan(&plan, 256, 128, 8) == 2);
+    HOST_CHECK(cc1120_rm46_plan(&plan, 4 * 128 + 1, 128, 8) == 0);
+    HOST_CHECK(plan.numChunks == 0);
+
+    // An empty block needs nothing
+    HOST_CHECK(cc1120_rm46_plan(&plan, 0, 128, 8) == 0);
+
+    // A threshold of 1 never polls, one above the buffers always polls
+    HOST_CHECK(cc1120_rm46_plan(&plan, 3, 128, 1) == 1);
+    HOST_CHECK(plan.chunks[0].mode == CC1120_RM46_CHUNK_GROUP_DMA);
+    HOST_CHECK(cc1120_rm46_plan(&plan, 100, 16, 17) == 1);
+    HOST_CHECK(plan.chunks[0].mode == CC1120_RM46_CHUNK_POLLED);
+    HOST_CHECK(cc1120_rm46_plan(&plan, 300, 16, 17) == 2);
+    HOST_CHECK(plan.chunks[0].len == 255 && plan.chunks[1].len == 45);
+
+    // Every length and threshold the driver can use gives an exact cover
+    for (len = 1; len <= 256; len++) {
+        uint8_t dmaMinLen;
+        for (dmaMinLen = 1; dmaMinLen <= 32; dmaMinLen++) {
+            if (cc1120_rm46_plan(&plan, len, 128, dmaMinLen) == 0) {
+                HOST_CHECK(0);
+                continue;
+            }
+            check_covers(&plan, len, 128, dmaMinLen);
+        }
+    }
+
+    return HOST_TEST_RESULT("rm46_sched_test");
+}
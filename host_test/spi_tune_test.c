@@ -0,0 +1,234 @@
+/*
+ * Host test of the SPI clock tuner, cc1120_spi_tune: the driver runs over a simulated register file whose
+ * reads come back corrupted when the bus clock is above a limit for the kind of access. Checks that each
+ * access type is tuned to the expected candidate, stored in its own slot, with the configured back-off,
+ * that tuning stops at the first failing rate, and that the scratch registers are restored.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino spi_tune_test.c ../cc1120_arduino/cc1120_spi_tune.c \
+ *       ../cc1120_arduino/cc1120_spi.c ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_fields.c \
+ *       ../cc1120_arduino/cc1120_stats.c -o spi_tune_test
+ */
+#include "host_test.h"
+#include "cc1120_spi_tune.h"
+#include "cc1120_spi.h"
+#include "cc1120_regs.h"
+#include <string.h>
+
+#define MAX_HZ CC1120_SPI_MAX_HZ
+
+/* The candidates, from the slowest */
+#define HZ(n) (MAX_HZ >> (CC1120_SPI_TUNE_STEPS - 1 - (n)))
+#define SLOWEST_HZ HZ(0)
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+/* Register file answering like a CC1120 in IDLE, whose reads fail above a clock limit per kind of access */
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ext[256];
+    uint8_t fifo[256];
+    uint16_t pos;
+    uint8_t header;
+    uint8_t addr;
+    cc1120_spi_access_t access;
+    uint32_t clockHz;
+    uint32_t limitHz[CC1120_SPI_ACCESS_COUNT];  /* Reads are corrupted above this clock */
+    uint32_t badHz[CC1120_SPI_ACCESS_COUNT];    /* Reads are also corrupted at exactly this clock, if not 0 */
+    uint32_t corrupted;
+} sim_t;
+
+static uint32_t nowUs;
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+uint32_t mcu_get_time_us() {
+    return nowUs += 3;
+}
+
+static uint8_t sim_transfer(void *bus, uint8_t data) {
+    sim_t *sim = bus;
+    uint8_t reply = 0;
+    uint8_t *mem;
+
+    if (sim->pos == 0) {
+        sim->header = data;
+        sim->addr = data & 0x3FU;
+        if (sim->addr == 0x2FU)
+            sim->access = CC1120_SPI_ACCESS_EXT;
+        else if (sim->addr == CC1120_REGS_FIFO_ACCESS_DIR)
+            sim->access = CC1120_SPI_ACCESS_FIFO;
+        else
+            sim->access = (data & 0x40U) ? CC1120_SPI_ACCESS_BURST : CC1120_SPI_ACCESS_SINGLE;
+        sim->pos++;
+        return reply;
+    }
+
+    if (sim->access == CC1120_SPI_ACCESS_EXT || sim->access == CC1120_SPI_ACCESS_FIFO) {
+        if (sim->pos == 1) {
+            sim->addr = data;
+            sim->pos++;
+            return reply;
+        }
+        mem = (sim->access == CC1120_SPI_ACCESS_EXT) ? sim->ext : sim->fifo;
+    } else {
+        mem = sim->regs;
+    }
+
+    if (sim->header & 0x80U) {
+        reply = mem[sim->addr];
+        if (sim->clockHz > sim->limitHz[sim->access] || sim->clockHz == sim->badHz[sim->access]) {
+            reply ^= 0x10U;
+            sim->corrupted++;
+        }
+    } else {
+        mem[sim->addr] = data;
+    }
+    if (sim->header & 0x40U)
+        sim->addr++;
+
+    sim->pos++;
+    return reply;
+}
+
+static void sim_cs_assert(void *bus, uint8_t csPin) {
+    (void)csPin;
+    ((sim_t *)bus)->pos = 0;
+}
+
+static void sim_cs_deassert(void *bus, uint8_t csPin) {
+    (void)bus;
+    (void)csPin;
+}
+
+static uint32_t sim_set_clock(void *bus, uint32_t hz) {
+    ((sim_t *)bus)->clockHz = hz;
+    return hz;
+}
+
+static const cc1120_transport_ops_t SIM_OPS = { sim_transfer, sim_cs_assert, sim_cs_deassert, sim_set_clock, NULL };
+static const cc1120_transport_ops_t FIXED_OPS = { sim_transfer, sim_cs_assert, sim_cs_deassert, NULL, NULL };
+
+/**
+ * @brief Resets the simulated radio with per-access limits and fills the scratch registers.
+ *
+ * @param sim - The simulated radio.
+ * @param limits - The clock limit of each kind of access.
+ */
+static void sim_reset(sim_t *sim, const uint32_t limits[CC1120_SPI_ACCESS_COUNT]) {
+    uint16_t i;
+
+    memset(sim, 0, sizeof(*sim));
+    for (i = 0; i < 256; i++) {
+        sim->regs[i] = (uint8_t)(0xA0U + i);
+        sim->ext[i] = (uint8_t)(0x30U + i);
+    }
+    memcpy(sim->limitHz, limits, sizeof(sim->limitHz));
+}
+
+/**
+ * @brief Checks that SYNC3..0 and FREQOFF1/0 hold what sim_reset put there.
+ *
+ * @param sim - The simulated radio.
+ * @return bool - true if the scratch registers were restored.
+ */
+static bool scratch_restored(const sim_t *sim) {
+    uint8_t i;
+
+    for (i = 0; i < 4; i++) {
+        if (sim->regs[CC1120_REGS_SYNC3 + i] != (uint8_t)(0xA0U + CC1120_REGS_SYNC3 + i))
+            return false;
+    }
+    for (i = 0; i < 2; i++) {
+        if (sim->ext[CC1120_REGS_EXT_FREQOFF1 + i] != (uint8_t)(0x30U + CC1120_REGS_EXT_FREQOFF1 + i))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Tunes every access type on a fresh device and compares the stored rates.
+ *
+ * @param limits - The clock limit of each kind of access.
+ * @param marginSteps - The back-off to tune with.
+ * @param expected - The rate expected for each kind of access.
+ */
+static void check_tune(const uint32_t limits[CC1120_SPI_ACCESS_COUNT], uint8_t marginSteps,
+                       const uint32_t expected[CC1120_SPI_ACCESS_COUNT]) {
+    static sim_t sim;
+    cc1120_dev_t dev;
+    uint8_t access;
+
+    sim_reset(&sim, limits);
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    HOST_CHECK(cc1120_spi_tune(&dev, MAX_HZ, marginSteps) == CC1120_ERROR_CODE_SUCCESS);
+    for (access = 0; access < CC1120_SPI_ACCESS_COUNT; access++) {
+        if (dev.spiClockHz[access] != expected[access]) {
+            printf("margin %u, access %u: tuned to %lu Hz, expected %lu Hz\n", marginSteps, access,
+                   (unsigned long)dev.spiClockHz[access], (unsigned long)expected[access]);
+            HOST_CHECK(false);
+        }
+    }
+    HOST_CHECK(sim.corrupted > 0);
+    HOST_CHECK(scratch_restored(&sim));
+}
+
+int main(void) {
+    static sim_t sim;
+    cc1120_dev_t dev;
+
+    // Single accesses pass at every candidate, the others fail one candidate sooner each
+    const uint32_t limits[CC1120_SPI_ACCESS_COUNT] = { HZ(5), HZ(4), HZ(3), HZ(2) };
+    const uint32_t margin0[CC1120_SPI_ACCESS_COUNT] = { HZ(5), HZ(4), HZ(3), HZ(2) };
+    const uint32_t margin1[CC1120_SPI_ACCESS_COUNT] = { HZ(4), HZ(3), HZ(2), HZ(1) };
+    const uint32_t margin2[CC1120_SPI_ACCESS_COUNT] = { HZ(3), HZ(2), HZ(1), HZ(0) };
+    const uint32_t marginAll[CC1120_SPI_ACCESS_COUNT] = { HZ(0), HZ(0), HZ(0), HZ(0) };
+
+    check_tune(limits, 0, margin0);
+    check_tune(limits, CC1120_SPI_TUNE_DEFAULT_MARGIN_STEPS, margin1);
+    check_tune(limits, 2, margin2);
+    check_tune(limits, CC1120_SPI_TUNE_STEPS + 3, marginAll);
+
+    // Tuning one access type only fills in untuned slots and leaves tuned ones alone
+    const uint32_t fast[CC1120_SPI_ACCESS_COUNT] = { MAX_HZ, MAX_HZ, MAX_HZ, MAX_HZ };
+    sim_reset(&sim, fast);
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    dev.spiClockHz[CC1120_SPI_ACCESS_SINGLE] = HZ(2);
+    HOST_CHECK(cc1120_spi_tune_access(&dev, CC1120_SPI_ACCESS_EXT, MAX_HZ, 0) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_EXT] == MAX_HZ);
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_SINGLE] == HZ(2));
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_BURST] == SLOWEST_HZ);
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_FIFO] == SLOWEST_HZ);
+    HOST_CHECK(sim.corrupted == 0 && scratch_restored(&sim));
+
+    // A rate that fails ends the climb, even though faster ones would pass again
+    sim_reset(&sim, fast);
+    sim.badHz[CC1120_SPI_ACCESS_BURST] = HZ(2);
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    HOST_CHECK(cc1120_spi_tune_access(&dev, CC1120_SPI_ACCESS_BURST, MAX_HZ, 0) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_BURST] == HZ(1));
+    HOST_CHECK(scratch_restored(&sim));
+
+    // If even the slowest candidate fails, the previous rate is kept and the other types are still tuned
+    const uint32_t broken[CC1120_SPI_ACCESS_COUNT] = { MAX_HZ, MAX_HZ, MAX_HZ, SLOWEST_HZ / 2 };
+    sim_reset(&sim, broken);
+    cc1120_dev_init(&dev, &SIM_OPS, &sim, 0);
+    dev.spiClockHz[CC1120_SPI_ACCESS_FIFO] = SLOWEST_HZ / 4;
+    HOST_CHECK(cc1120_spi_tune(&dev, MAX_HZ, 0) == CC1120_ERROR_CODE_SPI_TUNE_FAILED);
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_FIFO] == SLOWEST_HZ / 4);
+    HOST_CHECK(dev.spiClockHz[CC1120_SPI_ACCESS_EXT] == MAX_HZ);
+    HOST_CHECK(scratch_restored(&sim));
+
+    // A bus with a fixed clock cannot be tuned
+    sim_reset(&sim, fast);
+    cc1120_dev_init(&dev, &FIXED_OPS, &sim, 0);
+    HOST_CHECK(cc1120_spi_tune_access(&dev, CC1120_SPI_ACCESS_SINGLE, MAX_HZ, 0) == CC1120_ERROR_CODE_INVALID_PARAM);
+    HOST_CHECK(cc1120_spi_tune_access(&dev, CC1120_SPI_ACCESS_COUNT, MAX_HZ, 0) == CC1120_ERROR_CODE_INVALID_PARAM);
+
+    printf("candidates %lu..%lu Hz, default margin %u step\n", (unsigned long)SLOWEST_HZ, (unsigned long)MAX_HZ,
+           CC1120_SPI_TUNE_DEFAULT_MARGIN_STEPS);
+
+    return HOST_TEST_RESULT("spi_tune_test");
+}
@@ -0,0 +1,114 @@
+/*
+ * Host test of the TDMA strobe lead correction and jitter measurement, cc1120_tdma, on a virtual clock.
+ * The mocked radio starts its preamble a fixed time after STX, far from the default strobe lead,
+ * and the timer interrupt fires with a random latency.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino tdma_test.c ../cc1120_arduino/cc1120_tdma.c -o tdma_test
+ */
+#include "host_test.h"
+#include "cc1120_tdma.h"
+#include "cc1120_regs.h"
+#include "cc1120_mcu.h"
+#include "cc1120_spi.h"
+#include "cc1120_txrx.h"
+
+/* Time from STX to the first preamble bit of the mocked radio */
+#define TRUE_LEAD_US 400U
+
+/* Largest latency of the timer interrupt */
+#define LATENCY_US 20U
+
+#define SLOT_US 10000U
+#define GUARD_US 1000U
+#define SYNC_LEAD_US 2000U
+
+static uint32_t nowUs;
+static uint32_t timerAtUs;
+static bool timerSet;
+static uint64_t rng = 0x2545F4914F6CDD1DULL;
+
+static uint32_t rng_next(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng >> 32);
+}
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+uint32_t mcu_get_time_us() {
+    return nowUs;
+}
+
+bool mcu_timer_at(uint32_t atUs, void (*callback)(void *ctx), void *ctx) {
+    (void)callback;
+    (void)ctx;
+    timerAtUs = atUs;
+    timerSet = true;
+    return true;
+}
+
+cc1120_status_code cc1120_tx_load(cc1120_dev_t *dev, uint8_t *data, uint8_t len) {
+    (void)dev;
+    (void)data;
+    (void)len;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+cc1120_status_code cc1120_strobe_spi(cc1120_dev_t *dev, uint8_t addr) {
+    (void)dev;
+    (void)addr;
+    return CC1120_ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Sends one packet in slot 1: the timer fires late by up to LATENCY_US, and the sync edge
+ * follows the strobe by the radio's lead and the preamble.
+ *
+ * @param tdma - The schedule.
+ */
+static void send_one(cc1120_tdma_t *tdma) {
+    uint8_t packet[4] = {0};
+
+    timerSet = false;
+    HOST_CHECK(cc1120_tdma_arm(tdma, 1, packet, sizeof(packet)) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(timerSet);
+
+    nowUs = timerAtUs + rng_next() % (LATENCY_US + 1);
+    cc1120_tdma_on_timer(tdma);
+    cc1120_tdma_on_pkt_sync(tdma, 0, 1, tdma->strobedUs + TRUE_LEAD_US + SYNC_LEAD_US);
+    nowUs += SLOT_US;
+}
+
+int main(void) {
+    cc1120_dev_t dev = {0};
+    cc1120_tdma_t tdma;
+    uint32_t i;
+
+    HOST_CHECK(cc1120_tdma_init(&tdma, &dev, SLOT_US, 4, GUARD_US, SYNC_LEAD_US) == CC1120_ERROR_CODE_SUCCESS);
+
+    // The start-up error of the lead is not jitter
+    for (i = 0; i < CC1120_TDMA_SETTLE_SAMPLES; i++)
+        send_one(&tdma);
+    HOST_CHECK(tdma.jitter.count == 0);
+    HOST_CHECK(cc1120_tdma_suggested_guard_us(&tdma) == GUARD_US);
+
+    for (i = 0; i < 200; i++)
+        send_one(&tdma);
+
+    uint32_t guardUs = cc1120_tdma_suggested_guard_us(&tdma);
+    printf("strobe lead %ld us, jitter %ld..%ld us over %lu packets, suggested guard %lu us\n",
+           (long)tdma.strobeLeadUs, (long)tdma.jitter.minUs, (long)tdma.jitter.maxUs,
+           (unsigned long)tdma.jitter.count, (unsigned long)guardUs);
+
+    HOST_CHECK(tdma.jitter.count == 200);
+    HOST_CHECK(tdma.strobeLeadUs > (int32_t)TRUE_LEAD_US - 2 * (int32_t)LATENCY_US);
+    HOST_CHECK(tdma.strobeLeadUs < (int32_t)TRUE_LEAD_US + 2 * (int32_t)LATENCY_US);
+    HOST_CHECK(guardUs <= 2 * LATENCY_US);
+    HOST_CHECK(tdma.missed == 0);
+
+    return HOST_TEST_RESULT("tdma_test");
+}
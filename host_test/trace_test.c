@@ -0,0 +1,237 @@
+/*
+ * Host test of the SPI trace recorder, cc1120_trace: the driver runs over a simulated register file
+ * through CC1120_TRACE_TRANSPORT, and the drained trace must decode into the same register, FIFO and
+ * strobe operations whether or not the simulated transport has block transfers. Also checks replay, ring overflow,
+ * a trace cut mid-transaction and an unknown record.
+ *
+ *   cc -std=c99 -Wall -I../cc1120_arduino trace_test.c ../cc1120_arduino/cc1120_trace.c \
+ *       ../cc1120_arduino/cc1120_spi.c ../cc1120_arduino/cc1120_dev.c ../cc1120_arduino/cc1120_fields.c \
+ *       ../cc1120_arduino/cc1120_stats.c -o trace_test
+ */
+#include "host_test.h"
+#include "cc1120_trace.h"
+#include "cc1120_spi.h"
+#include "cc1120_regs.h"
+#include <string.h>
+
+#define SIM_STATUS 0x0FU
+
+cc1120_log_level_t CC1120_FILE_LOG_LEVEL = CC1120_LOG_LEVEL_OFF, CC1120_SERIAL_LOG_LEVEL = CC1120_LOG_LEVEL_OFF;
+
+/* Register file answering like a CC1120 in IDLE: reads of a register return its contents */
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ext[256];
+    uint16_t pos;
+    uint8_t header;
+    uint8_t addr;
+    bool isExt;
+    uint8_t corrupt;            /* XORed into every register read, to make a replay differ */
+} sim_t;
+
+typedef struct {
+    char lines[8][128];
+    uint8_t count;
+    uint16_t lost;
+} decoded_t;
+
+static uint32_t nowUs;
+
+void mcu_log(cc1120_log_level_t level, char str[], ...) {
+    (void)level;
+    (void)str;
+}
+
+uint32_t mcu_get_time_us() {
+    return nowUs += 3;
+}
+
+static uint8_t sim_transfer(void *bus, uint8_t data) {
+    sim_t *sim = bus;
+    uint8_t reply = 0;
+
+    if (sim->pos == 0) {
+        sim->header = data;
+        sim->addr = data & 0x3FU;
+        sim->isExt = (sim->addr == 0x2FU);
+        reply = SIM_STATUS;
+    } else if (sim->isExt && sim->pos == 1) {
+        sim->addr = data;
+    } else {
+        uint8_t *mem = sim->isExt ? sim->ext : sim->regs;
+        if (sim->header & 0x80U)
+            reply = mem[sim->addr] ^ sim->corrupt;
+        else
+            mem[sim->addr] = data;
+        if (sim->header & 0x40U)
+            sim->addr++;
+    }
+
+    sim->pos++;
+    return reply;
+}
+
+static void sim_transfer_block(void *bus, const uint8_t tx[], uint8_t rx[], uint16_t len) {
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        uint8_t data = sim_transfer(bus, (tx != NULL) ? tx[i] : 0x00U);
+        if (rx != NULL)
+            rx[i] = data;
+    }
+}
+
+static void sim_cs_assert(void *bus, uint8_t csPin) {
+    (void)csPin;
+    ((sim_t *)bus)->pos = 0;
+}
+
+static void sim_cs_deassert(void *bus, uint8_t csPin) {
+    (void)bus;
+    (void)csPin;
+}
+
+static const cc1120_transport_ops_t SIM_OPS = { sim_transfer, sim_cs_assert, sim_cs_deassert, NULL, NULL };
+static const cc1120_transport_ops_t SIM_BLOCK_OPS = { sim_transfer, sim_cs_assert, sim_cs_deassert, NULL,
+                                                      sim_transfer_block };
+
+static void sim_reset(sim_t *sim, uint8_t corrupt) {
+    uint16_t i;
+
+    memset(sim, 0, sizeof(*sim));
+    for (i = 0; i < 256; i++) {
+        sim->regs[i] = (uint8_t)i;
+        sim->ext[i] = (uint8_t)(0x80U | i);
+    }
+    sim->corrupt = corrupt;
+}
+
+static void on_txn(void *ctx, const cc1120_trace_txn_t *txn) {
+    decoded_t *decoded = ctx;
+
+    decoded->lost += txn->lostBefore;
+    if (decoded->count < sizeof(decoded->lines) / sizeof(decoded->lines[0]))
+        cc1120_trace_describe(txn, decoded->lines[decoded->count], sizeof(decoded->lines[0]));
+    decoded->count++;
+}
+
+/* What the driver calls in run_driver decode to */
+static const char *const EXPECTED[] = {
+    "cs53 3us STROBE SRX (st 0x0F)",
+    "cs53 3us R REG 0x0A [1] = 0A (st 0x0F)",
+    "cs53 3us R REG 0x00 [12] = 00 01 02 03 04 05 06 07 ... (st 0x0F)",
+    "cs53 3us W EXT 0x0C [3] = 01 02 03 (st 0x0F)",
+    "cs53 3us R EXT 0x73 [1] = F3 (st 0x0F)",
+    "cs53 3us W FIFO [10] = 01 02 03 04 05 06 07 08 ... (st 0x0F)",
+};
+
+#define EXPECTED_COUNT (sizeof(EXPECTED) / sizeof(EXPECTED[0]))
+
+/**
+ * @brief Runs a strobe, register, extended register and FIFO accesses through the recorder.
+ *
+ * @param dev - The device on CC1120_TRACE_TRANSPORT.
+ */
+static void run_driver(cc1120_dev_t *dev) {
+    uint8_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint8_t buf[12];
+
+    HOST_CHECK(cc1120_strobe_spi(dev, CC1120_STROBE_SRX) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_read_spi(dev, 0x0AU, buf, 1) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_read_spi(dev, 0x00U, buf, 12) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_write_ext_addr_spi(dev, 0x0CU, data, 3) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_read_ext_addr_spi(dev, 0x73U, buf, 1) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(cc1120_write_fifo(dev, data, 10) == CC1120_ERROR_CODE_SUCCESS);
+}
+
+/**
+ * @brief Records run_driver over a transport and checks the decoded operations.
+ *
+ * @param ops - The simulated transport, with or without block transfers.
+ * @param out - Filled with the drained trace.
+ * @param max - The size of out.
+ * @return uint16_t - The trace length.
+ */
+static uint16_t record(const cc1120_transport_ops_t *ops, uint8_t out[], uint16_t max) {
+    static uint8_t ring[2048];
+    static sim_t sim;
+    cc1120_trace_t trace;
+    cc1120_dev_t dev;
+    decoded_t decoded = {0};
+    uint8_t i;
+
+    sim_reset(&sim, 0);
+    cc1120_trace_init(&trace, ops, &sim, ring, sizeof(ring));
+    cc1120_dev_init(&dev, &CC1120_TRACE_TRANSPORT, &trace, 53);
+    run_driver(&dev);
+
+    uint16_t len = cc1120_trace_drain(&trace, out, max);
+    HOST_CHECK(len > 0 && trace.stats.lost == 0);
+    HOST_CHECK(cc1120_trace_drain(&trace, out + len, max - len) == 0);
+
+    HOST_CHECK(cc1120_trace_decode(out, len, on_txn, &decoded) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(decoded.count == EXPECTED_COUNT && decoded.lost == 0);
+    for (i = 0; i < EXPECTED_COUNT && i < decoded.count; i++) {
+        if (strcmp(decoded.lines[i], EXPECTED[i]) != 0) {
+            printf("decoded \"%s\", expected \"%s\"\n", decoded.lines[i], EXPECTED[i]);
+            HOST_CHECK(false);
+        }
+    }
+
+    return len;
+}
+
+int main(void) {
+    static uint8_t bytes[4096];
+    static uint8_t blocks[4096];
+    static sim_t sim;
+    cc1120_trace_replay_t replay;
+    decoded_t decoded;
+
+    uint16_t bytesLen = record(&SIM_OPS, bytes, sizeof(bytes));
+    uint16_t blocksLen = record(&SIM_BLOCK_OPS, blocks, sizeof(blocks));
+    HOST_CHECK(blocksLen == bytesLen);
+
+    // Replaying on an identical device matches, on one whose reads differ it does not
+    sim_reset(&sim, 0);
+    HOST_CHECK(cc1120_trace_replay(bytes, bytesLen, &SIM_OPS, &sim, 0xFFU, &replay) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(replay.transactions == EXPECTED_COUNT && replay.mismatches == 0);
+    sim_reset(&sim, 0x01U);
+    HOST_CHECK(cc1120_trace_replay(blocks, blocksLen, &SIM_OPS, &sim, 0xFFU, &replay) ==
+               CC1120_ERROR_CODE_TRACE_MISMATCH);
+    HOST_CHECK(replay.mismatches > 0 && replay.firstMismatchTxn == 1);
+
+    // A trace cut inside the last transaction decodes up to it
+    memset(&decoded, 0, sizeof(decoded));
+    HOST_CHECK(cc1120_trace_decode(bytes, bytesLen - 3U, on_txn, &decoded) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(decoded.count == EXPECTED_COUNT - 1);
+
+    // An unknown record is refused
+    bytes[0] = 0x7FU;
+    HOST_CHECK(cc1120_trace_decode(bytes, bytesLen, on_txn, &decoded) == CC1120_ERROR_CODE_INVALID_PARAM);
+
+    // With a small ring, whole records are dropped and reported before the next transaction that fits
+    static uint8_t small[40];
+    cc1120_trace_t trace;
+    cc1120_dev_t dev;
+    uint8_t reg;
+    uint8_t i;
+    sim_reset(&sim, 0);
+    cc1120_trace_init(&trace, &SIM_OPS, &sim, small, sizeof(small));
+    cc1120_dev_init(&dev, &CC1120_TRACE_TRANSPORT, &trace, 53);
+    for (i = 0; i < 5; i++)
+        cc1120_read_spi(&dev, 0x0AU, &reg, 1);
+    uint16_t len = cc1120_trace_drain(&trace, bytes, sizeof(bytes));
+    cc1120_read_spi(&dev, 0x0BU, &reg, 1);
+    len += cc1120_trace_drain(&trace, bytes + len, sizeof(bytes) - len);
+    HOST_CHECK(trace.stats.lost > 0);
+
+    memset(&decoded, 0, sizeof(decoded));
+    HOST_CHECK(cc1120_trace_decode(bytes, len, on_txn, &decoded) == CC1120_ERROR_CODE_SUCCESS);
+    HOST_CHECK(decoded.lost == trace.stats.lost);
+    HOST_CHECK(decoded.count > 0 && strstr(decoded.lines[decoded.count - 1], "R REG 0x0B [1] = 0B") != NULL);
+
+    printf("trace of %u bytes for %u transactions, %lu records lost in the small ring\n", bytesLen,
+           (unsigned)EXPECTED_COUNT, (unsigned long)trace.stats.lost);
+
+    return HOST_TEST_RESULT("trace_test");
+}